@@ -1,21 +1,38 @@
 #include "Legalization.hpp"
+#include "profiler.hpp"
+#include "logger.hpp"
+#include "time_budget.hpp"
+#include "out_of_core.hpp"
 #include <cmath>
 #include <algorithm>
 #include <numeric>
 #include <iomanip>
 
+namespace {
+
+// 以site為單位：寬度向上取整、座標向下對齊到 origin + k * site
+inline Dbu site_ceil(Dbu width, Dbu site) { return ceil_div(width, site) * site; }
+inline Dbu snap_to_site(Dbu x, Dbu origin, Dbu site) { return origin + floor_div(x - origin, site) * site; }
+
+inline Dbu squared_distance(Dbu dx, Dbu dy) { return dx * dx + dy * dy; }
+
+} // namespace
+
 // 移除舊的構造函數，只保留使用 DesignDatabase 的版本
 Legalizer::Legalizer(double max_disp, DesignDatabase& db)
     : max_disp_(max_disp), db_(&db) {
+    // sqrt(INT64_MAX) ≈ 3.03e9：更大的上限等於不限制
+    max_disp_sq_ = max_disp_ < 3.0e9 ? static_cast<Dbu>(std::floor(max_disp_ * max_disp_))
+                                     : std::numeric_limits<Dbu>::max();
     
     // Assign IDs to rows and initialize row properties
     for (int i = 0; i < static_cast<int>(db_->placement_rows.size()); ++i) {
         db_->placement_rows[i].id = i;
         // 確保 height 和 site_width 正確設置
-        if (db_->placement_rows[i].height == 0.0) {
+        if (db_->placement_rows[i].height == 0) {
             db_->placement_rows[i].height = db_->placement_rows[i].step_y;
         }
-        if (db_->placement_rows[i].site_width == 0.0) {
+        if (db_->placement_rows[i].site_width == 0) {
             db_->placement_rows[i].site_width = db_->placement_rows[i].step_x;
         }
         
@@ -63,6 +80,9 @@ void Legalizer::classify_instances(std::vector<std::shared_ptr<Instance>>& ff_in
     std::cout << "  Total flip-flops found: " << ff_count << std::endl;
     std::cout << "  Eligible flip-flops for legalization: " << ff_instances.size() << std::endl;
     std::cout << "  Blockage instances (non-FF, placed): " << blockage_instances.size() << std::endl;
+    if (db_->out_of_core) {
+        std::cout << "  Out-of-core obstacles: " << db_->out_of_core->obstacle_count() << std::endl;
+    }
 }
 
 void Legalizer::Abacus() 
@@ -72,10 +92,19 @@ void Legalizer::Abacus()
     // Step 1: 分類 instances
     std::vector<std::shared_ptr<Instance>> ff_instances;
     std::vector<std::shared_ptr<Instance>> blockage_instances;
-    classify_instances(ff_instances, blockage_instances);
+    {
+        PROFILE_SCOPE("classify_instances");
+        classify_instances(ff_instances, blockage_instances);
+    }
     
     // Step 2: Build sub-rows by splitting around blockages
-    buildSubRows(blockage_instances);
+    {
+        ScopedTimer subrow_timer("buildSubRows");
+        buildSubRows(blockage_instances);
+        subrow_timer.set_items(blockage_instances.size());
+    }
+    
+    ScopedTimer abacus_timer("Abacus");
     
     // Step 3: Sort flip-flop instances by x-coordinate for processing
     std::sort(ff_instances.begin(), ff_instances.end(), 
@@ -87,11 +116,12 @@ void Legalizer::Abacus()
     int processed_count = 0;
     for (auto& instance : ff_instances) {
         
-        double Cbest = std::numeric_limits<double>::max();
+        Dbu Cbest = std::numeric_limits<Dbu>::max();   // squared displacement
         int originRowIdx = findBestRow(*instance);
         
         if (originRowIdx == -1) {
-            std::cerr << "WARN: instance " << instance->name << " cannot fit any [row]; skipping.\n";
+            LOG_WARN_LIMITED("instance cannot fit any row") << "instance " << instance->name
+                                                            << " cannot fit any [row]; skipping.";
             continue;
         }
         
@@ -107,10 +137,10 @@ void Legalizer::Abacus()
             
             // 判斷需不需要執行
             if (rowidx1 >= static_cast<int>(db_->placement_rows.size())) up = false;
-            else if (std::abs(instance->position.y - db_->placement_rows[rowidx1].origin.y) < Cbest) up = true;
+            else if (squared_distance(0, instance->position.y - db_->placement_rows[rowidx1].origin.y) < Cbest) up = true;
             
             if (rowidx2 < 0) down = false;
-            else if (std::abs(instance->position.y - db_->placement_rows[rowidx2].origin.y) < Cbest) down = true;
+            else if (squared_distance(0, instance->position.y - db_->placement_rows[rowidx2].origin.y) < Cbest) down = true;
             
             if (!up && !down) break;
             
@@ -141,26 +171,78 @@ void Legalizer::Abacus()
                     }
                 }
             }
+            
+            // -time_budget到期：已經找到可放的row就不再往外搜尋
+            if (bestRowIdx != -1 && time_budget_expired(*db_)) break;
         }
         if (bestRowIdx != -1 && bestSubRowIdx != -1) {
-            double finalcost = placeRow(db_->placement_rows[bestRowIdx], *instance,
-                                      db_->placement_rows[bestRowIdx].subrows[bestSubRowIdx], true, true);
+            placeRow(db_->placement_rows[bestRowIdx], *instance,
+                     db_->placement_rows[bestRowIdx].subrows[bestSubRowIdx], true, true);
             instance->placement_status = Instance::PLACED;
             processed_count++;
         } else {
-            std::cout << "  Warning: Could not place instance " << instance->name << std::endl;
+            LOG_WARN_LIMITED("could not place instance") << "Could not place instance " << instance->name;
             // 如果無法找到合適位置，至少設置為原始位置
+            instance->placement_status = Instance::UNPLACED;
             instance->x_new = instance->position.x;
             instance->y_new = instance->position.y;
         }
     }
     
+    abacus_timer.set_items(processed_count);
     std::cout << "Abacus completed. Processed " << processed_count << " instances." << std::endl;
 }
 
-void Legalizer::buildSubRows(std::vector<std::shared_ptr<Instance>>& blockage_instances) {
-    const double eps = 1e-6;
+// 從每個row的subrows挖掉 [MINx, MAXx) x [MINy, MAXy)，邊界對齊site
+void Legalizer::cutSubRows(Dbu MINx, Dbu MAXx, Dbu MINy, Dbu MAXy) {
+    for (auto& row : db_->placement_rows) 
+    {   
+        //if (row.origin.y!=MINy) continue;
+        if (!(row.origin.y + row.height > MINy && row.origin.y < MAXy))continue;
+
+        // site 對齊邊界 (整數運算，不需要 eps)
+        Dbu front = row.origin.x + floor_div(MINx - row.origin.x, row.site_width) * row.site_width;
+        Dbu back  = row.origin.x + ceil_div(MAXx - row.origin.x, row.site_width) * row.site_width;
+
+        auto& sr = row.subrows;
+        for (auto slice = sr.begin(); slice != sr.end();) 
+        {
+            // X 向不重疊（允許相接）
+            if (slice->x_max <= front|| back <= slice->x_min) {
+                ++slice;
+                continue;
+            }
+
+            // 1. 完全覆蓋整個 subrow
+            if (front <= slice->x_min&& back >= slice->x_max) {
+                slice = sr.erase(slice);
+            }
+            // 2. 覆蓋 subrow 左端
+            else if (front <= slice->x_min&& back < slice->x_max) {
+                slice->x_min = back;
+                slice->Usewidth = slice->x_max - slice->x_min;
+                ++slice;
+            }
+            // 3. 覆蓋 subrow 右端
+            else if (front > slice->x_min&& back >= slice->x_max) {
+                slice->x_max = front;
+                slice->Usewidth = slice->x_max - slice->x_min;
+                ++slice;
+            }
+            // 4. 中間切成兩段
+            else if (front > slice->x_min&& back < slice->x_max) {
+                SubRow left(slice->x_min, front);
+                SubRow right(back, slice->x_max);
+                slice = sr.erase(slice);
+                slice = sr.insert(slice, left);
+                slice = sr.insert(std::next(slice), right);
+                ++slice;
+            }
+        }
+    }
+}
 
+void Legalizer::buildSubRows(std::vector<std::shared_ptr<Instance>>& blockage_instances) {
     std::cout << "buildSubRows: Processing " << blockage_instances.size() << " blockage instances" << std::endl;
 
     // 排序，確保左到右
@@ -171,140 +253,34 @@ void Legalizer::buildSubRows(std::vector<std::shared_ptr<Instance>>& blockage_in
 
     for (const auto& blk : blockage_instances) {
         if (!blk->cell_template) {
-            std::cout << blk->name << " no template" << std::endl;
+            LOG_WARN_LIMITED("blockage without template") << blk->name << " no template";
             continue;
         }
 
-        double MINx = blk->position.x;
-        double MAXx = blk->position.x + blk->cell_template->width;
-        double MINy = blk->position.y;
-        double MAXy = blk->position.y + blk->cell_template->height;
-
-        if(blk->name=="c_n34785")
-        {
-            std::cout<<"Hi-before"<<std::endl;
-             std::cout<<MINx<<" "<<MAXx<<" "<<MINy<<" "<<MAXy<<std::endl;
-        }
-
-
-        int affected_rows = 0;
-        for (auto& row : db_->placement_rows) 
-        {   
-            //if (row.origin.y!=MINy) continue;
-            if (!(row.origin.y + row.height > blk->position.y && row.origin.y < blk->position.y +blk->get_height()))continue;
-            affected_rows++;
+        Dbu MINx = blk->position.x;
+        Dbu MAXx = blk->position.x + blk->cell_template->width;
+        Dbu MINy = blk->position.y;
+        Dbu MAXy = blk->position.y + blk->cell_template->height;
 
-            // site 對齊邊界，加入 eps 避免卡在中間
-            double front = row.origin.x + 
-                          std::floor((MINx - row.origin.x) / row.site_width + eps) * row.site_width;
-            double back  = row.origin.x + 
-                          std::ceil((MAXx - row.origin.x) / row.site_width - eps) * row.site_width;
-            //double front = MINx;
-            //double back = MAXx;
+        LOG_HOT << blk->name << " bounds: " << MINx << " " << MAXx << " " << MINy << " " << MAXy;
 
+        cutSubRows(MINx, MAXx, MINy, MAXy);
+    }
 
-            auto& sr = row.subrows;
-            for (auto slice = sr.begin(); slice != sr.end();) 
-            {
-                // X 向不重疊（允許相接）
-                if (slice->x_max <= front|| back <= slice->x_min) {
-                    ++slice;
-                    continue;
-                }
-
-                // 1. 完全覆蓋整個 subrow
-                if (front <= slice->x_min&& back >= slice->x_max) {
-                    slice = sr.erase(slice);
-                }
-                // 2. 覆蓋 subrow 左端
-                else if (front <= slice->x_min&& back < slice->x_max) {
-                    slice->x_min = back;
-                    slice->Usewidth = slice->x_max - slice->x_min;
-                    ++slice;
-                }
-                // 3. 覆蓋 subrow 右端
-                else if (front > slice->x_min&& back >= slice->x_max) {
-                    slice->x_max = front;
-                    slice->Usewidth = slice->x_max - slice->x_min;
-                    ++slice;
-                }
-                // 4. 中間切成兩段
-                else if (front > slice->x_min&& back < slice->x_max) {
-                    SubRow left(slice->x_min, front);
-                    SubRow right(back, slice->x_max);
-                    slice = sr.erase(slice);
-                    slice = sr.insert(slice, left);
-                    slice = sr.insert(std::next(slice), right);
-                    ++slice;
-                }
-            }
+    // -out_of_core：組合邏輯instance只剩mmap的obstacle (切subrow的結果和順序無關，不必排序)
+    if (db_->out_of_core) {
+        const ObstacleRecord* obstacles = db_->out_of_core->obstacles();
+        for (size_t i = 0; i < db_->out_of_core->obstacle_count(); ++i) {
+            const ObstacleRecord& obstacle = obstacles[i];
+            cutSubRows(obstacle.x, obstacle.x + obstacle.width, obstacle.y, obstacle.y + obstacle.height);
         }
-
     }
 
     for (const auto& rect : db_->placement_blockages) 
     {
-
-        double MINx = rect.x1 ;
-        double MAXx = rect.x2 ;
-        double MINy = rect.y1 ;
-        double MAXy = rect.y2 ;
-
-
-        int affected_rows = 0;
-        for (auto& row : db_->placement_rows) 
-        {   
-            //if (row.origin.y!=MINy) continue;
-            if (!(row.origin.y + row.height > MINy && row.origin.y < MAXy))continue;
-            affected_rows++;
-
-            // site 對齊邊界，加入 eps 避免卡在中間
-            double front = row.origin.x + 
-                          std::floor((MINx - row.origin.x) / row.site_width + eps) * row.site_width;
-            double back  = row.origin.x + 
-                          std::ceil((MAXx - row.origin.x) / row.site_width - eps) * row.site_width;
-            //double front = MINx;
-            //double back = MAXx;
-
-
-            auto& sr = row.subrows;
-            for (auto slice = sr.begin(); slice != sr.end();) 
-            {
-                // X 向不重疊（允許相接）
-                if (slice->x_max <= front|| back <= slice->x_min) {
-                    ++slice;
-                    continue;
-                }
-
-                // 1. 完全覆蓋整個 subrow
-                if (front <= slice->x_min&& back >= slice->x_max) {
-                    slice = sr.erase(slice);
-                }
-                // 2. 覆蓋 subrow 左端
-                else if (front <= slice->x_min&& back < slice->x_max) {
-                    slice->x_min = back;
-                    slice->Usewidth = slice->x_max - slice->x_min;
-                    ++slice;
-                }
-                // 3. 覆蓋 subrow 右端
-                else if (front > slice->x_min&& back >= slice->x_max) {
-                    slice->x_max = front;
-                    slice->Usewidth = slice->x_max - slice->x_min;
-                    ++slice;
-                }
-                // 4. 中間切成兩段
-                else if (front > slice->x_min&& back < slice->x_max) {
-                    SubRow left(slice->x_min, front);
-                    SubRow right(back, slice->x_max);
-                    slice = sr.erase(slice);
-                    slice = sr.insert(slice, left);
-                    slice = sr.insert(std::next(slice), right);
-                    ++slice;
-                }
-            }
-        }
-
+        cutSubRows(rect.x1, rect.x2, rect.y1, rect.y2);
     }
+
     
     // 輸出所有 rows 和 subrows 的信息到文件
     // std::ofstream ofs("rows_subrows_info.txt");
@@ -358,11 +334,11 @@ void Legalizer::buildSubRows(std::vector<std::shared_ptr<Instance>>& blockage_in
 }
 
 int Legalizer::findBestRow(const Instance& instance) {
-    double best = std::numeric_limits<double>::infinity();
+    Dbu best = std::numeric_limits<Dbu>::max();
     int br = -1;
     
     for (int i = 0; i < static_cast<int>(db_->placement_rows.size()); ++i) {
-        double dy = std::abs(instance.position.y - db_->placement_rows[i].origin.y);
+        Dbu dy = std::abs(instance.position.y - db_->placement_rows[i].origin.y);
         if (dy < best) {
             br = i;
             best = dy;
@@ -375,12 +351,12 @@ int Legalizer::findSubrowpos(const Instance& instance, const PlacementRow& row)
     if (!instance.cell_template) return -1;
     
     int subRow = -1;
-    double minDisplacement = std::numeric_limits<double>::max();
+    Dbu minDisplacement = std::numeric_limits<Dbu>::max();
     
     for (int idx = 0; idx < static_cast<int>(row.subrows.size()); ++idx) {
         if (instance.cell_template->width > row.subrows[idx].Usewidth) continue;
         
-        double move = 0;
+        Dbu move = 0;
         if (instance.position.x < row.subrows[idx].x_min) {
             move = row.subrows[idx].x_min - instance.position.x;
         } else if (instance.position.x + instance.cell_template->width > row.subrows[idx].x_max) {
@@ -397,7 +373,7 @@ int Legalizer::findSubrowpos(const Instance& instance, const PlacementRow& row)
     return subRow;
 }
 
-void Legalizer::AddCell(Cluster& cluster, Instance& instance, double tempXpos, double placeCellwidth) {
+void Legalizer::AddCell(Cluster& cluster, Instance& instance, Dbu tempXpos, Dbu placeCellwidth) {
     cluster.cellInCluster.push_back(&instance);
     cluster.weight += instance.weight;
     cluster.q += instance.weight * (tempXpos - cluster.width);
@@ -408,16 +384,16 @@ void Legalizer::AddCluster(Cluster& pred, Cluster& curr) {
     pred.cellInCluster.insert(pred.cellInCluster.end(), 
                              curr.cellInCluster.begin(), curr.cellInCluster.end());
     
-    double oldWidth = pred.width;
+    Dbu oldWidth = pred.width;
     pred.weight += curr.weight;
     pred.q += curr.q - curr.weight * oldWidth;
     pred.width += curr.width;
 }
 
-void Legalizer::Collapse(Cluster& cluster, double xmin, double xmax, SubRow& sr, double sitew) {
+void Legalizer::Collapse(Cluster& cluster, Dbu xmin, Dbu xmax, SubRow& sr, Dbu sitew) {
     while (true) {
-        cluster.x = cluster.q / cluster.weight;
-        cluster.x = std::floor((cluster.x - sr.x_min) / sitew) * sitew + sr.x_min;
+        // floor((q / weight - x_min) / sitew)，整個用整數算 (不先除出小數位置)
+        cluster.x = sr.x_min + floor_div(cluster.q - cluster.weight * sr.x_min, cluster.weight * sitew) * sitew;
         
         if (cluster.x < xmin) cluster.x = xmin;
         if (cluster.x + cluster.width > xmax) cluster.x = xmax - cluster.width;
@@ -433,32 +409,28 @@ void Legalizer::Collapse(Cluster& cluster, double xmin, double xmax, SubRow& sr,
     sr.lastCluster = &cluster;
 }
 
-double Legalizer::placeRow(const PlacementRow& row, Instance& instance, SubRow& sr, 
-                          bool final, bool check) {
-    if (!instance.cell_template) return std::numeric_limits<double>::max();
+Dbu Legalizer::placeRow(const PlacementRow& row, Instance& instance, SubRow& sr, 
+                       bool final, bool check) {
+    if (!instance.cell_template) return std::numeric_limits<Dbu>::max();
     
-    double placeCellwidth = std::ceil(instance.cell_template->width / row.site_width) * row.site_width;
+    Dbu placeCellwidth = site_ceil(instance.cell_template->width, row.site_width);
     
     if (final) {
         sr.Usewidth -= placeCellwidth;
         
-        double tempXpos = instance.position.x;
+        Dbu tempXpos = instance.position.x;
         if (tempXpos <= sr.x_min) {
             tempXpos = sr.x_min;
         } else if (tempXpos + instance.cell_template->width >= sr.x_max) {
-            tempXpos = sr.x_max - instance.cell_template->width;
-            tempXpos = std::floor((tempXpos - sr.x_min) / row.site_width) * row.site_width + sr.x_min;
+            tempXpos = snap_to_site(sr.x_max - instance.cell_template->width, sr.x_min, row.site_width);
         } else {
-            tempXpos = std::floor((tempXpos - sr.x_min) / row.site_width) * row.site_width + sr.x_min;
+            tempXpos = snap_to_site(tempXpos, sr.x_min, row.site_width);
         }
         
         if (!sr.lastCluster || sr.lastCluster->x + sr.lastCluster->width <= tempXpos) {
             Cluster* prev = sr.lastCluster;
             Cluster* cur = new Cluster();
             cur->x = tempXpos;
-            cur->width = 0.0;
-            cur->weight = 0.0;
-            cur->q = 0.0;
             cur->leftCluster = prev;
             sr.lastCluster = cur;
             
@@ -471,14 +443,13 @@ double Legalizer::placeRow(const PlacementRow& row, Instance& instance, SubRow&
         }
     } else {
         // Temporary placement for cost calculation
-        double tempXpos = instance.position.x;
+        Dbu tempXpos = instance.position.x;
         if (tempXpos <= sr.x_min) {
             tempXpos = sr.x_min;
         } else if (tempXpos + instance.cell_template->width >= sr.x_max) {
-            tempXpos = sr.x_max - instance.cell_template->width;
-            tempXpos = std::floor((tempXpos - sr.x_min) / row.site_width) * row.site_width + sr.x_min;
+            tempXpos = snap_to_site(sr.x_max - instance.cell_template->width, sr.x_min, row.site_width);
         } else {
-            tempXpos = std::floor((tempXpos - sr.x_min) / row.site_width) * row.site_width + sr.x_min;
+            tempXpos = snap_to_site(tempXpos, sr.x_min, row.site_width);
         }
         
         if (!sr.lastCluster || sr.lastCluster->x + sr.lastCluster->width <= tempXpos) {
@@ -486,17 +457,16 @@ double Legalizer::placeRow(const PlacementRow& row, Instance& instance, SubRow&
             instance.y_new = row.origin.y;
         } else {
             // Simulate cluster operations
-            double TempWeight = sr.lastCluster->weight + instance.weight;
-            double TempQ = sr.lastCluster->q + instance.weight * (tempXpos - sr.lastCluster->width);
-            double TempWidth = sr.lastCluster->width + placeCellwidth;
-            double Tempx = 0;
+            Dbu TempWeight = sr.lastCluster->weight + instance.weight;
+            Dbu TempQ = sr.lastCluster->q + instance.weight * (tempXpos - sr.lastCluster->width);
+            Dbu TempWidth = sr.lastCluster->width + placeCellwidth;
+            Dbu Tempx = 0;
             
             std::vector<Cluster*> checkmaxdis;
             Cluster* curr = sr.lastCluster;
             
             while (true) {
-                Tempx = TempQ / TempWeight;
-                Tempx = sr.x_min + std::floor((Tempx - sr.x_min) / row.site_width) * row.site_width;
+                Tempx = sr.x_min + floor_div(TempQ - TempWeight * sr.x_min, TempWeight * row.site_width) * row.site_width;
                 
                 if (Tempx < sr.x_min) Tempx = sr.x_min;
                 if (Tempx + TempWidth > sr.x_max) Tempx = sr.x_max - TempWidth;
@@ -520,23 +490,20 @@ double Legalizer::placeRow(const PlacementRow& row, Instance& instance, SubRow&
             if (check) {
                 for (auto* c : checkmaxdis) {
                     for (Instance* cp : c->cellInCluster) {
-                        double displacement = std::sqrt((cp->position.x - Tempx) * (cp->position.x - Tempx) + 
-                                                       (cp->position.y - row.origin.y) * (cp->position.y - row.origin.y));
-                        if (displacement > max_disp_) {
-                            return std::numeric_limits<double>::max();
+                        if (squared_distance(cp->position.x - Tempx, cp->position.y - row.origin.y) > max_disp_sq_) {
+                            return std::numeric_limits<Dbu>::max();
                         }
-                        Tempx += std::ceil(cp->cell_template->width / row.site_width) * row.site_width;
+                        Tempx += site_ceil(cp->cell_template->width, row.site_width);
                     }
                 }
             }
         }
     }
     
-    double dis = std::sqrt((instance.position.x - instance.x_new) * (instance.position.x - instance.x_new) + 
-                          (instance.position.y - row.origin.y) * (instance.position.y - row.origin.y));
+    Dbu dis = squared_distance(instance.position.x - instance.x_new, instance.position.y - row.origin.y);
     
-    if (check && dis > max_disp_) {
-        return std::numeric_limits<double>::max();
+    if (check && dis > max_disp_sq_) {
+        return std::numeric_limits<Dbu>::max();
     }
     
     return dis;
@@ -549,12 +516,12 @@ void Legalizer::place() {
         for (auto& sub : row.subrows) {
             Cluster* cluster = sub.lastCluster;
             while (cluster) {
-                double x = sub.x_min + std::floor((cluster->x - sub.x_min) / row.site_width) * row.site_width;               
+                Dbu x = snap_to_site(cluster->x, sub.x_min, row.site_width);
                 for (Instance* instance : cluster->cellInCluster) 
                 {
                     instance->x_new = x;
                     instance->y_new = row.origin.y;
-                    x += std::ceil(instance->cell_template->width / row.site_width) * row.site_width;
+                    x += site_ceil(instance->cell_template->width, row.site_width);
                 }
                 cluster = cluster->leftCluster;
             }
@@ -564,7 +531,7 @@ void Legalizer::place() {
     int placed_count = 0;
     for (const auto& pair : db_->instances) {
         if (pair.second->is_flip_flop()) {
-            if (pair.second->x_new != 0.0 || pair.second->y_new != 0.0) {
+            if (pair.second->x_new != 0 || pair.second->y_new != 0) {
                 placed_count++;
             }
         }
@@ -578,8 +545,8 @@ std::pair<double, double> Legalizer::calculate_displacement() const {
     
     for (const auto& pair : db_->instances) {
         const auto& instance = pair.second;
-        double displacement = std::sqrt((instance->x_new - instance->position.x) * (instance->x_new - instance->position.x) + 
-                                       (instance->y_new - instance->position.y) * (instance->y_new - instance->position.y));
+        double displacement = std::sqrt(static_cast<double>(
+            squared_distance(instance->x_new - instance->position.x, instance->y_new - instance->position.y)));
         total_displacement += displacement;
         max_displacement = std::max(max_displacement, displacement);
     }
@@ -638,24 +605,14 @@ void Legalizer::writeOutput(const std::string& filename) const {
         
         // 找到匹配的 row
         for (const auto& row : db_->placement_rows) {
-            if (std::abs(instance->y_new - row.origin.y) < 0.001) { // 允許小誤差
+            if (instance->y_new == row.origin.y) {
                 matched_row_id = row.id;
                 
-                // 檢查 x 座標是否對齊 site
+                // 檢查 x 座標是否對齊 site (整數倍)
                 if (row.site_width > 0) {
-                    double offset_from_row = instance->x_new - row.origin.x;
-                    site_offset = offset_from_row / row.site_width;
-                    
-                    // 檢查是否為整數倍
-                    double rounded_offset = std::round(site_offset);
-                    
-                    // 如果四捨五入後相等，認為是對齊的
-                    if (std::abs(site_offset - rounded_offset) < 1e-9) {
-                        aligned = true;
-                        site_offset = rounded_offset;
-                    } else {
-                        aligned = false;
-                    }
+                    Dbu offset_from_row = instance->x_new - row.origin.x;
+                    aligned = offset_from_row % row.site_width == 0;
+                    site_offset = static_cast<double>(offset_from_row) / row.site_width;
                 } else {
                     aligned = false; // site_width 為 0 是錯誤的
                 }
@@ -710,5 +667,5 @@ void Legalizer::writeOutput(const std::string& filename) const {
 }
 
 double calculate_euclidean_distance(const Point& p1, const Point& p2) {
-    return std::sqrt((p1.x - p2.x) * (p1.x - p2.x) + (p1.y - p2.y) * (p1.y - p2.y));
+    return p1.distance_to(p2);
 }
\ No newline at end of file
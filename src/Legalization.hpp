@@ -27,6 +27,9 @@ public:
     // Build sub-rows by splitting around blockages (non-flip-flop instances)
     void buildSubRows( std::vector<std::shared_ptr<Instance>>& blockage_instances);
     
+    // Remove one blockage rectangle (site-aligned) from every row's sub-rows
+    void cutSubRows(Dbu MINx, Dbu MAXx, Dbu MINy, Dbu MAXy);
+    
     // Calculate total and maximum displacement
     std::pair<double, double> calculate_displacement() const;
     
@@ -37,7 +40,10 @@ public:
     void place();
 
 private:
+    friend struct LegalizerBenchmarkAccess;   // microbenchmark.cpp 直接量測 placeRow
+
     double max_disp_;
+    Dbu max_disp_sq_;     // max_disp_²：cost用整數平方距離比較 (和歐氏距離同序)
     DesignDatabase* db_;  // 指向整個數據庫
     
     // 輔助函數：分類 instances
@@ -49,13 +55,14 @@ private:
     int findSubrowpos(const Instance& instance, const PlacementRow& row);
     
     // Cluster management - 對應原始的 cluster 操作
-    void AddCell(Cluster& cluster, Instance& instance, double tempXpos, double placeCellwidth);
+    void AddCell(Cluster& cluster, Instance& instance, Dbu tempXpos, Dbu placeCellwidth);
     void AddCluster(Cluster& pred, Cluster& curr);
-    void Collapse(Cluster& cluster, double xmin, double xmax, SubRow& sr, double sitew);
+    void Collapse(Cluster& cluster, Dbu xmin, Dbu xmax, SubRow& sr, Dbu sitew);
     
     // Place instance in row - 對應原始的 placeRow
-    double placeRow(const PlacementRow& row, Instance& instance, SubRow& sr, 
-                   bool final, bool check);
+    // 回傳squared displacement (DBU²)；超過max displacement時為 numeric_limits<Dbu>::max()
+    Dbu placeRow(const PlacementRow& row, Instance& instance, SubRow& sr, 
+                 bool final, bool check);
 };
 
 // Utility functions
@@ -1,6 +1,7 @@
 #include "argument_parser.hpp"
 #include <iostream>
 #include <string>
+#include <cstdlib>
 
 // =============================================================================
 // COMMAND LINE ARGUMENT PARSER IMPLEMENTATION
@@ -20,8 +21,43 @@ void print_usage(const char* program_name) {
     std::cout << "Optional options:" << std::endl;
     std::cout << "  -db <file1> [file2]...  Database files (ignored)" << std::endl;
     std::cout << "  -tf <file1> [file2]...  Technology files (ignored)" << std::endl;
-    std::cout << "  -sdc <file1> [file2]... SDC timing files (ignored)" << std::endl;
+    std::cout << "  -sdc <file1> [file2]... SDC files (create_clock names for clock tracing)" << std::endl;
     std::cout << "  -out <name>             Output name (future use)" << std::endl;
+    std::cout << "  -profile <file>         Write per-step timing/memory profile as JSON" << std::endl;
+    std::cout << "  -trace <file>           Record a Chrome trace-event JSON (open in Perfetto)" << std::endl;
+    std::cout << "  -log_level <level>      error | warn | info | debug (default: info)" << std::endl;
+    std::cout << "  -quiet                  Suppress progress output; keep warnings and errors" << std::endl;
+    std::cout << "  -threads <n>            Threads incl. main (default 0 = all cores; 1 = sequential)" << std::endl;
+    std::cout << "  -time_budget <seconds>  Wall-clock limit; banking stops early to finish output in time" << std::endl;
+    std::cout << "  -param <name>=<value>   Override a banking heuristic (repeatable):" << std::endl;
+    std::cout << "                          fsdn2_distance, fsdn4_distance, lsrdpq4_distance (DBU),"  << std::endl;
+    std::cout << "                          legalization_max_displacement (0 = unlimited), banking_group_fraction," << std::endl;
+    std::cout << "                          clock_leaf_group_min_ffs (0 = bank across the clock domain)" << std::endl;
+    std::cout << "  -autotune               Search the banking parameters (successive halving) and report the best" << std::endl;
+    std::cout << "  -autotune_candidates <n>  Configurations in the first round (default 16)" << std::endl;
+    std::cout << "  -out_of_core            Spill combinational cells to <out>.ooc_* files (mmap); only FFs in memory" << std::endl;
+    std::cout << "  -tiles <n>              Bank and legalize in n tiles, one worker process per tile" << std::endl;
+    std::cout << "  -tile_workers <n>       Concurrent tile workers (default 0 = min(tiles, cores))" << std::endl;
+    std::cout << "  -tile_halo <dbu>        Boundary fix-up band around tile edges (default: largest banking distance)" << std::endl;
+    std::cout << "  -compress_output <gz|zst>  Write <out>.v/.def/.list compressed (inputs: .gz/.zst detected automatically)" << std::endl;
+    std::cout << "  -no_scan_reorder        Do not re-stitch scan chains after legalization (step 19.5)" << std::endl;
+    std::cout << "  --checkpoint-after <step>  Save the database after a step (1-16, 18, 18.5, 19, 19.5)" << std::endl;
+    std::cout << "                          to <out>_step<step>" CHECKPOINT_EXTENSION << std::endl;
+    std::cout << "  --resume-from <file>    Load a checkpoint and run only the remaining steps" << std::endl;
+    std::cout << "                          (-lib/-lef/-v/-weight not needed; -def optional)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Server mode (libraries parsed once, jobs over a Unix-domain socket):" << std::endl;
+    std::cout << "  -server <socket>        Load -lib/-lef, then serve jobs until stopped" << std::endl;
+    std::cout << "  -jobs <n>               Concurrent jobs in server mode (default 2)" << std::endl;
+    std::cout << "  -submit <socket>        Run -v/-def/-weight/-out as a job on the server" << std::endl;
+    std::cout << "  -stop_server <socket>   Finish running jobs and stop the server" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Batch mode (libraries parsed once, designs run concurrently):" << std::endl;
+    std::cout << "  -batch <manifest>       One design per line: -weight/-v/-def/-out [-memory_mb <n>]" << std::endl;
+    std::cout << "                          (relative paths are relative to the manifest, # = comment)" << std::endl;
+    std::cout << "  -jobs <n>               Concurrent designs (default 2)" << std::endl;
+    std::cout << "  -memory_budget_mb <n>   Memory shared by running designs (default 80% of RAM)" << std::endl;
+    std::cout << "  -batch_summary <file>   Also write the runtime/QoR summary as CSV" << std::endl;
     std::cout << std::endl;
     std::cout << "Example:" << std::endl;
     std::cout << "  " << program_name << " -weight testcase1_weight \\" << std::endl;
@@ -82,6 +118,151 @@ ProgramArguments parse_arguments(int argc, char* argv[]) {
             current_list = nullptr;
             current_single = &args.output_name;
         }
+        else if (arg == "-profile") {
+            current_list = nullptr;
+            current_single = &args.profile_file;
+        }
+        else if (arg == "-trace") {
+            current_list = nullptr;
+            current_single = &args.trace_file;
+        }
+        else if (arg == "-log_level") {
+            current_list = nullptr;
+            current_single = nullptr;
+            if (i + 1 < argc) {
+                args.log_level = argv[++i];
+            }
+        }
+        else if (arg == "-threads") {
+            current_list = nullptr;
+            current_single = nullptr;
+            if (i + 1 < argc) {
+                args.threads = std::atoi(argv[++i]);
+            }
+        }
+        else if (arg == "-time_budget") {
+            current_list = nullptr;
+            current_single = nullptr;
+            if (i + 1 < argc) {
+                args.time_budget = std::atof(argv[++i]);
+            }
+        }
+        else if (arg == "-param") {
+            current_list = nullptr;
+            current_single = nullptr;
+            if (i + 1 < argc) {
+                std::string error;
+                if (!set_banking_parameter(args.banking_params, argv[++i], error) && args.param_error.empty()) {
+                    args.param_error = error;
+                }
+            }
+        }
+        else if (arg == "-autotune") {
+            current_list = nullptr;
+            current_single = nullptr;
+            args.autotune = true;
+        }
+        else if (arg == "-autotune_candidates") {
+            current_list = nullptr;
+            current_single = nullptr;
+            if (i + 1 < argc) {
+                args.autotune_candidates = std::atoi(argv[++i]);
+            }
+        }
+        else if (arg == "-out_of_core") {
+            current_list = nullptr;
+            current_single = nullptr;
+            args.out_of_core = true;
+        }
+        else if (arg == "-no_scan_reorder") {
+            current_list = nullptr;
+            current_single = nullptr;
+            args.scan_reorder = false;
+        }
+        else if (arg == "-tiles") {
+            current_list = nullptr;
+            current_single = nullptr;
+            if (i + 1 < argc) {
+                args.tiles = std::atoi(argv[++i]);
+            }
+        }
+        else if (arg == "-tile_workers") {
+            current_list = nullptr;
+            current_single = nullptr;
+            if (i + 1 < argc) {
+                args.tile_workers = std::atoi(argv[++i]);
+            }
+        }
+        else if (arg == "-tile_halo") {
+            current_list = nullptr;
+            current_single = nullptr;
+            if (i + 1 < argc) {
+                args.tile_halo = std::atol(argv[++i]);
+            }
+        }
+        else if (arg == "-compress_output") {
+            current_list = nullptr;
+            current_single = &args.compress_output;
+        }
+        else if (arg == "-tile_worker") {
+            current_list = nullptr;
+            current_single = nullptr;
+            args.tile_worker = true;
+        }
+        else if (arg == "--checkpoint-after") {
+            current_list = nullptr;
+            current_single = &args.checkpoint_after;
+        }
+        else if (arg == "--resume-from") {
+            current_list = nullptr;
+            current_single = &args.resume_from;
+        }
+        else if (arg == "-server") {
+            current_list = nullptr;
+            current_single = &args.server_socket;
+        }
+        else if (arg == "-submit") {
+            current_list = nullptr;
+            current_single = &args.submit_socket;
+        }
+        else if (arg == "-stop_server") {
+            current_list = nullptr;
+            current_single = &args.stop_server_socket;
+        }
+        else if (arg == "-batch") {
+            current_list = nullptr;
+            current_single = &args.batch_manifest;
+        }
+        else if (arg == "-batch_summary") {
+            current_list = nullptr;
+            current_single = &args.batch_summary;
+        }
+        else if (arg == "-memory_budget_mb") {
+            current_list = nullptr;
+            current_single = nullptr;
+            if (i + 1 < argc) {
+                args.memory_budget_mb = std::atol(argv[++i]);
+            }
+        }
+        else if (arg == "-memory_mb") {
+            current_list = nullptr;
+            current_single = nullptr;
+            if (i + 1 < argc) {
+                args.design_memory_mb = std::atol(argv[++i]);
+            }
+        }
+        else if (arg == "-jobs") {
+            current_list = nullptr;
+            current_single = nullptr;
+            if (i + 1 < argc) {
+                args.jobs = std::atoi(argv[++i]);
+            }
+        }
+        else if (arg == "-quiet") {
+            current_list = nullptr;
+            current_single = nullptr;
+            args.quiet = true;
+        }
         else if (arg.length() > 0 && arg[0] == '-') {
             std::cout << "Warning: Unknown option " << arg << std::endl;
             current_list = nullptr;
@@ -106,4 +287,16 @@ ProgramArguments parse_arguments(int argc, char* argv[]) {
     }
     
     return args;
-}
\ No newline at end of file
+}
+
+ProgramArguments parse_argument_tokens(const std::vector<std::string>& tokens) {
+    if (tokens.empty()) return ProgramArguments();   // parse_arguments在argc < 2時會exit
+    
+    std::vector<char*> argv;
+    std::string program = "job";
+    argv.push_back(&program[0]);
+    for (const auto& token : tokens) {
+        argv.push_back(const_cast<char*>(token.c_str()));
+    }
+    return parse_arguments(static_cast<int>(argv.size()), argv.data());
+}
@@ -3,6 +3,8 @@
 #include <vector>
 #include <unordered_map>
 #include <iostream>
+#include "checkpoint.hpp"
+#include "banking_parameters.hpp"
 
 // =============================================================================
 // COMMAND LINE ARGUMENT PARSER FOR ICCAD 2025 COMPETITION FORMAT
@@ -22,40 +24,158 @@ struct ProgramArguments {
     std::vector<std::string> lef_files;
     std::vector<std::string> db_files;        // 將被忽略
     std::vector<std::string> tf_files;        // 將被忽略
-    std::vector<std::string> sdc_files;       // 將被忽略
+    std::vector<std::string> sdc_files;       // 只讀create_clock / create_generated_clock
     std::vector<std::string> verilog_files;
     std::vector<std::string> def_files;
     std::string output_name;
+    std::string profile_file;                 // -profile: per-step timing JSON (optional)
+    std::string trace_file;                   // -trace: Chrome trace-event JSON (optional)
+    std::string log_level = "info";           // -log_level: error | warn | info | debug
+    bool quiet = false;                       // -quiet: only warnings and errors
+    int threads = 0;                          // -threads: worker threads incl. main (0 = all cores)
+    double time_budget = 0.0;                 // -time_budget: wall-clock seconds for the run (0 = unlimited)
+    BankingParameters banking_params;         // -param <name>=<value> (repeatable)
+    std::string param_error;                  // First bad -param, reported by validate()
+    bool autotune = false;                    // -autotune: search banking parameters instead of one run
+    int autotune_candidates = 0;              // -autotune_candidates: configurations in the first round (0 = default)
+    bool out_of_core = false;                 // -out_of_core: keep combinational cells on disk (mmap), only FFs in memory
+    int tiles = 0;                            // -tiles: banking / legalization in N tile worker processes (0/1 = off)
+    int tile_workers = 0;                     // -tile_workers: concurrent tile workers (0 = min(tiles, cores))
+    long tile_halo = 0;                       // -tile_halo: boundary fix-up band in DBU (0 = largest banking distance)
+    bool tile_worker = false;                 // -tile_worker: internal, one tile (stops after --checkpoint-after)
+    std::string compress_output;              // -compress_output: gz / zst appended to the .v / .def / .list outputs
+    bool scan_reorder = true;                 // -no_scan_reorder: keep the banked scan chains as stitched by banking
+    std::string checkpoint_after;             // --checkpoint-after: write a checkpoint after this step
+    std::string resume_from;                  // --resume-from: start from a checkpoint instead of parsing
+    std::string report_dir;                   // Debug reports directory (server jobs: next to -out)
+    bool write_reports = true;                // false: skip debug report files (libmbff)
+    std::string server_socket;                // -server: keep libraries loaded, serve jobs on this socket
+    std::string submit_socket;                // -submit: send this design as a job to a server
+    std::string stop_server_socket;           // -stop_server: ask a server to exit
+    int jobs = 2;                             // -jobs: concurrent server jobs / batch designs
+    std::string batch_manifest;               // -batch: one design per line, library parsed once
+    std::string batch_summary;                // -batch_summary: combined runtime/QoR table as CSV
+    long memory_budget_mb = 0;                // -memory_budget_mb: memory for concurrent batch designs (0 = 80% of RAM)
+    long design_memory_mb = 0;                // -memory_mb (manifest line): this design's budget (0 = estimate)
     
     // 驗證所有必要檔案是否存在
     bool validate() const {
         bool valid = true;
         
-        if (weight_file.empty()) {
+        // 從checkpoint繼續時輸入檔已經在checkpoint裡 (DEF writer改用記錄的DEF路徑)
+        // -server 只載入library；-submit 只送design檔 (library在server上)
+        // -batch 的design在manifest裡
+        bool client_only = !stop_server_socket.empty();
+        bool needs_library = resume_from.empty() && submit_socket.empty() && !client_only;
+        bool needs_design = resume_from.empty() && server_socket.empty() && batch_manifest.empty() && !client_only;
+        
+        if (needs_design && weight_file.empty()) {
             std::cout << "Error: No weight file specified" << std::endl;
             valid = false;
         }
         
-        if (lib_files.empty()) {
+        if (needs_library && lib_files.empty()) {
             std::cout << "Error: No library files specified" << std::endl;
             valid = false;
         }
         
-        if (lef_files.empty()) {
+        if (needs_library && lef_files.empty()) {
             std::cout << "Error: No LEF files specified" << std::endl;
             valid = false;
         }
         
-        if (verilog_files.empty()) {
+        if (needs_design && verilog_files.empty()) {
             std::cout << "Error: No Verilog files specified" << std::endl;
             valid = false;
         }
         
-        if (def_files.empty()) {
+        if (needs_design && def_files.empty()) {
             std::cout << "Error: No DEF files specified" << std::endl;
             valid = false;
         }
         
+        if ((!server_socket.empty()) + (!submit_socket.empty()) + (!batch_manifest.empty()) + client_only > 1) {
+            std::cout << "Error: -server, -submit, -stop_server and -batch are exclusive" << std::endl;
+            valid = false;
+        }
+        
+        if ((!server_socket.empty() || !batch_manifest.empty()) && !resume_from.empty()) {
+            std::cout << "Error: --resume-from is a per-job option in server/batch mode (use it with -submit or in the manifest)" << std::endl;
+            valid = false;
+        }
+        
+        if (memory_budget_mb < 0 || design_memory_mb < 0) {
+            std::cout << "Error: memory budgets must be >= 0 MB" << std::endl;
+            valid = false;
+        }
+        
+        if (jobs < 1) {
+            std::cout << "Error: -jobs must be >= 1" << std::endl;
+            valid = false;
+        }
+        
+        if (log_level != "error" && log_level != "warn" && log_level != "info" && log_level != "debug") {
+            std::cout << "Error: Unknown log level " << log_level << std::endl;
+            valid = false;
+        }
+        
+        if (threads < 0) {
+            std::cout << "Error: -threads must be >= 0 (0 = all cores)" << std::endl;
+            valid = false;
+        }
+        
+        if (!param_error.empty()) {
+            std::cout << "Error: " << param_error << std::endl;
+            valid = false;
+        }
+        
+        if (autotune_candidates < 0) {
+            std::cout << "Error: -autotune_candidates must be >= 0" << std::endl;
+            valid = false;
+        }
+        
+        if (autotune && (!server_socket.empty() || !submit_socket.empty())) {
+            std::cout << "Error: -autotune runs locally (single design or -batch)" << std::endl;
+            valid = false;
+        }
+        
+        if (time_budget < 0.0) {
+            std::cout << "Error: -time_budget must be >= 0 seconds (0 = unlimited)" << std::endl;
+            valid = false;
+        }
+        
+        if (out_of_core && (!checkpoint_after.empty() || !resume_from.empty() || autotune)) {
+            std::cout << "Error: -out_of_core cannot be combined with checkpoints or -autotune" << std::endl;
+            valid = false;
+        }
+        
+        if (tiles < 0 || tile_workers < 0 || tile_halo < 0) {
+            std::cout << "Error: -tiles, -tile_workers and -tile_halo must be >= 0" << std::endl;
+            valid = false;
+        }
+        
+        if (tiles > 1 && (time_budget > 0.0 || autotune || !server_socket.empty() || !submit_socket.empty() ||
+                          !batch_manifest.empty() || tile_worker)) {
+            std::cout << "Error: -tiles runs a single local design (no -time_budget, -autotune, server or batch mode)" << std::endl;
+            valid = false;
+        }
+        
+        if (!compress_output.empty() && compress_output != "gz" && compress_output != "zst") {
+            std::cout << "Error: -compress_output must be gz or zst" << std::endl;
+            valid = false;
+        }
+        
+        if (tile_worker && (resume_from.empty() || checkpoint_after.empty())) {
+            std::cout << "Error: -tile_worker needs --resume-from and --checkpoint-after" << std::endl;
+            valid = false;
+        }
+        
+        if (!checkpoint_after.empty() && checkpoint_step_rank(checkpoint_after) < 0) {
+            std::cout << "Error: Unknown checkpoint step " << checkpoint_after
+                      << " (use 1-16, 18, 18.5, 19 or 19.5)" << std::endl;
+            valid = false;
+        }
+        
         return valid;
     }
     
@@ -75,12 +195,64 @@ struct ProgramArguments {
             std::cout << "TF files (ignored): " << tf_files.size() << std::endl;
         }
         if (!sdc_files.empty()) {
-            std::cout << "SDC files (ignored): " << sdc_files.size() << std::endl;
+            std::cout << "SDC files: " << sdc_files.size() << std::endl;
         }
         
         if (!output_name.empty()) {
             std::cout << "Output name: " << output_name << std::endl;
         }
+        if (!profile_file.empty()) {
+            std::cout << "Profile JSON: " << profile_file << std::endl;
+        }
+        if (!trace_file.empty()) {
+            std::cout << "Trace JSON: " << trace_file << std::endl;
+        }
+        if (log_level != "info") {
+            std::cout << "Log level: " << log_level << std::endl;
+        }
+        if (threads > 0) {
+            std::cout << "Threads: " << threads << std::endl;
+        }
+        if (time_budget > 0.0) {
+            std::cout << "Time budget: " << time_budget << " s" << std::endl;
+        }
+        for (const auto& assignment : banking_parameter_assignments(banking_params)) {
+            std::cout << "Parameter: " << assignment << std::endl;
+        }
+        if (autotune) {
+            std::cout << "Autotune: on" << std::endl;
+        }
+        if (out_of_core) {
+            std::cout << "Out-of-core netlist: on" << std::endl;
+        }
+        if (tiles > 1) {
+            std::cout << "Tiles: " << tiles << " (workers: " << (tile_workers > 0 ? std::to_string(tile_workers) : "auto")
+                      << ", halo: " << (tile_halo > 0 ? std::to_string(tile_halo) + " DBU" : "auto") << ")" << std::endl;
+        }
+        if (tile_worker) {
+            std::cout << "Tile worker: on" << std::endl;
+        }
+        if (!compress_output.empty()) {
+            std::cout << "Compressed output: ." << compress_output << std::endl;
+        }
+        if (!scan_reorder) {
+            std::cout << "Scan chain reordering: off" << std::endl;
+        }
+        if (!checkpoint_after.empty()) {
+            std::cout << "Checkpoint after step: " << checkpoint_after << std::endl;
+        }
+        if (!resume_from.empty()) {
+            std::cout << "Resume from: " << resume_from << std::endl;
+        }
+        if (!server_socket.empty()) {
+            std::cout << "Server socket: " << server_socket << " (" << jobs << " concurrent jobs)" << std::endl;
+        }
+        if (!submit_socket.empty()) {
+            std::cout << "Submit to: " << submit_socket << std::endl;
+        }
+        if (!batch_manifest.empty()) {
+            std::cout << "Batch manifest: " << batch_manifest << " (" << jobs << " concurrent designs)" << std::endl;
+        }
         std::cout << std::endl;
     }
 };
@@ -88,5 +260,8 @@ struct ProgramArguments {
 // 解析命令行參數
 ProgramArguments parse_arguments(int argc, char* argv[]);
 
+// 同parse_arguments，參數來自server request / batch manifest (不含程式名稱)
+ProgramArguments parse_argument_tokens(const std::vector<std::string>& tokens);
+
 // 顯示使用說明
 void print_usage(const char* program_name);
\ No newline at end of file
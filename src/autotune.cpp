@@ -0,0 +1,267 @@
+#include "autotune.hpp"
+#include "data_structures.hpp"
+#include "flow.hpp"
+#include "checkpoint.hpp"
+#include "task_graph.hpp"
+#include "thread_pool.hpp"
+#include "profiler.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 抽樣用的距離門檻 (DBU)；預設值10000在中間，往兩邊各約一個數量級
+const double DISTANCE_CHOICES[] = {1000.0, 2000.0, 5000.0, 10000.0, 20000.0, 50000.0, 100000.0};
+const size_t DISTANCE_CHOICE_COUNT = sizeof(DISTANCE_CHOICES) / sizeof(DISTANCE_CHOICES[0]);
+
+struct Evaluation {
+    DesignQoR qor;
+    bool ok = false;
+    std::string error;
+    // design objective加上放不下的FF重罰；displacement不進分數 (DBU和cost不同尺度)
+    double score() const {
+        if (!ok) return std::numeric_limits<double>::max();
+        return qor.weighted_cost + AUTOTUNE_UNPLACED_PENALTY * qor.unplaced_ffs;
+    }
+    // 分數相同時displacement小的優先
+    bool better_than(const Evaluation& other) const {
+        if (score() != other.score()) return score() < other.score();
+        return ok && qor.displacement < other.qor.displacement;
+    }
+};
+
+bool same_distances(const BankingParameters& a, const BankingParameters& b) {
+    return a.fsdn2_distance == b.fsdn2_distance && a.fsdn4_distance == b.fsdn4_distance &&
+           a.lsrdpq4_distance == b.lsrdpq4_distance;
+}
+
+// 候選0是命令列的設定；其餘以固定seed抽樣，不重複
+std::vector<BankingParameters> sample_candidates(const BankingParameters& baseline, size_t count) {
+    std::vector<BankingParameters> candidates(1, baseline);
+    std::mt19937 rng(AUTOTUNE_SEED);
+    size_t attempts = 0;
+    while (candidates.size() < count && attempts++ < count * 20) {
+        BankingParameters candidate = baseline;
+        candidate.fsdn2_distance = DISTANCE_CHOICES[rng() % DISTANCE_CHOICE_COUNT];
+        candidate.fsdn4_distance = DISTANCE_CHOICES[rng() % DISTANCE_CHOICE_COUNT];
+        candidate.lsrdpq4_distance = DISTANCE_CHOICES[rng() % DISTANCE_CHOICE_COUNT];
+        bool duplicate = false;
+        for (const auto& existing : candidates) duplicate = duplicate || same_distances(existing, candidate);
+        if (!duplicate) candidates.push_back(candidate);
+    }
+    return candidates;
+}
+
+std::string describe(const BankingParameters& params) {
+    std::ostringstream text;
+    text << "fsdn2=" << params.fsdn2_distance << " fsdn4=" << params.fsdn4_distance
+         << " lsrdpq4=" << params.lsrdpq4_distance;
+    return text.str();
+}
+
+// 從共用checkpoint跑一個候選 (steps 17-19，不寫任何檔案)
+Evaluation evaluate_candidate(const ProgramArguments& run_args, const std::string& checkpoint,
+                              const BankingParameters& params, double fraction, ThreadPool& pool) {
+    Evaluation evaluation;
+    try {
+        DesignDatabase db;
+        std::string step;
+        if (!load_checkpoint(checkpoint, db, step)) throw std::runtime_error("cannot load " + checkpoint);
+
+        ProgramArguments candidate_args = run_args;
+        candidate_args.banking_params = params;
+        candidate_args.banking_params.banking_group_fraction = fraction;
+        DiscardStreambuf discard;
+        run_banking_flow(candidate_args, db, pool, checkpoint_step_rank(step), checkpoint_step_rank("19"), &discard);
+
+        evaluation.qor = measure_design_qor(db);
+        evaluation.ok = true;
+    } catch (const std::exception& e) {
+        evaluation.error = e.what();
+    }
+    return evaluation;
+}
+
+} // namespace
+
+// =============================================================================
+// AUTOTUNE ONE DESIGN
+// =============================================================================
+
+AutotuneResult autotune_design(const ProgramArguments& design, const DesignDatabase* library, ThreadPool& pool) {
+    ScopedTimer tune_timer("Autotune");
+    AutotuneResult result;
+    std::string prefix = design.output_name.empty() ? "output" : design.output_name;
+    std::string checkpoint = prefix + "_autotune" + CHECKPOINT_EXTENSION;
+    int base_rank = checkpoint_step_rank(AUTOTUNE_BASE_STEP);
+
+    // 所有tuning執行都不寫debug report、不受 -time_budget / checkpoint選項影響
+    ProgramArguments run_args = design;
+    run_args.write_reports = false;
+    run_args.time_budget = 0.0;
+    run_args.checkpoint_after.clear();
+
+    // --- Steps 1-16 once → shared checkpoint -------------------------------
+    {
+        ScopedTimer base_timer("Autotune: steps 1-" AUTOTUNE_BASE_STEP);
+        DesignDatabase db;
+        db.design_name = "ICCAD_2025_Design";
+        int completed_rank = -1;
+        if (!design.resume_from.empty()) {
+            std::string resumed_step;
+            if (!load_checkpoint(design.resume_from, db, resumed_step)) {
+                throw std::runtime_error("cannot resume from " + design.resume_from);
+            }
+            completed_rank = checkpoint_step_rank(resumed_step);
+            if (completed_rank > base_rank) {
+                throw std::runtime_error("autotune needs a checkpoint from step " AUTOTUNE_BASE_STEP
+                                         " or earlier, got step " + resumed_step);
+            }
+        } else if (library) {
+            share_cell_library(*library, db);
+            completed_rank = checkpoint_step_rank("2");
+        }
+
+        DiscardStreambuf discard;
+        int linked_rank = checkpoint_step_rank("6");
+        if (completed_rank < linked_rank) {
+            run_banking_flow(run_args, db, pool, completed_rank, linked_rank, &discard);
+            completed_rank = linked_rank;
+        }
+        result.linked = measure_design_qor(db);
+        run_banking_flow(run_args, db, pool, completed_rank, base_rank, &discard);
+        if (!save_checkpoint(db, AUTOTUNE_BASE_STEP, checkpoint)) {
+            throw std::runtime_error("cannot write " + checkpoint);
+        }
+        base_timer.set_items(db.instances.size());
+    }
+
+    // --- Successive halving ------------------------------------------------
+    size_t count = design.autotune_candidates > 0 ? design.autotune_candidates : AUTOTUNE_DEFAULT_CANDIDATES;
+    std::vector<BankingParameters> candidates = sample_candidates(design.banking_params, count);
+    int rounds = 0;
+    for (size_t n = candidates.size(); n > 1; n = (n + AUTOTUNE_ETA - 1) / AUTOTUNE_ETA) rounds++;
+
+    std::cout << "\n🎛️  Autotuning " << prefix << ": " << candidates.size() << " candidates, "
+              << rounds + 1 << " rounds (keep 1/" << AUTOTUNE_ETA << " per round)" << std::endl;
+
+    std::vector<Evaluation> evaluations(candidates.size());
+    std::vector<size_t> alive(candidates.size());
+    for (size_t i = 0; i < alive.size(); i++) alive[i] = i;
+
+    for (int round = 0; round <= rounds; round++) {
+        double fraction = std::pow(static_cast<double>(AUTOTUNE_ETA), round - rounds);
+        // 最後一輪也跑baseline，才能和完整design的結果比較
+        std::vector<size_t> batch = alive;
+        if (round == rounds && std::find(batch.begin(), batch.end(), size_t(0)) == batch.end()) {
+            batch.push_back(0);
+        }
+
+        // 同一輪的候選最多 -jobs 個同時執行
+        std::atomic<size_t> next(0);
+        auto worker = [&]() {
+            for (size_t slot = next++; slot < batch.size(); slot = next++) {
+                size_t id = batch[slot];
+                evaluations[id] = evaluate_candidate(run_args, checkpoint, candidates[id], fraction, pool);
+            }
+        };
+        int workers = std::max(1, std::min<int>(design.jobs, static_cast<int>(batch.size())));
+        std::vector<std::thread> threads;
+        for (int i = 1; i < workers; i++) threads.emplace_back(worker);
+        worker();
+        for (auto& thread : threads) thread.join();
+        result.evaluations += static_cast<int>(batch.size());
+
+        std::stable_sort(batch.begin(), batch.end(), [&](size_t a, size_t b) {
+            return evaluations[a].better_than(evaluations[b]);
+        });
+
+        std::cout << "  Round " << round + 1 << ": " << std::fixed << std::setprecision(1) << fraction * 100.0
+                  << "% of FF groups, " << batch.size() << " runs" << std::endl;
+        for (size_t id : batch) {
+            std::cout << "    #" << std::setw(2) << id << "  ";
+            if (evaluations[id].ok) {
+                std::cout << "score " << std::setw(14) << std::setprecision(2) << evaluations[id].score()
+                          << "  cost " << std::setw(14) << evaluations[id].qor.weighted_cost
+                          << "  MBFFs " << std::setw(7) << evaluations[id].qor.multibit_instances
+                          << "  unplaced " << std::setw(5) << evaluations[id].qor.unplaced_ffs;
+            } else {
+                std::cout << "FAILED (" << evaluations[id].error << ")";
+            }
+            std::cout << "  " << describe(candidates[id]) << (id == 0 ? "  [baseline]" : "") << std::endl;
+        }
+        std::cout.unsetf(std::ios::fixed);
+
+        if (round < rounds) {
+            std::vector<size_t> survivors;
+            size_t keep = (alive.size() + AUTOTUNE_ETA - 1) / AUTOTUNE_ETA;
+            for (size_t id : batch) {
+                if (survivors.size() == keep) break;
+                if (std::find(alive.begin(), alive.end(), id) != alive.end()) survivors.push_back(id);
+            }
+            alive = survivors;
+        } else {
+            alive = batch;   // 最後一輪含baseline，依完整design的cost排序
+        }
+    }
+    std::remove(checkpoint.c_str());
+
+    size_t best = alive.front();
+    if (!evaluations[best].ok) throw std::runtime_error("every candidate failed: " + evaluations[best].error);
+    if (!evaluations[0].ok) throw std::runtime_error("baseline run failed: " + evaluations[0].error);
+    result.best = candidates[best];
+    result.best.banking_group_fraction = 1.0;
+    result.baseline = evaluations[0].qor;
+    result.tuned = evaluations[best].qor;
+    tune_timer.set_items(result.evaluations);
+
+    double change = result.baseline.weighted_cost > 0.0
+        ? 100.0 * (result.tuned.weighted_cost - result.baseline.weighted_cost) / result.baseline.weighted_cost : 0.0;
+    std::string flags = banking_parameter_flags(result.best);
+    std::cout << "  🏆 Best for " << prefix << ": " << (flags.empty() ? "(defaults)" : flags) << std::endl;
+    std::cout << "     cost " << std::fixed << std::setprecision(2) << result.baseline.weighted_cost << " -> "
+              << result.tuned.weighted_cost << " (" << change << "%), " << result.evaluations << " runs"
+              << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+
+    std::string params_file = prefix + "_autotune.params";
+    std::ofstream params_out(params_file);
+    if (params_out.is_open()) {
+        params_out << flags << "\n";
+        std::cout << "     written to " << params_file << std::endl;
+    } else {
+        LOG_WARN << "Cannot write " << params_file;
+    }
+    return result;
+}
+
+// =============================================================================
+// -autotune (single design)
+// =============================================================================
+
+int run_autotune(const ProgramArguments& args) {
+    ThreadPool& pool = ThreadPool::instance();
+    pool.resize(args.threads);
+
+    // 同時執行的候選各自的stage輸出整段處理 (不交錯)
+    StageOutputScope routing;
+    try {
+        autotune_design(args, nullptr, pool);
+    } catch (const std::exception& e) {
+        LOG_ERROR << "❌ Autotune: " << e.what();
+        return 1;
+    }
+    return 0;
+}
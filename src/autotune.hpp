@@ -0,0 +1,46 @@
+#ifndef AUTOTUNE_HPP
+#define AUTOTUNE_HPP
+
+#include "argument_parser.hpp"
+#include "batch.hpp"
+#include <string>
+
+class DesignDatabase;
+class ThreadPool;
+
+// =============================================================================
+// BANKING PARAMETER AUTOTUNER (-autotune)
+// =============================================================================
+// 1. Steps 1-16 (parse → substitution → banking types + regroup) 只跑一次，
+//    結果存成共用的checkpoint (<out>_autotune.mbffckpt，結束後刪除)
+// 2. 候選參數：命令列的 -param 設定 (baseline) + 固定seed抽樣的距離門檻組合
+// 3. Successive halving：第r輪每個候選從checkpoint載入，只bank前 ETA^(r-R) 比例
+//    的FF group (banking_group_fraction)，跑到step 19 (legalization，不寫檔)，
+//    依 beta*power + gamma*area + 放不下的FF罰分 排序 (同分時displacement小的優先)
+//    留下前 1/ETA；最後一輪跑完整design
+//    同一輪的候選最多 -jobs 個同時執行，共用thread pool
+// 4. 印出每輪排名和最佳參數 (-param ...)，另存到 <out>_autotune.params
+// -batch 時每個design各自tune，總表列出每個design的最佳參數
+// =============================================================================
+
+#define AUTOTUNE_DEFAULT_CANDIDATES 16
+#define AUTOTUNE_ETA 2                  // Keep 1/ETA of the candidates each round
+#define AUTOTUNE_SEED 2025              // Candidate sampling is reproducible
+#define AUTOTUNE_BASE_STEP "16"         // Shared checkpoint: everything before strategic banking
+#define AUTOTUNE_UNPLACED_PENALTY 1.0e6 // Score added per FF left unplaced by legalization
+
+struct AutotuneResult {
+    BankingParameters best;             // Full-design winner (banking_group_fraction = 1)
+    DesignQoR linked;                   // After step 6, before any optimization
+    DesignQoR baseline;                 // Command-line -param values, full design
+    DesignQoR tuned;                    // `best`, full design
+    int evaluations = 0;                // Candidate runs over all rounds
+};
+
+// Tune one design; `library` holds steps 1-2 (nullptr: parse -lib/-lef here). Throws on errors.
+AutotuneResult autotune_design(const ProgramArguments& design, const DesignDatabase* library, ThreadPool& pool);
+
+// -autotune for the design on the command line; returns the process exit status
+int run_autotune(const ProgramArguments& args);
+
+#endif // AUTOTUNE_HPP
@@ -6,16 +6,14 @@
 // =============================================================================
 
 #include "parsers.hpp"
+#include "time_budget.hpp"
+#include "placement_capacity.hpp"
 #include <iostream>
 #include <algorithm>
 #include <fstream>
 #include <iomanip>
 #include <set>
 
-#define FSDN_2BIT_BANKING_distance 10000.0
-#define FSDN_4BIT_BANKING_distance 10000.0
-#define LSRDPQ_4BIT_BANKING_distance 10000.0
-
 // =============================================================================
 // BANKING OPERATION TRACKING STRUCTURE
 // =============================================================================
@@ -24,43 +22,16 @@ struct BankingOperation {
     std::vector<std::shared_ptr<Instance>> source_instances;
     std::string result_instance_name;
     std::string target_cell_type;
-    std::map<std::string, std::string> pin_mapping;
     std::string operation_type; // "DEBANK_CLUSTER_REBANK", "FSDN_2BIT_BANKING", "FSDN_4BIT_BANKING", "LSRDPQ_4BIT_BANKING"
 };
 
-// Global banking operations collector
-static std::vector<BankingOperation> banking_operations;
+// Banking operations collector
+// Step 18整個在同一個stage (同一個thread) 內填入、記錄、清空；thread_local讓
+// server mode 同時跑的多個design各用各的
+static thread_local std::vector<BankingOperation> banking_operations;
 
 // Track original 1-bit sources for complete pin mapping
-static std::map<std::string, std::vector<std::shared_ptr<Instance>>> original_sources_map;
-
-// Generate complete pin mapping from original single-bit FFs to final multi-bit FF
-void generate_complete_banking_pin_mapping(
-    const std::vector<std::shared_ptr<Instance>>& original_sources,
-    std::shared_ptr<Instance> final_multibit_ff,
-    std::map<std::string, std::string>& pin_mapping) {
-
-        for (size_t i = 0; i < original_sources.size(); i++) {
-            const auto& source = original_sources[i];
-
-            // Map each pin from original FF to corresponding multi-bit pin
-            for (const auto& conn : source->connections) {
-                std::string original_pin = source->name + "/" + conn.pin_name;
-                std::string final_pin;
-
-                // Data pins get bit indexing
-                if (conn.pin_name == "D" || conn.pin_name == "Q" || conn.pin_name == "QN") {
-                    final_pin = final_multibit_ff->name + "/" + conn.pin_name + "[" + std::to_string(i) + "]";
-                }
-                // Shared pins (CK, SI, SE, R, S) don't get bit indexing
-                else {
-                    final_pin = final_multibit_ff->name + "/" + conn.pin_name;
-                }
-
-                pin_mapping[original_pin] = final_pin;
-            }
-      }
-  }
+static thread_local std::map<std::string, std::vector<std::shared_ptr<Instance>>> original_sources_map;
 
 // Process remaining 2-bit FFs that couldn't be banked to 4-bit
 void finalize_2bit_banking_records() {
@@ -92,7 +63,6 @@ void finalize_2bit_banking_records() {
             op.source_instances = original_sources;
             op.result_instance_name = twobit_name;
             op.target_cell_type = ""; // Will be filled from actual instance
-            op.pin_mapping = std::map<std::string, std::string>(); // Will be generated in record phase
             op.operation_type = "FSDN_2BIT_BANKING";
             banking_operations.push_back(op);
         }
@@ -426,11 +396,9 @@ int count_ff_instances(const DesignDatabase& db) {
 // =============================================================================
 
 // Calculate Manhattan distance between two instances
-double manhattan_distance(const std::shared_ptr<Instance>& inst1, 
-                         const std::shared_ptr<Instance>& inst2) {
-    double dx = std::abs(inst1->position.x - inst2->position.x);
-    double dy = std::abs(inst1->position.y - inst2->position.y);
-    return dx + dy;
+Dbu manhattan_distance(const std::shared_ptr<Instance>& inst1, 
+                       const std::shared_ptr<Instance>& inst2) {
+    return inst1->position.manhattan_to(inst2->position);
 }
 
 // Simple distance threshold clustering for banking
@@ -454,7 +422,7 @@ simple_distance_clustering(const std::vector<std::shared_ptr<Instance>>& instanc
         for (size_t j = i + 1; j < instances.size() && cluster.size() < (size_t)target_cluster_size; j++) {
             if (used[j]) continue;
             
-            double dist = manhattan_distance(instances[i], instances[j]);
+            Dbu dist = manhattan_distance(instances[i], instances[j]);
             if (dist <= max_distance_threshold) {
                 cluster.push_back(instances[j]);
                 used[j] = true;
@@ -470,6 +438,12 @@ simple_distance_clustering(const std::vector<std::shared_ptr<Instance>>& instanc
     return clusters;
 }
 
+// -param banking_group_fraction: 只處理前面這個比例的group (key順序固定，
+// autotuner的successive halving用它控制每一輪的工作量)
+size_t banking_group_limit(const DesignDatabase& db, size_t group_count) {
+    return static_cast<size_t>(std::ceil(db.banking_params.banking_group_fraction * group_count));
+}
+
 // Helper function to map 2-bit connections to 4-bit pins
 void map_2bit_to_4bit_connections(const std::vector<std::shared_ptr<Instance>>& twobit_instances,
                                  std::shared_ptr<Instance> fourbit_instance,
@@ -485,36 +459,32 @@ void map_2bit_to_4bit_connections(const std::vector<std::shared_ptr<Instance>>&
         auto& twobit = twobit_instances[i];
         
         for (const auto& conn : twobit->connections) {
+            std::string fourbit_pin;
             if (conn.pin_name == "D0") {
-                fourbit_instance->connections.push_back({
-                    "D" + std::to_string(i * 2), conn.net_name
-                });
+                fourbit_pin = "D" + std::to_string(i * 2);
             } else if (conn.pin_name == "D1") {
-                fourbit_instance->connections.push_back({
-                    "D" + std::to_string(i * 2 + 1), conn.net_name
-                });
+                fourbit_pin = "D" + std::to_string(i * 2 + 1);
             } else if (conn.pin_name == "Q0") {
-                fourbit_instance->connections.push_back({
-                    "Q" + std::to_string(i * 2), conn.net_name
-                });
+                fourbit_pin = "Q" + std::to_string(i * 2);
             } else if (conn.pin_name == "Q1") {
-                fourbit_instance->connections.push_back({
-                    "Q" + std::to_string(i * 2 + 1), conn.net_name
-                });
+                fourbit_pin = "Q" + std::to_string(i * 2 + 1);
             } else if (conn.pin_name == "QN0") {
-                fourbit_instance->connections.push_back({
-                    "QN" + std::to_string(i * 2), conn.net_name
-                });
+                fourbit_pin = "QN" + std::to_string(i * 2);
             } else if (conn.pin_name == "QN1") {
-                fourbit_instance->connections.push_back({
-                    "QN" + std::to_string(i * 2 + 1), conn.net_name
-                });
+                fourbit_pin = "QN" + std::to_string(i * 2 + 1);
             } else {
                 // Shared pins (CK, SI, SE, R, S, etc.) - use first instance's connection
                 if (i == 0) {
                     fourbit_instance->connections.push_back(conn);
                 }
+                db.pin_provenance.forward_pin(twobit->name, conn.pin_name,
+                                              fourbit_instance->name, conn.pin_name);
+                continue;
             }
+            
+            fourbit_instance->connections.push_back({fourbit_pin, conn.net_name});
+            db.pin_provenance.forward_pin(twobit->name, conn.pin_name,
+                                          fourbit_instance->name, fourbit_pin);
         }
     }
 }
@@ -533,13 +503,14 @@ int execute_1bit_to_2bit_banking(DesignDatabase& db, const std::string& group_ke
         return 0;
     }
     
-    // Use spatial clustering to find pairs (distance threshold: 5000)
-    auto two_bit_clusters = simple_distance_clustering(fsdn_instances, 2, FSDN_2BIT_BANKING_distance);
+    // Use spatial clustering to find pairs (distance threshold: -param fsdn2_distance)
+    auto two_bit_clusters = simple_distance_clustering(fsdn_instances, 2, db.banking_params.fsdn2_distance);
     
-    static int ff_counter = 1;
+    int& ff_counter = db.banking_name_counters.fsdn2;
     int created_2bit = 0;
     
     for (const auto& cluster : two_bit_clusters) {
+        if (time_budget_expired(db)) break;
         if (cluster.size() != 2) continue;  // Only process exact pairs
         
         // Find target 2-bit FSDN FF using instances in cluster
@@ -560,9 +531,9 @@ int execute_1bit_to_2bit_banking(DesignDatabase& db, const std::string& group_ke
         
         std::string optimal_ff = optimal_it->second;
         
-        // Calculate center position
-        double center_x = (cluster[0]->position.x + cluster[1]->position.x) / 2.0;
-        double center_y = (cluster[0]->position.y + cluster[1]->position.y) / 2.0;
+        // Calculate center position (DBU, rounded down; legalization snaps to sites anyway)
+        Dbu center_x = floor_div(cluster[0]->position.x + cluster[1]->position.x, 2);
+        Dbu center_y = floor_div(cluster[0]->position.y + cluster[1]->position.y, 2);
         
         // Create new 2-bit instance with proper hierarchy naming
         auto new_2bit = std::make_shared<Instance>();
@@ -627,7 +598,7 @@ int execute_1bit_to_2bit_banking(DesignDatabase& db, const std::string& group_ke
 }
 
 // Phase 2: 2-bit FSDN → 4-bit FSDN Banking  
-int execute_2bit_to_4bit_banking(DesignDatabase& db, const std::string& group_key) {
+int execute_2bit_to_4bit_banking(DesignDatabase& db, const std::string& group_key, RowGapCapacity& capacity) {
     
     // CORRECTED: Phase 2 should ONLY process 2-bit FSDN instances in this specific group
     std::vector<std::shared_ptr<Instance>> twobit_instances;
@@ -659,13 +630,14 @@ int execute_2bit_to_4bit_banking(DesignDatabase& db, const std::string& group_ke
     }
     
     
-    // Use spatial clustering to find pairs (distance threshold: 8000)
-    auto four_bit_clusters = simple_distance_clustering(twobit_instances, 2, FSDN_4BIT_BANKING_distance);
+    // Use spatial clustering to find pairs (distance threshold: -param fsdn4_distance)
+    auto four_bit_clusters = simple_distance_clustering(twobit_instances, 2, db.banking_params.fsdn4_distance);
     
-    static int ff_counter_4bit = 1;
+    int& ff_counter_4bit = db.banking_name_counters.fsdn4;
     int created_4bit = 0;
     
     for (const auto& cluster : four_bit_clusters) {
+        if (time_budget_expired(db)) break;
         if (cluster.size() != 2) continue;  // Only process exact pairs
         
         // Find target 4-bit FSDN FF using instances in cluster
@@ -686,9 +658,15 @@ int execute_2bit_to_4bit_banking(DesignDatabase& db, const std::string& group_ke
         
         std::string optimal_ff = optimal_it->second;
         
-        // Calculate center position
-        double center_x = (cluster[0]->position.x + cluster[1]->position.x) / 2.0;
-        double center_y = (cluster[0]->position.y + cluster[1]->position.y) / 2.0;
+        // Calculate center position (DBU, rounded down; legalization snaps to sites anyway)
+        Dbu center_x = floor_div(cluster[0]->position.x + cluster[1]->position.x, 2);
+        Dbu center_y = floor_div(cluster[0]->position.y + cluster[1]->position.y, 2);
+        
+        // 附近沒有夠寬的row空隙：保持兩個2-bit (placement_capacity.hpp)
+        const auto& fourbit_template = db.cell_library[optimal_ff];
+        if (!capacity.reserve(Point(center_x, center_y), fourbit_template->width, fourbit_template->bit_width)) {
+            continue;
+        }
         
         // Create new 4-bit instance with proper hierarchy naming
         auto new_4bit = std::make_shared<Instance>();
@@ -754,16 +732,11 @@ int execute_2bit_to_4bit_banking(DesignDatabase& db, const std::string& group_ke
             }
          }
 
-        // Generate complete pin mapping from original 1-bit to final 4-bit
-        std::map<std::string, std::string> complete_pin_mapping;
-        generate_complete_banking_pin_mapping(all_original_sources, new_4bit, complete_pin_mapping);
-
         // Record final banking operation (1-bit sources → 4-bit result)
         BankingOperation op;
         op.source_instances = all_original_sources;
         op.result_instance_name = new_4bit->name;
         op.target_cell_type = optimal_ff;
-        op.pin_mapping = complete_pin_mapping;
         op.operation_type = "FSDN_4BIT_BANKING";
         banking_operations.push_back(op);
     }
@@ -790,8 +763,14 @@ void execute_fsdn_two_phase_banking(DesignDatabase& db) {
     int total_4bit_created = 0;
     int initial_fsdn_count = 0;
     
-    // Process each ff_instance_group
+    // 4-bit cell要預留row空隙 (placement_capacity.hpp)
+    RowGapCapacity capacity(db);
+    
+    // Process each ff_instance_group (-time_budget到期後剩下的group保持未banking)
+    size_t group_limit = banking_group_limit(db, db.ff_instance_groups.size());
+    size_t group_index = 0;
     for (auto& group_pair : db.ff_instance_groups) {
+        if (group_index++ >= group_limit || time_budget_expired(db)) break;
         const std::string& group_key = group_pair.first;
         const auto& group_instances = group_pair.second;
         
@@ -811,12 +790,16 @@ void execute_fsdn_two_phase_banking(DesignDatabase& db) {
         
         // Phase 2: 2-bit → 4-bit Banking (only if we created 2-bit FFs)
         if (created_2bit > 0) {
-            int created_4bit = execute_2bit_to_4bit_banking(db, group_key);
+            int created_4bit = execute_2bit_to_4bit_banking(db, group_key, capacity);
             total_4bit_created += created_4bit;
         }
         
     }
     
+    if (capacity.refused() > 0) {
+        std::cout << "  " << capacity.refused() << " 4-bit pairs kept as 2-bit (no row gap nearby)" << std::endl;
+    }
+    
     // Finalize remaining 2-bit banking records for FFs that couldn't be banked to 4-bit
     std::cout << "  Finalizing 2-bit banking records..." << std::endl;
     finalize_2bit_banking_records();
@@ -875,7 +858,7 @@ std::vector<std::shared_ptr<Instance>> collect_lsrdpq_instances_for_group(
 }
 
 // Single-Phase: 1-bit LSRDPQ/FDP → 4-bit LSRDPQ Banking
-int execute_lsrdpq_4bit_banking(DesignDatabase& db, const std::string& group_key) {
+int execute_lsrdpq_4bit_banking(DesignDatabase& db, const std::string& group_key, RowGapCapacity& capacity) {
     
     // Collect 1-bit LSRDPQ/FDP instances for this group
     auto lsrdpq_instances = collect_lsrdpq_instances_for_group(db, group_key);
@@ -884,13 +867,14 @@ int execute_lsrdpq_4bit_banking(DesignDatabase& db, const std::string& group_key
         return 0; // Need at least 4 instances for 4-bit banking
     }
     
-    // Use spatial clustering to find groups of 4 (distance threshold: 10000 for 4 instances)
-    auto four_bit_clusters = simple_distance_clustering(lsrdpq_instances, 4, LSRDPQ_4BIT_BANKING_distance);
+    // Use spatial clustering to find groups of 4 (distance threshold: -param lsrdpq4_distance)
+    auto four_bit_clusters = simple_distance_clustering(lsrdpq_instances, 4, db.banking_params.lsrdpq4_distance);
 
-    static int lsrdpq_counter = 1;
+    int& lsrdpq_counter = db.banking_name_counters.lsrdpq4;
     int created_4bit = 0;
     
     for (const auto& cluster : four_bit_clusters) {
+        if (time_budget_expired(db)) break;
         if (cluster.size() != 4) continue;  // Only process exact groups of 4
         
         // Target: RISING|D_Q_QN_CK|4bit group
@@ -903,14 +887,20 @@ int execute_lsrdpq_4bit_banking(DesignDatabase& db, const std::string& group_key
         
         std::string optimal_ff = optimal_it->second;
         
-        // Calculate center position of 4 instances
-        double center_x = 0, center_y = 0;
+        // Calculate center position of 4 instances (DBU, rounded down)
+        Dbu center_x = 0, center_y = 0;
         for (const auto& inst : cluster) {
             center_x += inst->position.x;
             center_y += inst->position.y;
         }
-        center_x /= 4.0;
-        center_y /= 4.0;
+        center_x = floor_div(center_x, 4);
+        center_y = floor_div(center_y, 4);
+        
+        // 附近沒有夠寬的row空隙：這4個FF保持1-bit
+        const auto& fourbit_template = db.cell_library[optimal_ff];
+        if (!capacity.reserve(Point(center_x, center_y), fourbit_template->width, fourbit_template->bit_width)) {
+            continue;
+        }
         
         // Create new 4-bit LSRDPQ instance
         auto new_4bit = std::make_shared<Instance>();
@@ -965,16 +955,11 @@ int execute_lsrdpq_4bit_banking(DesignDatabase& db, const std::string& group_key
         
         created_4bit++;
                  
-        // Generate complete pin mapping from 1-bit to 4-bit
-        std::map<std::string, std::string> complete_pin_mapping;
-        generate_complete_banking_pin_mapping(cluster, new_4bit, complete_pin_mapping);
-        
         // Record banking operation for output generation
         BankingOperation op;
         op.source_instances = cluster;
         op.result_instance_name = new_4bit->name;
         op.target_cell_type = optimal_ff;
-        op.pin_mapping = complete_pin_mapping;
         op.operation_type = "LSRDPQ_4BIT_BANKING";
         banking_operations.push_back(op);
     }
@@ -996,9 +981,13 @@ void execute_lsrdpq_single_phase_banking(DesignDatabase& db) {
     int total_groups_processed = 0;
     int total_4bit_created = 0;
     int initial_lsrdpq_count = 0;
+    RowGapCapacity capacity(db);   // 4-bit cell要預留row空隙 (placement_capacity.hpp)
     
-    // Process each ff_instance_group
+    // Process each ff_instance_group (-time_budget到期後剩下的group保持未banking)
+    size_t group_limit = banking_group_limit(db, db.ff_instance_groups.size());
+    size_t group_index = 0;
     for (auto& group_pair : db.ff_instance_groups) {
+        if (group_index++ >= group_limit || time_budget_expired(db)) break;
         const std::string& group_key = group_pair.first;
         
         // Count initial LSRDPQ instances for this group
@@ -1011,10 +1000,14 @@ void execute_lsrdpq_single_phase_banking(DesignDatabase& db) {
         total_groups_processed++;
         
         // Single-Phase: 1-bit → 4-bit Banking
-        int created_4bit = execute_lsrdpq_4bit_banking(db, group_key);
+        int created_4bit = execute_lsrdpq_4bit_banking(db, group_key, capacity);
         total_4bit_created += created_4bit;
     }
     
+    if (capacity.refused() > 0) {
+        std::cout << "  " << capacity.refused() << " LSRDPQ 4-bit clusters skipped (no row gap nearby)" << std::endl;
+    }
+    
     // Final verification
     int final_ff_count = count_ff_instances(db);
     
@@ -1164,9 +1157,13 @@ void execute_debank_cluster_rebanking(DesignDatabase& db) {
     int total_clusters_processed = 0;
     int total_instances_banked = 0;
     int total_new_mbffs = 0;
+    RowGapCapacity capacity(db);   // 4-bit cell要預留row空隙 (placement_capacity.hpp)
     
     // Process each cluster
+    size_t cluster_limit = banking_group_limit(db, clusters.size());
+    size_t cluster_index = 0;
     for (auto& cluster_pair : clusters) {
+        if (cluster_index++ >= cluster_limit || time_budget_expired(db)) break;
         const std::string& cluster_id = cluster_pair.first;
         auto& instances = cluster_pair.second;
         
@@ -1201,14 +1198,20 @@ void execute_debank_cluster_rebanking(DesignDatabase& db) {
         int target_bit_width = (instances.size() >= 4) ? 4 : 2;
         
         
-        // Calculate center position
-        double center_x = 0, center_y = 0;
+        // Calculate center position (DBU, rounded down)
+        Dbu center_x = 0, center_y = 0;
         for (auto& inst : instances) {
             center_x += inst->position.x;
             center_y += inst->position.y;
         }
-        center_x /= instances.size();
-        center_y /= instances.size();
+        center_x = floor_div(center_x, static_cast<Dbu>(instances.size()));
+        center_y = floor_div(center_y, static_cast<Dbu>(instances.size()));
+        
+        // 附近沒有夠寬的row空隙：留給後面的FSDN / LSRDPQ banking
+        const auto& target_template = db.cell_library[optimal_ff];
+        if (!capacity.reserve(Point(center_x, center_y), target_template->width, target_template->bit_width)) {
+            continue;
+        }
         
         // Create new multi-bit instance
         auto new_mbff = std::make_shared<Instance>();
@@ -1228,33 +1231,10 @@ void execute_debank_cluster_rebanking(DesignDatabase& db) {
         map_singlebit_to_multibit_connections(instances, new_mbff, target_bit_width, db);
         
         // Collect banking operation (do not record yet)
-        std::map<std::string, std::string> pin_mapping;
-        
-        // Generate complete pin mapping for this banking operation
-        for (size_t i = 0; i < instances.size(); i++) {
-            const auto& source = instances[i];
-            for (const auto& conn : source->connections) {
-                std::string original_pin = source->name + "/" + conn.pin_name;
-                std::string final_pin;
-                
-                // Data pins get bit indexing
-                if (conn.pin_name == "D" || conn.pin_name == "Q" || conn.pin_name == "QN") {
-                    final_pin = new_mbff->name + "/" + conn.pin_name + "[" + std::to_string(i) + "]";
-                }
-                // Shared pins (CK, SI, SE, R, S) don't get bit indexing
-                else {
-                    final_pin = new_mbff->name + "/" + conn.pin_name;
-                }
-                
-                pin_mapping[original_pin] = final_pin;
-            }
-        }
-        
         BankingOperation op;
         op.source_instances = instances;
         op.result_instance_name = new_mbff->name;
         op.target_cell_type = optimal_ff;
-        op.pin_mapping = pin_mapping; // Now properly populated
         op.operation_type = "DEBANK_CLUSTER_REBANK";
         banking_operations.push_back(op);
         
@@ -1270,6 +1250,10 @@ void execute_debank_cluster_rebanking(DesignDatabase& db) {
     }
     
     
+    if (capacity.refused() > 0) {
+        std::cout << "  " << capacity.refused() << " clusters not re-banked (no row gap nearby)" << std::endl;
+    }
+    
     // Export "after" state
     // export_banking_step_report(db, "AFTER_DEBANK_CLUSTER_REBANKING", "banking_step1_after.txt");
     
@@ -1294,24 +1278,26 @@ void map_singlebit_to_multibit_connections(const std::vector<std::shared_ptr<Ins
         auto& singlebit = singlebit_instances[i];
         
         for (const auto& conn : singlebit->connections) {
+            std::string multibit_pin;
             if (conn.pin_name == "D") {
-                multibit_instance->connections.push_back({
-                    "D" + std::to_string(i + pin_offset), conn.net_name
-                });
+                multibit_pin = "D" + std::to_string(i + pin_offset);
             } else if (conn.pin_name == "Q") {
-                multibit_instance->connections.push_back({
-                    "Q" + std::to_string(i + pin_offset), conn.net_name
-                });
+                multibit_pin = "Q" + std::to_string(i + pin_offset);
             } else if (conn.pin_name == "QN") {
-                multibit_instance->connections.push_back({
-                    "QN" + std::to_string(i + pin_offset), conn.net_name
-                });
+                multibit_pin = "QN" + std::to_string(i + pin_offset);
             } else {
                 // Shared pins (CK, SI, SE, R, S, etc.) - use first instance's connection
                 if (i == 0) {
                     multibit_instance->connections.push_back(conn);
                 }
+                db.pin_provenance.forward_pin(singlebit->name, conn.pin_name,
+                                              multibit_instance->name, conn.pin_name);
+                continue;
             }
+            
+            multibit_instance->connections.push_back({multibit_pin, conn.net_name});
+            db.pin_provenance.forward_pin(singlebit->name, conn.pin_name,
+                                          multibit_instance->name, multibit_pin);
         }
     }
 }
@@ -1329,24 +1315,17 @@ void record_all_banking_transformations(DesignDatabase& db) {
     for (const auto& op : banking_operations) {
         // Fill in missing information for finalized operations
         std::string target_cell_type = op.target_cell_type;
-        std::map<std::string, std::string> pin_mapping = op.pin_mapping;
         
-        if (target_cell_type.empty() || pin_mapping.empty()) {
+        if (target_cell_type.empty()) {
             // Find the actual result instance to get missing information
             auto result_it = db.instances.find(op.result_instance_name);
             if (result_it != db.instances.end()) {
-                if (target_cell_type.empty()) {
-                    target_cell_type = result_it->second->cell_template->name;
-                }
-                if (pin_mapping.empty()) {
-                    generate_complete_banking_pin_mapping(op.source_instances, result_it->second, pin_mapping);
-                }
+                target_cell_type = result_it->second->cell_template->name;
             }
         }
         
-        // Record bank transformation for each operation
-        record_bank_transformation(db, op.source_instances, op.result_instance_name, 
-                                  target_cell_type, pin_mapping);
+        // Record bank transformation for each operation (pin mapping comes from the source pins)
+        record_bank_transformation(db, op.source_instances, op.result_instance_name, target_cell_type);
         total_source_instances += op.source_instances.size();
     }
     
@@ -1356,23 +1335,10 @@ void record_all_banking_transformations(DesignDatabase& db) {
     
     // Capture BANK stage - all instances after banking operations
     std::cout << "  Capturing BANK stage..." << std::endl;
-    std::vector<std::shared_ptr<Instance>> all_ff_instances;
-    for (const auto& inst_pair : db.instances) {
-        if (inst_pair.second->is_flip_flop()) {
-            all_ff_instances.push_back(inst_pair.second);
-        }
-    }
-    
     // Find all BANK transformation records for this stage
-    std::vector<size_t> bank_indices;
-    for (size_t i = 0; i < db.transformation_history.size(); i++) {
-        if (db.transformation_history[i].operation == TransformationRecord::Operation::BANK) {
-            bank_indices.push_back(i);
-        }
-    }
+    std::vector<size_t> bank_indices = db.transformation_history.indices_of(TransformationRecord::BANK);
     
-    db.complete_pipeline.capture_stage("BANK", all_ff_instances, bank_indices, &db.transformation_history);
-    std::cout << "Captured stage BANK with " << all_ff_instances.size() << " FF instances" << std::endl;
+    db.complete_pipeline.capture_stage("BANK", db.instances, bank_indices, &db.transformation_history);
     
     // Clear operations and tracking maps after recording
     banking_operations.clear();
@@ -0,0 +1,104 @@
+#include "banking_parameters.hpp"
+#include <cstdlib>
+#include <sstream>
+
+// =============================================================================
+// PARAMETER TABLE
+// =============================================================================
+
+namespace {
+
+struct ParameterInfo {
+    const char* name;
+    double BankingParameters::*member;
+    double min_value;
+    double max_value;
+};
+
+const std::vector<ParameterInfo>& parameter_table() {
+    static const std::vector<ParameterInfo> table = {
+        {"fsdn2_distance", &BankingParameters::fsdn2_distance, 0.0, 1e12},
+        {"fsdn4_distance", &BankingParameters::fsdn4_distance, 0.0, 1e12},
+        {"lsrdpq4_distance", &BankingParameters::lsrdpq4_distance, 0.0, 1e12},
+        {"legalization_max_displacement", &BankingParameters::legalization_max_displacement, 0.0, 1e12},
+        {"banking_group_fraction", &BankingParameters::banking_group_fraction, 0.0, 1.0},
+        {"clock_leaf_group_min_ffs", &BankingParameters::clock_leaf_group_min_ffs, 0.0, 1e9},
+    };
+    return table;
+}
+
+const ParameterInfo* find_parameter(const std::string& name) {
+    for (const auto& info : parameter_table()) {
+        if (name == info.name) return &info;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+bool set_banking_parameter(BankingParameters& params, const std::string& name, const std::string& value,
+                           std::string& error) {
+    const ParameterInfo* info = find_parameter(name);
+    if (!info) {
+        error = "Unknown parameter " + name;
+        return false;
+    }
+    char* end = nullptr;
+    double number = std::strtod(value.c_str(), &end);
+    if (value.empty() || *end != '\0') {
+        error = "Parameter " + name + " needs a number, got '" + value + "'";
+        return false;
+    }
+    if (number < info->min_value || number > info->max_value) {
+        std::ostringstream message;
+        message << "Parameter " << name << " must be in [" << info->min_value << ", " << info->max_value << "]";
+        error = message.str();
+        return false;
+    }
+    params.*(info->member) = number;
+    return true;
+}
+
+bool set_banking_parameter(BankingParameters& params, const std::string& assignment, std::string& error) {
+    size_t equals = assignment.find('=');
+    if (equals == std::string::npos) {
+        error = "Expected <name>=<value>, got '" + assignment + "'";
+        return false;
+    }
+    return set_banking_parameter(params, assignment.substr(0, equals), assignment.substr(equals + 1), error);
+}
+
+std::vector<std::string> banking_parameter_names() {
+    std::vector<std::string> names;
+    for (const auto& info : parameter_table()) names.push_back(info.name);
+    return names;
+}
+
+double banking_parameter(const BankingParameters& params, const std::string& name) {
+    const ParameterInfo* info = find_parameter(name);
+    return info ? params.*(info->member) : 0.0;
+}
+
+std::vector<std::string> banking_parameter_assignments(const BankingParameters& params) {
+    BankingParameters defaults;
+    std::vector<std::string> assignments;
+    for (const auto& info : parameter_table()) {
+        if (params.*(info.member) == defaults.*(info.member)) continue;
+        std::ostringstream assignment;
+        assignment << info.name << "=" << params.*(info.member);
+        assignments.push_back(assignment.str());
+    }
+    return assignments;
+}
+
+std::string banking_parameter_flags(const BankingParameters& params) {
+    std::string flags;
+    for (const auto& assignment : banking_parameter_assignments(params)) {
+        flags += (flags.empty() ? "-param " : " -param ") + assignment;
+    }
+    return flags;
+}
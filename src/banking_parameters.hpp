@@ -0,0 +1,48 @@
+#ifndef BANKING_PARAMETERS_HPP
+#define BANKING_PARAMETERS_HPP
+
+#include <string>
+#include <vector>
+
+// =============================================================================
+// RUNTIME BANKING PARAMETERS (-param <name>=<value>)
+// =============================================================================
+// 原本寫死在banking.cpp / flow.cpp的heuristic門檻，改成每個design各自一份
+// (DesignDatabase::banking_params)，命令列、batch manifest、server job、
+// libmbff和autotuner都用同一組名稱設定
+// 下面的macro是預設值
+// =============================================================================
+
+// Manhattan distance limits for spatial clustering (DBU)
+#define FSDN_2BIT_BANKING_distance 10000.0
+#define FSDN_4BIT_BANKING_distance 10000.0
+#define LSRDPQ_4BIT_BANKING_distance 10000.0
+
+struct BankingParameters {
+    double fsdn2_distance = FSDN_2BIT_BANKING_distance;     // 1-bit → 2-bit FSDN pairing
+    double fsdn4_distance = FSDN_4BIT_BANKING_distance;     // 2-bit → 4-bit FSDN pairing
+    double lsrdpq4_distance = LSRDPQ_4BIT_BANKING_distance; // 1-bit → 4-bit LSRDPQ clustering
+    double legalization_max_displacement = 0.0;             // Abacus cluster displacement limit (0 = unlimited)
+    double banking_group_fraction = 1.0;                    // Bank only this share of FF groups (in key order)
+    double clock_leaf_group_min_ffs = 0.0;                  // Traced leaf CK nets with this many FFs bank on their own (0 = whole domain)
+};
+
+// Set one parameter from its text value; false (with `error` set) for an unknown name or bad value
+bool set_banking_parameter(BankingParameters& params, const std::string& name, const std::string& value,
+                           std::string& error);
+
+// Parse "name=value"
+bool set_banking_parameter(BankingParameters& params, const std::string& assignment, std::string& error);
+
+// Names accepted by set_banking_parameter, in declaration order
+std::vector<std::string> banking_parameter_names();
+
+double banking_parameter(const BankingParameters& params, const std::string& name);
+
+// "name=value" for every parameter that differs from the defaults (the -param arguments)
+std::vector<std::string> banking_parameter_assignments(const BankingParameters& params);
+
+// The same as command-line flags: "-param fsdn2_distance=5000 -param ..." ("" = all defaults)
+std::string banking_parameter_flags(const BankingParameters& params);
+
+#endif // BANKING_PARAMETERS_HPP
@@ -0,0 +1,486 @@
+#include "batch.hpp"
+#include "autotune.hpp"
+#include "data_structures.hpp"
+#include "flow.hpp"
+#include "checkpoint.hpp"
+#include "task_graph.hpp"
+#include "thread_pool.hpp"
+#include "profiler.hpp"
+#include "logger.hpp"
+#include "compressed_stream.hpp"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// =============================================================================
+// QoR SNAPSHOT
+// =============================================================================
+
+DesignQoR measure_design_qor(const DesignDatabase& db) {
+    DesignQoR qor;
+    for (const auto& pair : db.instances) {
+        const auto& inst = pair.second;
+        if (!inst->is_flip_flop() || !inst->cell_template) continue;
+        qor.ff_instances++;
+        qor.ff_bits += inst->get_bit_width();
+        if (inst->cell_template->is_multibit()) qor.multibit_instances++;
+        qor.ff_area += inst->cell_template->area;
+        qor.ff_power += inst->cell_template->leakage_power;
+        // Legalization後才有x_new / y_new；Abacus放不下的FF標成UNPLACED
+        if (inst->placement_status == Instance::UNPLACED) {
+            qor.unplaced_ffs++;
+        } else if (inst->x_new != 0 || inst->y_new != 0) {
+            qor.displacement += std::hypot(static_cast<double>(inst->x_new - inst->position.x),
+                                           static_cast<double>(inst->y_new - inst->position.y));
+        }
+    }
+    qor.weighted_cost = db.objective_weights.beta * qor.ff_power + db.objective_weights.gamma * qor.ff_area;
+    return qor;
+}
+
+namespace {
+
+// =============================================================================
+// MANIFEST
+// =============================================================================
+
+struct BatchEntry {
+    int line = 0;
+    std::string label;               // -out as written in the manifest
+    ProgramArguments args;
+    long memory_mb = 0;              // Budget reserved while the design runs
+
+    // Results
+    bool ok = false;
+    std::string error;
+    double wall_ms = 0.0;
+    DesignQoR initial;               // After step 6 (netlist linked)
+    DesignQoR final;
+
+    // -autotune
+    bool tuned = false;
+    double baseline_cost = 0.0;      // Manifest -param values
+    std::string best_params;         // -param flags of the winner ("" = defaults)
+};
+
+// 空白分隔，雙引號內的空白保留，# 之後忽略
+std::vector<std::string> split_manifest_line(const std::string& line) {
+    std::vector<std::string> tokens;
+    std::string token;
+    bool in_token = false;
+    bool quoted = false;
+    for (char c : line) {
+        if (quoted) {
+            if (c == '"') quoted = false;
+            else token.push_back(c);
+        } else if (c == '"') {
+            quoted = true;
+            in_token = true;
+        } else if (c == '#') {
+            break;
+        } else if (c == ' ' || c == '\t' || c == '\r') {
+            if (in_token) tokens.push_back(token);
+            token.clear();
+            in_token = false;
+        } else {
+            token.push_back(c);
+            in_token = true;
+        }
+    }
+    if (quoted) throw std::runtime_error("unterminated quote");
+    if (in_token) tokens.push_back(token);
+    return tokens;
+}
+
+std::string resolve_path(const std::string& base_dir, const std::string& path) {
+    bool absolute = !path.empty() && (path[0] == '/' || (path.size() > 1 && path[1] == ':'));   // D:/...
+    if (path.empty() || absolute || base_dir.empty()) return path;
+    return base_dir + "/" + path;
+}
+
+long file_size(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? static_cast<long>(info.st_size) : 0;
+}
+
+// mkdir -p (輸出檔所在目錄)
+bool make_directories(const std::string& path) {
+    if (path.empty()) return true;
+    struct stat info;
+    if (stat(path.c_str(), &info) == 0) return S_ISDIR(info.st_mode);
+    if (!make_directories(directory_of(path))) return false;
+    return mkdir(path.c_str(), 0777) == 0 || errno == EEXIST;
+}
+
+// parser讀不到檔案時只印錯誤並繼續；batch裡要把這種design標成失敗
+void check_inputs(const ProgramArguments& design) {
+    std::vector<std::string> inputs = design.verilog_files;
+    inputs.insert(inputs.end(), design.def_files.begin(), design.def_files.end());
+    if (!design.weight_file.empty()) inputs.push_back(design.weight_file);
+    if (!design.resume_from.empty()) inputs.push_back(design.resume_from);
+    for (const auto& input : inputs) {
+        if (access(input.c_str(), R_OK) != 0) throw std::runtime_error("cannot read " + input);
+    }
+}
+
+long estimate_memory_mb(const ProgramArguments& design) {
+    long input_bytes = 0;
+    for (const auto& file : design.verilog_files) input_bytes += file_size(file);
+    for (const auto& file : design.def_files) input_bytes += file_size(file);
+    if (!design.resume_from.empty()) input_bytes += file_size(design.resume_from);
+    return BATCH_MEMORY_BASE_MB + input_bytes * BATCH_MEMORY_PER_INPUT_BYTE / (1024 * 1024);
+}
+
+long physical_memory_mb() {
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGE_SIZE);
+    if (pages <= 0 || page_size <= 0) return 0;
+    return static_cast<long>(static_cast<double>(pages) * page_size / (1024 * 1024));
+}
+
+std::vector<BatchEntry> read_manifest(const ProgramArguments& args) {
+    std::ifstream file(args.batch_manifest);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open batch manifest " + args.batch_manifest);
+    }
+    std::string base_dir = directory_of(args.batch_manifest);
+
+    std::vector<BatchEntry> entries;
+    std::set<std::string> outputs;
+    std::set<std::string> report_dirs;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        std::string where = args.batch_manifest + ":" + std::to_string(line_number) + ": ";
+        std::vector<std::string> tokens;
+        try {
+            tokens = split_manifest_line(line);
+        } catch (const std::exception& e) {
+            throw std::runtime_error(where + e.what());
+        }
+        if (tokens.empty()) continue;
+
+        BatchEntry entry;
+        entry.line = line_number;
+        entry.args = parse_argument_tokens(tokens);
+        ProgramArguments& design = entry.args;
+        entry.label = design.output_name;
+        for (auto& path : design.verilog_files) path = resolve_path(base_dir, path);
+        for (auto& path : design.def_files) path = resolve_path(base_dir, path);
+        design.weight_file = resolve_path(base_dir, design.weight_file);
+        for (auto& path : design.sdc_files) path = resolve_path(base_dir, path);
+        design.output_name = resolve_path(base_dir, design.output_name);
+        design.resume_from = resolve_path(base_dir, design.resume_from);
+
+        if (design.output_name.empty()) throw std::runtime_error(where + "design has no -out");
+        if (design.resume_from.empty() &&
+            (design.verilog_files.empty() || design.def_files.empty() || design.weight_file.empty())) {
+            throw std::runtime_error(where + "design needs -v, -def and -weight (or --resume-from)");
+        }
+        if (!design.param_error.empty()) {
+            throw std::runtime_error(where + design.param_error);
+        }
+        if (!design.checkpoint_after.empty() && checkpoint_step_rank(design.checkpoint_after) < 0) {
+            throw std::runtime_error(where + "unknown checkpoint step " + design.checkpoint_after);
+        }
+        if (!outputs.insert(design.output_name).second) {
+            throw std::runtime_error(where + "-out " + design.output_name + " is used twice");
+        }
+
+        // library和執行設定沿用batch本身的參數
+        design.lib_files = args.lib_files;
+        design.lef_files = args.lef_files;
+        design.threads = args.threads;
+        design.autotune = design.autotune || args.autotune;
+        design.out_of_core = design.out_of_core || args.out_of_core;
+        design.scan_reorder = design.scan_reorder && args.scan_reorder;
+        if (design.out_of_core && (design.autotune || !design.checkpoint_after.empty() || !design.resume_from.empty())) {
+            throw std::runtime_error(where + "-out_of_core cannot be combined with checkpoints or -autotune");
+        }
+        if (design.autotune_candidates == 0) design.autotune_candidates = args.autotune_candidates;
+        if (design.compress_output.empty()) design.compress_output = args.compress_output;
+        if (!design.compress_output.empty() && compression_suffix(design.compress_output).empty()) {
+            throw std::runtime_error(where + "-compress_output must be gz or zst");
+        }
+        design.report_dir = directory_of(design.output_name);
+        if (!report_dirs.insert(design.report_dir).second) {
+            LOG_WARN << where << "debug reports share " << (design.report_dir.empty() ? "." : design.report_dir)
+                     << " with an earlier design and will be overwritten";
+        }
+
+        entry.memory_mb = design.design_memory_mb > 0 ? design.design_memory_mb : estimate_memory_mb(design);
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
+
+// =============================================================================
+// SCHEDULER
+// =============================================================================
+
+struct BatchState {
+    const DesignDatabase* library = nullptr;
+    ThreadPool* pool = nullptr;
+    std::vector<BatchEntry>* entries = nullptr;
+    long budget_mb = 0;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t next_entry = 0;           // 依manifest順序開始
+    long reserved_mb = 0;
+    int running = 0;
+};
+
+void run_design(BatchState& state, BatchEntry& entry) {
+    ScopedTimer design_timer("Batch design");
+    const ProgramArguments& design = entry.args;
+    auto start = std::chrono::steady_clock::now();
+    try {
+        check_inputs(design);
+        if (!make_directories(design.report_dir)) {
+            throw std::runtime_error("cannot create directory " + design.report_dir);
+        }
+
+        // -autotune：搜尋參數，不產生輸出檔
+        if (design.autotune) {
+            AutotuneResult tuning = autotune_design(design, state.library, *state.pool);
+            entry.initial = tuning.linked;
+            entry.final = tuning.tuned;
+            entry.tuned = true;
+            entry.baseline_cost = tuning.baseline.weighted_cost;
+            entry.best_params = banking_parameter_flags(tuning.best);
+            entry.ok = true;
+            entry.wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            return;
+        }
+
+        DesignDatabase db;
+        db.design_name = "ICCAD_2025_Design";
+        int completed_rank;
+        if (!design.resume_from.empty()) {
+            std::string resumed_step;
+            if (!load_checkpoint(design.resume_from, db, resumed_step)) {
+                throw std::runtime_error("cannot resume from " + design.resume_from);
+            }
+            completed_rank = checkpoint_step_rank(resumed_step);
+        } else {
+            share_cell_library(*state.library, db);
+            completed_rank = checkpoint_step_rank("2");
+        }
+
+        // 分兩段跑，中間記下初始QoR；step 7讀寫整個DB，切在這裡不影響平行度
+        int linked_rank = checkpoint_step_rank("6");
+        if (completed_rank < linked_rank) {
+            run_banking_flow(design, db, *state.pool, completed_rank, linked_rank);
+            completed_rank = linked_rank;
+        }
+        entry.initial = measure_design_qor(db);
+        run_banking_flow(design, db, *state.pool, completed_rank);
+        entry.final = measure_design_qor(db);
+        entry.ok = true;
+        design_timer.set_items(db.instances.size());
+    } catch (const std::exception& e) {
+        entry.error = e.what();
+        LOG_ERROR << "❌ Design " << entry.label << ": " << e.what();
+    }
+    entry.wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 一個driver thread依序領design；記憶體預算不夠時等執行中的design結束
+void drive_designs(BatchState& state) {
+    std::vector<BatchEntry>& entries = *state.entries;
+    while (true) {
+        BatchEntry* entry;
+        {
+            std::unique_lock<std::mutex> lock(state.mutex);
+            if (state.next_entry >= entries.size()) return;
+            entry = &entries[state.next_entry++];
+            // 單一design超過整個預算時，等其他design都結束後單獨執行
+            state.changed.wait(lock, [&]() {
+                return state.running == 0 || state.reserved_mb + entry->memory_mb <= state.budget_mb;
+            });
+            state.reserved_mb += entry->memory_mb;
+            state.running++;
+            std::cout << "\n📥 Design " << entry->label << " (" << entry->memory_mb << " MB budget, "
+                      << state.running << " running)" << std::endl;
+        }
+
+        run_design(state, *entry);
+
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.reserved_mb -= entry->memory_mb;
+            state.running--;
+            std::cout << (entry->ok ? "✅ Design " : "❌ Design ") << entry->label << " finished in "
+                      << std::fixed << std::setprecision(1) << entry->wall_ms / 1000.0 << " s" << std::endl;
+            std::cout.unsetf(std::ios::fixed);
+        }
+        state.changed.notify_all();
+    }
+}
+
+// =============================================================================
+// SUMMARY
+// =============================================================================
+
+void print_summary(const std::vector<BatchEntry>& entries, double total_ms, std::ostream& out) {
+    out << "\n=== Batch Summary ===" << std::endl;
+    out << std::left << std::setw(24) << "Design" << std::right
+        << std::setw(8) << "Status" << std::setw(10) << "Wall(s)"
+        << std::setw(11) << "FFs(in)" << std::setw(11) << "FFs(out)" << std::setw(9) << "MBFFs"
+        << std::setw(14) << "FF area" << std::setw(14) << "FF power" << std::setw(14) << "Cost(in)"
+        << std::setw(14) << "Cost(out)" << std::setw(9) << "Δcost" << std::endl;
+    out << std::string(138, '-') << std::endl;
+
+    int failed = 0;
+    double total_cost_in = 0.0;
+    double total_cost_out = 0.0;
+    out << std::fixed;
+    for (const auto& entry : entries) {
+        std::string label = entry.label.size() > 23 ? entry.label.substr(0, 20) + "..." : entry.label;
+        out << std::left << std::setw(24) << label << std::right
+            << std::setw(8) << (entry.ok ? "ok" : "FAILED")
+            << std::setw(10) << std::setprecision(1) << entry.wall_ms / 1000.0;
+        if (!entry.ok) {
+            failed++;
+            out << "  " << entry.error << std::endl;
+            continue;
+        }
+        double change = entry.initial.weighted_cost > 0.0
+            ? 100.0 * (entry.final.weighted_cost - entry.initial.weighted_cost) / entry.initial.weighted_cost : 0.0;
+        out << std::setw(11) << entry.initial.ff_instances << std::setw(11) << entry.final.ff_instances
+            << std::setw(9) << entry.final.multibit_instances
+            << std::setw(14) << std::setprecision(2) << entry.final.ff_area
+            << std::setw(14) << entry.final.ff_power
+            << std::setw(14) << entry.initial.weighted_cost << std::setw(14) << entry.final.weighted_cost
+            << std::setw(8) << std::setprecision(2) << change << "%" << std::endl;
+        total_cost_in += entry.initial.weighted_cost;
+        total_cost_out += entry.final.weighted_cost;
+    }
+    out << std::string(138, '-') << std::endl;
+    out << entries.size() - failed << "/" << entries.size() << " designs succeeded in "
+        << std::setprecision(1) << total_ms / 1000.0 << " s; total cost "
+        << std::setprecision(2) << total_cost_in << " -> " << total_cost_out
+        << " (Cost = beta*FF power + gamma*FF area)" << std::endl;
+
+    // -autotune：每個design的最佳參數 (Cost(out)為最佳參數的結果)
+    bool any_tuned = false;
+    for (const auto& entry : entries) {
+        if (!entry.ok || !entry.tuned) continue;
+        if (!any_tuned) out << "\nBest banking parameters (cost with manifest -param -> tuned):" << std::endl;
+        any_tuned = true;
+        out << "  " << std::left << std::setw(22) << entry.label << std::right << std::setprecision(2)
+            << entry.baseline_cost << " -> " << entry.final.weighted_cost << "  "
+            << (entry.best_params.empty() ? "(defaults)" : entry.best_params) << std::endl;
+    }
+    out.unsetf(std::ios::fixed);
+}
+
+bool export_summary_csv(const std::vector<BatchEntry>& entries, const std::string& filename) {
+    std::ofstream csv(filename);
+    if (!csv.is_open()) {
+        LOG_ERROR << "Cannot write batch summary " << filename;
+        return false;
+    }
+    csv << "design,out,status,wall_ms,memory_budget_mb,"
+        << "ff_in,ff_bits_in,ff_area_in,ff_power_in,cost_in,"
+        << "ff_out,ff_bits_out,mbff_out,ff_area_out,ff_power_out,cost_out,best_params,error\n";
+    csv << std::setprecision(10);
+    for (const auto& entry : entries) {
+        const DesignQoR& in = entry.initial;
+        const DesignQoR& out = entry.final;
+        std::string error = entry.error;
+        std::replace(error.begin(), error.end(), ',', ';');
+        csv << entry.label << "," << entry.args.output_name << "," << (entry.ok ? "ok" : "failed") << ","
+            << static_cast<long>(entry.wall_ms) << "," << entry.memory_mb << ","
+            << in.ff_instances << "," << in.ff_bits << "," << in.ff_area << "," << in.ff_power << ","
+            << in.weighted_cost << ","
+            << out.ff_instances << "," << out.ff_bits << "," << out.multibit_instances << ","
+            << out.ff_area << "," << out.ff_power << "," << out.weighted_cost << ","
+            << entry.best_params << "," << error << "\n";
+    }
+    return true;
+}
+
+} // namespace
+
+// =============================================================================
+// BATCH DRIVER
+// =============================================================================
+
+int run_batch(const ProgramArguments& args) {
+    std::vector<BatchEntry> entries;
+    try {
+        entries = read_manifest(args);
+    } catch (const std::exception& e) {
+        LOG_ERROR << "❌ " << e.what();
+        return 1;
+    }
+    if (entries.empty()) {
+        LOG_ERROR << "❌ Batch manifest " << args.batch_manifest << " lists no designs";
+        return 1;
+    }
+
+    ThreadPool& pool = ThreadPool::instance();
+    pool.resize(args.threads);
+
+    // 每個design的stage輸出整段寫出 (同時執行的design不會一行一行交錯)
+    StageOutputScope routing;
+
+    // Steps 1-2 只做一次：之後所有design共用這份cell library
+    DesignDatabase library;
+    library.design_name = "ICCAD_2025_Library";
+    try {
+        std::cout << "\n📚 Loading cell library for " << entries.size() << " designs..." << std::endl;
+        run_banking_flow(args, library, pool, -1, checkpoint_step_rank("2"));
+    } catch (const std::exception& e) {
+        LOG_ERROR << "❌ " << e.what();
+        return 1;
+    }
+
+    BatchState state;
+    state.library = &library;
+    state.pool = &pool;
+    state.entries = &entries;
+    state.budget_mb = args.memory_budget_mb > 0
+        ? args.memory_budget_mb
+        : static_cast<long>(physical_memory_mb() * BATCH_DEFAULT_RAM_FRACTION);
+    if (state.budget_mb <= 0) state.budget_mb = BATCH_MEMORY_BASE_MB;   // RAM大小未知：一次一個
+
+    int drivers = std::min<int>(args.jobs, static_cast<int>(entries.size()));
+    std::cout << "\n🗂️  Running " << entries.size() << " designs, up to " << drivers << " at a time within "
+              << state.budget_mb << " MB, on " << pool.size() << " threads" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < drivers; i++) {
+        threads.emplace_back(drive_designs, std::ref(state));
+    }
+    for (auto& thread : threads) thread.join();
+    double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    print_summary(entries, total_ms, std::cout);
+    if (!args.batch_summary.empty() && export_summary_csv(entries, args.batch_summary)) {
+        std::cout << "  Batch summary written to " << args.batch_summary << std::endl;
+    }
+
+    for (const auto& entry : entries) {
+        if (!entry.ok) return 1;
+    }
+    return 0;
+}
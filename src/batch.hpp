@@ -0,0 +1,48 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include "argument_parser.hpp"
+#include <string>
+
+class DesignDatabase;
+
+// =============================================================================
+// MULTI-DESIGN BATCH MODE
+// =============================================================================
+// -batch <manifest> 一次跑很多design：Liberty / LEF (steps 1-2) 只parse一次，
+// 每個design有自己的DesignDatabase，共用唯讀的cell library和同一個thread pool
+//
+// Manifest：一行一個design，格式和命令列相同 (可用雙引號包住含空白的路徑)
+//   -weight w1 -v d1.v -def d1.def -out out/d1
+//   -weight w2 -v d2.v -def d2.def -out out/d2 -memory_mb 4000
+// 相對路徑以manifest所在目錄為準，# 之後為註解
+//
+// 排程：最多 -jobs 個design同時執行，且執行中design的記憶體預算總和
+// 不超過 -memory_budget_mb (超過整個預算的design會單獨執行)；
+// 每個design的預算由 -memory_mb 指定，否則依Verilog + DEF大小估計
+// 全部結束後印出runtime / QoR總表 (-batch_summary 另存CSV)
+// =============================================================================
+
+// Peak memory per input byte (Verilog + DEF), measured on synthetic designs
+#define BATCH_MEMORY_PER_INPUT_BYTE 16
+#define BATCH_MEMORY_BASE_MB 32
+#define BATCH_DEFAULT_RAM_FRACTION 0.8
+
+// FF-level quality snapshot of one design (TNS is not estimated by this flow)
+struct DesignQoR {
+    long ff_instances = 0;
+    long ff_bits = 0;
+    long multibit_instances = 0;
+    double ff_area = 0.0;
+    double ff_power = 0.0;
+    double weighted_cost = 0.0;   // beta * power + gamma * area
+    long unplaced_ffs = 0;        // FFs legalization could not place (after step 19)
+    double displacement = 0.0;    // Total FF legalization displacement in DBU (after step 19)
+};
+
+DesignQoR measure_design_qor(const DesignDatabase& db);
+
+// Run every design in args.batch_manifest; returns the process exit status
+int run_batch(const ProgramArguments& args);
+
+#endif // BATCH_HPP
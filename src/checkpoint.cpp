@@ -0,0 +1,1153 @@
+#include "checkpoint.hpp"
+#include "data_structures.hpp"
+#include "logger.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// =============================================================================
+// BINARY CHECKPOINT IMPLEMENTATION
+// =============================================================================
+
+namespace {
+
+const char CHECKPOINT_MAGIC[8] = {'M', 'B', 'F', 'F', 'C', 'K', 'P', 'T'};
+const uint32_t CHECKPOINT_BYTE_ORDER = 0x01020304u;
+
+// Section tags (寫在每個section前面，壞檔時可以指出是哪一段)
+enum CheckpointSection : uint32_t {
+    SECTION_METADATA = 1,
+    SECTION_CELLS,
+    SECTION_INSTANCES,
+    SECTION_NETS,
+    SECTION_LAYOUT,
+    SECTION_GROUPS,
+    SECTION_HISTORY,
+    SECTION_PIPELINE,
+    SECTION_PROVENANCE,
+    SECTION_DUMMY_NAMES,
+    SECTION_END
+};
+
+uint64_t fnv1a(const char* data, size_t size, uint64_t hash = 1469598103934665603ULL) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+class CheckpointError : public std::runtime_error {
+public:
+    explicit CheckpointError(const std::string& message) : std::runtime_error(message) {}
+};
+
+// -----------------------------------------------------------------------------
+// Encoder: body bytes + interned string table
+// -----------------------------------------------------------------------------
+class Encoder {
+public:
+    void bytes(const void* data, size_t size) { body_.append(static_cast<const char*>(data), size); }
+    void u8(uint8_t value) { bytes(&value, sizeof(value)); }
+    void u32(uint32_t value) { bytes(&value, sizeof(value)); }
+    void i32(int32_t value) { bytes(&value, sizeof(value)); }
+    void u64(uint64_t value) { bytes(&value, sizeof(value)); }
+    void i64(int64_t value) { bytes(&value, sizeof(value)); }
+    void f64(double value) { bytes(&value, sizeof(value)); }
+    void boolean(bool value) { u8(value ? 1 : 0); }
+
+    // Interned string (u32 id into the string table)
+    void str(const std::string& value) { u32(intern(value)); }
+
+    // Length-prefixed inline string (header only)
+    void text(const std::string& value) {
+        u32(static_cast<uint32_t>(value.size()));
+        bytes(value.data(), value.size());
+    }
+
+    void strings(const std::vector<std::string>& values) {
+        u64(values.size());
+        for (const auto& value : values) str(value);
+    }
+
+    void string_map(const std::map<std::string, std::string>& values) {
+        u64(values.size());
+        for (const auto& entry : values) {
+            str(entry.first);
+            str(entry.second);
+        }
+    }
+
+    template <typename T>
+    void pod_vector(const std::vector<T>& values) {
+        u64(values.size());
+        if (!values.empty()) bytes(values.data(), values.size() * sizeof(T));
+    }
+
+    void point(const Point& value) { i64(value.x); i64(value.y); }
+    void rectangle(const Rectangle& value) { i64(value.x1); i64(value.y1); i64(value.x2); i64(value.y2); }
+
+    const std::string& body() const { return body_; }
+
+    std::string string_table() const {
+        Encoder table;
+        table.u64(table_.size());
+        for (const std::string* value : table_) {
+            table.text(*value);
+        }
+        return table.body_;
+    }
+
+private:
+    uint32_t intern(const std::string& value) {
+        auto it = ids_.find(value);
+        if (it != ids_.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(table_.size());
+        auto inserted = ids_.emplace(value, id).first;
+        table_.push_back(&inserted->first);
+        return id;
+    }
+
+    std::string body_;
+    std::unordered_map<std::string, uint32_t> ids_;
+    std::vector<const std::string*> table_;
+};
+
+// -----------------------------------------------------------------------------
+// Decoder: bounds-checked cursor over the mapped file
+// -----------------------------------------------------------------------------
+class Decoder {
+public:
+    Decoder(const char* begin, const char* end) : pos_(begin), end_(end) {}
+
+    const char* bytes(size_t size) {
+        if (size > remaining()) throw CheckpointError("unexpected end of file");
+        const char* data = pos_;
+        pos_ += size;
+        return data;
+    }
+
+    template <typename T>
+    T read() {
+        T value;
+        std::memcpy(&value, bytes(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    uint8_t u8() { return read<uint8_t>(); }
+    uint32_t u32() { return read<uint32_t>(); }
+    int32_t i32() { return read<int32_t>(); }
+    uint64_t u64() { return read<uint64_t>(); }
+    int64_t i64() { return read<int64_t>(); }
+    double f64() { return read<double>(); }
+    bool boolean() { return u8() != 0; }
+
+    // Element count; every element takes at least one byte, so larger counts are corrupt
+    size_t count() {
+        uint64_t value = u64();
+        if (value > remaining()) throw CheckpointError("invalid element count");
+        return static_cast<size_t>(value);
+    }
+
+    template <typename E>
+    E enumeration(int32_t limit) {
+        int32_t value = i32();
+        if (value < 0 || value >= limit) throw CheckpointError("enum value out of range");
+        return static_cast<E>(value);
+    }
+
+    std::string str() {
+        uint32_t id = u32();
+        if (id >= strings_.size()) throw CheckpointError("invalid string id");
+        return std::string(strings_[id].first, strings_[id].second);
+    }
+
+    std::string text() {
+        uint32_t size = u32();
+        const char* data = bytes(size);
+        return std::string(data, size);
+    }
+
+    std::vector<std::string> strings() {
+        std::vector<std::string> values(count());
+        for (auto& value : values) value = str();
+        return values;
+    }
+
+    std::map<std::string, std::string> string_map() {
+        std::map<std::string, std::string> values;
+        size_t size = count();
+        for (size_t i = 0; i < size; i++) {
+            std::string key = str();
+            values.emplace_hint(values.end(), std::move(key), str());
+        }
+        return values;
+    }
+
+    template <typename T>
+    void pod_vector(std::vector<T>& values) {
+        uint64_t size = u64();
+        if (size > remaining() / sizeof(T)) throw CheckpointError("invalid array size");
+        values.resize(static_cast<size_t>(size));
+        if (size) std::memcpy(values.data(), bytes(values.size() * sizeof(T)), values.size() * sizeof(T));
+    }
+
+    Point point() {
+        Point value;
+        value.x = i64();
+        value.y = i64();
+        return value;
+    }
+
+    Rectangle rectangle() {
+        Rectangle value;
+        value.x1 = i64();
+        value.y1 = i64();
+        value.x2 = i64();
+        value.y2 = i64();
+        return value;
+    }
+
+    // 字串table直接指向mapping，用到時才建std::string
+    void read_string_table() {
+        size_t size = count();
+        strings_.reserve(size);
+        for (size_t i = 0; i < size; i++) {
+            uint32_t length = u32();
+            strings_.emplace_back(bytes(length), length);
+        }
+    }
+
+    void expect_section(CheckpointSection section, const char* name) {
+        if (u32() != section) throw CheckpointError(std::string("missing section ") + name);
+        section_ = name;
+    }
+
+    const char* section() const { return section_; }
+    bool at_end() const { return pos_ == end_; }
+
+private:
+    size_t remaining() const { return static_cast<size_t>(end_ - pos_); }
+
+    const char* pos_;
+    const char* end_;
+    std::vector<std::pair<const char*, uint32_t>> strings_;
+    const char* section_ = "header";
+};
+
+// -----------------------------------------------------------------------------
+// unordered_map: iteration順序依插入歷史和bucket數而定。記錄bucket數，載入時
+// 先rehash到相同大小再倒序插入 (新node插在bucket開頭)，就能還原同樣的順序
+// -----------------------------------------------------------------------------
+template <typename Map, typename WriteEntry>
+void write_unordered(Encoder& out, const Map& map, WriteEntry write_entry) {
+    out.u64(map.bucket_count());
+    out.u64(map.size());
+    for (const auto& entry : map) {
+        write_entry(entry);
+    }
+}
+
+template <typename Map, typename ReadEntry>
+void read_unordered(Decoder& in, Map& map, ReadEntry read_entry) {
+    size_t buckets = static_cast<size_t>(in.u64());
+    size_t size = in.count();
+    std::vector<std::pair<typename Map::key_type, typename Map::mapped_type>> entries;
+    entries.reserve(size);
+    for (size_t i = 0; i < size; i++) {
+        entries.push_back(read_entry());
+    }
+    map.clear();
+    if (map.bucket_count() != buckets) map.rehash(buckets);   // 空map保留預設的1個bucket，之後的成長順序才一樣
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        map.emplace(std::move(it->first), std::move(it->second));
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Record encoders
+// -----------------------------------------------------------------------------
+void write_pin(Encoder& out, const Pin& pin) {
+    out.str(pin.name);
+    out.i32(pin.direction);
+    out.i32(pin.usage);
+    out.i32(pin.ff_pin_type);
+    out.point(pin.offset);
+    out.str(pin.connected_net_name);
+}
+
+Pin read_pin(Decoder& in) {
+    Pin pin;
+    pin.name = in.str();
+    pin.direction = in.enumeration<Pin::Direction>(Pin::UNKNOWN_DIR + 1);
+    pin.usage = in.enumeration<Pin::Usage>(Pin::UNKNOWN_USE + 1);
+    pin.ff_pin_type = in.enumeration<Pin::FlipFlopPinType>(Pin::FF_NOT_FF_PIN + 1);
+    pin.offset = in.point();
+    pin.connected_net_name = in.str();
+    return pin;
+}
+
+void write_cell(Encoder& out, const CellTemplate& cell) {
+    out.str(cell.name);
+    out.str(cell.library);
+    out.i64(cell.width);
+    out.i64(cell.height);
+    out.str(cell.site);
+    out.u64(cell.pins.size());
+    for (const auto& pin : cell.pins) write_pin(out, pin);
+    out.f64(cell.area);
+    out.f64(cell.leakage_power);
+    out.str(cell.single_bit_degenerate);
+    out.strings(cell.banking_targets);
+    out.i32(cell.bit_width);
+    out.i32(cell.clock_edge);
+    out.i32(cell.clock_role);
+    out.str(cell.clock_in_pin);
+    out.str(cell.clock_out_pin);
+    out.str(cell.clock_enable_pin);
+    out.boolean(cell.clock_out_inverted);
+    out.i32(cell.type);
+}
+
+std::shared_ptr<CellTemplate> read_cell(Decoder& in) {
+    auto cell = std::make_shared<CellTemplate>();
+    cell->name = in.str();
+    cell->library = in.str();
+    cell->width = in.i64();
+    cell->height = in.i64();
+    cell->site = in.str();
+    cell->pins.resize(in.count());
+    for (auto& pin : cell->pins) pin = read_pin(in);
+    cell->area = in.f64();
+    cell->leakage_power = in.f64();
+    cell->single_bit_degenerate = in.str();
+    cell->banking_targets = in.strings();
+    cell->bit_width = in.i32();
+    cell->clock_edge = in.enumeration<CellTemplate::ClockEdge>(CellTemplate::UNKNOWN_EDGE + 1);
+    cell->clock_role = in.enumeration<CellTemplate::ClockTreeRole>(CellTemplate::CLOCK_GATE + 1);
+    cell->clock_in_pin = in.str();
+    cell->clock_out_pin = in.str();
+    cell->clock_enable_pin = in.str();
+    cell->clock_out_inverted = in.boolean();
+    cell->type = in.enumeration<CellTemplate::CellType>(CellTemplate::OTHER + 1);
+    return cell;
+}
+
+void write_instance(Encoder& out, const Instance& inst, int32_t cell_index) {
+    out.str(inst.name);
+    out.str(inst.cell_type);
+    out.i32(cell_index);
+    out.str(inst.module_name);
+    out.i32(static_cast<int32_t>(inst.banking_type));
+    out.str(inst.cluster_id);
+    out.str(inst.best_ff_from_substitution);
+    out.f64(inst.best_ff_score);
+    out.point(inst.position);
+    out.i32(inst.orientation);
+    out.i32(inst.placement_status);
+    out.u64(inst.connections.size());
+    for (const auto& conn : inst.connections) {
+        out.str(conn.pin_name);
+        out.str(conn.net_name);
+    }
+    out.i64(inst.x_new);
+    out.i64(inst.y_new);
+    out.i32(inst.weight);
+    out.i32(inst.row_id);
+    out.u64(inst.pin_status.size());
+    for (const auto& status : inst.pin_status) {
+        out.str(status.pin_name);
+        out.i32(status.status);
+        out.str(status.net_name);
+    }
+}
+
+std::shared_ptr<Instance> read_instance(Decoder& in, const std::vector<std::shared_ptr<CellTemplate>>& cells) {
+    auto inst = std::make_shared<Instance>();
+    inst->name = in.str();
+    inst->cell_type = in.str();
+    int32_t cell_index = in.i32();
+    if (cell_index >= static_cast<int32_t>(cells.size())) throw CheckpointError("invalid cell index");
+    if (cell_index >= 0) inst->cell_template = cells[cell_index];
+    inst->module_name = in.str();
+    inst->banking_type = in.enumeration<BankingType>(static_cast<int32_t>(BankingType::NONE) + 1);
+    inst->cluster_id = in.str();
+    inst->best_ff_from_substitution = in.str();
+    inst->best_ff_score = in.f64();
+    inst->position = in.point();
+    inst->orientation = in.enumeration<Instance::Orientation>(Instance::FW + 1);
+    inst->placement_status = in.enumeration<Instance::PlacementStatus>(Instance::FIXED + 1);
+    inst->connections.resize(in.count());
+    for (auto& conn : inst->connections) {
+        conn.pin_name = in.str();
+        conn.net_name = in.str();
+    }
+    inst->x_new = in.i64();
+    inst->y_new = in.i64();
+    inst->weight = in.i32();
+    inst->row_id = in.i32();
+    inst->pin_status.resize(in.count());
+    for (auto& status : inst->pin_status) {
+        status.pin_name = in.str();
+        status.status = in.enumeration<Instance::PinConnectionStatus::Status>(Instance::PinConnectionStatus::MISSING + 1);
+        status.net_name = in.str();
+    }
+    return inst;
+}
+
+void write_net(Encoder& out, const Net& net) {
+    out.str(net.name);
+    out.u64(net.connections.size());
+    for (const auto& conn : net.connections) {
+        out.str(conn.instance_name);
+        out.str(conn.pin_name);
+    }
+    out.i32(net.type);
+    out.boolean(net.is_clock_net);
+}
+
+std::shared_ptr<Net> read_net(Decoder& in) {
+    auto net = std::make_shared<Net>();
+    net->name = in.str();
+    net->connections.resize(in.count());
+    for (auto& conn : net->connections) {
+        conn.instance_name = in.str();
+        conn.pin_name = in.str();
+    }
+    net->type = in.enumeration<Net::NetType>(Net::GROUND + 1);
+    net->is_clock_net = in.boolean();
+    return net;
+}
+
+void write_snapshot(Encoder& out, const InstanceSnapshot& snapshot) {
+    out.str(snapshot.instance_name);
+    out.str(snapshot.cell_type);
+    out.i64(snapshot.x);
+    out.i64(snapshot.y);
+    out.str(snapshot.orientation);
+    out.string_map(snapshot.pin_connections);
+    out.str(snapshot.cluster_id);
+    out.str(snapshot.original_name);
+    out.i32(snapshot.last_operation);
+    out.i64(snapshot.record_index);
+}
+
+InstanceSnapshot read_snapshot(Decoder& in) {
+    InstanceSnapshot snapshot;
+    snapshot.instance_name = in.str();
+    snapshot.cell_type = in.str();
+    snapshot.x = in.i64();
+    snapshot.y = in.i64();
+    snapshot.orientation = in.str();
+    snapshot.pin_connections = in.string_map();
+    snapshot.cluster_id = in.str();
+    snapshot.original_name = in.str();
+    snapshot.last_operation = in.enumeration<TransformationRecord::Operation>(TransformationRecord::POST_SUBSTITUTE + 1);
+    snapshot.record_index = static_cast<long>(in.i64());
+    return snapshot;
+}
+
+}  // namespace
+
+// TransformationLog的欄位是private，經由friend直接存取columns
+struct CheckpointAccess {
+    static void write_history(Encoder& out, const TransformationLog& log) {
+        out.u64(log.strings_.size());
+        for (const std::string* value : log.strings_) out.str(*value);
+
+        out.u64(log.pin_maps_.size());
+        for (const auto& mapping : log.pin_maps_) out.string_map(mapping);
+
+        out.u64(log.pin_sets_.size());
+        for (const auto& pins : log.pin_sets_) out.pod_vector(pins);
+
+        out.pod_vector(log.op_);
+        out.pod_vector(log.original_instance_);
+        out.pod_vector(log.result_instance_);
+        out.pod_vector(log.original_cell_);
+        out.pod_vector(log.result_cell_);
+        out.pod_vector(log.stage_);
+        out.pod_vector(log.cluster_);
+        out.pod_vector(log.orientation_);
+        out.pod_vector(log.pin_map_);
+        out.pod_vector(log.related_begin_);
+        out.pod_vector(log.bank_begin_);
+        out.pod_vector(log.result_x_);
+        out.pod_vector(log.result_y_);
+        out.pod_vector(log.removed_);
+        out.pod_vector(log.related_pool_);
+        out.pod_vector(log.bank_pool_);
+        out.pod_vector(log.latest_by_name_);
+        out.pod_vector(log.keep_by_name_);
+        out.u64(log.live_count_);
+    }
+
+    static void read_history(Decoder& in, TransformationLog& log) {
+        log.clear();
+
+        // 依原本的id順序重新intern，string id / pin-map id和存檔時一致
+        size_t string_count = in.count();
+        for (size_t i = 0; i < string_count; i++) {
+            if (log.intern(in.str()) != static_cast<int>(i)) throw CheckpointError("duplicate history string");
+        }
+        size_t pin_map_count = in.count();
+        for (size_t i = 0; i < pin_map_count; i++) {
+            std::map<std::string, std::string> mapping = in.string_map();
+            if (i == 0) continue;   // pin_map 0 = empty mapping (created by clear())
+            if (log.intern_pin_map(mapping) != static_cast<int>(i)) throw CheckpointError("duplicate pin map");
+        }
+        size_t pin_set_count = in.count();
+        for (size_t i = 0; i < pin_set_count; i++) {
+            std::vector<int> pins;
+            in.pod_vector(pins);
+            for (int pin : pins) {
+                if (pin < 0 || static_cast<size_t>(pin) >= string_count) throw CheckpointError("bad pin set string id");
+            }
+            if (!log.pin_set_ids_.emplace(pins, static_cast<int>(i)).second) throw CheckpointError("duplicate pin set");
+            log.pin_sets_.push_back(std::move(pins));
+        }
+
+        in.pod_vector(log.op_);
+        in.pod_vector(log.original_instance_);
+        in.pod_vector(log.result_instance_);
+        in.pod_vector(log.original_cell_);
+        in.pod_vector(log.result_cell_);
+        in.pod_vector(log.stage_);
+        in.pod_vector(log.cluster_);
+        in.pod_vector(log.orientation_);
+        in.pod_vector(log.pin_map_);
+        in.pod_vector(log.related_begin_);
+        in.pod_vector(log.bank_begin_);
+        in.pod_vector(log.result_x_);
+        in.pod_vector(log.result_y_);
+        in.pod_vector(log.removed_);
+        in.pod_vector(log.related_pool_);
+        in.pod_vector(log.bank_pool_);
+        in.pod_vector(log.latest_by_name_);
+        in.pod_vector(log.keep_by_name_);
+        log.live_count_ = static_cast<size_t>(in.u64());
+
+        size_t records = log.op_.size();
+        if (log.original_instance_.size() != records || log.result_instance_.size() != records ||
+            log.original_cell_.size() != records || log.result_cell_.size() != records ||
+            log.stage_.size() != records || log.cluster_.size() != records ||
+            log.orientation_.size() != records || log.pin_map_.size() != records ||
+            log.related_begin_.size() != records || log.bank_begin_.size() != records ||
+            log.result_x_.size() != records ||
+            log.result_y_.size() != records || log.removed_.size() != records ||
+            log.latest_by_name_.size() != string_count || log.keep_by_name_.size() != string_count ||
+            log.live_count_ > records) {
+            throw CheckpointError("inconsistent transformation log columns");
+        }
+        for (int pin_set : log.bank_pool_) {
+            if (pin_set < 0 || static_cast<size_t>(pin_set) >= pin_set_count) throw CheckpointError("bad bank pin set id");
+        }
+    }
+};
+
+namespace {
+
+// -----------------------------------------------------------------------------
+// Database encoder / decoder
+// -----------------------------------------------------------------------------
+void encode_database(Encoder& out, const DesignDatabase& db) {
+    out.u32(SECTION_METADATA);
+    out.str(db.design_name);
+    out.str(db.testcase_path);
+    out.str(db.input_verilog_path);
+    out.str(db.input_def_path);
+    out.u64(db.modules.size());
+    for (const auto& module : db.modules) {
+        out.str(module.name);
+        out.u64(module.start_pos);
+        out.u64(module.end_pos);
+        out.strings(module.instance_names);
+    }
+
+    // Cell table: library cells first, then any template only reachable from an instance
+    out.u32(SECTION_CELLS);
+    std::vector<const CellTemplate*> cells;
+    std::unordered_map<const CellTemplate*, int32_t> cell_index;
+    auto add_cell = [&](const CellTemplate* cell) {
+        if (cell && cell_index.emplace(cell, static_cast<int32_t>(cells.size())).second) cells.push_back(cell);
+    };
+    for (const auto& entry : db.cell_library) add_cell(entry.second.get());
+    for (const auto& entry : db.instances) add_cell(entry.second->cell_template.get());
+    for (const auto& group : db.ff_instance_groups) {
+        for (const auto& inst : group.second) add_cell(inst->cell_template.get());
+    }
+    out.u64(cells.size());
+    for (const CellTemplate* cell : cells) write_cell(out, *cell);
+    write_unordered(out, db.cell_library, [&](const std::pair<const std::string, std::shared_ptr<CellTemplate>>& entry) {
+        out.str(entry.first);
+        out.i32(entry.second ? cell_index[entry.second.get()] : -1);
+    });
+
+    // Instance table: db.instances, then instances only referenced by ff_instance_groups
+    out.u32(SECTION_INSTANCES);
+    std::vector<const Instance*> instances;
+    std::unordered_map<const Instance*, int32_t> instance_index;
+    instances.reserve(db.instances.size());
+    instance_index.reserve(db.instances.size());
+    auto add_instance = [&](const Instance* inst) {
+        if (inst && instance_index.emplace(inst, static_cast<int32_t>(instances.size())).second) instances.push_back(inst);
+    };
+    for (const auto& entry : db.instances) add_instance(entry.second.get());
+    for (const auto& group : db.ff_instance_groups) {
+        for (const auto& inst : group.second) add_instance(inst.get());
+    }
+    out.u64(instances.size());
+    for (const Instance* inst : instances) {
+        write_instance(out, *inst, inst->cell_template ? cell_index[inst->cell_template.get()] : -1);
+    }
+    write_unordered(out, db.instances, [&](const std::pair<const std::string, std::shared_ptr<Instance>>& entry) {
+        out.str(entry.first);
+        out.i32(entry.second ? instance_index[entry.second.get()] : -1);
+    });
+
+    out.u32(SECTION_NETS);
+    write_unordered(out, db.nets, [&](const std::pair<const std::string, std::shared_ptr<Net>>& entry) {
+        out.str(entry.first);
+        write_net(out, *entry.second);
+    });
+    out.string_map(db.sdc_clocks);
+    out.string_map(db.clock_domain_labels);
+
+    out.u32(SECTION_LAYOUT);
+    out.u64(db.design_pins.size());
+    for (const auto& pin : db.design_pins) {
+        out.str(pin.name);
+        out.str(pin.net_name);
+        out.i32(pin.direction);
+        out.point(pin.position);
+        out.str(pin.layer);
+    }
+    out.u64(db.placement_rows.size());
+    for (const auto& row : db.placement_rows) {
+        out.str(row.name);
+        out.str(row.site);
+        out.point(row.origin);
+        out.i32(row.num_x);
+        out.i32(row.num_y);
+        out.i64(row.step_x);
+        out.i64(row.step_y);
+        out.i64(row.height);
+        out.i64(row.site_width);
+        out.i32(row.id);
+        out.u64(row.subrows.size());
+        for (const auto& subrow : row.subrows) {   // lastCluster只在legalizer執行中有效
+            out.i64(subrow.x_min);
+            out.i64(subrow.x_max);
+            out.i64(subrow.Usewidth);
+        }
+    }
+    out.u64(db.tracks.size());
+    for (const auto& track : db.tracks) {
+        out.i32(track.direction);
+        out.i64(track.start);
+        out.i32(track.num);
+        out.i64(track.step);
+        out.str(track.layer);
+    }
+    out.rectangle(db.die_area);
+    out.u64(db.placement_blockages.size());
+    for (const auto& blockage : db.placement_blockages) out.rectangle(blockage);
+    out.u64(db.scan_chains.size());
+    for (const auto& chain : db.scan_chains) {
+        out.str(chain.name);
+        out.str(chain.scan_in_pin);
+        out.str(chain.scan_out_pin);
+        out.str(chain.start_instance);
+        out.str(chain.stop_instance);
+        out.str(chain.partition);
+        out.i32(chain.max_bits);
+        out.str(chain.scan_in_net);
+        out.boolean(chain.from_def);
+        out.u64(chain.chain_sequence.size());
+        for (const auto& conn : chain.chain_sequence) {
+            out.str(conn.instance_name);
+            out.str(conn.scan_in_pin);
+            out.str(conn.scan_out_pin);
+            out.i32(conn.ordered_segment);
+        }
+    }
+    const ObjectiveWeights& weights = db.objective_weights;
+    out.f64(weights.alpha);
+    out.f64(weights.beta);
+    out.f64(weights.gamma);
+    out.f64(weights.initial_tns);
+    out.f64(weights.initial_power);
+    out.f64(weights.initial_area);
+
+    out.u32(SECTION_GROUPS);
+    write_unordered(out, db.ff_compatibility_groups, [&](const std::pair<const std::string, std::vector<std::string>>& entry) {
+        out.str(entry.first);
+        out.strings(entry.second);
+    });
+    out.u64(db.hierarchical_ff_groups.size());
+    for (const auto& edge : db.hierarchical_ff_groups) {
+        out.str(edge.first);
+        out.u64(edge.second.size());
+        for (const auto& interface : edge.second) {
+            out.str(interface.first);
+            out.u64(interface.second.size());
+            for (const auto& width : interface.second) {
+                out.i32(width.first);
+                out.strings(width.second);
+            }
+        }
+    }
+    out.u64(db.ff_instance_groups.size());
+    for (const auto& group : db.ff_instance_groups) {
+        out.str(group.first);
+        out.u64(group.second.size());
+        for (const auto& inst : group.second) out.i32(inst ? instance_index[inst.get()] : -1);
+    }
+    out.string_map(db.optimal_ff_for_groups);
+    out.strings(db.banking_eligible_groups);
+    out.strings(db.banking_candidate_instance_groups);
+
+    out.u32(SECTION_HISTORY);
+    CheckpointAccess::write_history(out, db.transformation_history);
+
+    out.u32(SECTION_PIPELINE);
+    const CompletePipeline& pipeline = db.complete_pipeline;
+    out.u64(pipeline.stages.size());
+    for (const auto& stage : pipeline.stages) {
+        out.str(stage.stage_name);
+        out.u64(stage.changed.size());
+        for (const auto& snapshot : stage.changed) write_snapshot(out, snapshot);
+        out.strings(stage.removed);
+        out.u64(stage.transformation_indices.size());
+        for (size_t index : stage.transformation_indices) out.u64(index);
+        out.boolean(stage.captured);
+        out.u64(stage.total_instances);
+        out.u64(stage.ff_instances);
+        out.f64(stage.total_area);
+        out.f64(stage.total_power);
+    }
+    out.u64(pipeline.stage_index_map.size());
+    for (const auto& entry : pipeline.stage_index_map) {
+        out.str(entry.first);
+        out.u64(entry.second);
+    }
+    write_unordered(out, pipeline.live_view, [&](const std::pair<const std::string, std::pair<size_t, size_t>>& entry) {
+        out.str(entry.first);
+        out.u64(entry.second.first);
+        out.u64(entry.second.second);
+    });
+
+    out.u32(SECTION_PROVENANCE);
+    const PinProvenance& provenance = db.pin_provenance;
+    out.strings(provenance.instance_names);
+    out.strings(provenance.pin_names);
+    out.u64(provenance.nodes.size());
+    for (const auto& node : provenance.nodes) {
+        out.i32(node.instance_id);
+        out.i32(node.pin_id);
+        out.i32(node.forward);
+    }
+    out.pod_vector(provenance.original_pins);
+    write_unordered(out, provenance.live_nodes, [&](const std::pair<const unsigned long long, int>& entry) {
+        out.u64(entry.first);
+        out.i32(entry.second);
+    });
+
+    out.u32(SECTION_DUMMY_NAMES);
+    out.string_map(db.dummy_to_real_mapping);
+    out.string_map(db.real_to_dummy_mapping);
+    out.i32(db.global_dummy_counter);
+    out.i32(db.banking_name_counters.fsdn2);
+    out.i32(db.banking_name_counters.fsdn4);
+    out.i32(db.banking_name_counters.lsrdpq4);
+    out.i32(db.stats.total_instances);
+    out.i32(db.stats.flip_flop_count);
+    out.i32(db.stats.bankable_ff_count);
+    out.i32(db.stats.total_nets);
+    out.f64(db.stats.total_area);
+    out.f64(db.stats.total_power);
+
+    out.u32(SECTION_END);
+}
+
+void decode_database(Decoder& in, DesignDatabase& db) {
+    in.expect_section(SECTION_METADATA, "metadata");
+    db.design_name = in.str();
+    db.testcase_path = in.str();
+    db.input_verilog_path = in.str();
+    db.input_def_path = in.str();
+    db.modules.resize(in.count());
+    for (auto& module : db.modules) {
+        module.name = in.str();
+        module.start_pos = static_cast<size_t>(in.u64());
+        module.end_pos = static_cast<size_t>(in.u64());
+        module.instance_names = in.strings();
+    }
+
+    in.expect_section(SECTION_CELLS, "cells");
+    std::vector<std::shared_ptr<CellTemplate>> cells(in.count());
+    for (auto& cell : cells) cell = read_cell(in);
+    read_unordered(in, db.cell_library, [&]() {
+        std::string key = in.str();
+        int32_t index = in.i32();
+        if (index >= static_cast<int32_t>(cells.size())) throw CheckpointError("invalid cell index");
+        return std::make_pair(key, index >= 0 ? cells[index] : std::shared_ptr<CellTemplate>());
+    });
+
+    in.expect_section(SECTION_INSTANCES, "instances");
+    std::vector<std::shared_ptr<Instance>> instances(in.count());
+    for (auto& inst : instances) inst = read_instance(in, cells);
+    auto instance_at = [&](int32_t index) {
+        if (index >= static_cast<int32_t>(instances.size())) throw CheckpointError("invalid instance index");
+        return index >= 0 ? instances[index] : std::shared_ptr<Instance>();
+    };
+    read_unordered(in, db.instances, [&]() {
+        std::string key = in.str();
+        return std::make_pair(key, instance_at(in.i32()));
+    });
+
+    in.expect_section(SECTION_NETS, "nets");
+    read_unordered(in, db.nets, [&]() {
+        std::string key = in.str();
+        return std::make_pair(key, read_net(in));
+    });
+    db.sdc_clocks = in.string_map();
+    db.clock_domain_labels = in.string_map();
+
+    in.expect_section(SECTION_LAYOUT, "layout");
+    db.design_pins.resize(in.count());
+    for (auto& pin : db.design_pins) {
+        pin.name = in.str();
+        pin.net_name = in.str();
+        pin.direction = in.enumeration<DesignPin::Direction>(DesignPin::INOUT + 1);
+        pin.position = in.point();
+        pin.layer = in.str();
+    }
+    db.placement_rows.resize(in.count());
+    for (auto& row : db.placement_rows) {
+        row.name = in.str();
+        row.site = in.str();
+        row.origin = in.point();
+        row.num_x = in.i32();
+        row.num_y = in.i32();
+        row.step_x = in.i64();
+        row.step_y = in.i64();
+        row.height = in.i64();
+        row.site_width = in.i64();
+        row.id = in.i32();
+        row.subrows.resize(in.count());
+        for (auto& subrow : row.subrows) {
+            subrow.x_min = in.i64();
+            subrow.x_max = in.i64();
+            subrow.Usewidth = in.i64();
+            subrow.lastCluster = nullptr;
+        }
+    }
+    db.tracks.resize(in.count());
+    for (auto& track : db.tracks) {
+        track.direction = in.enumeration<Track::Direction>(Track::Y + 1);
+        track.start = in.i64();
+        track.num = in.i32();
+        track.step = in.i64();
+        track.layer = in.str();
+    }
+    db.die_area = in.rectangle();
+    db.placement_blockages.resize(in.count());
+    for (auto& blockage : db.placement_blockages) blockage = in.rectangle();
+    db.scan_chains.resize(in.count());
+    for (auto& chain : db.scan_chains) {
+        chain.name = in.str();
+        chain.scan_in_pin = in.str();
+        chain.scan_out_pin = in.str();
+        chain.start_instance = in.str();
+        chain.stop_instance = in.str();
+        chain.partition = in.str();
+        chain.max_bits = in.i32();
+        chain.scan_in_net = in.str();
+        chain.from_def = in.boolean();
+        chain.chain_sequence.resize(in.count());
+        for (auto& conn : chain.chain_sequence) {
+            conn.instance_name = in.str();
+            conn.scan_in_pin = in.str();
+            conn.scan_out_pin = in.str();
+            conn.ordered_segment = in.i32();
+        }
+    }
+    ObjectiveWeights& weights = db.objective_weights;
+    weights.alpha = in.f64();
+    weights.beta = in.f64();
+    weights.gamma = in.f64();
+    weights.initial_tns = in.f64();
+    weights.initial_power = in.f64();
+    weights.initial_area = in.f64();
+
+    in.expect_section(SECTION_GROUPS, "groups");
+    read_unordered(in, db.ff_compatibility_groups, [&]() {
+        std::string key = in.str();
+        return std::make_pair(key, in.strings());
+    });
+    db.hierarchical_ff_groups.clear();
+    size_t edge_count = in.count();
+    for (size_t e = 0; e < edge_count; e++) {
+        auto& interfaces = db.hierarchical_ff_groups[in.str()];
+        size_t interface_count = in.count();
+        for (size_t i = 0; i < interface_count; i++) {
+            auto& widths = interfaces[in.str()];
+            size_t width_count = in.count();
+            for (size_t w = 0; w < width_count; w++) {
+                int32_t width = in.i32();
+                widths[width] = in.strings();
+            }
+        }
+    }
+    db.ff_instance_groups.clear();
+    size_t group_count = in.count();
+    for (size_t g = 0; g < group_count; g++) {
+        auto& members = db.ff_instance_groups[in.str()];
+        members.resize(in.count());
+        for (auto& member : members) member = instance_at(in.i32());
+    }
+    db.optimal_ff_for_groups = in.string_map();
+    db.banking_eligible_groups = in.strings();
+    db.banking_candidate_instance_groups = in.strings();
+
+    in.expect_section(SECTION_HISTORY, "transformation history");
+    CheckpointAccess::read_history(in, db.transformation_history);
+
+    in.expect_section(SECTION_PIPELINE, "complete pipeline");
+    CompletePipeline& pipeline = db.complete_pipeline;
+    pipeline.stages.clear();
+    pipeline.stages.resize(in.count());
+    for (auto& stage : pipeline.stages) {
+        stage.stage_name = in.str();
+        stage.changed.resize(in.count());
+        for (auto& snapshot : stage.changed) snapshot = read_snapshot(in);
+        stage.removed = in.strings();
+        stage.transformation_indices.resize(in.count());
+        for (auto& index : stage.transformation_indices) index = static_cast<size_t>(in.u64());
+        stage.captured = in.boolean();
+        stage.total_instances = static_cast<size_t>(in.u64());
+        stage.ff_instances = static_cast<size_t>(in.u64());
+        stage.total_area = in.f64();
+        stage.total_power = in.f64();
+    }
+    pipeline.stage_index_map.clear();
+    size_t stage_names = in.count();
+    for (size_t i = 0; i < stage_names; i++) {
+        std::string name = in.str();
+        size_t index = static_cast<size_t>(in.u64());
+        if (index >= pipeline.stages.size()) throw CheckpointError("invalid stage index");
+        pipeline.stage_index_map[name] = index;
+    }
+    read_unordered(in, pipeline.live_view, [&]() {
+        std::string key = in.str();
+        size_t stage = static_cast<size_t>(in.u64());
+        size_t offset = static_cast<size_t>(in.u64());
+        if (stage >= pipeline.stages.size() || offset >= pipeline.stages[stage].changed.size()) {
+            throw CheckpointError("invalid pipeline view entry");
+        }
+        return std::make_pair(key, std::make_pair(stage, offset));
+    });
+
+    in.expect_section(SECTION_PROVENANCE, "pin provenance");
+    PinProvenance& provenance = db.pin_provenance;
+    provenance.clear();
+    std::vector<std::string> provenance_instances = in.strings();
+    for (const auto& name : provenance_instances) provenance.intern_instance(name);
+    std::vector<std::string> provenance_pins = in.strings();
+    for (const auto& name : provenance_pins) provenance.intern_pin(name);
+    if (provenance.instance_names.size() != provenance_instances.size() ||
+        provenance.pin_names.size() != provenance_pins.size()) {
+        throw CheckpointError("duplicate provenance names");
+    }
+    provenance.nodes.resize(in.count());
+    for (auto& node : provenance.nodes) {
+        node.instance_id = in.i32();
+        node.pin_id = in.i32();
+        node.forward = in.i32();
+        if (node.instance_id >= static_cast<int>(provenance_instances.size()) ||
+            node.pin_id >= static_cast<int>(provenance_pins.size()) ||
+            node.forward >= static_cast<int>(provenance.nodes.size())) {
+            throw CheckpointError("invalid provenance node");
+        }
+    }
+    in.pod_vector(provenance.original_pins);
+    read_unordered(in, provenance.live_nodes, [&]() {
+        unsigned long long key = in.u64();
+        return std::make_pair(key, static_cast<int>(in.i32()));
+    });
+
+    in.expect_section(SECTION_DUMMY_NAMES, "dummy names");
+    db.dummy_to_real_mapping = in.string_map();
+    db.real_to_dummy_mapping = in.string_map();
+    db.global_dummy_counter = in.i32();
+    db.banking_name_counters.fsdn2 = in.i32();
+    db.banking_name_counters.fsdn4 = in.i32();
+    db.banking_name_counters.lsrdpq4 = in.i32();
+    db.stats.total_instances = in.i32();
+    db.stats.flip_flop_count = in.i32();
+    db.stats.bankable_ff_count = in.i32();
+    db.stats.total_nets = in.i32();
+    db.stats.total_area = in.f64();
+    db.stats.total_power = in.f64();
+
+    in.expect_section(SECTION_END, "end");
+}
+
+// Read-only mapping of a whole file
+class MappedFile {
+public:
+    MappedFile() : data_(nullptr), size_(0) {}
+    ~MappedFile() {
+        if (data_) munmap(const_cast<char*>(data_), size_);
+    }
+
+    bool open(const std::string& filename) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(info.st_size);
+        void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) return false;
+        madvise(mapping, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(mapping);
+        return true;
+    }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data_;
+    size_t size_;
+};
+
+}  // namespace
+
+const std::vector<std::string>& checkpoint_step_keys() {
+    // Step 17 is part of Step 18 (same stage), so it is not a boundary
+    static const std::vector<std::string> keys = {
+        "1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "11",
+        "12", "13", "14", "15", "16", "18", "18.5", "19", "19.5"
+    };
+    return keys;
+}
+
+int checkpoint_step_rank(const std::string& step) {
+    const std::vector<std::string>& keys = checkpoint_step_keys();
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (keys[i] == step) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+bool save_checkpoint(const DesignDatabase& db, const std::string& step, const std::string& filename) {
+    Encoder body;
+    encode_database(body, db);
+    std::string strings = body.string_table();
+
+    Encoder header;
+    header.bytes(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header.u32(CHECKPOINT_BYTE_ORDER);
+    header.u32(CHECKPOINT_VERSION);
+    header.text(step);
+    header.u64(strings.size());
+    header.u64(body.body().size());
+    header.u64(fnv1a(body.body().data(), body.body().size(), fnv1a(strings.data(), strings.size())));
+
+    // 先寫暫存檔再rename，中途失敗不會留下半個checkpoint
+    std::string temp_filename = filename + ".tmp";
+    {
+        std::ofstream out(temp_filename, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            LOG_ERROR << "Cannot write checkpoint " << temp_filename;
+            return false;
+        }
+        out.write(header.body().data(), header.body().size());
+        out.write(strings.data(), strings.size());
+        out.write(body.body().data(), body.body().size());
+        if (!out) {
+            LOG_ERROR << "Failed while writing checkpoint " << temp_filename;
+            return false;
+        }
+    }
+    if (std::rename(temp_filename.c_str(), filename.c_str()) != 0) {
+        LOG_ERROR << "Cannot rename checkpoint to " << filename;
+        std::remove(temp_filename.c_str());
+        return false;
+    }
+
+    size_t total = header.body().size() + strings.size() + body.body().size();
+    std::cout << "  💾 Checkpoint after step " << step << " written to " << filename
+              << " (" << (total + 1023) / 1024 << " KB, " << db.instances.size() << " instances)" << std::endl;
+    return true;
+}
+
+bool load_checkpoint(const std::string& filename, DesignDatabase& db, std::string& step) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        LOG_ERROR << "Cannot open checkpoint " << filename;
+        return false;
+    }
+
+    Decoder header(file.data(), file.data() + file.size());
+    try {
+        if (std::memcmp(header.bytes(sizeof(CHECKPOINT_MAGIC)), CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0) {
+            throw CheckpointError("not a checkpoint file");
+        }
+        if (header.u32() != CHECKPOINT_BYTE_ORDER) throw CheckpointError("byte order mismatch");
+        uint32_t version = header.u32();
+        if (version != CHECKPOINT_VERSION) {
+            throw CheckpointError("unsupported version " + std::to_string(version) +
+                                  " (expected " + std::to_string(CHECKPOINT_VERSION) + ")");
+        }
+        std::string saved_step = header.text();
+        if (checkpoint_step_rank(saved_step) < 0) throw CheckpointError("unknown step " + saved_step);
+        uint64_t strings_size = header.u64();
+        uint64_t body_size = header.u64();
+        uint64_t checksum = header.u64();
+        if (strings_size > file.size() || body_size > file.size()) throw CheckpointError("truncated file");
+        const char* payload = header.bytes(static_cast<size_t>(strings_size + body_size));
+        if (!header.at_end()) throw CheckpointError("trailing data");
+        if (fnv1a(payload, static_cast<size_t>(strings_size + body_size)) != checksum) {
+            throw CheckpointError("checksum mismatch");
+        }
+
+        Decoder in(payload, payload + strings_size + body_size);
+        in.read_string_table();
+        DesignDatabase restored;
+        try {
+            decode_database(in, restored);
+        } catch (const CheckpointError& e) {
+            throw CheckpointError(std::string(e.what()) + " in section " + in.section());
+        }
+        if (!in.at_end()) throw CheckpointError("trailing data after last section");
+
+        db = std::move(restored);
+        step = saved_step;
+    } catch (const CheckpointError& e) {
+        LOG_ERROR << "Invalid checkpoint " << filename << ": " << e.what();
+        return false;
+    }
+
+    std::cout << "  💾 Restored checkpoint " << filename << " (after step " << step << "): "
+              << db.cell_library.size() << " cells, " << db.instances.size() << " instances, "
+              << db.nets.size() << " nets, " << db.transformation_history.size() << " transformation records"
+              << std::endl;
+    return true;
+}
@@ -0,0 +1,41 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <string>
+#include <vector>
+
+class DesignDatabase;
+
+// =============================================================================
+// BINARY CHECKPOINT / RESTORE OF DesignDatabase
+// =============================================================================
+// --checkpoint-after <step> 在該step結束時把整個DesignDatabase寫成binary檔，
+// --resume-from <file> 直接載入，跳過該step以前的所有parse / 分群 / substitution
+//
+// 檔案格式 (little-endian, versioned)：
+//   header : magic "MBFFCKPT", version, step key, body size, FNV-1a checksum
+//   strings: 所有字串只存一次 (cell / net / pin / instance名稱重複非常多)
+//   body   : 各section依序存放，字串以string id表示，
+//            shared_ptr (Instance -> CellTemplate, ff_instance_groups -> Instance)
+//            存成table index，載入時再fix-up回同一個物件
+// 載入時mmap整個檔案，字串table直接指向mapping，不做任何文字parsing
+// unordered_map會記錄bucket數並以相反順序插入，iteration順序和存檔時一樣，
+// resume後的輸出和完整執行逐byte相同
+// =============================================================================
+
+#define CHECKPOINT_VERSION 8
+#define CHECKPOINT_EXTENSION ".mbffckpt"
+
+// Step keys accepted by --checkpoint-after, in pipeline order
+const std::vector<std::string>& checkpoint_step_keys();
+
+// Position of `step` in checkpoint_step_keys(); -1 if unknown
+int checkpoint_step_rank(const std::string& step);
+
+// Write `db` as it is after `step`; false (with an error logged) on I/O failure
+bool save_checkpoint(const DesignDatabase& db, const std::string& step, const std::string& filename);
+
+// Replace `db` with the checkpoint contents and report the step it was taken after
+bool load_checkpoint(const std::string& filename, DesignDatabase& db, std::string& step);
+
+#endif // CHECKPOINT_HPP
@@ -0,0 +1,316 @@
+#include "clock_tracing.hpp"
+#include "parsers.hpp"
+#include "compressed_stream.hpp"
+#include "logger.hpp"
+#include "out_of_core.hpp"
+#include <iostream>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+// =============================================================================
+// SDC CLOCKS
+// =============================================================================
+
+namespace {
+
+// SDC command tokens: words, {brace lists} and [bracket commands] stay whole
+std::vector<std::string> tokenize_sdc_command(const std::string& command) {
+    std::vector<std::string> tokens;
+    size_t pos = 0;
+    while (pos < command.size()) {
+        while (pos < command.size() && std::isspace(static_cast<unsigned char>(command[pos]))) pos++;
+        if (pos >= command.size()) break;
+        size_t start = pos;
+        char open = command[pos];
+        if (open == '{' || open == '[') {
+            char close = open == '{' ? '}' : ']';
+            int depth = 0;
+            do {
+                if (command[pos] == open) depth++;
+                else if (command[pos] == close) depth--;
+                pos++;
+            } while (pos < command.size() && depth > 0);
+        } else {
+            while (pos < command.size() && !std::isspace(static_cast<unsigned char>(command[pos]))) pos++;
+        }
+        tokens.push_back(command.substr(start, pos - start));
+    }
+    return tokens;
+}
+
+// "[get_ports {clk}]" / "{a b}" / "clk" -> object names (get_pins keeps "inst/pin")
+std::vector<std::string> sdc_object_names(const std::string& token) {
+    std::string text = token;
+    if (!text.empty() && text[0] == '[') {
+        std::vector<std::string> inner = tokenize_sdc_command(text.substr(1, text.size() - 2));
+        text.clear();
+        for (size_t i = 1; i < inner.size(); i++) {
+            if (inner[i][0] == '-') continue;   // -hierarchical, -quiet, ...
+            text += " " + inner[i];
+        }
+    }
+    std::vector<std::string> names;
+    for (const auto& word : tokenize_sdc_command(text)) {
+        std::string name = word;
+        if (!name.empty() && name[0] == '{') {
+            for (const auto& item : tokenize_sdc_command(name.substr(1, name.size() - 2))) names.push_back(item);
+        } else if (!name.empty()) {
+            names.push_back(name);
+        }
+    }
+    return names;
+}
+
+} // namespace
+
+void parse_sdc_file(const std::string& filepath, DesignDatabase& db) {
+    std::cout << "  Parsing: " << filepath << std::endl;
+
+    InputFile file(filepath);
+    if (!file.is_open()) {
+        std::cout << "  ERROR: Cannot open " << filepath << std::endl;
+        return;
+    }
+
+    // create_clock -name NAME ... [get_ports {clk}]
+    // create_generated_clock -name NAME -source [get_ports clk] ... [get_pins div_reg/Q]
+    // 只記target (最後的object list)；-source是master clock不是target
+    int clock_count = 0;
+    std::string line, command;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty() && line.back() == '\\') {
+            command += line.substr(0, line.size() - 1) + " ";
+            continue;
+        }
+        command += line;
+        std::vector<std::string> tokens = tokenize_sdc_command(command);
+        command.clear();
+        if (tokens.empty() || (tokens[0] != "create_clock" && tokens[0] != "create_generated_clock")) continue;
+
+        std::string clock_name;
+        std::vector<std::string> targets;
+        for (size_t i = 1; i < tokens.size(); i++) {
+            const std::string& token = tokens[i];
+            if (token == "-name" && i + 1 < tokens.size()) {
+                std::vector<std::string> names = sdc_object_names(tokens[++i]);
+                if (!names.empty()) clock_name = names.front();
+            } else if (token == "-add" || token == "-invert" || token == "-preinvert" || token == "-combinational") {
+                continue;
+            } else if (token[0] == '-') {
+                i++;   // -period / -waveform / -source / -divide_by / ... take one value
+            } else {
+                std::vector<std::string> names = sdc_object_names(token);
+                targets.insert(targets.end(), names.begin(), names.end());
+            }
+        }
+        if (targets.empty()) continue;   // virtual clock
+        if (clock_name.empty()) clock_name = targets.front();
+        for (const auto& target : targets) db.sdc_clocks.emplace(target, clock_name);
+        clock_count++;
+    }
+
+    std::cout << "    Parsed " << clock_count << " clocks (" << db.sdc_clocks.size() << " source objects)" << std::endl;
+}
+
+// =============================================================================
+// CLOCK TREE TRACING
+// =============================================================================
+
+namespace {
+
+bool is_active_clock_net(const std::string& net) {
+    return !net.empty() && net != "UNCONNECTED" && net.find("SYNOPSYS_UNCONNECTED") == std::string::npos &&
+           net != "VSS" && net != "VDD";
+}
+
+const std::string* connection_net(const std::vector<Instance::Connection>& connections, const std::string& pin_name) {
+    for (const auto& conn : connections) {
+        if (conn.pin_name == pin_name) return &conn.net_name;
+    }
+    return nullptr;
+}
+
+std::string net_key(const std::string& module_name, const std::string& net_name) {
+    return module_name + "/" + net_name;
+}
+
+// Clock tree cell driving a net: clock input net (empty = root) and ICG enable net
+struct ClockDriver {
+    const CellTemplate* cell = nullptr;
+    std::string input;
+    std::string enable;
+};
+typedef std::unordered_map<std::string, ClockDriver> ClockDriverMap;   // module/net -> driver
+
+void add_clock_driver(ClockDriverMap& drivers, const std::string& module_name, const CellTemplate* cell,
+                      const std::vector<Instance::Connection>& connections) {
+    if (!cell || cell->clock_role == CellTemplate::NOT_CLOCK_CELL) return;
+    const std::string* out = connection_net(connections, cell->clock_out_pin);
+    if (!out || !is_active_clock_net(*out)) return;
+    ClockDriver driver;
+    driver.cell = cell;
+    const std::string* input = connection_net(connections, cell->clock_in_pin);
+    if (input && is_active_clock_net(*input)) driver.input = *input;
+    if (cell->clock_role == CellTemplate::CLOCK_GATE) {
+        const std::string* enable = connection_net(connections, cell->clock_enable_pin);
+        driver.enable = enable ? *enable : std::string("UNCONNECTED");
+    }
+    drivers.emplace(net_key(module_name, *out), driver);
+}
+
+struct ClockTrace {
+    std::string root;        // SDC clock name or root net
+    bool inverted = false;   // Odd number of inversions between root and this net
+    std::string enables;     // "&<enable net>" per ICG, root -> leaf
+
+    std::string label() const { return root + (inverted ? "~" : "") + enables; }
+};
+
+} // namespace
+
+void trace_clock_domains(DesignDatabase& db) {
+    std::cout << "  Tracing FF clock pins through the clock tree..." << std::endl;
+    db.clock_domain_labels.clear();
+
+    // SDC targets -> root clock name：get_pins target經由instance的connection對到net
+    std::unordered_map<std::string, std::string> clock_of_key;   // module/net
+    std::unordered_map<std::string, std::string> clock_of_net;   // port / net name in any module
+    for (const auto& entry : db.sdc_clocks) {
+        size_t slash = entry.first.rfind('/');
+        if (slash != std::string::npos) {
+            auto inst = db.instances.find(entry.first.substr(0, slash));
+            if (inst != db.instances.end() && inst->second) {
+                const std::string* net = connection_net(inst->second->connections, entry.first.substr(slash + 1));
+                if (net && is_active_clock_net(*net)) {
+                    clock_of_key.emplace(net_key(inst->second->module_name, *net), entry.second);
+                    continue;
+                }
+            }
+        }
+        clock_of_net.emplace(entry.first, entry.second);
+    }
+
+    // 每個module的 clock tree cell output net -> cell
+    ClockDriverMap clock_drivers;
+    for (const auto& pair : db.instances) {
+        const Instance* instance = pair.second.get();
+        add_clock_driver(clock_drivers, instance->module_name, instance->cell_template.get(), instance->connections);
+    }
+
+    // -out_of_core：clock tree cell在spill檔，追到某個net時才從net index讀入net上的cell
+    // (driver和get_pins target都在這時對上)
+    std::unordered_map<std::string, size_t> module_of_name;
+    if (db.out_of_core) {
+        for (size_t m = 0; m < db.modules.size(); m++) module_of_name.emplace(db.modules[m].name, m);
+    }
+    auto page_in = [&](const std::string& module_name, const std::string& net, const std::string& key) {
+        auto module = module_of_name.find(module_name);
+        if (module == module_of_name.end()) return;
+        for (const SpilledInstance& instance : db.out_of_core->net_instances(net, module->second)) {
+            for (const auto& conn : instance.connections) {
+                if (conn.net_name != net) continue;
+                auto clock = db.sdc_clocks.find(instance.name + "/" + conn.pin_name);
+                if (clock != db.sdc_clocks.end()) clock_of_key.emplace(key, clock->second);
+            }
+            add_clock_driver(clock_drivers, module_name, db.get_cell(instance.cell_type).get(), instance.connections);
+        }
+    };
+
+    // net往回走到root或已追過的net，再由root往leaf累積反相和ICG enable
+    std::unordered_map<std::string, ClockTrace> traces;   // module/net -> trace
+    std::unordered_set<std::string> clock_nets;
+    int role_counts[CellTemplate::CLOCK_GATE + 1] = {0, 0, 0, 0};   // 只算FF CK往回追到的cell
+    int stopped = 0;
+    auto trace = [&](const std::string& module_name, const std::string& leaf_net) -> const ClockTrace& {
+        std::vector<std::pair<std::string, const ClockDriver*>> path;   // (net key, driving clock tree cell)
+        std::unordered_set<std::string> on_path;
+        std::string net = leaf_net;
+        std::string key = net_key(module_name, net);
+        ClockTrace base;
+        while (true) {
+            auto known = traces.find(key);
+            if (known != traces.end()) {
+                base = known->second;
+                break;
+            }
+            clock_nets.insert(net);
+            if (db.out_of_core) page_in(module_name, net, key);
+            auto driver = clock_drivers.find(key);
+            const std::string* input = nullptr;
+            if (driver != clock_drivers.end()) {
+                if (path.size() >= CLOCK_TRACE_MAX_DEPTH || !on_path.insert(key).second) {
+                    LOG_HOT << "      Clock trace stopped at " << net << " (module " << module_name << ")";
+                    stopped++;
+                } else {
+                    if (!driver->second.input.empty()) input = &driver->second.input;
+                }
+            }
+            if (!input) {
+                auto clock = clock_of_key.find(key);
+                if (clock == clock_of_key.end()) {
+                    clock = clock_of_net.find(net);
+                    base.root = clock != clock_of_net.end() ? clock->second : net;
+                } else {
+                    base.root = clock->second;
+                }
+                traces[key] = base;
+                break;
+            }
+            path.emplace_back(key, &driver->second);
+            net = *input;
+            key = net_key(module_name, net);
+        }
+        for (size_t i = path.size(); i-- > 0;) {
+            const ClockDriver& driver = *path[i].second;
+            role_counts[driver.cell->clock_role]++;   // path上的net都會memoize，每個cell只算一次
+            if (driver.cell->clock_out_inverted) base.inverted = !base.inverted;
+            if (driver.cell->clock_role == CellTemplate::CLOCK_GATE) base.enables += "&" + driver.enable;
+            traces[path[i].first] = base;
+        }
+        return traces[net_key(module_name, leaf_net)];
+    };
+
+    // 每個FF CK net追一次；label和net名稱相同時不記 (lookup直接回傳net名稱)
+    std::set<std::string> domains;
+    std::unordered_set<std::string> traced_ck_nets;
+    for (const auto& pair : db.instances) {
+        const Instance* instance = pair.second.get();
+        if (!instance->is_flip_flop()) continue;
+        for (const auto& conn : instance->connections) {
+            if (classify_ff_pin_type(conn.pin_name) != Pin::FF_CLOCK || !is_active_clock_net(conn.net_name)) continue;
+            std::string key = net_key(instance->module_name, conn.net_name);
+            if (!traced_ck_nets.insert(key).second) continue;
+            std::string label = trace(instance->module_name, conn.net_name).label();
+            if (label != conn.net_name) db.clock_domain_labels[key] = label;
+            if (domains.insert(label).second) {
+                LOG_HOT << "      Clock domain " << label << " (from " << conn.net_name << ")";
+            }
+        }
+    }
+
+    for (const auto& name : clock_nets) {
+        auto net = db.nets.find(name);
+        if (net != db.nets.end() && net->second) {
+            net->second->type = Net::CLOCK;
+            net->second->is_clock_net = true;
+        }
+    }
+
+    std::cout << "    Clock tree cells on FF clock paths: " << role_counts[CellTemplate::CLOCK_BUFFER] << " buffers, "
+              << role_counts[CellTemplate::CLOCK_INVERTER] << " inverters, "
+              << role_counts[CellTemplate::CLOCK_GATE] << " clock gates" << std::endl;
+    std::cout << "    FF clock nets: " << traced_ck_nets.size() << " -> " << domains.size() << " clock domains" << std::endl;
+    if (stopped > 0) {
+        LOG_WARN << "Clock tracing: " << stopped << " clock nets in loops or deeper than "
+                 << CLOCK_TRACE_MAX_DEPTH << " cells were treated as roots";
+    }
+}
+
+const std::string& clock_domain_label(const DesignDatabase& db, const std::string& module_name,
+                                      const std::string& net_name) {
+    if (db.clock_domain_labels.empty()) return net_name;
+    auto it = db.clock_domain_labels.find(net_key(module_name, net_name));
+    return it != db.clock_domain_labels.end() ? it->second : net_name;
+}
@@ -0,0 +1,38 @@
+#ifndef CLOCK_TRACING_HPP
+#define CLOCK_TRACING_HPP
+
+#include <string>
+
+class DesignDatabase;
+
+// =============================================================================
+// CLOCK DOMAIN TRACING (SDC in step 5, tracing in step 7)
+// =============================================================================
+// FF的CK net常常是clock tree的leaf (clk經過buffer / inverter / ICG後的net)，
+// 直接比net名稱會把同一個clock的FF分成很多group。這裡從每個FF的CK net往回追：
+//   1. Liberty標出clock tree cell (CellTemplate::clock_role)：單輸入單輸出、function是
+//      輸入本身 (buffer) 或反相 (inverter)，以及clock_gating_integrated_cell (ICG)
+//   2. 每個module建 output net -> clock tree cell 的driver表，沿driver的clock輸入往回走，
+//      直到沒有clock tree cell driver的net (root)；每個net只追一次 (memoized)
+//   3. root是SDC create_clock / create_generated_clock的port / net / pin時用clock名稱，
+//      否則用net名稱
+// 每個CK net得到一個label：root clock，奇數個反相時加 "~"，經過的ICG依root -> leaf
+// 加 "&<enable net>"。沒有clock tree cell的CK net，label就是SDC clock名稱或net名稱本身
+// Banking group (step 16.5) 用label (-param clock_leaf_group_min_ffs可讓FF夠多的leaf net自己一個group)
+// net名稱是module內的local名稱，追蹤只在同一個module內進行 (不跨hierarchy port)
+// -out_of_core時組合邏輯cell不在db.instances：追到的每個net從net index讀入net上的cell
+// =============================================================================
+
+#define CLOCK_TRACE_MAX_DEPTH 64            // Clock tree cells followed from one CK net before giving up
+
+// SDC create_clock / create_generated_clock targets -> db.sdc_clocks (other commands are skipped)
+void parse_sdc_file(const std::string& filepath, DesignDatabase& db);
+
+// Label every FF CK net with (root clock, edge parity, gating enables) -> db.clock_domain_labels
+void trace_clock_domains(DesignDatabase& db);
+
+// Traced label of a CK net; nets that were not traced return the net name itself
+const std::string& clock_domain_label(const DesignDatabase& db, const std::string& module_name,
+                                      const std::string& net_name);
+
+#endif // CLOCK_TRACING_HPP
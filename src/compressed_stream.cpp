@@ -0,0 +1,752 @@
+#include "compressed_stream.hpp"
+#include "logger.hpp"
+#include <zlib.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+bool ends_with(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// =============================================================================
+// CHUNK QUEUE (I/O thread <-> parser / writer)
+// =============================================================================
+
+class ChunkQueue {
+public:
+    // Producer side; false once the consumer has cancelled
+    bool push(std::vector<char>&& chunk) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return cancelled_ || chunks_.size() < COMPRESSED_QUEUE_DEPTH; });
+        if (cancelled_) return false;
+        chunks_.push_back(std::move(chunk));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // End of stream ("" = success)
+    void finish(const std::string& error) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_ = true;
+        error_ = error;
+        not_empty_.notify_all();
+    }
+
+    // Consumer side; false at the end of the stream
+    bool pop(std::vector<char>& chunk) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return cancelled_ || finished_ || !chunks_.empty(); });
+        if (chunks_.empty()) return false;
+        chunk = std::move(chunks_.front());
+        chunks_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    void cancel() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+        chunks_.clear();
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+    std::string error() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return error_;
+    }
+
+    // 用完的chunk還回來給producer重用 (不必每個chunk重新配置 / page fault)
+    void recycle(std::vector<char>&& chunk) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (spare_.size() < COMPRESSED_QUEUE_DEPTH) spare_.push_back(std::move(chunk));
+    }
+
+    std::vector<char> take_spare() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (spare_.empty()) return std::vector<char>();
+        std::vector<char> chunk = std::move(spare_.back());
+        spare_.pop_back();
+        return chunk;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<std::vector<char>> chunks_;
+    std::vector<std::vector<char>> spare_;
+    bool finished_ = false;
+    bool cancelled_ = false;
+    std::string error_;
+};
+
+// =============================================================================
+// HELPER PROCESS (zstd)
+// =============================================================================
+
+bool program_in_path(const std::string& program) {
+    const char* path = std::getenv("PATH");
+    if (!path) return false;
+    std::string dirs(path);
+    size_t start = 0;
+    while (start <= dirs.size()) {
+        size_t end = dirs.find(':', start);
+        if (end == std::string::npos) end = dirs.size();
+        std::string candidate = (end > start ? dirs.substr(start, end - start) : ".") + "/" + program;
+        if (access(candidate.c_str(), X_OK) == 0) return true;
+        start = end + 1;
+    }
+    return false;
+}
+
+// argv[0]在PATH裡找；child的 child_fd (0 = stdin, 1 = stdout) 接到pipe，parent拿另一端
+pid_t spawn_with_pipe(const std::vector<std::string>& argv, int child_fd, int& parent_fd) {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) return -1;
+    int child_end = child_fd == 0 ? fds[0] : fds[1];
+    parent_fd = child_fd == 0 ? fds[1] : fds[0];
+
+    std::vector<char*> raw;
+    for (const auto& arg : argv) raw.push_back(const_cast<char*>(arg.c_str()));
+    raw.push_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(child_end, child_fd);   // dup2清掉CLOEXEC
+        execvp(raw[0], raw.data());
+        _exit(127);
+    }
+    close(child_end);
+    if (pid < 0) {
+        close(parent_fd);
+        parent_fd = -1;
+    }
+    return pid;
+}
+
+std::string wait_status(pid_t pid, const std::string& what) {
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return what + ": waitpid failed";
+    }
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0) return "";
+    if (WIFEXITED(status)) return what + " exited with status " + std::to_string(WEXITSTATUS(status));
+    return what + " was killed by signal " + std::to_string(WTERMSIG(status));
+}
+
+// =============================================================================
+// DECOMPRESSING SOURCES
+// =============================================================================
+
+class ByteSource {
+public:
+    virtual ~ByteSource() {}
+    // Bytes read (0 = end of stream, -1 = error in `error`)
+    virtual long read(char* data, size_t size) = 0;
+    // Called at the end of the stream; "" = success
+    virtual std::string finish() { return ""; }
+    std::string error;
+};
+
+class PlainSource : public ByteSource {
+public:
+    PlainSource(const std::string& path, off_t offset) {
+        fd_ = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) return;
+        if (offset > 0 && lseek(fd_, offset, SEEK_SET) != offset) {
+            close(fd_);
+            fd_ = -1;
+            return;
+        }
+        // 循序讀：kernel加大read-ahead window
+        posix_fadvise(fd_, offset, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    ~PlainSource() override {
+        if (fd_ >= 0) close(fd_);
+    }
+    bool ok() const { return fd_ >= 0; }
+
+    long read(char* data, size_t size) override {
+        while (true) {
+            ssize_t count = ::read(fd_, data, size);
+            if (count >= 0) return static_cast<long>(count);
+            if (errno == EINTR) continue;
+            error = std::strerror(errno);
+            return -1;
+        }
+    }
+
+private:
+    int fd_ = -1;
+};
+
+class GzipSource : public ByteSource {
+public:
+    explicit GzipSource(const std::string& path) : path_(path) {
+        file_ = gzopen(path.c_str(), "rb");
+        if (file_) gzbuffer(file_, 1 << 18);
+    }
+    ~GzipSource() override {
+        if (file_) gzclose_r(file_);
+    }
+    bool ok() const { return file_ != nullptr; }
+
+    long read(char* data, size_t size) override {
+        int count = gzread(file_, data, static_cast<unsigned>(size));
+        if (count < 0) {
+            error = gzip_error();
+            return -1;
+        }
+        return count;
+    }
+
+    // 截斷的.gz：gzread回傳0，錯誤 (Z_BUF_ERROR) 只留在gzerror
+    std::string finish() override { return gzip_error(); }
+
+private:
+    // gzerror的訊息前面帶著檔名，去掉
+    std::string gzip_error() {
+        int code = Z_OK;
+        std::string message = gzerror(file_, &code);
+        if (code == Z_OK) return "";
+        if (message.compare(0, path_.size() + 2, path_ + ": ") == 0) message.erase(0, path_.size() + 2);
+        return message;
+    }
+
+    std::string path_;
+    gzFile file_ = nullptr;
+};
+
+class ProcessSource : public ByteSource {
+public:
+    explicit ProcessSource(const std::string& path) {
+        pid_ = spawn_with_pipe({COMPRESSED_ZSTD_PROGRAM, "-dcq", "--", path}, 1, fd_);
+    }
+    ~ProcessSource() override {
+        // 提早結束 (seek / close)：關掉pipe讓zstd結束，不理會它的exit status
+        if (fd_ >= 0) close(fd_);
+        if (pid_ > 0) wait_status(pid_, COMPRESSED_ZSTD_PROGRAM);
+    }
+    bool ok() const { return pid_ > 0; }
+
+    long read(char* data, size_t size) override {
+        while (true) {
+            ssize_t count = ::read(fd_, data, size);
+            if (count >= 0) return static_cast<long>(count);
+            if (errno == EINTR) continue;
+            error = std::strerror(errno);
+            return -1;
+        }
+    }
+
+    std::string finish() override {
+        close(fd_);
+        fd_ = -1;
+        pid_t pid = pid_;
+        pid_ = -1;
+        return wait_status(pid, COMPRESSED_ZSTD_PROGRAM " -dc");
+    }
+
+private:
+    pid_t pid_ = -1;
+    int fd_ = -1;
+};
+
+// =============================================================================
+// COMPRESSING SINKS
+// =============================================================================
+
+class ByteSink {
+public:
+    virtual ~ByteSink() {}
+    virtual bool write(const char* data, size_t size) = 0;
+    // Flush and close; "" = success
+    virtual std::string finish() = 0;
+    std::string error;
+};
+
+class GzipSink : public ByteSink {
+public:
+    explicit GzipSink(const std::string& path) {
+        std::string mode = "wb" + std::to_string(COMPRESSED_GZIP_LEVEL);
+        file_ = gzopen(path.c_str(), mode.c_str());
+        if (file_) gzbuffer(file_, 1 << 18);
+    }
+    ~GzipSink() override {
+        if (file_) gzclose_w(file_);
+    }
+    bool ok() const { return file_ != nullptr; }
+
+    bool write(const char* data, size_t size) override {
+        if (size == 0) return true;
+        if (gzwrite(file_, data, static_cast<unsigned>(size)) == 0) {
+            int code = 0;
+            error = gzerror(file_, &code);
+            return false;
+        }
+        return true;
+    }
+
+    std::string finish() override {
+        int status = gzclose_w(file_);
+        file_ = nullptr;
+        return status == Z_OK ? "" : "gzip close failed (" + std::to_string(status) + ")";
+    }
+
+private:
+    gzFile file_ = nullptr;
+};
+
+class ProcessSink : public ByteSink {
+public:
+    explicit ProcessSink(const std::string& path) {
+        pid_ = spawn_with_pipe({COMPRESSED_ZSTD_PROGRAM, "-qf", "-o", path}, 0, fd_);
+    }
+    ~ProcessSink() override {
+        if (fd_ >= 0) close(fd_);
+        if (pid_ > 0) wait_status(pid_, COMPRESSED_ZSTD_PROGRAM);
+    }
+    bool ok() const { return pid_ > 0; }
+
+    bool write(const char* data, size_t size) override {
+        while (size > 0) {
+            ssize_t count = ::write(fd_, data, size);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                error = std::strerror(errno);
+                return false;
+            }
+            data += count;
+            size -= static_cast<size_t>(count);
+        }
+        return true;
+    }
+
+    std::string finish() override {
+        close(fd_);
+        fd_ = -1;
+        pid_t pid = pid_;
+        pid_ = -1;
+        return wait_status(pid, COMPRESSED_ZSTD_PROGRAM);
+    }
+
+private:
+    pid_t pid_ = -1;
+    int fd_ = -1;
+};
+
+} // namespace
+
+// =============================================================================
+// FORMAT DETECTION
+// =============================================================================
+
+Compression compression_from_extension(const std::string& path) {
+    if (ends_with(path, ".gz")) return Compression::GZIP;
+    if (ends_with(path, ".zst")) return Compression::ZSTD;
+    return Compression::NONE;
+}
+
+Compression detect_compression(const std::string& path) {
+    unsigned char magic[4] = {0, 0, 0, 0};
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return compression_from_extension(path);
+    size_t count = std::fread(magic, 1, sizeof(magic), file);
+    std::fclose(file);
+    if (count >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) return Compression::GZIP;
+    if (count >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+        return Compression::ZSTD;
+    }
+    return Compression::NONE;
+}
+
+std::string strip_compression_extension(const std::string& path) {
+    if (ends_with(path, ".gz")) return path.substr(0, path.size() - 3);
+    if (ends_with(path, ".zst")) return path.substr(0, path.size() - 4);
+    return path;
+}
+
+std::string compression_suffix(const std::string& format) {
+    if (format == "gz") return ".gz";
+    if (format == "zst") return ".zst";
+    return "";
+}
+
+const char* compression_name(Compression compression) {
+    switch (compression) {
+        case Compression::GZIP: return "gzip";
+        case Compression::ZSTD: return "zstd";
+        default: return "none";
+    }
+}
+
+// =============================================================================
+// PREFETCH (command-line order)
+// =============================================================================
+
+namespace {
+
+std::mutex prefetch_mutex;
+std::vector<std::string> prefetch_order;
+std::vector<bool> prefetch_issued;
+
+// 只是hint：kernel在背景把檔案讀進page cache
+void prefetch_file(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    close(fd);
+}
+
+} // namespace
+
+void set_input_prefetch_order(const std::vector<std::string>& paths) {
+    std::lock_guard<std::mutex> lock(prefetch_mutex);
+    prefetch_order = paths;
+    prefetch_issued.assign(paths.size(), false);
+}
+
+void prefetch_next_input(const std::string& path) {
+    std::string next;
+    {
+        std::lock_guard<std::mutex> lock(prefetch_mutex);
+        for (size_t i = 0; i < prefetch_order.size(); i++) {
+            if (prefetch_order[i] != path) continue;
+            prefetch_issued[i] = true;
+            if (i + 1 < prefetch_order.size() && !prefetch_issued[i + 1]) {
+                prefetch_issued[i + 1] = true;
+                next = prefetch_order[i + 1];
+            }
+            break;
+        }
+    }
+    if (!next.empty()) prefetch_file(next);
+}
+
+// =============================================================================
+// ReadAheadBuffer：背景thread讀檔 / 解壓，前景依chunk讀
+// =============================================================================
+
+class ReadAheadBuffer : public std::streambuf {
+public:
+    ReadAheadBuffer(const std::string& path, Compression compression)
+        : path_(path), compression_(compression) {
+        ok_ = start(0);
+    }
+    ~ReadAheadBuffer() override { stop(); }
+
+    bool ok() const { return ok_; }
+
+protected:
+    int_type underflow() override {
+        if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+        chunk_start_ += static_cast<std::streamoff>(chunk_.size());
+        chunk_.clear();
+        setg(nullptr, nullptr, nullptr);
+        std::vector<char> next;
+        if (!queue_ || !queue_->pop(next)) {
+            std::string error = queue_ ? queue_->error() : "";
+            if (!error.empty() && !reported_) {
+                reported_ = true;
+                LOG_ERROR << (compression_ == Compression::NONE ? "Cannot read " : "Cannot decompress ")
+                          << path_ << ": " << error;
+            }
+            return traits_type::eof();
+        }
+        if (chunk_.capacity() > 0) queue_->recycle(std::move(chunk_));
+        chunk_.swap(next);
+        setg(chunk_.data(), chunk_.data(), chunk_.data() + chunk_.size());
+        return traits_type::to_int_type(*gptr());
+    }
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+        if (!(which & std::ios_base::in) || dir == std::ios_base::end) return pos_type(off_type(-1));
+        off_type target = dir == std::ios_base::cur ? position() + off : off;
+        if (dir == std::ios_base::cur && off == 0) return pos_type(target);
+        return seekpos(pos_type(target), which);
+    }
+
+    // 目前chunk內：直接移動；未壓縮：從target重新開始讀
+    // 壓縮檔往前：丟掉中間的資料；往回：從頭重新解壓
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+        off_type target = off_type(pos);
+        if (!(which & std::ios_base::in) || target < 0) return pos_type(off_type(-1));
+        off_type chunk_end = chunk_start_ + static_cast<off_type>(chunk_.size());
+        if (target >= chunk_start_ && target < chunk_end) {
+            setg(chunk_.data(), chunk_.data() + (target - chunk_start_), chunk_.data() + chunk_.size());
+            return pos;
+        }
+        if (compression_ == Compression::NONE || target < chunk_start_) {
+            off_type restart = compression_ == Compression::NONE ? target : 0;
+            stop();
+            chunk_ = std::vector<char>();
+            chunk_start_ = restart;
+            setg(nullptr, nullptr, nullptr);
+            if (!start(restart)) return pos_type(off_type(-1));
+            if (restart == target) return pos;
+        }
+        while (target > chunk_start_ + static_cast<off_type>(chunk_.size())) {
+            setg(eback(), egptr(), egptr());
+            if (traits_type::eq_int_type(underflow(), traits_type::eof())) return pos_type(off_type(-1));
+        }
+        if (!chunk_.empty()) setg(chunk_.data(), chunk_.data() + (target - chunk_start_), chunk_.data() + chunk_.size());
+        return pos;
+    }
+
+private:
+    off_type position() const {
+        return chunk_start_ + (eback() ? static_cast<off_type>(gptr() - eback()) : 0);
+    }
+
+    bool start(off_type offset) {
+        if (compression_ == Compression::NONE) {
+            PlainSource* plain = new PlainSource(path_, static_cast<off_t>(offset));
+            source_.reset(plain);
+            if (!plain->ok()) return false;
+        } else if (compression_ == Compression::GZIP) {
+            GzipSource* gzip = new GzipSource(path_);
+            source_.reset(gzip);
+            if (!gzip->ok()) return false;
+        } else {
+            if (!program_in_path(COMPRESSED_ZSTD_PROGRAM)) {
+                LOG_ERROR << "Cannot decompress " << path_ << ": " << COMPRESSED_ZSTD_PROGRAM << " not found in PATH";
+                return false;
+            }
+            ProcessSource* process = new ProcessSource(path_);
+            source_.reset(process);
+            if (!process->ok()) return false;
+        }
+        queue_.reset(new ChunkQueue());
+        ChunkQueue* queue = queue_.get();
+        ByteSource* source = source_.get();
+        reader_ = std::thread([queue, source]() {
+            while (true) {
+                std::vector<char> chunk = queue->take_spare();
+                chunk.resize(COMPRESSED_CHUNK_SIZE);
+                size_t filled = 0;
+                while (filled < chunk.size()) {
+                    long count = source->read(chunk.data() + filled, chunk.size() - filled);
+                    if (count < 0) {
+                        queue->finish(source->error);
+                        return;
+                    }
+                    if (count == 0) break;
+                    filled += static_cast<size_t>(count);
+                }
+                bool last = filled < chunk.size();
+                chunk.resize(filled);
+                if (filled > 0 && !queue->push(std::move(chunk))) return;
+                if (last) {
+                    queue->finish(source->finish());
+                    return;
+                }
+            }
+        });
+        return true;
+    }
+
+    void stop() {
+        if (queue_) queue_->cancel();
+        if (reader_.joinable()) reader_.join();
+        queue_.reset();
+        source_.reset();
+    }
+
+    std::string path_;
+    Compression compression_;
+    bool ok_ = false;
+    bool reported_ = false;
+    std::unique_ptr<ByteSource> source_;
+    std::unique_ptr<ChunkQueue> queue_;
+    std::thread reader_;
+    std::vector<char> chunk_;
+    off_type chunk_start_ = 0;      // Decompressed offset of chunk_[0]
+};
+
+// =============================================================================
+// CompressedOutputBuffer：前景格式化，背景壓縮 / 寫檔
+// =============================================================================
+
+class CompressedOutputBuffer : public std::streambuf {
+public:
+    CompressedOutputBuffer(const std::string& path, Compression compression) : path_(path) {
+        if (compression == Compression::GZIP) {
+            GzipSink* gzip = new GzipSink(path);
+            sink_.reset(gzip);
+            ok_ = gzip->ok();
+        } else if (program_in_path(COMPRESSED_ZSTD_PROGRAM)) {
+            ProcessSink* process = new ProcessSink(path);
+            sink_.reset(process);
+            ok_ = process->ok();
+        } else {
+            LOG_ERROR << "Cannot compress " << path << ": " << COMPRESSED_ZSTD_PROGRAM << " not found in PATH";
+        }
+        if (!ok_) return;
+
+        ChunkQueue* queue = &queue_;
+        ByteSink* sink = sink_.get();
+        std::atomic<bool>* failed = &write_failed_;
+        writer_ = std::thread([queue, sink, failed]() {
+            // zstd提早結束時write回EPIPE，不讓SIGPIPE結束整個程式
+            sigset_t pipe_signal;
+            sigemptyset(&pipe_signal);
+            sigaddset(&pipe_signal, SIGPIPE);
+            pthread_sigmask(SIG_BLOCK, &pipe_signal, nullptr);
+            std::vector<char> chunk;
+            while (queue->pop(chunk)) {
+                if (!sink->write(chunk.data(), chunk.size())) {
+                    *failed = true;
+                    queue->cancel();
+                    return;
+                }
+            }
+        });
+        buffer_.resize(COMPRESSED_CHUNK_SIZE);
+        setp(buffer_.data(), buffer_.data() + buffer_.size());
+    }
+    ~CompressedOutputBuffer() override { finish(); }
+
+    bool ok() const { return ok_; }
+
+    bool finish() {
+        if (!ok_ || finished_) return ok_ && !write_failed_;
+        finished_ = true;
+        bool queued = flush_chunk();
+        queue_.finish("");
+        writer_.join();
+        std::string error = write_failed_ ? sink_->error : "";
+        std::string close_error = sink_->finish();
+        if (error.empty()) error = close_error;
+        if (!queued && error.empty()) error = "write failed";
+        if (!error.empty()) {
+            LOG_ERROR << "Cannot write " << path_ << ": " << error;
+            write_failed_ = true;
+        }
+        return !write_failed_;
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (finished_ || !flush_chunk()) return traits_type::eof();
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    // std::endl每行都會flush；壓縮串流等chunk滿了才送出
+    int sync() override { return write_failed_ ? -1 : 0; }
+
+private:
+    bool flush_chunk() {
+        size_t size = static_cast<size_t>(pptr() - pbase());
+        if (size == 0) return !write_failed_;
+        buffer_.resize(size);
+        bool queued = queue_.push(std::move(buffer_));
+        buffer_ = std::vector<char>(COMPRESSED_CHUNK_SIZE);
+        setp(buffer_.data(), buffer_.data() + buffer_.size());
+        return queued;
+    }
+
+    std::string path_;
+    bool ok_ = false;
+    bool finished_ = false;
+    std::atomic<bool> write_failed_{false};   // writer thread設，呼叫端thread讀
+    std::unique_ptr<ByteSink> sink_;
+    ChunkQueue queue_;
+    std::thread writer_;
+    std::vector<char> buffer_;
+};
+
+// =============================================================================
+// InputFile / OutputFile
+// =============================================================================
+
+InputFile::InputFile(const std::string& path) : std::istream(nullptr) {
+    compression_ = detect_compression(path);
+    prefetch_next_input(path);
+    buffer_.reset(new ReadAheadBuffer(path, compression_));
+    open_ = buffer_->ok();
+    rdbuf(buffer_.get());
+    if (!open_) {
+        setstate(std::ios::failbit);
+        return;
+    }
+    struct stat info;
+    if (compression_ == Compression::NONE && stat(path.c_str(), &info) == 0) {
+        size_hint_ = static_cast<size_t>(info.st_size);
+    }
+}
+
+InputFile::~InputFile() {
+    close();
+}
+
+void InputFile::close() {
+    rdbuf(nullptr);
+    buffer_.reset();
+    open_ = false;
+}
+
+std::string InputFile::read_all() {
+    // 直接讀進一個string (未壓縮時一次配置到檔案大小)，不逐行getline再串接
+    std::string content(size_hint_ > 0 ? size_hint_ + 1 : COMPRESSED_CHUNK_SIZE, '\0');
+    size_t used = 0;
+    while (open_) {
+        if (used == content.size()) content.resize(content.size() * 2);
+        std::streamsize count = rdbuf()->sgetn(&content[used], static_cast<std::streamsize>(content.size() - used));
+        if (count <= 0) break;
+        used += static_cast<size_t>(count);
+    }
+    content.resize(used);
+    setstate(std::ios::eofbit);
+    return content;
+}
+
+OutputFile::OutputFile(const std::string& path) : std::ostream(nullptr) {
+    compression_ = compression_from_extension(path);
+    if (compression_ == Compression::NONE) {
+        open_ = file_.open(path, std::ios::out | std::ios::trunc) != nullptr;
+        rdbuf(&file_);
+    } else {
+        compressed_.reset(new CompressedOutputBuffer(path, compression_));
+        open_ = compressed_->ok();
+        rdbuf(compressed_.get());
+    }
+    if (!open_) setstate(std::ios::failbit);
+}
+
+OutputFile::~OutputFile() {
+    close();
+}
+
+bool OutputFile::close() {
+    if (!open_) return !fail();
+    open_ = false;
+    flush();
+    bool ok = !bad();
+    if (compressed_) {
+        ok = compressed_->finish() && ok;
+    } else {
+        ok = file_.close() != nullptr && ok;
+    }
+    if (!ok) setstate(std::ios::badbit);
+    return ok;
+}
@@ -0,0 +1,96 @@
+#ifndef COMPRESSED_STREAM_HPP
+#define COMPRESSED_STREAM_HPP
+
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// =============================================================================
+// TRANSPARENT COMPRESSED INPUT / OUTPUT (.gz / .zst)
+// =============================================================================
+// 輸入檔 (Liberty / LEF / Verilog / DEF / weight，writer重讀的Verilog / DEF) 一律用
+// InputFile 開啟：依檔頭magic bytes判斷格式 (沒有magic時看副檔名)
+//   - 未壓縮：背景thread以大塊read()讀檔 (posix_fadvise SEQUENTIAL)
+//   - gzip：背景thread用zlib解壓
+//   - zstd：背景的 `zstd -dc` process解壓 (build環境沒有libzstd header)，背景thread讀pipe
+// 讀到的資料以固定大小的chunk放進有上限的queue (用完的chunk還給reader重用)，
+// parser在前景讀，I/O / 解壓和parsing重疊
+// seekg / tellg 用解壓後的offset (DEF writer記錄的section offset照常使用)；
+// 未壓縮檔seek直接從新位置重新讀；壓縮檔往回seek會從頭重新解壓，所以只適合少量的seek
+// 開啟一個輸入檔時，對set_input_prefetch_order清單中的下一個檔案發POSIX_FADV_WILLNEED
+// (parse目前的檔案時，kernel先把下一個檔案讀進page cache)
+//
+// OutputFile 依副檔名決定是否壓縮 (-compress_output gz|zst 讓 .v / .def / .list 加上副檔名)；
+// 格式化在前景，壓縮和寫檔在背景thread (zstd為 `zstd -q -o` process)
+// =============================================================================
+
+#define COMPRESSED_CHUNK_SIZE (1 << 20)   // Bytes per decompressed / uncompressed chunk
+#define COMPRESSED_QUEUE_DEPTH 4          // Chunks read ahead / buffered between the I/O thread and the parser / writer
+#define COMPRESSED_GZIP_LEVEL 1           // zlib level for .gz output (fast; text still shrinks ~4x)
+#define COMPRESSED_ZSTD_PROGRAM "zstd"    // zstd executable (looked up in PATH)
+
+enum class Compression { NONE, GZIP, ZSTD };
+
+// By file name (".gz" / ".zst")
+Compression compression_from_extension(const std::string& path);
+
+// By magic bytes of an existing file, falling back to the extension
+Compression detect_compression(const std::string& path);
+
+// "top.v.gz" -> "top.v" (unchanged without a compression extension)
+std::string strip_compression_extension(const std::string& path);
+
+// "gz" / "zst" -> ".gz" / ".zst" ("" for anything else)
+std::string compression_suffix(const std::string& format);
+
+const char* compression_name(Compression compression);
+
+// Input files in the order the flow parses them (hint for prefetch_next_input)
+void set_input_prefetch_order(const std::vector<std::string>& paths);
+
+// Start reading the file after `path` in the prefetch order into the page cache
+void prefetch_next_input(const std::string& path);
+
+class ReadAheadBuffer;
+class CompressedOutputBuffer;
+
+class InputFile : public std::istream {
+public:
+    explicit InputFile(const std::string& path);
+    ~InputFile();
+
+    bool is_open() const { return open_; }
+    void close();
+    Compression compression() const { return compression_; }
+
+    // Rest of the file in one string (a single allocation for uncompressed files)
+    std::string read_all();
+
+private:
+    std::unique_ptr<ReadAheadBuffer> buffer_;
+    Compression compression_ = Compression::NONE;
+    size_t size_hint_ = 0;
+    bool open_ = false;
+};
+
+class OutputFile : public std::ostream {
+public:
+    explicit OutputFile(const std::string& path);
+    ~OutputFile();
+
+    bool is_open() const { return open_; }
+    // Flush and finish the compressed stream; false (and badbit) if anything failed
+    bool close();
+    Compression compression() const { return compression_; }
+
+private:
+    std::filebuf file_;
+    std::unique_ptr<CompressedOutputBuffer> compressed_;
+    Compression compression_ = Compression::NONE;
+    bool open_ = false;
+};
+
+#endif // COMPRESSED_STREAM_HPP
@@ -9,6 +9,11 @@
 #include <algorithm>
 #include <iomanip>
 #include <limits>
+#include <deque>
+#include <functional>
+#include <cstdint>
+#include <cstdlib>
+#include "banking_parameters.hpp"
 
 // =============================================================================
 // CLEAN UNIFIED DATA STRUCTURES FOR FLIP-FLOP BANKING COMPETITION
@@ -24,32 +29,49 @@ struct CellTemplate;
 struct Instance;
 struct Net;
 struct Pin;
+class TimeBudget;
+class OutOfCoreNetlist;
 
 // =============================================================================
 // 1. BASIC GEOMETRIC TYPES
 // =============================================================================
+// 座標一律用整數DBU (DEF database units)：DEF本來就是整數，site對齊用整數除法，
+// 不會有浮點誤差造成的off-grid結果；LEF的micron尺寸在parse時四捨五入成DBU
+
+typedef int64_t Dbu;
+
+#define LEF_DBU_PER_MICRON 1000
+
+inline Dbu microns_to_dbu(double microns) { return static_cast<Dbu>(std::llround(microns * LEF_DBU_PER_MICRON)); }
+
+// floor(a / b) and ceil(a / b) for b > 0 (C++ integer division truncates toward zero)
+inline Dbu floor_div(Dbu a, Dbu b) { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+inline Dbu ceil_div(Dbu a, Dbu b) { return -floor_div(-a, b); }
 
 struct Point {
-    double x = 0.0;
-    double y = 0.0;
+    Dbu x = 0;
+    Dbu y = 0;
     
     Point() = default;
-    Point(double x_, double y_) : x(x_), y(y_) {}
+    Point(Dbu x_, Dbu y_) : x(x_), y(y_) {}
     
     double distance_to(const Point& other) const {
-        double dx = x - other.x;
-        double dy = y - other.y;
+        double dx = static_cast<double>(x - other.x);
+        double dy = static_cast<double>(y - other.y);
         return sqrt(dx*dx + dy*dy);
     }
+    Dbu manhattan_to(const Point& other) const {
+        return std::abs(x - other.x) + std::abs(y - other.y);
+    }
 };
 
 struct Rectangle {
-    double x1 = 0.0, y1 = 0.0;  // Lower-left
-    double x2 = 0.0, y2 = 0.0;  // Upper-right
+    Dbu x1 = 0, y1 = 0;  // Lower-left
+    Dbu x2 = 0, y2 = 0;  // Upper-right
     
-    double width() const { return x2 - x1; }
-    double height() const { return y2 - y1; }
-    double area() const { return width() * height(); }
+    Dbu width() const { return x2 - x1; }
+    Dbu height() const { return y2 - y1; }
+    double area() const { return static_cast<double>(width()) * static_cast<double>(height()); }
 };
 
 // =============================================================================
@@ -144,8 +166,8 @@ struct CellTemplate {
     std::string library;             // "hopt", "lopt", etc.
     
     // Physical properties (from LEF)
-    double width = 0.0;              // microns
-    double height = 0.0;             // microns
+    Dbu width = 0;                   // DBU (LEF microns x LEF_DBU_PER_MICRON)
+    Dbu height = 0;                  // DBU
     std::string site = "core";       // Placement site
     std::vector<Pin> pins;
     
@@ -165,6 +187,19 @@ struct CellTemplate {
         UNKNOWN_EDGE                 // Not parsed or not a flip-flop
     } clock_edge = UNKNOWN_EDGE;
     
+    // Clock tree role (from Liberty pin functions / clock_gating_integrated_cell)
+    // 只認單一clock輸入、單一輸出的cell；clock tracing經由這些cell往回追到root clock
+    enum ClockTreeRole {
+        NOT_CLOCK_CELL,
+        CLOCK_BUFFER,                // function : "A"
+        CLOCK_INVERTER,              // function : "!A"
+        CLOCK_GATE                   // clock_gating_integrated_cell (ICG)
+    } clock_role = NOT_CLOCK_CELL;
+    std::string clock_in_pin;        // Buffer/inverter input or ICG clock_gate_clock_pin
+    std::string clock_out_pin;       // Output pin driving the downstream clock net
+    std::string clock_enable_pin;    // ICG clock_gate_enable_pin
+    bool clock_out_inverted = false; // Output is the inverted clock (inverter, inverting ICG)
+    
     // Cell type classification
     enum CellType {
         FLIP_FLOP,                   // Can participate in banking
@@ -266,7 +301,7 @@ struct Instance {
     std::vector<Connection> connections;
     
     /*Legalization*/
-    double x_new = 0.0, y_new = 0.0;   // 新位置
+    Dbu x_new = 0, y_new = 0;           // 新位置
     int weight = 1;                     // 權重  
     int row_id = -1;                    // 所屬 row ID
     /*Legalization*/
@@ -302,11 +337,11 @@ struct Instance {
     
     /*Legalization*/
     Point get_original_position() const { return position; }
-    double get_width() const { 
-        return cell_template ? cell_template->width : 0.0; 
+    Dbu get_width() const { 
+        return cell_template ? cell_template->width : 0; 
     }
-    double get_height() const { 
-        return cell_template ? cell_template->height : 0.0; 
+    Dbu get_height() const { 
+        return cell_template ? cell_template->height : 0; 
     }
     /*Legalization*/
     
@@ -373,16 +408,23 @@ struct ScanChain {
     std::string name;                    // Scan chain name
     std::string scan_in_pin;            // External scan input pin
     std::string scan_out_pin;           // External scan output pin
+    std::string start_instance;          // START component ("" = START PIN scan_in_pin)
+    std::string stop_instance;           // STOP component ("" = STOP PIN scan_out_pin)
+    std::string partition;               // + PARTITION (chains of one partition may exchange FFs)
+    int max_bits = -1;                   // + PARTITION ... MAXBITS (-1 = not given)
+    std::string scan_in_net;             // Net on the first FF's SI pin (recorded at step 8)
+    bool from_def = false;               // Parsed from DEF SCANCHAINS (written back by the DEF writer)
     
     // Scan chain sequence: SI -> FF1 -> FF2 -> ... -> SO
     struct ScanConnection {
         std::string instance_name;       // Instance name
         std::string scan_in_pin;        // SI pin name
         std::string scan_out_pin;       // SO pin name
+        int ordered_segment = -1;        // + ORDERED list index (-1 = FLOATING, free to reorder)
         
         ScanConnection() = default;
-        ScanConnection(const std::string& inst, const std::string& si, const std::string& so)
-            : instance_name(inst), scan_in_pin(si), scan_out_pin(so) {}
+        ScanConnection(const std::string& inst, const std::string& si, const std::string& so, int segment = -1)
+            : instance_name(inst), scan_in_pin(si), scan_out_pin(so), ordered_segment(segment) {}
     };
     std::vector<ScanConnection> chain_sequence;
     
@@ -401,21 +443,21 @@ struct ScanChain {
 
 /*Legalization*/
 struct Cluster {
-    double x = 0.0;                     // 左端座標
-    double width = 0.0;                 // 寬度
-    double weight = 0.0;                // 權重
-    double q = 0.0;                     // 加權位置和
+    Dbu x = 0;                          // 左端座標
+    Dbu width = 0;                      // 寬度
+    Dbu weight = 0;                     // 權重
+    Dbu q = 0;                          // 加權位置和 (整數，最佳位置 = q / weight)
     Cluster* leftCluster = nullptr;     // 前一個 cluster
     std::vector<Instance*> cellInCluster; // 改為 Instance*
 };
 // 修改 SubRow 結構，使其與原始邏輯一致
 struct SubRow {
-    double x_min = 0.0, x_max = 0.0;
-    double Usewidth = 0.0;              // 改名為 Usewidth 以匹配原始代碼
+    Dbu x_min = 0, x_max = 0;
+    Dbu Usewidth = 0;                   // 改名為 Usewidth 以匹配原始代碼
     Cluster* lastCluster = nullptr;
     
     SubRow() = default;
-    SubRow(double xmin, double xmax)
+    SubRow(Dbu xmin, Dbu xmax)
         : x_min(xmin), x_max(xmax), Usewidth(xmax - xmin), lastCluster(nullptr) {}
 };
 /*Legalization*/
@@ -446,11 +488,11 @@ struct PlacementRow {
     std::string site;                // Site type
     Point origin;                    // Starting point
     int num_x = 0, num_y = 0;        // Site count
-    double step_x = 0.0, step_y = 0.0;  // Site spacing
+    Dbu step_x = 0, step_y = 0;      // Site spacing
 
     /*Legalization*/
-    double height = 0.0;        // 從 step_y 獲取
-    double site_width = 0.0;    // 從 step_x 獲取
+    Dbu height = 0;             // 從 step_y 獲取
+    Dbu site_width = 0;         // 從 step_x 獲取
     int id = -1;                // Row ID
     std::vector<SubRow> subrows; // 原本就有，但確保使用正確的 SubRow
     /*Legalization*/
@@ -463,9 +505,9 @@ struct PlacementRow {
 
 struct Track {
     enum Direction { X, Y } direction = X;
-    double start = 0.0;              // Starting coordinate
+    Dbu start = 0;                   // Starting coordinate
     int num = 0;                     // Number of tracks
-    double step = 0.0;               // Track spacing
+    Dbu step = 0;                    // Track spacing
     std::string layer;               // Metal layer
     
     void print() const {
@@ -524,9 +566,13 @@ struct TransformationRecord {
     
     // For multi-instance transformations (banking/debanking)
     std::vector<std::string> related_instances;            // Other instances involved in the transformation
+
+    // BANK: pins of each source bit (bit 0 = original, bit i = related_instances[i-1]).
+    // The log stores only interned pin-name lists; pin_mapping() derives "src/pin" -> "mbff/pin[i]"
+    std::vector<std::vector<std::string>> bank_source_pins;
     
     // Position information (for final placement)
-    double result_x = 0.0, result_y = 0.0;                // Final position
+    Dbu result_x = 0, result_y = 0;                        // Final position
     std::string result_orientation = "N";                  // Final orientation
     
     // Enhanced tracking fields
@@ -575,6 +621,446 @@ struct TransformationRecord {
     }
 };
 
+// =============================================================================
+// 8.1. COLUMNAR TRANSFORMATION LOG
+// =============================================================================
+// transformation_history以欄位方式儲存，每筆record只留幾個整數：
+// - instance/cell/stage/cluster/orientation名稱都interned到同一個string table
+// - pin mapping放在共用的pin-map table，相同的mapping (例如KEEP的D->D, CK->CK) 只存一份
+// - related instances放在同一個pool，用offset表示
+// - BANK的pin mapping不存字串：每個source bit只存一個pin-name list id，讀取時才展開
+// TransformationRecord只當作寫入時的builder，讀取時用TransformationRecordRef
+// =============================================================================
+
+class TransformationLog;
+
+// 輕量的record handle (log pointer + index)，可以複製和保存
+class TransformationRecordRef {
+public:
+    // related_instances的唯讀view
+    class NameList {
+    public:
+        class const_iterator {
+        public:
+            const_iterator(const TransformationLog* log, const int* pos) : log_(log), pos_(pos) {}
+            const std::string& operator*() const;
+            const_iterator& operator++() { ++pos_; return *this; }
+            bool operator!=(const const_iterator& other) const { return pos_ != other.pos_; }
+            bool operator==(const const_iterator& other) const { return pos_ == other.pos_; }
+        private:
+            const TransformationLog* log_;
+            const int* pos_;
+        };
+
+        NameList(const TransformationLog* log, const int* first, const int* last)
+            : log_(log), first_(first), last_(last) {}
+        size_t size() const { return static_cast<size_t>(last_ - first_); }
+        bool empty() const { return first_ == last_; }
+        const std::string& operator[](size_t i) const { return *const_iterator(log_, first_ + i); }
+        const_iterator begin() const { return const_iterator(log_, first_); }
+        const_iterator end() const { return const_iterator(log_, last_); }
+    private:
+        const TransformationLog* log_;
+        const int* first_;
+        const int* last_;
+    };
+
+    TransformationRecordRef() : log_(nullptr), index_(0) {}
+    TransformationRecordRef(const TransformationLog* log, size_t index) : log_(log), index_(index) {}
+
+    bool valid() const { return log_ != nullptr; }
+    size_t index() const { return index_; }
+
+    TransformationRecord::Operation operation() const;
+    const std::string& original_instance_name() const;
+    const std::string& result_instance_name() const;
+    const std::string& original_cell_type() const;
+    const std::string& result_cell_type() const;
+    const std::string& stage() const;
+    const std::string& cluster_id() const;
+    const std::string& result_orientation() const;
+    std::map<std::string, std::string> pin_mapping() const;   // BANK mappings are built on demand
+    NameList related_instances() const;
+    Dbu result_x() const;
+    Dbu result_y() const;
+
+    std::string operation_string() const;
+    void print() const;
+
+    // Builder copy of this record (append it to another log)
+    TransformationRecord to_record() const;
+
+private:
+    const TransformationLog* log_;
+    size_t index_;
+};
+
+class TransformationLog {
+public:
+    // Live-record iterator (removed records are skipped)
+    class const_iterator {
+    public:
+        const_iterator(const TransformationLog* log, size_t index) : log_(log), index_(index) { skip_removed(); }
+        TransformationRecordRef operator*() const { return TransformationRecordRef(log_, index_); }
+        const_iterator& operator++() { ++index_; skip_removed(); return *this; }
+        bool operator!=(const const_iterator& other) const { return index_ != other.index_; }
+        bool operator==(const const_iterator& other) const { return index_ == other.index_; }
+    private:
+        void skip_removed() {
+            while (index_ < log_->op_.size() && log_->removed_[index_]) ++index_;
+        }
+        const TransformationLog* log_;
+        size_t index_;
+    };
+
+    TransformationLog() { clear(); }
+
+    // strings_指向string_ids_的key，複製後要重新指向自己的table
+    TransformationLog(const TransformationLog& other) { *this = other; }
+    TransformationLog& operator=(const TransformationLog& other) {
+        if (this == &other) return *this;
+        op_ = other.op_;
+        original_instance_ = other.original_instance_;
+        result_instance_ = other.result_instance_;
+        original_cell_ = other.original_cell_;
+        result_cell_ = other.result_cell_;
+        stage_ = other.stage_;
+        cluster_ = other.cluster_;
+        orientation_ = other.orientation_;
+        pin_map_ = other.pin_map_;
+        related_begin_ = other.related_begin_;
+        bank_begin_ = other.bank_begin_;
+        result_x_ = other.result_x_;
+        result_y_ = other.result_y_;
+        removed_ = other.removed_;
+        live_count_ = other.live_count_;
+        related_pool_ = other.related_pool_;
+        bank_pool_ = other.bank_pool_;
+        string_ids_ = other.string_ids_;
+        strings_.assign(string_ids_.size(), nullptr);
+        for (const auto& entry : string_ids_) strings_[entry.second] = &entry.first;
+        pin_maps_ = other.pin_maps_;
+        pin_map_buckets_ = other.pin_map_buckets_;
+        pin_sets_ = other.pin_sets_;
+        pin_set_ids_ = other.pin_set_ids_;
+        latest_by_name_ = other.latest_by_name_;
+        keep_by_name_ = other.keep_by_name_;
+        return *this;
+    }
+    // unordered_map的move保留node，strings_的pointer仍然有效
+    TransformationLog(TransformationLog&&) = default;
+    TransformationLog& operator=(TransformationLog&&) = default;
+
+    void clear() {
+        op_.clear();
+        original_instance_.clear();
+        result_instance_.clear();
+        original_cell_.clear();
+        result_cell_.clear();
+        stage_.clear();
+        cluster_.clear();
+        orientation_.clear();
+        pin_map_.clear();
+        related_begin_.clear();
+        bank_begin_.clear();
+        result_x_.clear();
+        result_y_.clear();
+        removed_.clear();
+        related_pool_.clear();
+        bank_pool_.clear();
+        live_count_ = 0;
+
+        string_ids_.clear();
+        strings_.clear();
+        latest_by_name_.clear();
+        keep_by_name_.clear();
+
+        pin_maps_.clear();
+        pin_map_buckets_.clear();
+        pin_sets_.clear();
+        pin_set_ids_.clear();
+        pin_maps_.emplace_back();  // pin_map 0 = empty mapping
+        intern("");                // string 0 = ""
+    }
+
+    // Append a record; returns its index
+    size_t push_back(const TransformationRecord& record) {
+        size_t index = op_.size();
+        int original_id = intern(record.original_instance_name);
+        int result_id = intern(record.result_instance_name);
+
+        op_.push_back(static_cast<unsigned char>(record.operation));
+        original_instance_.push_back(original_id);
+        result_instance_.push_back(result_id);
+        original_cell_.push_back(intern(record.original_cell_type));
+        result_cell_.push_back(intern(record.result_cell_type));
+        stage_.push_back(intern(record.stage));
+        cluster_.push_back(intern(record.cluster_id));
+        orientation_.push_back(intern(record.result_orientation));
+        pin_map_.push_back(intern_pin_map(record.pin_mapping));
+        related_begin_.push_back(static_cast<int>(related_pool_.size()));
+        for (const auto& name : record.related_instances) {
+            related_pool_.push_back(intern(name));
+        }
+        bank_begin_.push_back(static_cast<int>(bank_pool_.size()));
+        for (const auto& pins : record.bank_source_pins) {
+            bank_pool_.push_back(intern_pin_set(pins));
+        }
+        result_x_.push_back(record.result_x);
+        result_y_.push_back(record.result_y);
+        removed_.push_back(0);
+        live_count_++;
+
+        // Later records overwrite earlier ones -> latest record per instance
+        latest_by_name_[original_id] = static_cast<int>(index);
+        latest_by_name_[result_id] = static_cast<int>(index);
+        if (record.operation == TransformationRecord::KEEP && keep_by_name_[original_id] < 0) {
+            keep_by_name_[original_id] = static_cast<int>(index);
+        }
+        return index;
+    }
+
+    size_t size() const { return live_count_; }
+    bool empty() const { return live_count_ == 0; }
+    size_t slot_count() const { return op_.size(); }  // Including removed records
+    bool is_removed(size_t index) const { return removed_[index] != 0; }
+
+    TransformationRecordRef operator[](size_t index) const { return TransformationRecordRef(this, index); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, op_.size()); }
+
+    // Indices of live records with the given operation
+    std::vector<size_t> indices_of(TransformationRecord::Operation operation) const {
+        std::vector<size_t> indices;
+        for (size_t i = 0; i < op_.size(); ++i) {
+            if (!removed_[i] && op_[i] == operation) indices.push_back(i);
+        }
+        return indices;
+    }
+
+    // O(1): latest live record whose original or result instance is `instance_name`
+    TransformationRecordRef latest_for_instance(const std::string& instance_name) const {
+        auto it = string_ids_.find(instance_name);
+        if (it == string_ids_.end() || latest_by_name_[it->second] < 0) return TransformationRecordRef();
+        return TransformationRecordRef(this, static_cast<size_t>(latest_by_name_[it->second]));
+    }
+
+    // O(1) removal of the original KEEP record of an instance (tombstone)
+    bool remove_keep_record(const std::string& instance_name) {
+        auto it = string_ids_.find(instance_name);
+        if (it == string_ids_.end()) return false;
+        int name_id = it->second;
+        int index = keep_by_name_[name_id];
+        if (index < 0 || removed_[index]) return false;
+
+        removed_[index] = 1;
+        live_count_--;
+        keep_by_name_[name_id] = -1;
+
+        // Rare: the removed record was still the latest for this name
+        const int names[2] = {original_instance_[index], result_instance_[index]};
+        for (int name : names) {
+            if (latest_by_name_[name] != index) continue;
+            latest_by_name_[name] = -1;
+            for (int i = index - 1; i >= 0; --i) {
+                if (!removed_[i] && (original_instance_[i] == name || result_instance_[i] == name)) {
+                    latest_by_name_[name] = i;
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+
+    size_t distinct_pin_maps() const { return pin_maps_.size(); }
+    size_t distinct_strings() const { return strings_.size(); }
+
+private:
+    friend class TransformationRecordRef;
+    friend class TransformationRecordRef::NameList::const_iterator;
+    friend struct CheckpointAccess;   // Binary checkpoint save/restore (checkpoint.cpp)
+
+    int intern(const std::string& value) {
+        auto it = string_ids_.find(value);
+        if (it != string_ids_.end()) return it->second;
+        int id = static_cast<int>(strings_.size());
+        auto inserted = string_ids_.emplace(value, id).first;
+        strings_.push_back(&inserted->first);  // unordered_map keys are node-stable
+        latest_by_name_.push_back(-1);
+        keep_by_name_.push_back(-1);
+        return id;
+    }
+
+    int intern_pin_map(const std::map<std::string, std::string>& mapping) {
+        if (mapping.empty()) return 0;
+        size_t hash = mapping.size();
+        std::hash<std::string> hasher;
+        for (const auto& pin_pair : mapping) {
+            hash = hash * 31 + hasher(pin_pair.first);
+            hash = hash * 31 + hasher(pin_pair.second);
+        }
+        auto& bucket = pin_map_buckets_[hash];
+        for (int id : bucket) {
+            if (pin_maps_[id] == mapping) return id;
+        }
+        int id = static_cast<int>(pin_maps_.size());
+        pin_maps_.push_back(mapping);
+        bucket.push_back(id);
+        return id;
+    }
+
+    int intern_pin_set(const std::vector<std::string>& pins) {
+        std::vector<int> ids;
+        ids.reserve(pins.size());
+        for (const auto& pin : pins) ids.push_back(intern(pin));
+        auto it = pin_set_ids_.find(ids);
+        if (it != pin_set_ids_.end()) return it->second;
+        int id = static_cast<int>(pin_sets_.size());
+        pin_set_ids_.emplace(ids, id);
+        pin_sets_.push_back(std::move(ids));
+        return id;
+    }
+
+    const std::string& str(int id) const { return *strings_[id]; }
+
+    void bank_range(size_t index, int& first, int& last) const {
+        first = bank_begin_[index];
+        last = (index + 1 < bank_begin_.size()) ? bank_begin_[index + 1] : static_cast<int>(bank_pool_.size());
+    }
+
+    // Columns (one entry per record)
+    std::vector<unsigned char> op_;
+    std::vector<int> original_instance_;
+    std::vector<int> result_instance_;
+    std::vector<int> original_cell_;
+    std::vector<int> result_cell_;
+    std::vector<int> stage_;
+    std::vector<int> cluster_;
+    std::vector<int> orientation_;
+    std::vector<int> pin_map_;
+    std::vector<int> related_begin_;
+    std::vector<int> bank_begin_;          // Offset into bank_pool_ (empty range = stored pin map)
+    std::vector<Dbu> result_x_;
+    std::vector<Dbu> result_y_;
+    std::vector<unsigned char> removed_;
+    size_t live_count_ = 0;
+
+    // Shared tables
+    std::vector<int> related_pool_;
+    std::vector<int> bank_pool_;           // Pin-set id per BANK source bit
+    std::unordered_map<std::string, int> string_ids_;
+    std::vector<const std::string*> strings_;
+    std::deque<std::map<std::string, std::string>> pin_maps_;
+    std::unordered_map<size_t, std::vector<int>> pin_map_buckets_;
+    std::vector<std::vector<int>> pin_sets_;        // Pin-name string ids (e.g. CK, D, Q, SE, SI)
+    std::map<std::vector<int>, int> pin_set_ids_;
+
+    // Per-name indices (indexed by string id)
+    std::vector<int> latest_by_name_;
+    std::vector<int> keep_by_name_;
+};
+
+inline const std::string& TransformationRecordRef::NameList::const_iterator::operator*() const {
+    return log_->str(*pos_);
+}
+
+inline TransformationRecord::Operation TransformationRecordRef::operation() const {
+    return static_cast<TransformationRecord::Operation>(log_->op_[index_]);
+}
+inline const std::string& TransformationRecordRef::original_instance_name() const { return log_->str(log_->original_instance_[index_]); }
+inline const std::string& TransformationRecordRef::result_instance_name() const { return log_->str(log_->result_instance_[index_]); }
+inline const std::string& TransformationRecordRef::original_cell_type() const { return log_->str(log_->original_cell_[index_]); }
+inline const std::string& TransformationRecordRef::result_cell_type() const { return log_->str(log_->result_cell_[index_]); }
+inline const std::string& TransformationRecordRef::stage() const { return log_->str(log_->stage_[index_]); }
+inline const std::string& TransformationRecordRef::cluster_id() const { return log_->str(log_->cluster_[index_]); }
+inline const std::string& TransformationRecordRef::result_orientation() const { return log_->str(log_->orientation_[index_]); }
+inline std::map<std::string, std::string> TransformationRecordRef::pin_mapping() const {
+    int first, last;
+    log_->bank_range(index_, first, last);
+    if (first == last) return log_->pin_maps_[log_->pin_map_[index_]];
+
+    // BANK: source bit i的D/Q/QN對到 mbff/pin[i]，其他共用pin (CK, SI, SE, R, S) 對到 mbff/pin
+    std::map<std::string, std::string> mapping;
+    const std::string& mbff = result_instance_name();
+    NameList related = related_instances();
+    for (int bit = 0; bit < last - first; bit++) {
+        const std::string& source = bit == 0 ? original_instance_name() : related[bit - 1];
+        for (int pin_id : log_->pin_sets_[log_->bank_pool_[first + bit]]) {
+            const std::string& pin = log_->str(pin_id);
+            std::string result_pin = mbff + "/" + pin;
+            if (pin == "D" || pin == "Q" || pin == "QN") result_pin += "[" + std::to_string(bit) + "]";
+            mapping[source + "/" + pin] = result_pin;
+        }
+    }
+    return mapping;
+}
+inline TransformationRecordRef::NameList TransformationRecordRef::related_instances() const {
+    const int* pool = log_->related_pool_.data();
+    int first = log_->related_begin_[index_];
+    int last = (index_ + 1 < log_->related_begin_.size()) ? log_->related_begin_[index_ + 1]
+                                                          : static_cast<int>(log_->related_pool_.size());
+    return NameList(log_, pool + first, pool + last);
+}
+inline Dbu TransformationRecordRef::result_x() const { return log_->result_x_[index_]; }
+inline Dbu TransformationRecordRef::result_y() const { return log_->result_y_[index_]; }
+
+inline std::string TransformationRecordRef::operation_string() const {
+    switch (operation()) {
+        case TransformationRecord::KEEP: return "KEEP";
+        case TransformationRecord::DEBANK: return "DEBANK";
+        case TransformationRecord::BANK: return "BANK";
+        case TransformationRecord::SUBSTITUTE: return "SUBSTITUTE";
+        case TransformationRecord::POST_SUBSTITUTE: return "POST_SUBSTITUTE";
+        default: return "UNKNOWN";
+    }
+}
+
+inline TransformationRecord TransformationRecordRef::to_record() const {
+    TransformationRecord record(original_instance_name(), result_instance_name(), operation(),
+                                original_cell_type(), result_cell_type());
+    record.stage = stage();
+    for (const auto& name : related_instances()) record.related_instances.push_back(name);
+    int first, last;
+    log_->bank_range(index_, first, last);
+    if (first == last) record.pin_mapping = log_->pin_maps_[log_->pin_map_[index_]];
+    for (int i = first; i < last; i++) {
+        std::vector<std::string> pins;
+        for (int pin_id : log_->pin_sets_[log_->bank_pool_[i]]) pins.push_back(log_->str(pin_id));
+        record.bank_source_pins.push_back(std::move(pins));
+    }
+    record.result_x = result_x();
+    record.result_y = result_y();
+    record.result_orientation = result_orientation();
+    record.cluster_id = cluster_id();
+    return record;
+}
+
+inline void TransformationRecordRef::print() const {
+    std::cout << "Transform [" << operation_string() << "]: "
+              << original_instance_name() << " (" << original_cell_type() << ") -> "
+              << result_instance_name() << " (" << result_cell_type() << ")" << std::endl;
+    const auto& mapping = pin_mapping();
+    if (!mapping.empty()) {
+        std::cout << "  Pin mapping: ";
+        bool first = true;
+        for (const auto& pair : mapping) {
+            if (!first) std::cout << ", ";
+            std::cout << pair.first << "->" << pair.second;
+            first = false;
+        }
+        std::cout << std::endl;
+    }
+    NameList related = related_instances();
+    if (!related.empty()) {
+        std::cout << "  Related instances: ";
+        for (size_t i = 0; i < related.size(); i++) {
+            if (i > 0) std::cout << ", ";
+            std::cout << related[i];
+        }
+        std::cout << std::endl;
+    }
+}
+
 // =============================================================================
 // 8.5. STAGE-BASED PIPELINE SYSTEM (for Complete Transformation Tracking)
 // =============================================================================
@@ -582,7 +1068,7 @@ struct TransformationRecord {
 struct InstanceSnapshot {
     std::string instance_name;                       // Current instance name
     std::string cell_type;                           // Current cell type
-    double x = 0.0, y = 0.0;                        // Current position
+    Dbu x = 0, y = 0;                               // Current position
     std::string orientation = "N";                   // Current orientation
     std::map<std::string, std::string> pin_connections; // pin_name -> net_name
     
@@ -590,10 +1076,11 @@ struct InstanceSnapshot {
     std::string cluster_id;                          // Grouping information
     std::string original_name;                       // Original instance name (before any transformation)
     TransformationRecord::Operation last_operation = TransformationRecord::KEEP;
+    long record_index = -1;                          // Latest transformation record at capture time (-1 = none)
     
     InstanceSnapshot() = default;
     InstanceSnapshot(const std::string& name, const std::string& cell, 
-                    double pos_x, double pos_y, const std::string& orient = "N")
+                    Dbu pos_x, Dbu pos_y, const std::string& orient = "N")
         : instance_name(name), cell_type(cell), x(pos_x), y(pos_y), 
           orientation(orient), original_name(name) {}
     
@@ -616,6 +1103,18 @@ struct InstanceSnapshot {
         return snapshot;
     }
     
+    // 不建立新snapshot，直接比較instance目前狀態 (cell, position, connectivity)
+    bool matches_instance(const std::shared_ptr<Instance>& inst) const {
+        const std::string& current_cell = inst->cell_template ? inst->cell_template->name : inst->cell_type;
+        if (cell_type != current_cell || x != inst->position.x || y != inst->position.y) return false;
+        if (pin_connections.size() != inst->connections.size()) return false;
+        for (const auto& conn : inst->connections) {
+            auto it = pin_connections.find(conn.pin_name);
+            if (it == pin_connections.end() || it->second != conn.net_name) return false;
+        }
+        return true;
+    }
+    
     void print() const {
         std::cout << "  Instance " << instance_name << " (" << cell_type << ")"
                   << " @ (" << x << ", " << y << ") " << orientation << std::endl;
@@ -633,10 +1132,16 @@ struct InstanceSnapshot {
     }
 };
 
+// 每個stage只存相對於前一個stage的delta：
+// - changed: 新增或cell/position/connectivity/tracking資訊有變的FF
+// - removed: 前一個stage存在但這個stage消失的FF
+// 完整的stage view由CompletePipeline::reconstruct_stage重建
 struct StagePipeline {
     std::string stage_name;                          // "ORIGINAL", "DEBANK", "SUBSTITUTE", "BANK", "LEGALIZE"
-    std::vector<InstanceSnapshot> instances;         // 這個階段的所有FF instances
+    std::vector<InstanceSnapshot> changed;           // Added or modified FF instances
+    std::vector<std::string> removed;                // FF instances gone since the previous stage
     std::vector<size_t> transformation_indices;     // 對應的transformation records indices
+    bool captured = false;
     
     // Stage metadata
     size_t total_instances = 0;
@@ -647,12 +1152,6 @@ struct StagePipeline {
     StagePipeline() = default;
     StagePipeline(const std::string& name) : stage_name(name) {}
     
-    void add_instance(const InstanceSnapshot& snapshot) {
-        instances.push_back(snapshot);
-        total_instances++;
-        // Note: area/power calculation would need cell template access
-    }
-    
     void add_transformation_index(size_t index) {
         transformation_indices.push_back(index);
     }
@@ -661,11 +1160,12 @@ struct StagePipeline {
         std::cout << "\n=== Stage: " << stage_name << " ===" << std::endl;
         std::cout << "Total instances: " << total_instances << std::endl;
         std::cout << "FF instances: " << ff_instances << std::endl;
+        std::cout << "Changed / removed: " << changed.size() << " / " << removed.size() << std::endl;
         std::cout << "Associated transformations: " << transformation_indices.size() << std::endl;
         
-        if (!instances.empty()) {
-            std::cout << "Instance list:" << std::endl;
-            for (const auto& instance : instances) {
+        if (!changed.empty()) {
+            std::cout << "Changed instances:" << std::endl;
+            for (const auto& instance : changed) {
                 instance.print();
             }
         }
@@ -685,6 +1185,10 @@ struct CompletePipeline {
     std::vector<StagePipeline> stages;               // 所有階段的pipeline
     std::map<std::string, size_t> stage_index_map;  // stage_name -> index mapping
     
+    // 目前最新的view：instance name -> (stage index, offset in stage.changed)
+    // 只存位置不存snapshot，所以額外記憶體只有一個name table
+    std::unordered_map<std::string, std::pair<size_t, size_t>> live_view;
+    
     CompletePipeline() {
         // Initialize with standard stages
         add_stage("ORIGINAL");
@@ -717,62 +1221,80 @@ struct CompletePipeline {
         return nullptr;
     }
     
+    const InstanceSnapshot& snapshot_at(const std::pair<size_t, size_t>& location) const {
+        return stages[location.first].changed[location.second];
+    }
+    
+    // Stages are captured in pipeline order; capture only stores the delta
+    // against the previous captured stage. Non-FF instances are ignored.
     void capture_stage(const std::string& stage_name, 
-                      const std::vector<std::shared_ptr<Instance>>& all_instances,
+                      const std::unordered_map<std::string, std::shared_ptr<Instance>>& all_instances,
                       const std::vector<size_t>& new_transformation_indices = {},
-                      const std::vector<TransformationRecord>* transformation_history = nullptr) {
-        StagePipeline* stage = get_stage(stage_name);
-        if (!stage) {
+                      const TransformationLog* transformation_history = nullptr) {
+        auto stage_it = stage_index_map.find(stage_name);
+        if (stage_it == stage_index_map.end()) {
             std::cout << "Warning: Unknown stage " << stage_name << std::endl;
             return;
         }
+        size_t stage_index = stage_it->second;
+        StagePipeline* stage = &stages[stage_index];
         
         // Clear existing data
-        stage->instances.clear();
+        stage->changed.clear();
+        stage->removed.clear();
         stage->transformation_indices.clear();
         stage->total_instances = 0;
         stage->ff_instances = 0;
+        stage->captured = true;
         
-        // Create a map from instance name to the LATEST transformation record for quick lookup
-        std::map<std::string, const TransformationRecord*> instance_to_record;
-        if (transformation_history) {
-            // Iterate through records to find the latest one for each instance
-            for (size_t i = 0; i < transformation_history->size(); ++i) {
-                const auto& record = (*transformation_history)[i];
-                // Map both original and result instance names to the record
-                // Later records will overwrite earlier ones, giving us the latest transformation
-                instance_to_record[record.original_instance_name] = &record;
-                instance_to_record[record.result_instance_name] = &record;
-            }
-        }
+        std::unordered_map<std::string, std::pair<size_t, size_t>> next_view;
+        next_view.reserve(live_view.size());
         
-        // Capture all FF instances
-        for (const auto& inst : all_instances) {
-            if (inst->is_flip_flop()) {
-                InstanceSnapshot snapshot = InstanceSnapshot::from_instance(inst);
-                
-                // Try to find transformation record for this instance
-                auto record_it = instance_to_record.find(inst->name);
-                if (record_it != instance_to_record.end()) {
-                    const TransformationRecord* record = record_it->second;
-                    
-                    // Set cluster_id and original_name from transformation record
-                    snapshot.cluster_id = record->cluster_id;
-                    snapshot.last_operation = record->operation;
-                    
-                    // For DEBANK operations, the original_name should be the original multi-bit FF
-                    if (record->operation == TransformationRecord::DEBANK) {
-                        snapshot.original_name = record->original_instance_name;
-                    } else {
-                        // For other operations, try to trace back to the original
-                        snapshot.original_name = record->original_instance_name;
-                    }
+        for (const auto& inst_pair : all_instances) {
+            const auto& inst = inst_pair.second;
+            if (!inst->is_flip_flop()) continue;
+            stage->ff_instances++;
+            stage->total_instances++;
+            
+            // Latest transformation record for this instance (O(1) lookup)
+            TransformationRecordRef record;
+            if (transformation_history) {
+                record = transformation_history->latest_for_instance(inst->name);
+            }
+            long record_index = record.valid() ? static_cast<long>(record.index()) : -1;
+            
+            auto prev_it = live_view.find(inst->name);
+            if (prev_it != live_view.end()) {
+                const InstanceSnapshot& previous = snapshot_at(prev_it->second);
+                if (previous.record_index == record_index && previous.matches_instance(inst)) {
+                    next_view.emplace(inst->name, prev_it->second);
+                    continue;  // Unchanged: no snapshot stored for this stage
                 }
+            }
+            
+            InstanceSnapshot snapshot = InstanceSnapshot::from_instance(inst);
+            snapshot.record_index = record_index;
+            if (record.valid()) {
+                // Set cluster_id and original_name from transformation record
+                snapshot.cluster_id = record.cluster_id();
+                snapshot.last_operation = record.operation();
                 
-                stage->add_instance(snapshot);
-                stage->ff_instances++;
+                // For DEBANK operations this is the original multi-bit FF
+                snapshot.original_name = record.original_instance_name();
+            }
+            
+            next_view.emplace(inst->name, std::make_pair(stage_index, stage->changed.size()));
+            stage->changed.push_back(std::move(snapshot));
+        }
+        
+        // Instances that disappeared since the previous stage
+        for (const auto& prev_pair : live_view) {
+            if (next_view.find(prev_pair.first) == next_view.end()) {
+                stage->removed.push_back(prev_pair.first);
             }
         }
+        std::sort(stage->removed.begin(), stage->removed.end());
+        live_view.swap(next_view);
         
         // Add transformation indices
         for (size_t index : new_transformation_indices) {
@@ -780,7 +1302,34 @@ struct CompletePipeline {
         }
         
         std::cout << "Captured stage " << stage_name << " with " 
-                  << stage->ff_instances << " FF instances" << std::endl;
+                  << stage->ff_instances << " FF instances ("
+                  << stage->changed.size() << " changed, " 
+                  << stage->removed.size() << " removed)" << std::endl;
+    }
+    
+    // 重建某個stage的完整view (依instance name排序)
+    std::vector<const InstanceSnapshot*> reconstruct_stage(const std::string& stage_name) const {
+        std::vector<const InstanceSnapshot*> view;
+        auto stage_it = stage_index_map.find(stage_name);
+        if (stage_it == stage_index_map.end() || !stages[stage_it->second].captured) return view;
+        
+        std::map<std::string, const InstanceSnapshot*> members;
+        for (size_t i = 0; i <= stage_it->second; ++i) {
+            const StagePipeline& stage = stages[i];
+            if (!stage.captured) continue;
+            for (const auto& name : stage.removed) {
+                members.erase(name);
+            }
+            for (const auto& snapshot : stage.changed) {
+                members[snapshot.instance_name] = &snapshot;
+            }
+        }
+        
+        view.reserve(members.size());
+        for (const auto& member : members) {
+            view.push_back(member.second);
+        }
+        return view;
     }
     
     void print() const {
@@ -795,13 +1344,15 @@ struct CompletePipeline {
     // Generate stage comparison report
     void print_stage_comparison() const {
         std::cout << "\n=== STAGE COMPARISON ===" << std::endl;
-        std::cout << "Stage            | Instances | FF Count | Transformations" << std::endl;
-        std::cout << "-----------------|-----------|----------|----------------" << std::endl;
+        std::cout << "Stage            | Instances | FF Count | Changed | Removed | Transformations" << std::endl;
+        std::cout << "-----------------|-----------|----------|---------|---------|----------------" << std::endl;
         
         for (const auto& stage : stages) {
             std::cout << std::setw(16) << std::left << stage.stage_name << " | "
                       << std::setw(9) << stage.total_instances << " | "
                       << std::setw(8) << stage.ff_instances << " | "
+                      << std::setw(7) << stage.changed.size() << " | "
+                      << std::setw(7) << stage.removed.size() << " | "
                       << stage.transformation_indices.size() << std::endl;
         }
     }
@@ -812,6 +1363,130 @@ struct CompletePipeline {
 // =============================================================================
 
 
+// =============================================================================
+// 8.6. PIN PROVENANCE (original FF pin -> current instance pin)
+// =============================================================================
+// 每個原始FF pin對應一個node，debank/bank時把舊pin的node forward到新pin
+// 多個原始pin可以合併到同一個node (例如banking後共用的CK)
+// 輸出.list時對原始pin做一次線性掃描即可，不需要重播transformation_history
+// =============================================================================
+
+struct PinProvenance {
+    struct Node {
+        int instance_id = -1;            // Interned instance name
+        int pin_id = -1;                 // Interned pin name
+        mutable int forward = -1;        // Next node after a transformation (-1 = live)
+    };
+
+    std::vector<std::string> instance_names;             // instance_id -> name
+    std::unordered_map<std::string, int> instance_ids;   // name -> instance_id
+    std::vector<std::string> pin_names;                  // pin_id -> name
+    std::unordered_map<std::string, int> pin_ids;        // name -> pin_id
+    std::vector<Node> nodes;
+    std::vector<int> original_pins;                      // Node IDs of original FF pins (registration order)
+    std::unordered_map<unsigned long long, int> live_nodes;  // (instance_id, pin_id) -> node
+
+    void clear() {
+        instance_names.clear();
+        instance_ids.clear();
+        pin_names.clear();
+        pin_ids.clear();
+        nodes.clear();
+        original_pins.clear();
+        live_nodes.clear();
+    }
+
+    int intern_instance(const std::string& name) {
+        auto it = instance_ids.find(name);
+        if (it != instance_ids.end()) return it->second;
+        int id = static_cast<int>(instance_names.size());
+        instance_names.push_back(name);
+        instance_ids[name] = id;
+        return id;
+    }
+
+    int intern_pin(const std::string& name) {
+        auto it = pin_ids.find(name);
+        if (it != pin_ids.end()) return it->second;
+        int id = static_cast<int>(pin_names.size());
+        pin_names.push_back(name);
+        pin_ids[name] = id;
+        return id;
+    }
+
+    static unsigned long long live_key(int instance_id, int pin_id) {
+        return (static_cast<unsigned long long>(instance_id) << 32) | static_cast<unsigned int>(pin_id);
+    }
+
+    // Register every connected pin of an original FF instance
+    void register_original_instance(const Instance& inst) {
+        int instance_id = intern_instance(inst.name);
+        for (const auto& conn : inst.connections) {
+            int pin_id = intern_pin(conn.pin_name);
+            unsigned long long key = live_key(instance_id, pin_id);
+            if (live_nodes.count(key)) continue;
+
+            Node node;
+            node.instance_id = instance_id;
+            node.pin_id = pin_id;
+            int node_id = static_cast<int>(nodes.size());
+            nodes.push_back(node);
+            live_nodes[key] = node_id;
+            original_pins.push_back(node_id);
+        }
+    }
+
+    // Move from_instance/from_pin to to_instance/to_pin. O(1); pins that were
+    // never registered (or were already forwarded) are ignored.
+    void forward_pin(const std::string& from_instance, const std::string& from_pin,
+                     const std::string& to_instance, const std::string& to_pin) {
+        auto inst_it = instance_ids.find(from_instance);
+        auto pin_it = pin_ids.find(from_pin);
+        if (inst_it == instance_ids.end() || pin_it == pin_ids.end()) return;
+
+        unsigned long long from_key = live_key(inst_it->second, pin_it->second);
+        auto from_it = live_nodes.find(from_key);
+        if (from_it == live_nodes.end()) return;
+        int from_node = from_it->second;
+
+        int to_instance_id = intern_instance(to_instance);
+        int to_pin_id = intern_pin(to_pin);
+        unsigned long long to_key = live_key(to_instance_id, to_pin_id);
+        if (to_key == from_key) return;
+
+        int to_node;
+        auto to_it = live_nodes.find(to_key);
+        if (to_it != live_nodes.end()) {
+            to_node = to_it->second;
+        } else {
+            Node node;
+            node.instance_id = to_instance_id;
+            node.pin_id = to_pin_id;
+            to_node = static_cast<int>(nodes.size());
+            nodes.push_back(node);
+            live_nodes[to_key] = to_node;
+        }
+
+        nodes[from_node].forward = to_node;
+        live_nodes.erase(live_nodes.find(from_key));
+    }
+
+    // Follow forwarding links to the live node (with path halving)
+    int find(int node_id) const {
+        while (nodes[node_id].forward != -1) {
+            int next = nodes[node_id].forward;
+            if (nodes[next].forward != -1) {
+                nodes[node_id].forward = nodes[next].forward;
+            }
+            node_id = next;
+        }
+        return node_id;
+    }
+
+    const std::string& node_instance(int node_id) const { return instance_names[nodes[node_id].instance_id]; }
+    const std::string& node_pin(int node_id) const { return pin_names[nodes[node_id].pin_id]; }
+};
+
 // =============================================================================
 // 9. MAIN DESIGN DATABASE
 // =============================================================================
@@ -822,6 +1497,7 @@ public:
     std::string design_name;
     std::string testcase_path;
     std::string input_verilog_path;  // Store input verilog file path
+    std::string input_def_path;      // First DEF file (re-read by the DEF writer)
     
     // Module hierarchy information
     struct Module {
@@ -849,6 +1525,10 @@ public:
     // Scan chain information
     std::vector<ScanChain> scan_chains;
     
+    // Clock domains (clock_tracing.hpp)
+    std::map<std::string, std::string> sdc_clocks;           // SDC create_clock port/net -> clock name
+    std::map<std::string, std::string> clock_domain_labels;  // module + "/" + FF CK net -> traced clock label
+    
     // Objective function
     ObjectiveWeights objective_weights;
     
@@ -871,16 +1551,35 @@ public:
     std::vector<std::string> banking_candidate_instance_groups;
     
     // Transformation tracking system (for ICCAD 2025 Contest Output)
-    std::vector<TransformationRecord> transformation_history;
+    TransformationLog transformation_history;
     
     // Stage-based pipeline system (for Complete Transformation Tracking)
     CompletePipeline complete_pipeline;
-    
+
+    // Live original-pin -> current-pin forwarding table (for .list CellInst section)
+    PinProvenance pin_provenance;
+
     // ICCAD 2025 Contest operation log support
     std::map<std::string, std::string> dummy_to_real_mapping;  // dummy_1 -> actual_instance_name
     std::map<std::string, std::string> real_to_dummy_mapping;  // actual_instance_name -> dummy_1  
     mutable int global_dummy_counter = 1;
     
+    // Banked instance naming (ff_fsdn2_N, ff_fsdn4_N, ff_lsrdpq4_N), per design
+    struct BankingNameCounters {
+        int fsdn2 = 1;
+        int fsdn4 = 1;
+        int lsrdpq4 = 1;
+    } banking_name_counters;
+    
+    // Heuristic thresholds for this design (-param name=value)
+    BankingParameters banking_params;
+    
+    // -time_budget for this run (nullptr = no limit); anytime phases poll time_budget_expired()
+    std::shared_ptr<TimeBudget> time_budget;
+    
+    // -out_of_core: combinational instances / obstacles on disk (nullptr = everything in db.instances)
+    std::shared_ptr<OutOfCoreNetlist> out_of_core;
+    
     // Statistics
     struct Stats {
         int total_instances = 0;
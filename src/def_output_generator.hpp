@@ -1,5 +1,6 @@
 #pragma once
 #include "data_structures.hpp"
+#include "compressed_stream.hpp"
 #include <fstream>
 #include <sstream>
 
@@ -15,7 +16,10 @@ private:
     struct DefSectionData {
         std::vector<std::string> header_lines;        // VERSION to DIEAREA
         std::vector<std::string> row_lines;          // ROW definitions
-        std::vector<std::string> combinational_components; // 非FF的COMPONENTS
+        // 非FF的COMPONENTS和NETS不存在記憶體，寫檔時從原始DEF串流複製
+        int combinational_components_count = 0;
+        std::streamoff components_begin = -1;        // 第一個component行的offset
+        std::streamoff components_end = -1;          // END COMPONENTS行的offset
         std::vector<std::string> pins_lines;         // PINS section
         std::vector<std::string> pinproperties_lines; // PINPROPERTIES section (optional)
         std::vector<std::string> blockages_lines;    // BLOCKAGES section (optional)
@@ -34,7 +38,8 @@ private:
             std::string use_type = "SIGNAL";
         };
         
-        std::vector<Net> original_nets;
+        int original_nets_count = 0;
+        std::streamoff nets_begin = -1;              // NETS header之後的offset
         
         // Statistics
         int total_components_count = 0;
@@ -60,17 +65,23 @@ private:
     void parse_and_store_original_def_sections(const std::string& input_def_path);
     
     // Write individual sections
-    void write_header_section(std::ofstream& out);
-    void write_row_section(std::ofstream& out);
-    void write_components_section(std::ofstream& out);
-    void write_pins_section(std::ofstream& out);
-    void write_pinproperties_section(std::ofstream& out);
-    void write_blockages_section(std::ofstream& out);
-    void write_specialnets_section(std::ofstream& out);
-    void write_nets_section(std::ofstream& out);
+    void write_header_section(std::ostream& out);
+    void write_row_section(std::ostream& out);
+    void write_components_section(std::ostream& out);
+    void write_pins_section(std::ostream& out);
+    void write_pinproperties_section(std::ostream& out);
+    void write_blockages_section(std::ostream& out);
+    void write_specialnets_section(std::ostream& out);
+    void write_nets_section(std::ostream& out);
+    void write_scanchains_section(std::ostream& out);
     
     // NET-specific parsing and processing
     void parse_original_nets_from_def(const std::string& input_def_path);
+    template <typename Visit>
+    void for_each_original_net(const std::string& input_def_path, std::streamoff resume_offset, Visit visit);
+    void write_net(std::ostream& out, const DefSectionData::Net& original_net,
+                   std::map<std::string, std::vector<DefSectionData::NetConnection>>& wire_to_final_connections,
+                   int& nets_updated);
     void build_wire_to_final_connections_mapping(std::map<std::string, std::vector<DefSectionData::NetConnection>>& mapping);
     bool is_combinational_pin(const std::string& pin_name);
     std::string normalize_net_name(const std::string& net_name);
@@ -79,6 +90,9 @@ private:
     std::string get_def_instance_name(const std::shared_ptr<Instance>& instance);
     std::string get_def_orientation(const std::shared_ptr<Instance>& instance);
     bool is_flip_flop_instance(const std::string& instance_name);
+    bool is_copied_component(const std::string& line);
+    
+    std::string input_def_path_;                     // Source of the streamed sections
     
     // Get final legalized FF instances (LEGALIZE stage from pipeline)
     std::vector<std::shared_ptr<Instance>> get_final_ff_instances();
@@ -95,10 +109,11 @@ void DefOutputGenerator::generate_def_up_to_nets(const std::string& input_def_pa
     std::cout << "  Output: " << output_def_path << std::endl;
     
     // Step 1: Parse and store original DEF sections
+    input_def_path_ = input_def_path;
     parse_and_store_original_def_sections(input_def_path);
     
     // Step 2: Generate output DEF file
-    std::ofstream out(output_def_path);
+    OutputFile out(output_def_path);
     if (!out.is_open()) {
         throw std::runtime_error("Cannot create output DEF file: " + output_def_path);
     }
@@ -112,7 +127,9 @@ void DefOutputGenerator::generate_def_up_to_nets(const std::string& input_def_pa
     write_blockages_section(out);
     write_specialnets_section(out);
     
-    out.close();
+    if (!out.close()) {
+        throw std::runtime_error("Failed to write output DEF file: " + output_def_path);
+    }
     std::cout << "  ✓ DEF file generated successfully (up to NETS section)" << std::endl;
 }
 
@@ -123,11 +140,12 @@ void DefOutputGenerator::generate_complete_def_file(const std::string& input_def
     std::cout << "  Output: " << output_def_path << std::endl;
     
     // Step 1: Parse and store original DEF sections (including NETS)
+    input_def_path_ = input_def_path;
     parse_and_store_original_def_sections(input_def_path);
     parse_original_nets_from_def(input_def_path);
     
     // Step 2: Generate output DEF file
-    std::ofstream out(output_def_path);
+    OutputFile out(output_def_path);
     if (!out.is_open()) {
         throw std::runtime_error("Cannot create output DEF file: " + output_def_path);
     }
@@ -141,24 +159,28 @@ void DefOutputGenerator::generate_complete_def_file(const std::string& input_def
     write_blockages_section(out);
     write_specialnets_section(out);
     write_nets_section(out);
+    write_scanchains_section(out);
     
     out << "END DESIGN" << std::endl;
-    out.close();
+    if (!out.close()) {
+        throw std::runtime_error("Failed to write output DEF file: " + output_def_path);
+    }
     std::cout << "  ✓ Complete DEF file generated successfully" << std::endl;
 }
 
 void DefOutputGenerator::parse_and_store_original_def_sections(const std::string& input_def_path) {
     std::cout << "  📖 Parsing original DEF sections..." << std::endl;
     
-    std::ifstream file(input_def_path);
+    InputFile file(input_def_path);
     if (!file.is_open()) {
         throw std::runtime_error("Cannot open input DEF file: " + input_def_path);
     }
     
     std::string line;
     std::string current_section = "HEADER";
+    std::streamoff line_start = 0;                   // Offset of `line` (getline drops only the '\n')
     
-    while (std::getline(file, line)) {
+    for (; std::getline(file, line); line_start += line.size() + 1) {
         std::string trimmed = line;
         
         // Determine current section
@@ -171,10 +193,12 @@ void DefOutputGenerator::parse_and_store_original_def_sections(const std::string
             std::istringstream iss(trimmed);
             std::string word;
             iss >> word >> def_sections.total_components_count;
+            def_sections.components_begin = line_start + line.size() + 1;
             continue; // Don't store the COMPONENTS line itself
         }
         else if (trimmed == "END COMPONENTS") {
             current_section = "POST_COMPONENTS";
+            def_sections.components_end = line_start;
             continue;
         }
         else if (trimmed.find("PINS ") == 0) {
@@ -238,24 +262,9 @@ void DefOutputGenerator::parse_and_store_original_def_sections(const std::string
             def_sections.row_lines.push_back(line);
         }
         else if (current_section == "COMPONENTS") {
-            // Only store non-FF components for later copying
-            if (line.find("SNPS") != std::string::npos) {
-                // Check if this is a flip-flop - use same patterns as in get_final_ff_instances
-                bool is_ff = false;
-                if (line.find("FDN") != std::string::npos ||
-                    line.find("FSD") != std::string::npos ||
-                    line.find("FDP") != std::string::npos ||
-                    line.find("LSRD") != std::string::npos ||
-                    line.find("SSRR") != std::string::npos) {
-                    is_ff = true;
-                }
-                
-                if (!is_ff) {
-                    def_sections.combinational_components.push_back(line);
-                }
-            } else {
-                // Non-SNPS component, keep it
-                def_sections.combinational_components.push_back(line);
+            // Only count non-FF components here; write_components_section copies them
+            if (is_copied_component(line)) {
+                def_sections.combinational_components_count++;
             }
         }
         else if (current_section == "PINS") {
@@ -276,33 +285,46 @@ void DefOutputGenerator::parse_and_store_original_def_sections(const std::string
     
     std::cout << "    ✓ Header lines: " << def_sections.header_lines.size() << std::endl;
     std::cout << "    ✓ ROW lines: " << def_sections.row_lines.size() << std::endl;
-    std::cout << "    ✓ Combinational components: " << def_sections.combinational_components.size() << std::endl;
+    std::cout << "    ✓ Combinational components: " << def_sections.combinational_components_count << std::endl;
     std::cout << "    ✓ PINS lines: " << def_sections.pins_lines.size() << std::endl;
     std::cout << "    ✓ PINPROPERTIES lines: " << def_sections.pinproperties_lines.size() << std::endl;
     std::cout << "    ✓ BLOCKAGES lines: " << def_sections.blockages_lines.size() << std::endl;
     std::cout << "    ✓ SPECIALNETS lines: " << def_sections.specialnets_lines.size() << std::endl;
 }
 
-void DefOutputGenerator::write_header_section(std::ofstream& out) {
+bool DefOutputGenerator::is_copied_component(const std::string& line) {
+    if (line.find("SNPS") == std::string::npos) {
+        return true;  // Non-SNPS component, keep it
+    }
+    // Check if this is a flip-flop - use same patterns as in get_final_ff_instances
+    bool is_ff = line.find("FDN") != std::string::npos ||
+                 line.find("FSD") != std::string::npos ||
+                 line.find("FDP") != std::string::npos ||
+                 line.find("LSRD") != std::string::npos ||
+                 line.find("SSRR") != std::string::npos;
+    return !is_ff;
+}
+
+void DefOutputGenerator::write_header_section(std::ostream& out) {
     // Write all header lines (VERSION, DIVIDERCHAR, DESIGN, UNITS, DIEAREA)
     for (const auto& line : def_sections.header_lines) {
         out << line << std::endl;
     }
 }
 
-void DefOutputGenerator::write_row_section(std::ofstream& out) {
+void DefOutputGenerator::write_row_section(std::ostream& out) {
     // Write all ROW definitions exactly as they were
     for (const auto& line : def_sections.row_lines) {
         out << line << std::endl;
     }
 }
 
-void DefOutputGenerator::write_components_section(std::ofstream& out) {
+void DefOutputGenerator::write_components_section(std::ostream& out) {
     // Get final FF instances after legalization
     auto final_ff_instances = get_final_ff_instances();
     
     // Calculate total component count (FF + combinational)
-    int total_components = final_ff_instances.size() + def_sections.combinational_components.size();
+    int total_components = final_ff_instances.size() + def_sections.combinational_components_count;
     
     out << "COMPONENTS " << total_components << " ;" << std::endl;
     
@@ -315,28 +337,36 @@ void DefOutputGenerator::write_components_section(std::ofstream& out) {
         
         out << " - " << def_name << " " << cell_type 
             << " + PLACED ( " 
-            << static_cast<int>(instance->x_new) << " " 
-            << static_cast<int>(instance->y_new) << " ) " 
+            << instance->x_new << " " 
+            << instance->y_new << " ) " 
             << orientation << " ;" << std::endl;
     }
     
     // Write combinational components exactly as they were
-    std::cout << "  🔧 Writing " << def_sections.combinational_components.size() << " combinational components..." << std::endl;
-    for (const auto& line : def_sections.combinational_components) {
-        out << line << std::endl;
+    std::cout << "  🔧 Writing " << def_sections.combinational_components_count << " combinational components..." << std::endl;
+    if (def_sections.components_begin >= 0) {
+        InputFile file(input_def_path_);
+        file.seekg(def_sections.components_begin);
+        std::string line;
+        for (std::streamoff offset = def_sections.components_begin; std::getline(file, line); offset += line.size() + 1) {
+            if (offset == def_sections.components_end) break;
+            if (is_copied_component(line)) {
+                out << line << std::endl;
+            }
+        }
     }
     
     out << "END COMPONENTS" << std::endl;
 }
 
-void DefOutputGenerator::write_pins_section(std::ofstream& out) {
+void DefOutputGenerator::write_pins_section(std::ostream& out) {
     // Write PINS section exactly as it was in the original
     for (const auto& line : def_sections.pins_lines) {
         out << line << std::endl;
     }
 }
 
-void DefOutputGenerator::write_pinproperties_section(std::ofstream& out) {
+void DefOutputGenerator::write_pinproperties_section(std::ostream& out) {
     // Write PINPROPERTIES section if it exists
     if (!def_sections.pinproperties_lines.empty()) {
         out << "PINPROPERTIES " << def_sections.pinproperties_count << " ;" << std::endl;
@@ -350,7 +380,7 @@ void DefOutputGenerator::write_pinproperties_section(std::ofstream& out) {
     }
 }
 
-void DefOutputGenerator::write_blockages_section(std::ofstream& out) {
+void DefOutputGenerator::write_blockages_section(std::ostream& out) {
     // Write BLOCKAGES section if it exists
     if (!def_sections.blockages_lines.empty()) {
         out << "BLOCKAGES " << def_sections.blockages_count << " ;" << std::endl;
@@ -364,7 +394,7 @@ void DefOutputGenerator::write_blockages_section(std::ofstream& out) {
     }
 }
 
-void DefOutputGenerator::write_specialnets_section(std::ofstream& out) {
+void DefOutputGenerator::write_specialnets_section(std::ostream& out) {
     // Write SPECIALNETS section if it exists
     if (!def_sections.specialnets_lines.empty()) {
         out << "SPECIALNETS " << def_sections.specialnets_count << " ;" << std::endl;
@@ -396,7 +426,7 @@ std::vector<std::shared_ptr<Instance>> DefOutputGenerator::get_final_ff_instance
     
     // Get final result instances from transformation history
     for (const auto& record : db.transformation_history) {
-        result_instance_names.insert(record.result_instance_name);
+        result_instance_names.insert(record.result_instance_name());
     }
     
     // Find the corresponding instances in db.instances
@@ -425,7 +455,21 @@ std::vector<std::shared_ptr<Instance>> DefOutputGenerator::get_final_ff_instance
 void DefOutputGenerator::parse_original_nets_from_def(const std::string& input_def_path) {
     std::cout << "  📖 Parsing original NETS section..." << std::endl;
     
-    std::ifstream file(input_def_path);
+    // 只數net數 (NETS header要先寫)，connections在write_nets_section時再串流讀一次
+    def_sections.original_nets_count = 0;
+    def_sections.nets_begin = -1;
+    for_each_original_net(input_def_path, -1, [this](const DefSectionData::Net&) {
+        def_sections.original_nets_count++;
+    });
+    
+    std::cout << "    ✓ Parsed " << def_sections.original_nets_count << " original nets" << std::endl;
+}
+
+// Calls visit(net) for every net of the NETS section, in file order, holding one net at a time.
+// resume_offset < 0: scan from the top (and record nets_begin); otherwise resume right after the NETS header.
+template <typename Visit>
+void DefOutputGenerator::for_each_original_net(const std::string& input_def_path, std::streamoff resume_offset, Visit visit) {
+    InputFile file(input_def_path);
     if (!file.is_open()) {
         throw std::runtime_error("Cannot open input DEF file for NETS parsing: " + input_def_path);
     }
@@ -433,8 +477,14 @@ void DefOutputGenerator::parse_original_nets_from_def(const std::string& input_d
     std::string line;
     bool in_nets_section = false;
     DefSectionData::Net current_net;
+    std::streamoff offset = 0;
+    if (resume_offset >= 0) {
+        file.seekg(resume_offset);
+        offset = resume_offset;
+        in_nets_section = true;
+    }
     
-    while (std::getline(file, line)) {
+    for (; std::getline(file, line); offset += line.size() + 1) {
         std::string trimmed = line;
         // Remove leading/trailing whitespace
         size_t start = trimmed.find_first_not_of(" \t");
@@ -443,6 +493,9 @@ void DefOutputGenerator::parse_original_nets_from_def(const std::string& input_d
         }
         
         if (trimmed.find("NETS ") == 0) {
+            if (!in_nets_section && def_sections.nets_begin < 0) {
+                def_sections.nets_begin = offset + line.size() + 1;
+            }
             in_nets_section = true;
             continue;
         }
@@ -450,7 +503,7 @@ void DefOutputGenerator::parse_original_nets_from_def(const std::string& input_d
         if (trimmed == "END NETS") {
             // Add the last net if it has a name
             if (!current_net.name.empty()) {
-                def_sections.original_nets.push_back(current_net);
+                visit(current_net);
             }
             break;
         }
@@ -460,7 +513,7 @@ void DefOutputGenerator::parse_original_nets_from_def(const std::string& input_d
                 // New net definition
                 if (!current_net.name.empty()) {
                     // Save previous net
-                    def_sections.original_nets.push_back(current_net);
+                    visit(current_net);
                 }
                 
                 // Parse net name
@@ -495,7 +548,42 @@ void DefOutputGenerator::parse_original_nets_from_def(const std::string& input_d
     }
     
     file.close();
-    std::cout << "    ✓ Parsed " << def_sections.original_nets.size() << " original nets" << std::endl;
+}
+
+// SCANCHAINS from the input DEF, with the members / order after Step 19.5
+void DefOutputGenerator::write_scanchains_section(std::ostream& out) {
+    int chain_count = 0;
+    for (const auto& chain : db.scan_chains) {
+        if (chain.from_def) chain_count++;
+    }
+    if (chain_count == 0) return;
+    
+    out << "SCANCHAINS " << chain_count << " ;" << std::endl;
+    for (const auto& chain : db.scan_chains) {
+        if (!chain.from_def) continue;
+        out << " - " << chain.name << std::endl;
+        out << "   + START " << (chain.start_instance.empty() ? "PIN" : chain.start_instance) << " "
+            << chain.scan_in_pin << std::endl;
+        int segment = -2;
+        for (const auto& conn : chain.chain_sequence) {
+            // FLOATING成員放在同一個list，每個ORDERED list各自一個
+            if (conn.ordered_segment != segment) {
+                out << "   + " << (conn.ordered_segment >= 0 ? "ORDERED" : "FLOATING") << std::endl;
+                segment = conn.ordered_segment;
+            }
+            out << "     " << conn.instance_name << " ( IN " << conn.scan_in_pin << " )";
+            if (!conn.scan_out_pin.empty()) out << " ( OUT " << conn.scan_out_pin << " )";
+            out << std::endl;
+        }
+        if (!chain.partition.empty()) {
+            out << "   + PARTITION " << chain.partition;
+            if (chain.max_bits >= 0) out << " MAXBITS " << chain.max_bits;
+            out << std::endl;
+        }
+        out << "   + STOP " << (chain.stop_instance.empty() ? "PIN" : chain.stop_instance) << " "
+            << chain.scan_out_pin << " ;" << std::endl;
+    }
+    out << "END SCANCHAINS" << std::endl;
 }
 
 std::string DefOutputGenerator::normalize_net_name(const std::string& net_name) {
@@ -591,7 +679,61 @@ bool DefOutputGenerator::is_combinational_pin(const std::string& pin_name) {
     return pin_name.length() > 0 && (pin_name[0] == 'A' || pin_name[0] == 'X');
 }
 
-void DefOutputGenerator::write_nets_section(std::ofstream& out) {
+// One original net: final FF connections first, then the original pins that survive banking
+void DefOutputGenerator::write_net(std::ostream& out, const DefSectionData::Net& original_net,
+                                   std::map<std::string, std::vector<DefSectionData::NetConnection>>& wire_to_final_connections,
+                                   int& nets_updated) {
+    out << " - " << original_net.name << std::endl;
+    
+    // Process each connection in this net
+    bool net_has_ff_updates = false;
+    
+    // First, write any final FF connections for this net
+    // Use normalized net name for matching
+    std::string normalized_original_net = normalize_net_name(original_net.name);
+    if (wire_to_final_connections.count(normalized_original_net)) {
+        for (const auto& final_conn : wire_to_final_connections[normalized_original_net]) {
+            out << "   ( " << final_conn.instance_name << " " << final_conn.pin_name << " )" << std::endl;
+        }
+        net_has_ff_updates = true;
+    }
+    
+    // Then, process original connections
+    bool is_synopsys_unconnected = (original_net.name.find("SYNOPSYS_UNCONNECTED") != std::string::npos);
+    
+    for (const auto& orig_conn : original_net.connections) {
+        if (is_combinational_pin(orig_conn.pin_name)) {
+            // Combinational pins (A*, X*) → always copy
+            out << "   ( " << orig_conn.instance_name << " " << orig_conn.pin_name << " )" << std::endl;
+        } else {
+            // Non-combinational pins (FF or latch pins)
+            if (is_synopsys_unconnected) {
+                // For SYNOPSYS_UNCONNECTED nets, skip FF pins (QN, Q, D, etc.)
+                // Only A*, X* pins are copied above
+            } else {
+                // For regular nets, only copy if this net doesn't have final FF connections
+                if (!net_has_ff_updates) {
+                    out << "   ( " << orig_conn.instance_name << " " << orig_conn.pin_name << " )" << std::endl;
+                }
+                // If net_has_ff_updates is true, skip original FF connections 
+                // because they've been replaced by final FF connections above
+            }
+        }
+    }
+    
+    if (net_has_ff_updates) {
+        nets_updated++;
+    }
+    
+    // Write USE clause
+    out << "   + USE " << original_net.use_type;
+    if (original_net.use_type.find(" ;") == std::string::npos) {
+        out << " ;";
+    }
+    out << std::endl;
+}
+
+void DefOutputGenerator::write_nets_section(std::ostream& out) {
     std::cout << "  🔌 Writing NETS section..." << std::endl;
     
     // Step 1: Build mapping from wire names to final FF connections
@@ -609,68 +751,22 @@ void DefOutputGenerator::write_nets_section(std::ofstream& out) {
     }
     
     // Step 3: Calculate total nets count (all original nets + 1 for new UNCONNECTED if needed)
-    int total_nets = def_sections.original_nets.size();
+    int total_nets = def_sections.original_nets_count;
     if (!new_unconnected_pins.empty()) {
         total_nets += 1; // Add one new UNCONNECTED net
     }
     
     out << "NETS " << total_nets << " ;" << std::endl;
     
-    // Step 4: Process all original nets
+    // Step 4: Process all original nets (streamed again from the input DEF, one net at a time)
     int nets_processed = 0;
     int nets_updated = 0;
     
-    for (const auto& original_net : def_sections.original_nets) {
-        out << " - " << original_net.name << std::endl;
-        
-        // Process each connection in this net
-        bool net_has_ff_updates = false;
-        
-        // First, write any final FF connections for this net
-        // Use normalized net name for matching
-        std::string normalized_original_net = normalize_net_name(original_net.name);
-        if (wire_to_final_connections.count(normalized_original_net)) {
-            for (const auto& final_conn : wire_to_final_connections[normalized_original_net]) {
-                out << "   ( " << final_conn.instance_name << " " << final_conn.pin_name << " )" << std::endl;
-            }
-            net_has_ff_updates = true;
-        }
-        
-        // Then, process original connections
-        bool is_synopsys_unconnected = (original_net.name.find("SYNOPSYS_UNCONNECTED") != std::string::npos);
-        
-        for (const auto& orig_conn : original_net.connections) {
-            if (is_combinational_pin(orig_conn.pin_name)) {
-                // Combinational pins (A*, X*) → always copy
-                out << "   ( " << orig_conn.instance_name << " " << orig_conn.pin_name << " )" << std::endl;
-            } else {
-                // Non-combinational pins (FF or latch pins)
-                if (is_synopsys_unconnected) {
-                    // For SYNOPSYS_UNCONNECTED nets, skip FF pins (QN, Q, D, etc.)
-                    // Only A*, X* pins are copied above
-                } else {
-                    // For regular nets, only copy if this net doesn't have final FF connections
-                    if (!net_has_ff_updates) {
-                        out << "   ( " << orig_conn.instance_name << " " << orig_conn.pin_name << " )" << std::endl;
-                    }
-                    // If net_has_ff_updates is true, skip original FF connections 
-                    // because they've been replaced by final FF connections above
-                }
-            }
-        }
-        
-        if (net_has_ff_updates) {
-            nets_updated++;
-        }
-        
-        // Write USE clause
-        out << "   + USE " << original_net.use_type;
-        if (original_net.use_type.find(" ;") == std::string::npos) {
-            out << " ;";
-        }
-        out << std::endl;
-        
-        nets_processed++;
+    if (def_sections.nets_begin >= 0) {
+        for_each_original_net(input_def_path_, def_sections.nets_begin, [&](const DefSectionData::Net& original_net) {
+            write_net(out, original_net, wire_to_final_connections, nets_updated);
+            nets_processed++;
+        });
     }
     
     // Step 5: Write new UNCONNECTED net for final FF pins that connect to UNCONNECTED
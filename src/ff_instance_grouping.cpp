@@ -1,5 +1,8 @@
 #include "parsers.hpp"
 #include "timing_repr_hardcoded.hpp"
+#include "logger.hpp"
+#include "scan_reorder.hpp"
+#include "clock_tracing.hpp"
 #include <iostream>
 #include <set>
 #include <unordered_set>
@@ -58,7 +61,9 @@ std::string get_instance_clock_edge(std::shared_ptr<Instance> instance, const De
 }
 
 // Get the scan chain ID for an instance (if any)
-std::string get_instance_scan_chain(std::shared_ptr<Instance> instance, const DesignDatabase& db) {
+// chain_of: instance name -> chain name，group_ff_instances建一次 (不必每個instance掃所有chain)
+std::string get_instance_scan_chain(std::shared_ptr<Instance> instance,
+                                    const std::unordered_map<std::string, std::string>& chain_of) {
     // 檢查是否有SI/SE connections來判斷是否在scan chain中
     // Note: In this testcase, there are no SO pins, only SI and SE
     std::string si_net = "";
@@ -87,13 +92,9 @@ std::string get_instance_scan_chain(std::shared_ptr<Instance> instance, const De
     // 如果有active SI或SE connection，則需要找到這個FF屬於哪個scan chain
     if (si_connected || se_connected) {
         // 查找這個instance屬於哪個scan chain
-        for (size_t chain_idx = 0; chain_idx < db.scan_chains.size(); chain_idx++) {
-            const auto& chain = db.scan_chains[chain_idx];
-            for (const auto& scan_conn : chain.chain_sequence) {
-                if (scan_conn.instance_name == instance->name) {
-                    return chain.name; // 返回scan chain名稱
-                }
-            }
+        auto it = chain_of.find(instance->name);
+        if (it != chain_of.end()) {
+            return it->second; // 返回scan chain名稱
         }
         // 如果沒找到對應的scan chain，可能是scan chain detection的問題
         return "UNASSIGNED_SCAN";
@@ -103,13 +104,13 @@ std::string get_instance_scan_chain(std::shared_ptr<Instance> instance, const De
     return "NON_SCAN";
 }
 
-// Get clock domain for an instance (simplified)
+// Get clock domain for an instance (traced clock label of the CK net)
 std::string get_instance_clock_domain(std::shared_ptr<Instance> instance, const DesignDatabase& db) {
     // 尋找clock connection
     for (const auto& conn : instance->connections) {
         Pin::FlipFlopPinType pin_type = classify_ff_pin_type(conn.pin_name);
         if (pin_type == Pin::FF_CLOCK && is_active_logical_connection(conn, pin_type)) {
-            return conn.net_name;
+            return clock_domain_label(db, instance->module_name, conn.net_name);
         }
     }
     
@@ -120,8 +121,9 @@ std::string get_instance_clock_domain(std::shared_ptr<Instance> instance, const
 // Based on scan chain, hierarchy, and clock domain (pin patterns handled by three-stage substitution)
 // Cross-hierarchy banking is prohibited according to Q70 in Problem B_QA_0812.pdf
 // Cross-clock banking is prohibited for timing reasons
-std::string generate_instance_group_key(std::shared_ptr<Instance> instance, const DesignDatabase& db) {
-    std::string scan_chain = get_instance_scan_chain(instance, db);
+std::string generate_instance_group_key(std::shared_ptr<Instance> instance, const DesignDatabase& db,
+                                        const std::unordered_map<std::string, std::string>& chain_of) {
+    std::string scan_chain = get_instance_scan_chain(instance, chain_of);
     std::string hierarchy = get_instance_hierarchy(instance); // Add hierarchy constraint
     std::string clock_domain = get_instance_clock_domain(instance, db); // Add clock domain constraint
     
@@ -148,8 +150,14 @@ void group_ff_instances(DesignDatabase& db) {
     std::cout << "    Found " << ff_instances.size() << " FF instances to group" << std::endl;
     
     // 根據group key分組
+    std::unordered_map<std::string, std::string> chain_of;
+    for (const auto& chain : db.scan_chains) {
+        for (const auto& scan_conn : chain.chain_sequence) {
+            chain_of.emplace(scan_conn.instance_name, chain.name);   // 第一個出現的chain
+        }
+    }
     for (auto& instance : ff_instances) {
-        std::string group_key = generate_instance_group_key(instance, db);
+        std::string group_key = generate_instance_group_key(instance, db, chain_of);
         db.ff_instance_groups[group_key].push_back(instance);
     }
     
@@ -160,8 +168,8 @@ void group_ff_instances(DesignDatabase& db) {
     for (const auto& group_pair : db.ff_instance_groups) {
         total_grouped_instances += group_pair.second.size();
         if (group_pair.second.size() > 1) {
-            std::cout << "      Group [" << group_pair.first << "]: " 
-                      << group_pair.second.size() << " instances" << std::endl;
+            LOG_HOT << "      Group [" << group_pair.first << "]: "
+                    << group_pair.second.size() << " instances";
         }
     }
     
@@ -169,7 +177,8 @@ void group_ff_instances(DesignDatabase& db) {
 }
 
 // Helper function to get clock signal name from instance
-std::string get_instance_clock_signal(std::shared_ptr<Instance> instance) {
+// (traced clock domain label: root clock + edge parity + gating enables, see clock_tracing.hpp)
+std::string get_instance_clock_signal(std::shared_ptr<Instance> instance, const DesignDatabase& db) {
     // Find the actual clock net name connected to CK pin
     for (const auto& conn : instance->connections) {
         Pin::FlipFlopPinType pin_type = classify_ff_pin_type(conn.pin_name);
@@ -178,7 +187,7 @@ std::string get_instance_clock_signal(std::shared_ptr<Instance> instance) {
                 conn.net_name.find("SYNOPSYS_UNCONNECTED") == std::string::npos &&
                 conn.net_name != "VSS" && 
                 conn.net_name != "VDD") {
-                return conn.net_name;
+                return clock_domain_label(db, instance->module_name, conn.net_name);
             }
         }
     }
@@ -204,13 +213,43 @@ void rebuild_ff_instance_groups_for_banking(DesignDatabase& db) {
     
     std::cout << "    Found " << ff_instances.size() << " FF instances to group" << std::endl;
     
+    // SCANDEF PARTITION：scan FF只和同partition的FF併 (step 19.5重新串chain時不會跨partition)
+    // debank出來的instance用cluster_id (原本的multi-bit名稱) 查
+    std::unordered_map<std::string, std::string> scan_partitions = build_scan_partition_map(db);
+    
+    // -param clock_leaf_group_min_ffs > 0：traced clock domain (clock_tracing.hpp) 裡
+    // FF數達到門檻的leaf CK net自己一個group，較小的leaf才併進domain的group
+    // 預設0：整個domain一個group
+    double leaf_min_ffs = db.banking_params.clock_leaf_group_min_ffs;
+    std::vector<std::string> leaf_nets(ff_instances.size());
+    std::unordered_map<std::string, int> leaf_sizes;   // hierarchy|leaf CK net -> FFs
+    for (size_t i = 0; i < ff_instances.size() && leaf_min_ffs > 0.0; i++) {
+        for (const auto& conn : ff_instances[i]->connections) {
+            if (classify_ff_pin_type(conn.pin_name) != Pin::FF_CLOCK) continue;
+            if (clock_domain_label(db, ff_instances[i]->module_name, conn.net_name) != conn.net_name) {
+                leaf_nets[i] = conn.net_name;
+                leaf_sizes[get_instance_hierarchy(ff_instances[i]) + "|" + conn.net_name]++;
+            }
+            break;
+        }
+    }
+    
     // Group by hierarchy + clock signal
-    for (auto& instance : ff_instances) {
+    for (size_t i = 0; i < ff_instances.size(); i++) {
+        auto& instance = ff_instances[i];
         std::string hierarchy = get_instance_hierarchy(instance);
-        std::string clock_signal = get_instance_clock_signal(instance);
+        std::string clock_signal = get_instance_clock_signal(instance, db);
         
-        // Create group key: hierarchy|clock_signal
+        // Create group key: hierarchy|clock_signal (+ |leaf CK net) (+ |scan partition)
         std::string group_key = hierarchy + "|" + clock_signal;
+        if (!leaf_nets[i].empty() && leaf_sizes[hierarchy + "|" + leaf_nets[i]] >= leaf_min_ffs) {
+            group_key += "|" + leaf_nets[i];
+        }
+        if (!scan_partitions.empty()) {
+            auto partition = scan_partitions.find(instance->name);
+            if (partition == scan_partitions.end()) partition = scan_partitions.find(instance->cluster_id);
+            if (partition != scan_partitions.end()) group_key += "|" + partition->second;
+        }
         
         db.ff_instance_groups[group_key].push_back(instance);
     }
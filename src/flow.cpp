@@ -0,0 +1,561 @@
+#include "flow.hpp"
+#include "parsers.hpp"
+#include "substitution.hpp"
+#include "def_output_generator.hpp"
+/*Legalization*/
+#include "Legalization.hpp"
+/*Legalization*/
+#include "profiler.hpp"
+#include "logger.hpp"
+#include "task_graph.hpp"
+#include "thread_pool.hpp"
+#include "checkpoint.hpp"
+#include "time_budget.hpp"
+#include "out_of_core.hpp"
+#include "spatial_order.hpp"
+#include "tile_flow.hpp"
+#include "compressed_stream.hpp"
+#include "scan_reorder.hpp"
+#include "clock_tracing.hpp"
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+// =============================================================================
+// BANKING FLOW (steps 1-19.5 + writers as one task graph)
+// =============================================================================
+
+std::string report_path(const ProgramArguments& args, const std::string& filename) {
+    if (!args.write_reports) return "";
+    if (args.report_dir.empty()) return filename;
+    return args.report_dir + "/" + filename;
+}
+
+std::string directory_of(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    if (slash == std::string::npos) return "";
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+void share_cell_library(const DesignDatabase& library, DesignDatabase& db) {
+    // CellTemplate物件共用 (step 2之後只讀)；map本身複製，每個design各自查詢/插入
+    db.cell_library = library.cell_library;
+    db.ff_compatibility_groups = library.ff_compatibility_groups;
+    db.hierarchical_ff_groups = library.hierarchical_ff_groups;
+}
+
+void run_banking_flow(const ProgramArguments& args, DesignDatabase& db, ThreadPool& pool,
+                      int completed_rank, int last_rank, std::streambuf* output) {
+    // 整個flow用task graph表示：每個stage宣告讀/寫的DB部分，沒有資料依賴的
+    // stage (Liberty ∥ Verilog ∥ Weights、最後的writers) 會同時執行
+    TaskGraph pipeline;
+    bool write_outputs = last_rank < 0;
+
+    if (!args.checkpoint_after.empty() && checkpoint_step_rank(args.checkpoint_after) <= completed_rank) {
+        LOG_WARN << "Step " << args.checkpoint_after << " is already in the checkpoint; no new checkpoint is written";
+    }
+
+    // 已完成或超過last_rank的step不執行
+    auto step_selected = [&](const std::string& step) {
+        int rank = checkpoint_step_rank(step);
+        return rank > completed_rank && (last_rank < 0 || rank <= last_rank);
+    };
+
+    // 每個step的stage經由add_step加入 (沒選到的step跳過)
+    auto add_step = [&](const std::string& step, const std::string& name, unsigned reads, unsigned writes,
+                        std::function<void()> body) -> int {
+        if (!step_selected(step)) return -1;
+        return pipeline.add_stage(name, reads, writes, std::move(body));
+    };
+
+    // -param：這個design的heuristic門檻 (每次呼叫都由args決定)
+    db.banking_params = args.banking_params;
+
+    // -time_budget：第一次呼叫時開始計時 (batch分兩段跑同一個design時沿用)，
+    // 這次會執行的anytime phases依序登記給budget分配時間
+    if (args.time_budget > 0.0 && !db.time_budget) {
+        db.time_budget = std::make_shared<TimeBudget>(args.time_budget);
+    }
+    if (db.time_budget) {
+        if (step_selected("12")) db.time_budget->plan_phase("debanking", TIME_BUDGET_WEIGHT_DEBANKING);
+        if (step_selected("18")) db.time_budget->plan_phase("banking", TIME_BUDGET_WEIGHT_BANKING);
+        if (step_selected("19")) db.time_budget->plan_phase("legalization", TIME_BUDGET_WEIGHT_LEGALIZATION);
+    }
+
+    // -out_of_core：parse之前建立spill檔 (組合邏輯不進DesignDatabase)
+    if (args.out_of_core && !db.out_of_core && step_selected("3")) {
+        db.out_of_core = std::make_shared<OutOfCoreNetlist>(args.output_name.empty() ? "output" : args.output_name);
+    }
+
+    // --checkpoint-after: 在該step之後加一個讀全部DB的stage (等前面全部寫完，後面的writer等它讀完)
+    auto add_checkpoint = [&](const std::string& step) {
+        int rank = checkpoint_step_rank(step);
+        if (args.checkpoint_after != step || rank <= completed_rank || (last_rank >= 0 && rank > last_rank)) return;
+        pipeline.add_stage("Checkpoint after step " + step, DB_ALL, DB_NONE, [&args, &db, step]() {
+            ScopedTimer checkpoint_timer("Checkpoint after step " + step);
+            std::string prefix = args.output_name.empty() ? "checkpoint" : args.output_name;
+            std::string filename = prefix + "_step" + step + CHECKPOINT_EXTENSION;
+            if (!save_checkpoint(db, step, filename)) {
+                throw std::runtime_error("Cannot write checkpoint " + filename);
+            }
+            checkpoint_timer.set_items(db.instances.size());
+        });
+    };
+
+    // 輸出檔只在跑到最後時產生
+    auto add_writer = [&](const std::string& name, unsigned reads, unsigned writes, std::function<void()> body) -> int {
+        if (!write_outputs) return -1;
+        return pipeline.add_stage(name, reads, writes, std::move(body));
+    };
+
+    // 輸入檔依parse的順序排列：開啟一個檔案時，kernel先把下一個檔案讀進page cache
+    std::vector<std::string> input_files(args.lib_files);
+    input_files.insert(input_files.end(), args.lef_files.begin(), args.lef_files.end());
+    input_files.insert(input_files.end(), args.verilog_files.begin(), args.verilog_files.end());
+    input_files.insert(input_files.end(), args.def_files.begin(), args.def_files.end());
+    if (!args.weight_file.empty()) input_files.push_back(args.weight_file);
+    input_files.insert(input_files.end(), args.sdc_files.begin(), args.sdc_files.end());
+    set_input_prefetch_order(input_files);
+
+    // Step 1: Parse Liberty files (from command line arguments)
+    // 每個liberty檔各自parse (互相獨立)，再依檔案順序合併 (後面的同名cell覆蓋前面)
+    std::vector<std::vector<std::shared_ptr<CellTemplate>>> liberty_parts(args.lib_files.size());
+    std::vector<int> liberty_stages;
+    for (size_t i = 0; i < args.lib_files.size(); i++) {
+        liberty_stages.push_back(add_step("1", "parse_liberty_file", DB_NONE, DB_NONE, [&args, &liberty_parts, i]() {
+            PROFILE_SCOPE("Step 1: parse_liberty_file");
+            if (i == 0) {
+                std::cout << "\n📚 Step 1: Parsing Liberty files..." << std::endl;
+            }
+            liberty_parts[i] = parse_liberty_cells(args.lib_files[i]);
+        }));
+    }
+    
+    int liberty_merge = add_step("1", "Step 1: Liberty merge", DB_NONE, DB_CELL_LIBRARY, [&db, &liberty_parts]() {
+        ScopedTimer step_timer("Step 1: Liberty merge");
+        for (auto& part : liberty_parts) {
+            for (auto& cell : part) {
+                db.cell_library[cell->name] = cell;
+            }
+            part.clear();
+        }
+        std::cout << "  Cell library: " << db.cell_library.size() << " cells" << std::endl;
+        step_timer.set_items(db.cell_library.size());
+    });
+    for (int stage : liberty_stages) {
+        if (liberty_merge >= 0) pipeline.depends_on(liberty_merge, stage);
+    }
+    
+    // 建立banking關係
+    add_step("1", "Step 1: build_banking_relationships", DB_CELL_LIBRARY, DB_CELL_BANKING, [&db]() {
+        PROFILE_SCOPE("Step 1: build_banking_relationships");
+        build_banking_relationships(db);
+    });
+    
+    // 建立FF cell相容性分群
+    add_step("1", "Step 1: build_ff_cell_compatibility_groups", DB_CELL_LIBRARY | DB_CELL_PHYSICAL,
+             DB_CELL_GROUPS, [&db]() {
+        PROFILE_SCOPE("Step 1: build_ff_cell_compatibility_groups");
+        build_ff_cell_compatibility_groups(db);
+    });
+    add_checkpoint("1");
+    
+    // Step 2: Parse LEF files to add physical information to cells
+    add_step("2", "Step 2: LEF", DB_CELL_LIBRARY, DB_CELL_PHYSICAL, [&args, &db]() {
+        PROFILE_SCOPE("Step 2: LEF");
+        std::cout << "\n🏗️  Step 2: Parsing LEF files..." << std::endl;
+        std::cout.flush();
+        for (const auto& lef_file : args.lef_files) {
+            PROFILE_SCOPE("parse_lef_file");
+            parse_lef_file(lef_file, db);
+        }
+    });
+    add_checkpoint("2");
+    
+    // 輸出完整的Cell Library驗證報告（包含物理資訊）
+    //export_cell_library_validation(db);
+    
+    // Step 3: Parse Verilog files first to create instances and connections
+    // out of core要用cell library判斷哪些instance是FF (其餘直接spill)
+    add_step("3", "Step 3: Verilog", db.out_of_core ? DB_CELL_LIBRARY : DB_NONE, DB_NETLIST, [&args, &db]() {
+        ScopedTimer step_timer("Step 3: Verilog");
+        std::cout << "\n🔌 Step 3: Parsing Verilog netlist..." << std::endl;
+        std::cout.flush();
+        for (const auto& verilog_file : args.verilog_files) {
+            PROFILE_SCOPE("parse_verilog_file");
+            if (db.out_of_core) {
+                parse_verilog_file_out_of_core(verilog_file, db);
+            } else {
+                parse_verilog_file(verilog_file, db);
+            }
+        }
+        if (db.out_of_core) db.out_of_core->finish_netlist();
+        step_timer.set_items(db.instances.size());
+    });
+    add_checkpoint("3");
+    
+    // Step 4: Parse DEF files to add placement information to existing instances
+    // out of core的obstacle大小來自cell的LEF尺寸
+    unsigned def_reads = db.out_of_core ? (DB_CELL_LIBRARY | DB_CELL_PHYSICAL) : DB_NONE;
+    add_step("4", "Step 4: DEF", def_reads, DB_NETLIST | DB_PLACEMENT | DB_SCAN, [&args, &db]() {
+        ScopedTimer step_timer("Step 4: DEF");
+        std::cout << "\n📍 Step 4: Parsing DEF placement..." << std::endl;
+        std::cout.flush();
+        for (const auto& def_file : args.def_files) {
+            PROFILE_SCOPE("parse_def_file");
+            parse_def_file(def_file, db);
+        }
+        if (db.out_of_core) db.out_of_core->finish_obstacles();
+        step_timer.set_items(db.instances.size());
+    });
+    
+    // 有位置之後把instance依Hilbert curve重新排列 (之後的走訪順序 / 記憶體位置都是空間上連續)
+    add_step("4", "Step 4: Spatial reorder", DB_PLACEMENT, DB_NETLIST | DB_PLACEMENT, [&db]() {
+        reorder_instances_spatially(db);
+    });
+    add_checkpoint("4");
+    
+    // Step 5: Parse Weight file for objective function
+    add_step("5", "Step 5: Weights", DB_NONE, DB_WEIGHTS, [&args, &db]() {
+        PROFILE_SCOPE("Step 5: Weights");
+        std::cout << "\n⚖️  Step 5: Parsing objective weights..." << std::endl;
+        std::cout.flush();
+        parse_weight_file(args.weight_file, db);
+    });
+    
+    // Step 5: SDC clocks (clock tracing的root clock名稱)
+    if (!args.sdc_files.empty()) {
+        add_step("5", "Step 5: SDC clocks", DB_NONE, DB_CLOCKS, [&args, &db]() {
+            PROFILE_SCOPE("Step 5: SDC clocks");
+            std::cout << "\n⏱️  Step 5: Parsing SDC clocks..." << std::endl;
+            std::cout.flush();
+            db.sdc_clocks.clear();
+            for (const auto& sdc_file : args.sdc_files) parse_sdc_file(sdc_file, db);
+        });
+    }
+    add_checkpoint("5");
+    
+    // Step 6: Link instances to cell templates and finalize
+    add_step("6", "Step 6: Link instances", DB_CELL_LIBRARY, DB_NETLIST, [&db]() {
+        ScopedTimer step_timer("Step 6: Link instances");
+        std::cout << "\n🔗 Step 6: Linking instances to cells..." << std::endl;
+        std::cout.flush();
+        int linked_count = 0;
+        for (const auto& pair : db.instances) {
+            auto& instance = pair.second;
+            auto cell = db.get_cell(instance->cell_type);
+            if (cell) {
+                instance->cell_template = cell;
+                linked_count++;
+            } else {
+                LOG_WARN_LIMITED("cell not found in library") << "Cell " << instance->cell_type
+                                                              << " not found in library";
+            }
+        }
+        std::cout << "  Linked " << linked_count << " instances to cell templates" << std::endl;
+        step_timer.set_items(linked_count);
+    });
+    add_checkpoint("6");
+    
+    // 輸出完整的Instance驗證報告（包含placement和linking資訊）
+    //export_instance_validation(db);
+    
+    // Steps 7-9 / 12-19 讀寫範圍很廣，宣告成DB_ALL (barrier)
+    
+    // Step 7: Analyze FF pin connections for compatibility checking
+    add_step("7", "Step 7: FF pin connections", DB_ALL, DB_ALL, [&db]() {
+        PROFILE_SCOPE("Step 7: FF pin connections");
+        std::cout << "\n🔍 Step 7: Analyzing FF pin connections..." << std::endl;
+        std::cout.flush();
+        analyze_ff_pin_connections(db);
+        trace_clock_domains(db);
+    });
+    add_checkpoint("7");
+    
+    // Step 8: Detect scan chains from netlist connections
+    add_step("8", "Step 8: detect_scan_chains", DB_ALL, DB_ALL, [&db]() {
+        PROFILE_SCOPE("Step 8: detect_scan_chains");
+        std::cout << "\n🔗 Step 8: Detecting scan chains..." << std::endl;
+        std::cout.flush();
+        detect_scan_chains(db);
+        record_scan_chain_endpoints(db);
+    });
+    add_checkpoint("8");
+    
+    // Step 9: Build scan chain banking groups
+    add_step("9", "Step 9: Scan chain groups", DB_ALL, DB_ALL, [&db]() {
+        PROFILE_SCOPE("Step 9: Scan chain groups");
+        std::cout << "\n🏗️  Step 9: Building scan chain banking groups..." << std::endl;
+        std::cout.flush();
+        build_scan_chain_groups(db);
+    });
+    add_checkpoint("9");
+    
+    // Step 10: Export FF grouping analysis report (只寫hierarchical_ff_groups)
+    add_step("10", "Step 10: FF grouping report", DB_CELL_LIBRARY | DB_CELL_PHYSICAL | DB_NETLIST | DB_SCAN,
+             DB_CELL_GROUPS, [&args, &db]() {
+        PROFILE_SCOPE("Step 10: FF grouping report");
+        std::cout << "\n📊 Step 10: Exporting FF grouping analysis report..." << std::endl;
+        std::cout.flush();
+        export_ff_grouping_report(db, report_path(args, "ff_grouping_report.txt"));
+    });
+    add_checkpoint("10");
+    
+    // Step 11: Initialize Transformation Tracking System
+    // 每個FF寫cluster_id (netlist state)，所以宣告寫DB_NETLIST，不和讀netlist的Step 10同時跑
+    add_step("11", "Step 11: Transformation tracking", DB_NETLIST | DB_CELL_LIBRARY,
+             DB_NETLIST | DB_HISTORY | DB_PIN_PROVENANCE, [&db]() {
+        ScopedTimer step_timer("Step 11: Transformation tracking");
+        std::cout << "\n📋 Step 11: Initializing Transformation Tracking..." << std::endl;
+        std::cout.flush();
+        initialize_transformation_tracking(db);
+        step_timer.set_items(db.transformation_history.size());
+    });
+    add_checkpoint("11");
+    
+
+    // Step 12: Strategic Debanking - Convert multi-bit FFs to single-bit for re-optimization
+    add_step("12", "Step 12: Strategic debanking", DB_ALL, DB_ALL, [&db]() {
+        PROFILE_SCOPE("Step 12: Strategic debanking");
+        std::cout << "\n🔧 Step 12: Strategic Debanking..." << std::endl;
+        std::cout.flush();
+        if (db.time_budget) db.time_budget->begin_phase("debanking");
+        perform_strategic_debanking(db);
+        //export_strategic_debanking_report(db);
+    });
+    add_checkpoint("12");
+    
+    // Step 13: Group FF instances for substitution (temporary)
+    add_step("13", "Step 13: Group FF instances", DB_ALL, DB_ALL, [&db]() {
+        PROFILE_SCOPE("Step 13: Group FF instances");
+        std::cout << "\n🔗 Step 13: Grouping FF instances for substitution..." << std::endl;
+        std::cout.flush();
+        group_ff_instances(db);
+    });
+    add_checkpoint("13");
+    
+    // Step 14: Calculate optimal FF for each group (cell-level analysis)
+    add_step("14", "Step 14: Optimal FF per group", DB_ALL, DB_ALL, [&db]() {
+        PROFILE_SCOPE("Step 14: Optimal FF per group");
+        std::cout << "\n⚡ Step 14: Calculating optimal FF for each compatibility group..." << std::endl;
+        std::cout.flush();
+        calculate_optimal_ff_for_instance_groups(db);
+    });
+    add_checkpoint("14");
+    
+    // Step 15: Three-Stage FF Substitution
+    add_step("15", "Step 15: Three-stage substitution", DB_ALL, DB_ALL, [&db]() {
+        PROFILE_SCOPE("Step 15: Three-stage substitution");
+        std::cout << "\n🔄 Step 15: Three-Stage FF Substitution..." << std::endl;
+        std::cout.flush();
+        execute_three_stage_substitution(db);
+    });
+    add_checkpoint("15");
+    
+    // Step 16: Assign banking types before grouping (critical for correct grouping)
+    add_step("16", "Step 16: Banking types + regroup", DB_ALL, DB_ALL, [&db]() {
+        PROFILE_SCOPE("Step 16: Banking types + regroup");
+        std::cout << "\n🏷️  Step 16: Assigning banking types..." << std::endl;
+        std::cout.flush();
+        assign_banking_types(db);
+        
+        // Step 16.5: Rebuild FF instance groups for banking (after banking type assignment)
+        std::cout << "\n🔗 Step 16.5: Rebuilding FF instance groups for banking..." << std::endl;
+        std::cout.flush();
+        // Clear old groups completely
+        db.ff_instance_groups.clear();
+        std::cout << "  Cleared old ff_instance_groups" << std::endl;
+        
+        // Rebuild groups based on hierarchy + clock signal (no scan chain)
+        rebuild_ff_instance_groups_for_banking(db);
+    });
+    add_checkpoint("16");
+    
+    // Step 18: Strategic Banking
+    add_step("18", "Step 18: Strategic banking", DB_ALL, DB_ALL, [&args, &db]() {
+        // Step 17: Export FF instance grouping report
+        std::cout << "\n📋 Step 17: Exporting FF instance grouping report..." << std::endl;
+        std::cout.flush();
+        //export_ff_instance_grouping_report(db);
+        
+        PROFILE_SCOPE("Step 18: Strategic banking");
+        std::cout << "\n🏦 Step 18: Strategic Banking..." << std::endl;
+        std::cout.flush();
+        if (db.time_budget) db.time_budget->begin_phase("banking");
+        if (args.tiles > 1) {
+            run_tiled_banking(args, db);
+            return;
+        }
+        {
+            PROFILE_SCOPE("execute_banking_preparation");
+            execute_banking_preparation(db);
+        }
+        
+        // Step 17.1: Debank Cluster Re-banking
+        {
+            PROFILE_SCOPE("execute_debank_cluster_rebanking");
+            execute_debank_cluster_rebanking(db);
+        }
+        
+        // Step 17.2: FSDN Two-Phase Banking
+        {
+            PROFILE_SCOPE("execute_fsdn_two_phase_banking");
+            execute_fsdn_two_phase_banking(db);
+        }
+        
+        // Step 17.3: LSRDPQ4 Single-Phase Banking  
+        {
+            PROFILE_SCOPE("execute_lsrdpq_single_phase_banking");
+            execute_lsrdpq_single_phase_banking(db);
+        }
+        
+        // Record all banking transformations after all banking steps completed
+        {
+            PROFILE_SCOPE("record_all_banking_transformations");
+            record_all_banking_transformations(db);
+        }
+    });
+    add_checkpoint("18");
+    
+    // Step 18.5: Post-Banking SBFF Substitution
+    add_step("18.5", "Step 18.5: Post-banking substitution", DB_ALL, DB_ALL, [&db]() {
+        PROFILE_SCOPE("Step 18.5: Post-banking substitution");
+        std::cout << "\n🔄 Step 18.5: Post-Banking SBFF Substitution..." << std::endl;
+        std::cout.flush();
+        execute_post_banking_substitution(db);
+        
+        // Capture POST_BANKING stage for complete pipeline report
+        std::cout << "  Capturing POST_BANKING stage..." << std::endl;
+        
+        // Get indices of POST_SUBSTITUTE transformation records
+        std::vector<size_t> post_substitute_indices = db.transformation_history.indices_of(TransformationRecord::POST_SUBSTITUTE);
+        
+        std::cout << "    Found " << post_substitute_indices.size() << " POST_SUBSTITUTE transformation records" << std::endl;
+        
+        db.complete_pipeline.capture_stage("POST_BANKING", db.instances, post_substitute_indices, &db.transformation_history);
+    });
+    add_checkpoint("18.5");
+    
+    /*Legalization*/
+    add_step("19", "Step 19: Legalization", DB_ALL, DB_ALL, [&args, &db]() {
+        PROFILE_SCOPE("Step 19: Legalization");
+        std::cout << "\n⚖️  Step 19: Legalization..." << std::endl;
+        std::cout.flush();
+        if (db.time_budget) db.time_budget->begin_phase("legalization");
+        if (args.tiles > 1) {
+            run_tiled_legalization(args, db);
+            return;
+        }
+        double max_displacement = db.banking_params.legalization_max_displacement > 0.0
+            ? db.banking_params.legalization_max_displacement : std::numeric_limits<double>::max();
+        Legalizer legalizer(max_displacement, db);  // 傳入整個 DesignDatabase
+        legalizer.Abacus();                          // 不需要參數
+        {
+            PROFILE_SCOPE("place");
+            legalizer.place();                       // 不需要參數
+        }
+        //legalizer.writeOutput("legalization_result.txt"); // 只需要文件名
+        
+        // Step 17.6: Export Module Instance Distribution Report
+        std::cout << "\n📊 Step 17.6: Exporting Module Instance Distribution..." << std::endl;
+        std::cout.flush();
+        //export_module_instance_distribution(db, "module_instance_distribution.txt");
+        
+        if (db.time_budget) db.time_budget->print_summary(std::cout);
+    });
+    add_checkpoint("19");
+    
+    // Step 19.5: 最後的位置上重新串scan chain (banking可以自由併scan FF)
+    if (args.scan_reorder) {
+        add_step("19.5", "Step 19.5: Scan chain reordering", DB_ALL, DB_ALL, [&db]() {
+            PROFILE_SCOPE("Step 19.5: Scan chain reordering");
+            std::cout << "\n🔗 Step 19.5: Reordering scan chains..." << std::endl;
+            std::cout.flush();
+            reorder_scan_chains(db);
+        });
+    }
+    add_checkpoint("19.5");
+    
+    // Legalization完成，但不記錄transformation records
+    // (legalization不改變邏輯功能，contest不需要記錄)
+    /*Legalization*/
+    
+    // 以下writers只讀database (list writer另外寫dummy mapping / provenance)，四個檔案同時輸出
+
+    // Step 18: Export Complete Pipeline Report for Debugging
+    add_writer("Writer: complete_pipeline_report", DB_NETLIST | DB_HISTORY, DB_NONE, [&args, &db]() {
+        PROFILE_SCOPE("Writer: complete_pipeline_report");
+        std::cout << "\n📋 Step 18: Exporting Complete Pipeline Report..." << std::endl;
+        std::cout.flush();
+        export_transformation_report(db, report_path(args, "complete_pipeline_report.txt"));
+    });
+    
+    // Step 19: Generate final .v file output
+    add_writer("Writer: verilog", DB_CELL_LIBRARY | DB_CELL_PHYSICAL | DB_NETLIST, DB_NONE, [&args, &db]() {
+        PROFILE_SCOPE("Writer: verilog");
+        std::cout << "\n🏆 Step 19: Generating final .v file..." << std::endl;
+        std::cout.flush();
+        std::string verilog_filename = args.output_name + ".v" + compression_suffix(args.compress_output);
+        generate_final_verilog_file(db, verilog_filename);
+    });
+    
+    // Step 20: Generate complete .list file (Pin Mapping + Operation Log)
+    add_writer("Writer: list", DB_CELL_LIBRARY | DB_CELL_PHYSICAL | DB_NETLIST | DB_HISTORY,
+               DB_PIN_PROVENANCE | DB_DUMMY_NAMES, [&args, &db]() {
+        ScopedTimer step_timer("Writer: list");
+        std::cout << "\n📝 Step 20: Generating complete .list file with pin mapping..." << std::endl;
+        std::cout.flush();
+        
+        // Pin mapping comes straight from db.pin_provenance, followed by the operation log
+        std::string list_filename = args.output_name + ".list" + compression_suffix(args.compress_output);
+        generate_operation_log_file(db, list_filename);
+        step_timer.set_items(db.pin_provenance.original_pins.size());
+    });
+    
+    // Step 21: Generate final DEF file with optimized FF placement
+    add_writer("Writer: def", DB_CELL_LIBRARY | DB_CELL_PHYSICAL | DB_NETLIST | DB_PLACEMENT | DB_SCAN, DB_NONE,
+               [&args, &db]() {
+        ScopedTimer step_timer("Writer: def");
+        std::cout << "\n🏗️ Step 21: Generating final DEF file..." << std::endl;
+        std::cout.flush();
+        
+        // Determine input DEF file path (resume時沒給-def就用checkpoint記錄的路徑)
+        std::string input_def_path;
+        if (!args.def_files.empty()) {
+            input_def_path = args.def_files[0];  // Use first DEF file
+        } else if (!db.input_def_path.empty()) {
+            input_def_path = db.input_def_path;
+        } else {
+            throw std::runtime_error("No DEF file provided for output generation");
+        }
+        
+        // Debug: Check FF instances before DEF generation
+        int ff_count_before_def = 0;
+        for (const auto& inst_pair : db.instances) {
+            if (inst_pair.second->is_flip_flop()) {
+                ff_count_before_def++;
+            }
+        }
+        std::cout << "  DEBUG: Found " << ff_count_before_def << " FF instances before DEF generation" << std::endl;
+        
+        DefOutputGenerator def_generator(db);
+        std::string def_filename = args.output_name + ".def" + compression_suffix(args.compress_output);
+        def_generator.generate_complete_def_file(input_def_path, def_filename);
+        step_timer.set_items(db.instances.size());
+        
+        std::cout << "  ✓ Generated complete testcase_solution.def (including NETS section)" << std::endl;
+    });
+    
+    // Step 22: Test Simple Pin Mapping System (No DEBANK version)
+    // std::cout << "\n🔗 Step 22: Testing Simple Pin Mapping System..." << std::endl;
+    // std::cout.flush();
+    // export_simple_transformation_chains_report(db, "transformation_chains_report.txt");
+    // generate_simple_pin_mapping_file(db, "simple_pin_mapping.list");
+    
+    std::ostream console(output ? output : std::cout.rdbuf());
+    console << "\n🧵 Running " << pipeline.size() << " pipeline stages on " << pool.size() << " threads" << std::endl;
+    if (Logger::enabled(LogLevel::DEBUG)) {
+        pipeline.print_plan(console);
+    }
+    pipeline.run(pool, output);
+}
@@ -0,0 +1,42 @@
+#ifndef FLOW_HPP
+#define FLOW_HPP
+
+#include "data_structures.hpp"
+#include "argument_parser.hpp"
+#include <streambuf>
+#include <string>
+
+class ThreadPool;
+
+// =============================================================================
+// BANKING FLOW
+// =============================================================================
+// Steps 1-19 和四個writer組成一個TaskGraph (見flow.cpp)，給單次執行、
+// checkpoint resume 和 server mode 的每個job共用
+// step的rank即checkpoint_step_rank() (1=0, 2=1, ..., 19=18)
+// =============================================================================
+
+// Run the flow on `db`. Steps with rank <= completed_rank are already in `db`
+// (checkpoint, shared library); last_rank >= 0 stops after that step without writers.
+// Progress output goes to `output` when given, otherwise to std::cout.
+void run_banking_flow(const ProgramArguments& args, DesignDatabase& db, ThreadPool& pool,
+                      int completed_rank = -1, int last_rank = -1, std::streambuf* output = nullptr);
+
+// Copy the step 1-2 results (cell library + FF cell groups) of `library` into `db`;
+// CellTemplate objects are shared and must stay read-only
+void share_cell_library(const DesignDatabase& library, DesignDatabase& db);
+
+// Debug report location (-out directory in server/batch mode, otherwise cwd)
+std::string report_path(const ProgramArguments& args, const std::string& filename);
+
+// Directory part of `path` ("" when it has none)
+std::string directory_of(const std::string& path);
+
+// run_banking_flow output sink for runs whose progress is not shown (libmbff, autotune candidates)
+class DiscardStreambuf : public std::streambuf {
+protected:
+    int_type overflow(int_type ch) override { return traits_type::not_eof(ch); }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+#endif // FLOW_HPP
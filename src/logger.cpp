@@ -0,0 +1,187 @@
+#include "logger.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+
+// =============================================================================
+// LOGGER IMPLEMENTATION
+// =============================================================================
+
+LogLevel Logger::level_ = LogLevel::INFO;
+bool Logger::quiet_ = false;
+
+namespace {
+
+// 把std::cout的輸出累積起來，sync()（std::endl / flush）只有在buffer夠大
+// 或距離上次真正寫出超過 LOG_FLUSH_INTERVAL_MS 時才轉給底層stdout
+class BatchingStreambuf : public std::streambuf {
+public:
+    static const size_t FLUSH_BYTES = 1 << 16;
+
+    explicit BatchingStreambuf(std::streambuf* target)
+        : target_(target), last_flush_(std::chrono::steady_clock::now()) {
+        pending_.reserve(FLUSH_BYTES);
+    }
+
+    std::streambuf* target() const { return target_; }
+
+    void force_flush() {
+        if (!pending_.empty()) {
+            target_->sputn(pending_.data(), static_cast<std::streamsize>(pending_.size()));
+            pending_.clear();
+        }
+        target_->pubsync();
+        last_flush_ = std::chrono::steady_clock::now();
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            pending_.push_back(traits_type::to_char_type(ch));
+            if (pending_.size() >= FLUSH_BYTES) force_flush();
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        pending_.append(s, static_cast<size_t>(n));
+        if (pending_.size() >= FLUSH_BYTES) force_flush();
+        return n;
+    }
+
+    int sync() override {
+        auto now = std::chrono::steady_clock::now();
+        long long elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_flush_).count();
+        if (pending_.size() >= FLUSH_BYTES || elapsed_ms >= LOG_FLUSH_INTERVAL_MS) {
+            force_flush();
+        }
+        return 0;
+    }
+
+private:
+    std::streambuf* target_;
+    std::string pending_;
+    std::chrono::steady_clock::time_point last_flush_;
+};
+
+// quiet mode下一般的std::cout輸出全部丟掉
+class NullStreambuf : public std::streambuf {
+protected:
+    int_type overflow(int_type ch) override { return traits_type::not_eof(ch); }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+struct LoggerState {
+    std::mutex mutex;
+    BatchingStreambuf* batching = nullptr;   // Owns the real stdout
+    NullStreambuf* null_sink = nullptr;      // std::cout target in quiet mode
+    std::streambuf* original = nullptr;      // Restored on shutdown
+    std::map<std::string, long> limited_counts;
+    bool installed = false;
+};
+
+// 故意不釋放：避免static destruction順序和atexit flush打架
+LoggerState& state() {
+    static LoggerState* s = new LoggerState();
+    return *s;
+}
+
+const char* level_prefix(LogLevel level) {
+    switch (level) {
+        case LogLevel::ERROR: return "ERROR: ";
+        case LogLevel::WARN: return "WARNING: ";
+        case LogLevel::DEBUG: return "DEBUG: ";
+        default: return "";
+    }
+}
+
+}  // namespace
+
+void Logger::init(LogLevel level, bool quiet) {
+    LoggerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    level_ = level;
+    quiet_ = quiet;
+    if (quiet_ && static_cast<int>(level_) > static_cast<int>(LogLevel::WARN)) {
+        level_ = LogLevel::WARN;
+    }
+
+    if (!s.installed) {
+        s.original = std::cout.rdbuf();
+        s.batching = new BatchingStreambuf(s.original);
+        s.null_sink = new NullStreambuf();
+        s.installed = true;
+        std::atexit(Logger::shutdown);
+    }
+    std::cout.rdbuf(quiet_ ? static_cast<std::streambuf*>(s.null_sink) : s.batching);
+}
+
+void Logger::write(LogLevel level, const std::string& line) {
+    LoggerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    std::string text = level_prefix(level);
+    if (!line.empty() && line.compare(0, text.size(), text) == 0) text.clear();  // 已經自帶prefix
+    text += line;
+    if (text.empty() || text[text.size() - 1] != '\n') text += '\n';
+
+    std::streambuf* out = s.installed ? static_cast<std::streambuf*>(s.batching) : std::cout.rdbuf();
+    out->sputn(text.data(), static_cast<std::streamsize>(text.size()));
+    if (level == LogLevel::ERROR) {
+        if (s.installed) s.batching->force_flush();
+        else out->pubsync();
+    }
+}
+
+void Logger::write_raw(std::streambuf* target, const std::string& text) {
+    LoggerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    target->sputn(text.data(), static_cast<std::streamsize>(text.size()));
+    target->pubsync();
+}
+
+bool Logger::allow_limited(const char* key) {
+    LoggerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return ++s.limited_counts[key] <= LOG_RATE_LIMIT;
+}
+
+void Logger::flush() {
+    LoggerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.installed) s.batching->force_flush();
+    else std::cout.flush();
+}
+
+void Logger::shutdown() {
+    LoggerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.installed) return;
+
+    std::string summary;
+    for (const auto& entry : s.limited_counts) {
+        if (entry.second > LOG_RATE_LIMIT) {
+            summary += "WARNING: " + std::to_string(entry.second - LOG_RATE_LIMIT) +
+                       " more \"" + entry.first + "\" warnings suppressed (" +
+                       std::to_string(entry.second) + " total)\n";
+        }
+    }
+    s.limited_counts.clear();
+    if (!summary.empty()) {
+        s.batching->sputn(summary.data(), static_cast<std::streamsize>(summary.size()));
+    }
+
+    s.batching->force_flush();
+    std::cout.rdbuf(s.original);
+    s.installed = false;
+}
+
+LogLevel Logger::parse_level(const std::string& name, LogLevel fallback) {
+    if (name == "error") return LogLevel::ERROR;
+    if (name == "warn" || name == "warning") return LogLevel::WARN;
+    if (name == "info") return LogLevel::INFO;
+    if (name == "debug") return LogLevel::DEBUG;
+    return fallback;
+}
@@ -0,0 +1,98 @@
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+#include <string>
+#include <sstream>
+#include <iostream>
+
+// =============================================================================
+// LEVELED, BUFFERED LOGGING
+// =============================================================================
+// - Logger::init() 把 std::cout 換成批次寫出的buffer：std::endl / flush 不再
+//   每行都做system call，而是buffer滿或距上次輸出超過 LOG_FLUSH_INTERVAL_MS 才寫
+// - LOG_ERROR / LOG_WARN / LOG_INFO / LOG_DEBUG：先寫進各thread自己的line buffer，
+//   一整行完成後才進共用輸出，多thread不會交錯
+// - LOG_WARN_LIMITED(key)：同一個key只印前 LOG_RATE_LIMIT 次，其餘在結束時彙總
+// - LOG_HOT：hot loop裡的per-instance訊息，沒定義 MBFF_HOT_LOG 時整段compile掉
+// - quiet mode (-quiet)：一般的 std::cout 進度訊息全部丟掉，只留 WARN/ERROR
+// =============================================================================
+
+#define LOG_FLUSH_INTERVAL_MS 200
+#define LOG_RATE_LIMIT 5
+
+enum class LogLevel {
+    ERROR = 0,
+    WARN = 1,
+    INFO = 2,
+    DEBUG = 3
+};
+
+class Logger {
+public:
+    // Install the batching stdout buffer; call once at program start
+    static void init(LogLevel level, bool quiet);
+
+    // Flush everything, print rate-limit summary and restore std::cout
+    static void shutdown();
+
+    static LogLevel level() { return level_; }
+    static bool enabled(LogLevel level) { return static_cast<int>(level) <= static_cast<int>(level_); }
+    static bool quiet() { return quiet_; }
+
+    // Append one complete line (thread-safe)
+    static void write(LogLevel level, const std::string& line);
+
+    // Append already formatted std::cout text to `target` (serialized with write())
+    static void write_raw(std::streambuf* target, const std::string& text);
+
+    // true for the first LOG_RATE_LIMIT occurrences of `key`
+    static bool allow_limited(const char* key);
+
+    // Force pending output to the terminal
+    static void flush();
+
+    static LogLevel parse_level(const std::string& name, LogLevel fallback);
+
+private:
+    static LogLevel level_;
+    static bool quiet_;
+};
+
+// One log statement; the line is handed to Logger on destruction
+class LogLine {
+public:
+    explicit LogLine(LogLevel level) : level_(level) {}
+    ~LogLine() { Logger::write(level_, stream_.str()); }
+
+    template <typename T>
+    LogLine& operator<<(const T& value) {
+        stream_ << value;
+        return *this;
+    }
+
+    // Accept std::endl etc. (the newline is added by Logger::write)
+    LogLine& operator<<(std::ostream& (*)(std::ostream&)) { return *this; }
+
+private:
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    LogLevel level_;
+    std::ostringstream stream_;
+};
+
+#define LOG_AT(level) if (!Logger::enabled(level)) ; else LogLine(level)
+#define LOG_ERROR LOG_AT(LogLevel::ERROR)
+#define LOG_WARN LOG_AT(LogLevel::WARN)
+#define LOG_INFO LOG_AT(LogLevel::INFO)
+#define LOG_DEBUG LOG_AT(LogLevel::DEBUG)
+#define LOG_WARN_LIMITED(key) \
+    if (!Logger::enabled(LogLevel::WARN) || !Logger::allow_limited(key)) ; else LogLine(LogLevel::WARN)
+
+#ifdef MBFF_HOT_LOG
+#define LOG_HOT LOG_DEBUG
+#else
+#define LOG_HOT if (true) ; else LogLine(LogLevel::DEBUG)
+#endif
+
+#endif // LOGGER_HPP
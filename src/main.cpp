@@ -1,31 +1,45 @@
 #include "data_structures.hpp"
-#include "parsers.hpp"
 #include "argument_parser.hpp"
-#include "substitution.hpp"
-#include "def_output_generator.hpp"
-/*Legalization*/
-#include "Legalization.hpp"
-/*Legalization*/
+#include "flow.hpp"
+#include "server.hpp"
+#include "batch.hpp"
+#include "autotune.hpp"
+#include "profiler.hpp"
+#include "trace_recorder.hpp"
+#include "logger.hpp"
+#include "thread_pool.hpp"
+#include "checkpoint.hpp"
 #include <iostream>
-#include <chrono>
 #include <fstream>
+#include <stdexcept>
 
 // =============================================================================
 // CLEAN PARSER MAIN ENTRY POINT
 // =============================================================================
 // 極簡架構：
 // 1. 創建DesignDatabase
-// 2. 依序呼叫parser函數
-// 3. 輸出統計結果
+// 2. run_banking_flow把parser / 最佳化 / writer步驟加成TaskGraph的stage (flow.cpp)
+// 3. TaskGraph依資料依賴平行執行，輸出統計結果
+// -server / -submit / -stop_server 改走server mode (server.cpp)
 // =============================================================================
 
 // =============================================================================
 // MAIN FUNCTION
 // =============================================================================
 
+// Per-step timing / memory summary, then flush trace and log output
+static void finish_run(const ProgramArguments& args) {
+    StageProfiler::instance().print_summary(std::cout);
+    if (!args.profile_file.empty()) {
+        if (StageProfiler::instance().export_json(args.profile_file)) {
+            std::cout << "  Profile written to " << args.profile_file << std::endl;
+        }
+    }
+    TraceRecorder::instance().flush();
+    Logger::shutdown();
+}
+
 int main(int argc, char* argv[]) {
-    // 設定標準輸出為無緩衝模式，確保即時顯示
-    std::cout.setf(std::ios::unitbuf);
     std::cout << "=== ICCAD 2025 Flip-Flop Banking Competition Parser ===" << std::endl;
     
     // 解析命令行參數
@@ -37,266 +51,73 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    // 批次輸出的logger (取代unitbuf)；-quiet 時只留WARN/ERROR
+    Logger::init(Logger::parse_level(args.log_level, LogLevel::INFO), args.quiet);
+    
     // 顯示解析結果
     args.print_summary();
     
-    auto start_time = std::chrono::high_resolution_clock::now();
+    if (!args.trace_file.empty()) {
+        TraceRecorder::instance().enable(args.trace_file);
+    }
+    
+    // Server / client modes (see server.hpp)
+    if (!args.stop_server_socket.empty()) {
+        return stop_server(args.stop_server_socket);
+    }
+    if (!args.submit_socket.empty()) {
+        return submit_job(args);
+    }
+    if (!args.server_socket.empty()) {
+        int status = run_server(args);
+        Logger::shutdown();
+        return status;
+    }
+    
+    // 多個design共用一次parse的library (see batch.hpp)
+    if (!args.batch_manifest.empty()) {
+        int status = run_batch(args);
+        finish_run(args);
+        return status;
+    }
+    
+    // 搜尋banking參數，不產生輸出檔 (see autotune.hpp)
+    if (args.autotune) {
+        int status = run_autotune(args);
+        finish_run(args);
+        return status;
+    }
     
     try {
         // Create design database
         DesignDatabase db;
         db.design_name = "ICCAD_2025_Design";
         
-        // Step 1: Parse Liberty files (from command line arguments)
-        std::cout << "\n📚 Step 1: Parsing Liberty files..." << std::endl;
-        std::cout.flush();
-        for (const auto& lib_file : args.lib_files) {
-            parse_liberty_file(lib_file, db);
-        }
-        
-        // 建立banking關係
-        build_banking_relationships(db);
-        
-        // 建立FF cell相容性分群
-        build_ff_cell_compatibility_groups(db);
-        
-        // Step 2: Parse LEF files to add physical information to cells
-        std::cout << "\n🏗️  Step 2: Parsing LEF files..." << std::endl;
-        std::cout.flush();
-        for (const auto& lef_file : args.lef_files) {
-            parse_lef_file(lef_file, db);
-        }
-        
-        // 輸出完整的Cell Library驗證報告（包含物理資訊）
-        //export_cell_library_validation(db);
-        
-        // Step 3: Parse Verilog files first to create instances and connections
-        std::cout << "\n🔌 Step 3: Parsing Verilog netlist..." << std::endl;
-        std::cout.flush();
-        for (const auto& verilog_file : args.verilog_files) {
-            parse_verilog_file(verilog_file, db);
-        }
-        
-        // Step 4: Parse DEF files to add placement information to existing instances
-        std::cout << "\n📍 Step 4: Parsing DEF placement..." << std::endl;
-        std::cout.flush();
-        for (const auto& def_file : args.def_files) {
-            parse_def_file(def_file, db);
-        }
-        
-        // Step 5: Parse Weight file for objective function
-        std::cout << "\n⚖️  Step 5: Parsing objective weights..." << std::endl;
-        std::cout.flush();
-        parse_weight_file(args.weight_file, db);
-        
-        // Step 6: Link instances to cell templates and finalize
-        std::cout << "\n🔗 Step 6: Linking instances to cells..." << std::endl;
-        std::cout.flush();
-        int linked_count = 0;
-        for (const auto& pair : db.instances) {
-            auto& instance = pair.second;
-            auto cell = db.get_cell(instance->cell_type);
-            if (cell) {
-                instance->cell_template = cell;
-                linked_count++;
-            } else {
-                std::cout << "  WARNING: Cell " << instance->cell_type 
-                         << " not found in library" << std::endl;
-            }
-        }
-        std::cout << "  Linked " << linked_count << " instances to cell templates" << std::endl;
-        
-        // 輸出完整的Instance驗證報告（包含placement和linking資訊）
-        //export_instance_validation(db);
-        
-        // Step 7: Analyze FF pin connections for compatibility checking
-        std::cout << "\n🔍 Step 7: Analyzing FF pin connections..." << std::endl;
-        std::cout.flush();
-        analyze_ff_pin_connections(db);
-        
-        // Step 8: Detect scan chains from netlist connections
-        std::cout << "\n🔗 Step 8: Detecting scan chains..." << std::endl;
-        std::cout.flush();
-        detect_scan_chains(db);
-        
-        // Step 9: Build scan chain banking groups
-        std::cout << "\n🏗️  Step 9: Building scan chain banking groups..." << std::endl;
-        std::cout.flush();
-        build_scan_chain_groups(db);
-        
-        // Step 10: Export FF grouping analysis report
-        std::cout << "\n📊 Step 10: Exporting FF grouping analysis report..." << std::endl;
-        std::cout.flush();
-        export_ff_grouping_report(db);
-        
-        // Step 11: Initialize Transformation Tracking System
-        std::cout << "\n📋 Step 11: Initializing Transformation Tracking..." << std::endl;
-        std::cout.flush();
-        initialize_transformation_tracking(db);
-        
-
-        // Step 12: Strategic Debanking - Convert multi-bit FFs to single-bit for re-optimization
-        std::cout << "\n🔧 Step 12: Strategic Debanking..." << std::endl;
-        std::cout.flush();
-        perform_strategic_debanking(db);
-        //export_strategic_debanking_report(db);
-        
-        // Step 13: Group FF instances for substitution (temporary)
-        std::cout << "\n🔗 Step 13: Grouping FF instances for substitution..." << std::endl;
-        std::cout.flush();
-        group_ff_instances(db);
-        
-        // Step 14: Calculate optimal FF for each group (cell-level analysis)
-        std::cout << "\n⚡ Step 14: Calculating optimal FF for each compatibility group..." << std::endl;
-        std::cout.flush();
-        calculate_optimal_ff_for_instance_groups(db);
-        
-        // Step 15: Three-Stage FF Substitution
-        std::cout << "\n🔄 Step 15: Three-Stage FF Substitution..." << std::endl;
-        std::cout.flush();
-        execute_three_stage_substitution(db);
-        
-        // Step 16: Assign banking types before grouping (critical for correct grouping)
-        std::cout << "\n🏷️  Step 16: Assigning banking types..." << std::endl;
-        std::cout.flush();
-        assign_banking_types(db);
-        
-        // Step 16.5: Rebuild FF instance groups for banking (after banking type assignment)
-        std::cout << "\n🔗 Step 16.5: Rebuilding FF instance groups for banking..." << std::endl;
-        std::cout.flush();
-        // Clear old groups completely
-        db.ff_instance_groups.clear();
-        std::cout << "  Cleared old ff_instance_groups" << std::endl;
-        
-        // Rebuild groups based on hierarchy + clock signal (no scan chain)
-        rebuild_ff_instance_groups_for_banking(db);
-        
-        // Step 17: Export FF instance grouping report
-        std::cout << "\n📋 Step 17: Exporting FF instance grouping report..." << std::endl;
-        std::cout.flush();
-        //export_ff_instance_grouping_report(db);
-        
-        // Step 18: Strategic Banking
-        std::cout << "\n🏦 Step 18: Strategic Banking..." << std::endl;
-        std::cout.flush();
-        execute_banking_preparation(db);
-        
-        // Step 17.1: Debank Cluster Re-banking
-        execute_debank_cluster_rebanking(db);
-        
-        // Step 17.2: FSDN Two-Phase Banking
-        execute_fsdn_two_phase_banking(db);
-        
-        // Step 17.3: LSRDPQ4 Single-Phase Banking  
-        execute_lsrdpq_single_phase_banking(db);
-        
-        // Record all banking transformations after all banking steps completed
-        record_all_banking_transformations(db);
-        
-        // Step 18.5: Post-Banking SBFF Substitution
-        std::cout << "\n🔄 Step 18.5: Post-Banking SBFF Substitution..." << std::endl;
-        std::cout.flush();
-        execute_post_banking_substitution(db);
-        
-        // Capture POST_BANKING stage for complete pipeline report
-        std::cout << "  Capturing POST_BANKING stage..." << std::endl;
-        std::vector<std::shared_ptr<Instance>> all_instances_after_post_banking;
-        for (const auto& inst_pair : db.instances) {
-            if (inst_pair.second->is_flip_flop()) {
-                all_instances_after_post_banking.push_back(inst_pair.second);
-            }
-        }
-        
-        // Get indices of POST_SUBSTITUTE transformation records
-        std::vector<size_t> post_substitute_indices;
-        for (size_t i = 0; i < db.transformation_history.size(); ++i) {
-            if (db.transformation_history[i].operation == TransformationRecord::POST_SUBSTITUTE) {
-                post_substitute_indices.push_back(i);
-            }
-        }
-        
-        std::cout << "    Found " << post_substitute_indices.size() << " POST_SUBSTITUTE transformation records" << std::endl;
-        
-        db.complete_pipeline.capture_stage("POST_BANKING", all_instances_after_post_banking, post_substitute_indices, &db.transformation_history);
-        
-        /*Legalization*/
-        std::cout << "\n⚖️  Step 19: Legalization..." << std::endl;
-        std::cout.flush();
-        Legalizer legalizer(std::numeric_limits<double>::max(), db);  // 傳入整個 DesignDatabase
-        legalizer.Abacus();                          // 不需要參數
-        legalizer.place();                           // 不需要參數
-        //legalizer.writeOutput("legalization_result.txt"); // 只需要文件名
-        
-        // Legalization完成，但不記錄transformation records
-        // (legalization不改變邏輯功能，contest不需要記錄)
-        /*Legalization*/
-
-        // Step 17.6: Export Module Instance Distribution Report
-        std::cout << "\n📊 Step 17.6: Exporting Module Instance Distribution..." << std::endl;
-        std::cout.flush();
-        //export_module_instance_distribution(db, "module_instance_distribution.txt");
-
-        // Step 18: Export Complete Pipeline Report for Debugging
-        std::cout << "\n📋 Step 18: Exporting Complete Pipeline Report..." << std::endl;
-        std::cout.flush();
-        export_transformation_report(db, "complete_pipeline_report.txt");
-        
-        // Step 19: Generate final .v file output
-        std::cout << "\n🏆 Step 19: Generating final .v file..." << std::endl;
-        std::cout.flush();
-        std::string verilog_filename = args.output_name + ".v";
-        generate_final_verilog_file(db, verilog_filename);
-        
-        // Step 20: Generate complete .list file (Pin Mapping + Operation Log)
-        std::cout << "\n📝 Step 20: Generating complete .list file with pin mapping..." << std::endl;
-        std::cout.flush();
-        
-        // First generate pin mapping to temporary file
-        generate_simple_pin_mapping_file(db, "temp_pin_mapping.list");
-        
-        // Then generate operation log and merge them
-        std::string list_filename = args.output_name + ".list";
-        generate_operation_log_file(db, list_filename);
-        
-        // Step 21: Generate final DEF file with optimized FF placement
-        std::cout << "\n🏗️ Step 21: Generating final DEF file..." << std::endl;
-        std::cout.flush();
-        
-        // Determine input DEF file path
-        std::string input_def_path;
-        if (!args.def_files.empty()) {
-            input_def_path = args.def_files[0];  // Use first DEF file
-        } else {
-            std::cerr << "Error: No DEF file provided for output generation" << std::endl;
-            return 1;
-        }
-        
-        // Debug: Check FF instances before DEF generation
-        int ff_count_before_def = 0;
-        for (const auto& inst_pair : db.instances) {
-            if (inst_pair.second->is_flip_flop()) {
-                ff_count_before_def++;
+        // --resume-from: 直接載入checkpoint，已完成的step不再加入graph
+        int resume_rank = -1;
+        if (!args.resume_from.empty()) {
+            ScopedTimer resume_timer("Resume: load checkpoint");
+            std::cout << "\n💾 Resuming from checkpoint " << args.resume_from << "..." << std::endl;
+            std::string resumed_step;
+            if (!load_checkpoint(args.resume_from, db, resumed_step)) {
+                throw std::runtime_error("Cannot resume from " + args.resume_from);
             }
+            resume_rank = checkpoint_step_rank(resumed_step);
+            resume_timer.set_items(db.instances.size());
         }
-        std::cout << "  DEBUG: Found " << ff_count_before_def << " FF instances before DEF generation" << std::endl;
-        
-        DefOutputGenerator def_generator(db);
-        std::string def_filename = args.output_name + ".def";
-        def_generator.generate_complete_def_file(input_def_path, def_filename);
-        
-        std::cout << "  ✓ Generated complete testcase_solution.def (including NETS section)" << std::endl;
-        
-        // Step 22: Test Simple Pin Mapping System (No DEBANK version)
-        // std::cout << "\n🔗 Step 22: Testing Simple Pin Mapping System..." << std::endl;
-        // std::cout.flush();
-        // export_simple_transformation_chains_report(db, "transformation_chains_report.txt");
-        // generate_simple_pin_mapping_file(db, "simple_pin_mapping.list");
         
+        // 全程式共用一個thread pool (task graph和各stage裡的parallel_for)
+        ThreadPool& pool = ThreadPool::instance();
+        pool.resize(args.threads);
+        // -tile_worker: 只跑到 --checkpoint-after 的step，不寫輸出檔 (see tile_flow.hpp)
+        int last_rank = args.tile_worker ? checkpoint_step_rank(args.checkpoint_after) : -1;
+        run_banking_flow(args, db, pool, resume_rank, last_rank);
         
+        finish_run(args);
         return 0;
         
     } catch (const std::exception& e) {
-        std::cout << "\n❌ Error: " << e.what() << std::endl;
+        LOG_ERROR << "❌ " << e.what();
         return 1;
     }
 }
@@ -0,0 +1,188 @@
+#include "mbff_api.hpp"
+#include "argument_parser.hpp"
+#include "flow.hpp"
+#include "parsers.hpp"
+#include "checkpoint.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+// =============================================================================
+// LIBMBFF IMPLEMENTATION
+// =============================================================================
+
+namespace {
+
+int step_rank(const std::string& step) {
+    int rank = checkpoint_step_rank(step);
+    if (rank < 0) throw std::runtime_error("Unknown flow step " + step);
+    return rank;
+}
+
+// API options → 與命令列相同的ProgramArguments (不寫任何輸出檔)
+ProgramArguments flow_arguments(const MbffRunOptions& options) {
+    ProgramArguments args;
+    args.threads = options.threads;
+    args.time_budget = options.time_budget;
+    args.banking_params = options.params;
+    args.report_dir = options.report_dir;
+    args.write_reports = !options.report_dir.empty();
+    return args;
+}
+
+void run_steps(const ProgramArguments& args, DesignDatabase& db, const MbffRunOptions& options,
+               int completed_rank, int last_rank) {
+    DiscardStreambuf discard;   // MbffRunOptions::log == nullptr
+    std::streambuf* output = options.log ? options.log->rdbuf() : &discard;
+    ThreadPool& pool = ThreadPool::instance();
+    pool.resize(options.threads);
+    run_banking_flow(args, db, pool, completed_rank, last_rank, output);
+}
+
+} // namespace
+
+// =============================================================================
+// LIBRARY
+// =============================================================================
+
+void mbff_load_library(DesignDatabase& library, const std::vector<std::string>& lib_files,
+                       const std::vector<std::string>& lef_files, const MbffRunOptions& options) {
+    if (lib_files.empty() || lef_files.empty()) {
+        throw std::runtime_error("mbff_load_library needs Liberty and LEF files");
+    }
+    ProgramArguments args = flow_arguments(options);
+    args.lib_files = lib_files;
+    args.lef_files = lef_files;
+    run_steps(args, library, options, -1, step_rank("2"));
+}
+
+void mbff_share_library(const DesignDatabase& library, DesignDatabase& db) {
+    share_cell_library(library, db);
+}
+
+void mbff_add_cell(DesignDatabase& db, const CellTemplate& cell) {
+    if (cell.name.empty()) throw std::runtime_error("Cell without a name");
+    db.cell_library[cell.name] = std::make_shared<CellTemplate>(cell);
+}
+
+void mbff_finalize_cells(DesignDatabase& db) {
+    // Step 1 在Liberty merge之後做的兩件事
+    build_banking_relationships(db);
+    build_ff_cell_compatibility_groups(db);
+}
+
+// =============================================================================
+// DESIGN
+// =============================================================================
+
+Instance& mbff_add_instance(DesignDatabase& db, const std::string& name, const std::string& cell_type,
+                            Dbu x, Dbu y, Instance::Orientation orientation,
+                            Instance::PlacementStatus status) {
+    if (db.instances.count(name)) throw std::runtime_error("Duplicate instance " + name);
+    auto instance = std::make_shared<Instance>();
+    instance->name = name;
+    instance->cell_type = cell_type;           // Step 6 links cell_template
+    instance->position = Point(x, y);
+    instance->orientation = orientation;
+    instance->placement_status = status;
+    db.instances[name] = instance;
+    return *instance;
+}
+
+Net& mbff_add_net(DesignDatabase& db, const std::string& name, Net::NetType type) {
+    auto& net = db.nets[name];
+    if (!net) {
+        net = std::make_shared<Net>();
+        net->name = name;
+    }
+    net->type = type;
+    net->is_clock_net = type == Net::CLOCK;
+    return *net;
+}
+
+void mbff_connect(DesignDatabase& db, const std::string& instance, const std::string& pin, const std::string& net) {
+    auto it = db.instances.find(instance);
+    if (it == db.instances.end()) throw std::runtime_error("Unknown instance " + instance);
+
+    // 和Verilog parser相同的規範化：UNCONNECTED / VDD / VSS 不建立Net
+    std::string normalized_net = net;
+    if (net.find("SYNOPSYS_UNCONNECTED") != std::string::npos) normalized_net = "UNCONNECTED";
+    else if (is_power_net(net)) normalized_net = "VDD";
+    else if (is_ground_net(net)) normalized_net = "VSS";
+    it->second->connections.emplace_back(pin, normalized_net);
+    if (normalized_net == "UNCONNECTED" || normalized_net == "VDD" || normalized_net == "VSS") return;
+
+    auto net_it = db.nets.find(net);
+    if (net_it == db.nets.end()) {
+        bool clock = net == "clk" || net.find("clock") != std::string::npos;
+        mbff_add_net(db, net, clock ? Net::CLOCK : Net::SIGNAL);
+        net_it = db.nets.find(net);
+    }
+    net_it->second->connections.emplace_back(instance, pin);   // build_net_connections
+}
+
+void mbff_add_row(DesignDatabase& db, const PlacementRow& row) {
+    db.placement_rows.push_back(row);
+    // 和DEF parser相同：row高度 = 和前一個row的y間距
+    size_t count = db.placement_rows.size();
+    if (count > 1) {
+        PlacementRow& previous = db.placement_rows[count - 2];
+        previous.height = row.origin.y - previous.origin.y;
+        db.placement_rows[count - 1].height = previous.height;
+    }
+}
+
+// =============================================================================
+// RUN + RESULTS
+// =============================================================================
+
+void mbff_run(DesignDatabase& db, const MbffRunOptions& options) {
+    int first_rank = step_rank(options.first_step);
+    int last_rank = step_rank(options.last_step);
+    if (last_rank < first_rank) {
+        throw std::runtime_error("Step " + options.last_step + " comes before step " + options.first_step);
+    }
+    if (db.cell_library.empty()) {
+        throw std::runtime_error("No cell library (mbff_load_library / mbff_share_library / mbff_add_cell)");
+    }
+    run_steps(flow_arguments(options), db, options, first_rank - 1, last_rank);
+}
+
+std::vector<TransformationRecord> mbff_transformations(const DesignDatabase& db) {
+    std::vector<TransformationRecord> records;
+    records.reserve(db.transformation_history.size());
+    for (TransformationRecordRef ref : db.transformation_history) {
+        TransformationRecord record(ref.original_instance_name(), ref.result_instance_name(), ref.operation(),
+                                    ref.original_cell_type(), ref.result_cell_type());
+        record.pin_mapping = ref.pin_mapping();
+        record.stage = ref.stage();
+        for (const auto& name : ref.related_instances()) record.related_instances.push_back(name);
+        record.result_x = ref.result_x();
+        record.result_y = ref.result_y();
+        record.result_orientation = ref.result_orientation();
+        record.cluster_id = ref.cluster_id();
+        records.push_back(std::move(record));
+    }
+    return records;
+}
+
+std::vector<MbffPlacement> mbff_flip_flop_placements(const DesignDatabase& db) {
+    std::vector<MbffPlacement> placements;
+    for (const auto& pair : db.instances) {
+        const auto& instance = pair.second;
+        if (!instance->is_flip_flop()) continue;
+        MbffPlacement placement;
+        placement.instance_name = instance->name;
+        placement.cell_type = instance->cell_template->name;
+        placement.bit_width = instance->get_bit_width();
+        bool legalized = instance->x_new != 0 || instance->y_new != 0;
+        placement.x = legalized ? instance->x_new : instance->position.x;
+        placement.y = legalized ? instance->y_new : instance->position.y;
+        placement.orientation = instance->orientation;
+        placements.push_back(placement);
+    }
+    std::sort(placements.begin(), placements.end(),
+              [](const MbffPlacement& a, const MbffPlacement& b) { return a.instance_name < b.instance_name; });
+    return placements;
+}
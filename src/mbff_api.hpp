@@ -0,0 +1,96 @@
+#ifndef MBFF_API_HPP
+#define MBFF_API_HPP
+
+#include "data_structures.hpp"
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// =============================================================================
+// LIBMBFF: IN-MEMORY BANKING FLOW API
+// =============================================================================
+// 給netlist / placement已經在記憶體裡的flow直接呼叫，不用先寫Verilog/DEF再parse回來
+// (make libmbff → libmbff.a；include mbff_api.hpp)
+//
+//   DesignDatabase library;
+//   mbff_load_library(library, lib_files, lef_files);     // steps 1-2，可共用給多個design
+//
+//   DesignDatabase db;
+//   mbff_share_library(library, db);
+//   mbff_add_row(db, row);                                // 依y由小到大加入
+//   mbff_add_instance(db, "u_ff0", "SNPSSLOPT25_FSDN_V2_1", 10200, 600);   // x, y in DBU
+//   mbff_connect(db, "u_ff0", "CK", "clk");
+//   db.die_area / db.objective_weights / db.design_pins /
+//   db.placement_blockages / db.scan_chains 直接設定
+//
+//   mbff_run(db);                                         // steps 6-19，不寫任何檔案
+//   mbff_transformations(db);                             // KEEP / BANK / DEBANK / SUBSTITUTE ...
+//   mbff_flip_flop_placements(db);                        // 最終FF (cell, legalized位置)
+//
+// 和檔案輸入一樣：nets只記名稱和型別，連線存在Instance::connections；
+// 錯誤以std::runtime_error回報
+//
+// 注意：banking / legalization依db.instances的走訪順序做決定，同一個design以不同順序
+// mbff_add_instance會得到不同 (但都合法) 的結果；同樣的加入順序結果固定
+// =============================================================================
+
+struct MbffRunOptions {
+    std::string first_step = "6";      // Steps before this are already in the database
+    std::string last_step = "19";      // Stop after this step (checkpoint_step_keys())
+    int threads = 0;                   // Shared pool size incl. caller (0 = all cores)
+    double time_budget = 0.0;          // Wall-clock seconds, as -time_budget (0 = unlimited)
+    BankingParameters params;          // Heuristic thresholds, as -param (set_banking_parameter)
+    std::ostream* log = nullptr;       // Progress output; nullptr = discarded (warnings still go to the Logger)
+    std::string report_dir;            // Write debug reports here; empty = no report files
+};
+
+// Final placement of one flip-flop after mbff_run
+struct MbffPlacement {
+    std::string instance_name;
+    std::string cell_type;
+    int bit_width = 1;
+    Dbu x = 0;                         // Legalized position in DBU (input position if step 19 did not run)
+    Dbu y = 0;
+    Instance::Orientation orientation = Instance::N;
+};
+
+// --- Library ---------------------------------------------------------------
+
+// Parse Liberty + LEF into `library` (steps 1-2)
+void mbff_load_library(DesignDatabase& library, const std::vector<std::string>& lib_files,
+                       const std::vector<std::string>& lef_files, const MbffRunOptions& options = MbffRunOptions());
+
+// Use `library`'s cells in `db` (CellTemplate objects are shared read-only)
+void mbff_share_library(const DesignDatabase& library, DesignDatabase& db);
+
+// Cells built in memory instead of Liberty/LEF; call mbff_finalize_cells() after the last one
+void mbff_add_cell(DesignDatabase& db, const CellTemplate& cell);
+void mbff_finalize_cells(DesignDatabase& db);
+
+// --- Design ----------------------------------------------------------------
+
+// x / y are integer DBU, not microns (microns_to_dbu() converts LEF-style values)
+Instance& mbff_add_instance(DesignDatabase& db, const std::string& name, const std::string& cell_type,
+                            Dbu x, Dbu y, Instance::Orientation orientation = Instance::N,
+                            Instance::PlacementStatus status = Instance::PLACED);
+
+// Declare a net with an explicit type (mbff_connect creates missing nets as the parsers do)
+Net& mbff_add_net(DesignDatabase& db, const std::string& name, Net::NetType type = Net::SIGNAL);
+
+// instance.pin → net (both directions, like build_net_connections); power / ground / unconnected nets are normalized
+void mbff_connect(DesignDatabase& db, const std::string& instance, const std::string& pin, const std::string& net);
+
+// Rows in increasing y; row heights come from the spacing of consecutive rows, as in DEF
+void mbff_add_row(DesignDatabase& db, const PlacementRow& row);
+
+// --- Run + results ---------------------------------------------------------
+
+void mbff_run(DesignDatabase& db, const MbffRunOptions& options = MbffRunOptions());
+
+// Live transformation log in record order
+std::vector<TransformationRecord> mbff_transformations(const DesignDatabase& db);
+
+// All flip-flops sorted by instance name
+std::vector<MbffPlacement> mbff_flip_flop_placements(const DesignDatabase& db);
+
+#endif // MBFF_API_HPP
@@ -0,0 +1,674 @@
+// =============================================================================
+// PER-COMPONENT MICROBENCHMARKS
+// =============================================================================
+// 個別量測hot function：parser、banking clustering、legalizer、output writer
+// - 輸入全部用固定seed在記憶體中產生 (不需要testcase)
+// - 每個benchmark先跑warmup，再重複量測，報告median / p95 和 throughput
+// - -json 寫出結果；-baseline 讀入之前的JSON並列出差異 (PR前後比較)
+//
+// 使用方式：
+//   make microbench
+//   ./microbenchmark -size 20000 -reps 15 -json after.json -baseline before.json
+// =============================================================================
+
+#include "data_structures.hpp"
+#include "parsers.hpp"
+#include "Legalization.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define MICROBENCH_DEFAULT_SIZE 20000
+#define MICROBENCH_DEFAULT_REPS 11
+#define MICROBENCH_DEFAULT_WARMUP 2
+#define MICROBENCH_REGRESSION_PERCENT 10.0
+
+// Legalizer::placeRow is private; this friend exposes it to the harness only
+struct LegalizerBenchmarkAccess {
+    static double place_row(Legalizer& legalizer, const PlacementRow& row, Instance& instance,
+                            SubRow& subrow, bool final, bool check) {
+        return legalizer.placeRow(row, instance, subrow, final, check);
+    }
+};
+
+// =============================================================================
+// HARNESS
+// =============================================================================
+
+struct BenchmarkWork {
+    long items = 0;          // FFs / lines / cells processed per repetition
+    long bytes = 0;          // Input or output bytes per repetition
+};
+
+struct BenchmarkResult {
+    std::string name;
+    std::string item_unit;
+    int reps = 0;
+    double median_ms = 0.0;
+    double p95_ms = 0.0;
+    double min_ms = 0.0;
+    BenchmarkWork work;
+
+    double items_per_second() const { return median_ms > 0 ? work.items / (median_ms / 1000.0) : 0.0; }
+    double bytes_per_second() const { return median_ms > 0 ? work.bytes / (median_ms / 1000.0) : 0.0; }
+};
+
+struct Benchmark {
+    std::string name;
+    std::string item_unit;
+    std::function<void()> setup;             // Untimed, once
+    std::function<void()> before_rep;        // Untimed, before every repetition
+    std::function<BenchmarkWork()> run;      // Timed
+};
+
+// 被測函數都會印進度訊息，量測時把std::cout導到null
+class NullStreambuf : public std::streambuf {
+protected:
+    int_type overflow(int_type ch) override { return traits_type::not_eof(ch); }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+class MuteStdout {
+public:
+    MuteStdout() : saved_cout_(std::cout.rdbuf(&sink_)), saved_cerr_(std::cerr.rdbuf(&sink_)) {}
+    ~MuteStdout() {
+        std::cout.rdbuf(saved_cout_);
+        std::cerr.rdbuf(saved_cerr_);
+    }
+
+private:
+    NullStreambuf sink_;
+    std::streambuf* saved_cout_;
+    std::streambuf* saved_cerr_;
+};
+
+static double percentile(std::vector<double> samples, double fraction) {
+    if (samples.empty()) return 0.0;
+    std::sort(samples.begin(), samples.end());
+    size_t index = static_cast<size_t>(std::ceil(fraction * samples.size())) - 1;
+    return samples[std::min(index, samples.size() - 1)];
+}
+
+static BenchmarkResult run_benchmark(Benchmark& bench, int warmup, int reps) {
+    BenchmarkResult result;
+    result.name = bench.name;
+    result.item_unit = bench.item_unit;
+    result.reps = reps;
+
+    std::vector<double> samples;
+    {
+        MuteStdout mute;
+        if (bench.setup) bench.setup();
+        for (int i = 0; i < warmup + reps; i++) {
+            if (bench.before_rep) bench.before_rep();
+            auto start = std::chrono::steady_clock::now();
+            BenchmarkWork work = bench.run();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (i >= warmup) {
+                samples.push_back(ms);
+                result.work = work;
+            }
+        }
+    }
+
+    result.median_ms = percentile(samples, 0.5);
+    result.p95_ms = percentile(samples, 0.95);
+    result.min_ms = samples.empty() ? 0.0 : *std::min_element(samples.begin(), samples.end());
+    return result;
+}
+
+// =============================================================================
+// FIXED-SEED INPUTS
+// =============================================================================
+
+static const char* FF_CELL = "SNPSLOPT25_FSDN_V2_1";
+static const char* FF2_CELL = "SNPSLOPT25_FSDN2_V2_1";
+static const char* GATE_CELL = "SNPSLOPT25_AN2_MM_3";
+
+static void add_cell_template(DesignDatabase& db, const std::string& name, bool is_ff, int bits,
+                              Dbu width, const std::vector<std::string>& pins) {
+    auto cell = std::make_shared<CellTemplate>();
+    cell->name = name;
+    cell->type = is_ff ? CellTemplate::FLIP_FLOP : CellTemplate::OTHER;
+    cell->bit_width = bits;
+    cell->width = width;
+    cell->height = 600;
+    for (const auto& pin_name : pins) {
+        Pin pin;
+        pin.name = pin_name;
+        if (is_ff) pin.ff_pin_type = classify_ff_pin_type(pin_name);
+        cell->pins.push_back(pin);
+    }
+    db.cell_library[name] = cell;
+}
+
+static void add_benchmark_library(DesignDatabase& db) {
+    add_cell_template(db, FF_CELL, true, 1, 962, {"D", "SI", "SE", "CK", "Q", "QN"});
+    add_cell_template(db, FF2_CELL, true, 2, 1628, {"D0", "D1", "SI", "SE", "CK", "Q0", "Q1", "QN0", "QN1"});
+    add_cell_template(db, GATE_CELL, false, 1, 370, {"A1", "A2", "X"});
+}
+
+// Flat netlist: every FF is driven by one AN2 gate (same shape as testcase1)
+static std::string make_verilog_text(long ff_count, std::vector<size_t>& instance_offsets) {
+    std::ostringstream out;
+    out << "module top ( clk , in ) ;\ninput clk ;\ninput [63:0] in ;\n";
+    for (long i = 0; i < ff_count; i++) {
+        out << "wire d_" << i << " ;\nwire q_" << i << " ;\n";
+    }
+    std::string header = out.str();
+    std::string text = header;
+    instance_offsets.clear();
+    for (long i = 0; i < ff_count; i++) {
+        std::ostringstream inst;
+        instance_offsets.push_back(text.size());
+        inst << FF_CELL << " ff_" << i << " ( .D ( d_" << i << " ) , \n"
+             << "    .SI ( SYNOPSYS_UNCONNECTED_" << 2 * i << " ) , .SE ( SYNOPSYS_UNCONNECTED_" << 2 * i + 1 << " ) , \n"
+             << "    .CK ( clk ) , .Q ( q_" << i << " ) , .QN ( SYNOPSYS_UNCONNECTED_x" << i << " ) ) ;\n";
+        text += inst.str();
+        instance_offsets.push_back(text.size());
+        std::ostringstream gate;
+        gate << GATE_CELL << " g_" << i << " ( .A1 ( q_" << (i * 7 + 3) % ff_count << " ) , .A2 ( in[" << i % 64
+             << "] ) , .X ( d_" << i << " ) ) ;\n";
+        text += gate.str();
+    }
+    text += "endmodule\n";
+    return text;
+}
+
+static std::vector<std::string> make_component_lines(long ff_count, std::mt19937& rng) {
+    std::vector<std::string> lines;
+    std::uniform_int_distribution<int> coord(0, 800000);
+    for (long i = 0; i < ff_count; i++) {
+        std::ostringstream line;
+        line << "- ff_" << i << " " << FF_CELL << " + PLACED ( " << coord(rng) << " " << coord(rng) / 600 * 600 << " ) N ;";
+        lines.push_back(line.str());
+    }
+    return lines;
+}
+
+// Liberty cell block with the attributes parse_cell_properties scans, plus timing filler
+static std::vector<std::string> make_liberty_blocks(long count) {
+    std::vector<std::string> blocks;
+    const char* names[] = {"SNPSLOPT25_FSDN_V2_1", "SNPSHOPT25_FSDN4_V2_2", "SNPSSLOPT25_AN2_MM_3", "SNPSROPT25_LSRDPQ4_1"};
+    for (long i = 0; i < count; i++) {
+        std::string name = names[i % 4];
+        std::ostringstream block;
+        block << "cell(" << name << ") {\n  area : " << 0.5 + (i % 17) * 0.01 << " ;\n"
+              << "  cell_leakage_power : " << 1.0 + (i % 13) * 0.1 << " ;\n";
+        if (name.find("FSDN4") != std::string::npos) {
+            block << "  single_bit_degenerate : \"SNPSHOPT25_FSDN_V2_1\" ;\n";
+        }
+        if (name.find("AN2") == std::string::npos) {
+            block << "  ff(IQ,IQN) {\n    clocked_on : \"CK\" ;\n    next_state : \"(D&!SE)|(SI&SE)\" ;\n  }\n";
+        }
+        for (int pin = 0; pin < 4; pin++) {
+            block << "  pin(P" << pin << ") {\n    direction : input ;\n    capacitance : 0.00" << pin + 1 << " ;\n"
+                  << "    timing() {\n      related_pin : \"CK\" ;\n"
+                  << "      values(\"0.01, 0.02, 0.03, 0.04\", \"0.05, 0.06, 0.07, 0.08\") ;\n    }\n  }\n";
+        }
+        block << "}\n";
+        blocks.push_back(block.str());
+    }
+    return blocks;
+}
+
+static std::vector<std::shared_ptr<Instance>> make_placed_ffs(const DesignDatabase& db, long count, std::mt19937& rng) {
+    // 密度約等於testcase1：每個FF平均佔 ~2um x 2um
+    double side = std::sqrt(static_cast<double>(count)) * 2000.0;
+    std::uniform_int_distribution<Dbu> coord(0, static_cast<Dbu>(side));
+    std::vector<std::shared_ptr<Instance>> instances;
+    auto cell = db.cell_library.at(FF_CELL);
+    for (long i = 0; i < count; i++) {
+        auto inst = std::make_shared<Instance>();
+        inst->name = "ff_" + std::to_string(i);
+        inst->cell_type = FF_CELL;
+        inst->cell_template = cell;
+        inst->position.x = coord(rng);
+        inst->position.y = coord(rng) / 600 * 600;
+        instances.push_back(inst);
+    }
+    return instances;
+}
+
+static std::string temp_path(const std::string& name) {
+    const char* dir = std::getenv("TMPDIR");
+    return std::string(dir ? dir : "/tmp") + "/mbff_microbench_" + name;
+}
+
+static long file_size(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    return in.is_open() ? static_cast<long>(in.tellg()) : 0;
+}
+
+// =============================================================================
+// BENCHMARK DEFINITIONS
+// =============================================================================
+
+struct BenchmarkContext {
+    long size;
+    unsigned seed;
+
+    // Shared inputs (built lazily by setup steps)
+    std::string verilog_text;
+    std::vector<size_t> verilog_offsets;
+    std::vector<std::string> component_lines;
+    std::vector<std::string> liberty_blocks;
+    std::vector<std::shared_ptr<Instance>> placed_ffs;
+    std::unique_ptr<DesignDatabase> component_db;
+    std::unique_ptr<DesignDatabase> netlist_db;
+    std::unique_ptr<DesignDatabase> banked_db;
+    std::unique_ptr<DesignDatabase> legalizer_db;
+    std::unique_ptr<Legalizer> legalizer;
+    std::vector<std::shared_ptr<Instance>> row_instances;
+    PlacementRow row;
+};
+
+static void release_clusters(SubRow& subrow) {
+    Cluster* cluster = subrow.lastCluster;
+    while (cluster) {
+        Cluster* left = cluster->leftCluster;
+        delete cluster;
+        cluster = left;
+    }
+    subrow.lastCluster = nullptr;
+}
+
+static std::vector<Benchmark> build_benchmarks(BenchmarkContext& ctx) {
+    std::vector<Benchmark> benches;
+
+    // --- parse_verilog_instance ---
+    benches.push_back({"parse_verilog_instance", "instances",
+        [&ctx]() { ctx.verilog_text = make_verilog_text(ctx.size, ctx.verilog_offsets); },
+        nullptr,
+        [&ctx]() {
+            std::set<std::string> net_names;
+            BenchmarkWork work;
+            for (size_t offset : ctx.verilog_offsets) {
+                auto inst = parse_verilog_instance(ctx.verilog_text, offset, net_names);
+                if (inst) work.items++;
+            }
+            work.bytes = static_cast<long>(ctx.verilog_text.size());
+            return work;
+        }});
+
+    // --- parse_component_line ---
+    benches.push_back({"parse_component_line", "lines",
+        [&ctx]() {
+            std::mt19937 rng(ctx.seed);
+            ctx.component_lines = make_component_lines(ctx.size, rng);
+            ctx.component_db.reset(new DesignDatabase());
+            add_benchmark_library(*ctx.component_db);
+            for (long i = 0; i < ctx.size; i++) {
+                auto inst = std::make_shared<Instance>();
+                inst->name = "ff_" + std::to_string(i);
+                inst->cell_type = FF_CELL;
+                ctx.component_db->instances[inst->name] = inst;
+            }
+        },
+        nullptr,
+        [&ctx]() {
+            BenchmarkWork work;
+            for (const auto& line : ctx.component_lines) {
+                if (parse_component_line(line, *ctx.component_db)) work.items++;
+                work.bytes += static_cast<long>(line.size());
+            }
+            return work;
+        }});
+
+    // --- parse_cell_properties ---
+    benches.push_back({"parse_cell_properties", "cells",
+        [&ctx]() { ctx.liberty_blocks = make_liberty_blocks(ctx.size); },
+        nullptr,
+        [&ctx]() {
+            BenchmarkWork work;
+            const char* names[] = {"SNPSLOPT25_FSDN_V2_1", "SNPSHOPT25_FSDN4_V2_2", "SNPSSLOPT25_AN2_MM_3", "SNPSROPT25_LSRDPQ4_1"};
+            for (size_t i = 0; i < ctx.liberty_blocks.size(); i++) {
+                CellTemplate cell;
+                cell.name = names[i % 4];
+                parse_cell_properties(cell, ctx.liberty_blocks[i]);
+                work.items++;
+                work.bytes += static_cast<long>(ctx.liberty_blocks[i].size());
+            }
+            return work;
+        }});
+
+    // --- simple_distance_clustering ---
+    benches.push_back({"simple_distance_clustering", "FFs",
+        [&ctx]() {
+            DesignDatabase db;
+            add_benchmark_library(db);
+            std::mt19937 rng(ctx.seed);
+            ctx.placed_ffs = make_placed_ffs(db, ctx.size, rng);
+        },
+        nullptr,
+        [&ctx]() {
+            auto clusters = simple_distance_clustering(ctx.placed_ffs, 2, 10000.0);  // FSDN_2BIT_BANKING_distance
+            BenchmarkWork work;
+            work.items = clusters.empty() ? 0 : static_cast<long>(ctx.placed_ffs.size());
+            return work;
+        }});
+
+    // --- Legalizer::placeRow (Abacus inner loop on one long row) ---
+    benches.push_back({"Legalizer::placeRow", "FFs",
+        [&ctx]() {
+            ctx.legalizer_db.reset(new DesignDatabase());
+            add_benchmark_library(*ctx.legalizer_db);
+            ctx.row = PlacementRow();
+            ctx.row.name = "bench_row";
+            ctx.row.origin = Point(0, 0);
+            ctx.row.step_x = ctx.row.site_width = 74;
+            ctx.row.height = ctx.row.step_y = 600;
+            ctx.row.num_x = static_cast<int>(ctx.size * 2 * 1036 / 74);  // ~50% utilization
+            ctx.legalizer.reset(new Legalizer(std::numeric_limits<double>::max(), *ctx.legalizer_db));
+
+            std::mt19937 rng(ctx.seed);
+            std::uniform_int_distribution<Dbu> coord(0, static_cast<Dbu>(ctx.row.num_x) * 74);
+            auto cell = ctx.legalizer_db->cell_library.at(FF_CELL);
+            ctx.row_instances.clear();
+            for (long i = 0; i < ctx.size; i++) {
+                auto inst = std::make_shared<Instance>();
+                inst->name = "ff_" + std::to_string(i);
+                inst->cell_template = cell;
+                inst->position = Point(coord(rng), 0);
+                ctx.row_instances.push_back(inst);
+            }
+            std::sort(ctx.row_instances.begin(), ctx.row_instances.end(),
+                      [](const std::shared_ptr<Instance>& a, const std::shared_ptr<Instance>& b) {
+                          return a->position.x < b->position.x;
+                      });
+        },
+        nullptr,
+        [&ctx]() {
+            SubRow subrow(0.0, ctx.row.num_x * 74.0);
+            BenchmarkWork work;
+            for (auto& inst : ctx.row_instances) {
+                // Abacus：先試算cost，再正式放
+                LegalizerBenchmarkAccess::place_row(*ctx.legalizer, ctx.row, *inst, subrow, false, true);
+                LegalizerBenchmarkAccess::place_row(*ctx.legalizer, ctx.row, *inst, subrow, true, true);
+                work.items++;
+            }
+            release_clusters(subrow);
+            return work;
+        }});
+
+    // --- generate_final_verilog_file: re-emits the parsed input netlist ---
+    auto build_netlist_db = [&ctx]() {
+        if (ctx.netlist_db) return;
+        std::vector<size_t> offsets;
+        std::string text = make_verilog_text(ctx.size, offsets);
+        std::string input_path = temp_path("input.v");
+        {
+            std::ofstream out(input_path);
+            out << text;
+        }
+        ctx.netlist_db.reset(new DesignDatabase());
+        DesignDatabase& db = *ctx.netlist_db;
+        add_benchmark_library(db);
+        parse_verilog_file(input_path, db);
+        for (auto& pair : db.instances) {
+            auto cell = db.cell_library.find(pair.second->cell_type);
+            if (cell != db.cell_library.end()) pair.second->cell_template = cell->second;
+        }
+    };
+
+    // 模擬banking後的狀態：每兩個1-bit FF併成一個2-bit FF，pin provenance有forward鏈
+    auto build_banked_db = [&ctx]() {
+        ctx.banked_db.reset(new DesignDatabase());
+        DesignDatabase& db = *ctx.banked_db;
+        add_benchmark_library(db);
+        auto ff_cell = db.cell_library.at(FF_CELL);
+        auto mbff_cell = db.cell_library.at(FF2_CELL);
+        for (long i = 0; i < ctx.size; i++) {
+            Instance original;
+            original.name = "ff_" + std::to_string(i);
+            original.cell_type = FF_CELL;
+            original.cell_template = ff_cell;
+            for (const auto& pin : ff_cell->pins) {
+                original.connections.push_back(Instance::Connection(pin.name, pin.name + "_" + std::to_string(i)));
+            }
+            db.pin_provenance.register_original_instance(original);
+        }
+        const char* single_pins[] = {"D", "Q", "QN"};
+        for (long i = 0; i + 1 < ctx.size; i += 2) {
+            auto mbff = std::make_shared<Instance>();
+            mbff->name = "mbff_" + std::to_string(i / 2);
+            mbff->cell_type = FF2_CELL;
+            mbff->cell_template = mbff_cell;
+            db.instances[mbff->name] = mbff;
+            for (int b = 0; b < 2; b++) {
+                std::string from = "ff_" + std::to_string(i + b);
+                for (const char* pin : single_pins) {
+                    db.pin_provenance.forward_pin(from, pin, mbff->name, pin + std::to_string(b));
+                }
+                db.pin_provenance.forward_pin(from, "CK", mbff->name, "CK");
+                db.pin_provenance.forward_pin(from, "SI", mbff->name, "SI");
+                db.pin_provenance.forward_pin(from, "SE", mbff->name, "SE");
+            }
+        }
+    };
+
+    benches.push_back({"generate_final_verilog_file", "instances",
+        build_netlist_db,
+        nullptr,
+        [&ctx]() {
+            std::string output_path = temp_path("output.v");
+            generate_final_verilog_file(*ctx.netlist_db, output_path);
+            BenchmarkWork work;
+            work.items = static_cast<long>(ctx.netlist_db->instances.size());
+            work.bytes = file_size(output_path);
+            return work;
+        }});
+
+    benches.push_back({"write_pin_mapping_entries", "pins",
+        build_banked_db,
+        nullptr,
+        [&ctx]() {
+            std::ostringstream out;
+            BenchmarkWork work;
+            work.items = write_pin_mapping_entries(*ctx.banked_db, out);
+            work.bytes = static_cast<long>(out.tellp());
+            return work;
+        }});
+
+    return benches;
+}
+
+// =============================================================================
+// REPORTING
+// =============================================================================
+
+static std::string format_rate(double value, const std::string& unit) {
+    const char* suffix[] = {"", "K", "M", "G"};
+    int level = 0;
+    while (value >= 1000.0 && level < 3) {
+        value /= 1000.0;
+        level++;
+    }
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(value < 10 ? 2 : 1) << value << suffix[level] << " " << unit << "/s";
+    return out.str();
+}
+
+static void print_results(const std::vector<BenchmarkResult>& results, long size) {
+    std::cout << "\n=== MICROBENCHMARKS (size " << size << ") ===" << std::endl;
+    std::cout << std::left << std::setw(30) << "Benchmark" << std::right
+              << std::setw(12) << "Median(ms)" << std::setw(12) << "p95(ms)"
+              << std::setw(22) << "Items" << std::setw(16) << "Bytes" << std::endl;
+    std::cout << std::string(92, '-') << std::endl;
+    for (const auto& r : results) {
+        std::cout << std::left << std::setw(30) << r.name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << r.median_ms << std::setw(12) << r.p95_ms
+                  << std::setw(22) << format_rate(r.items_per_second(), r.item_unit)
+                  << std::setw(16) << (r.work.bytes > 0 ? format_rate(r.bytes_per_second(), "B") : "-") << std::endl;
+    }
+}
+
+static bool write_json(const std::vector<BenchmarkResult>& results, long size, const std::string& filename) {
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot open " << filename << " for writing" << std::endl;
+        return false;
+    }
+    out << "{\n  \"size\": " << size << ",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        out << std::fixed << std::setprecision(4)
+            << "    {\"name\": \"" << r.name << "\", \"reps\": " << r.reps
+            << ", \"median_ms\": " << r.median_ms << ", \"p95_ms\": " << r.p95_ms
+            << ", \"min_ms\": " << r.min_ms
+            << ", \"items\": " << r.work.items << ", \"bytes\": " << r.work.bytes
+            << std::setprecision(1)
+            << ", \"items_per_s\": " << r.items_per_second() << ", \"bytes_per_s\": " << r.bytes_per_second() << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    return true;
+}
+
+// 只讀自己寫出的格式：每個benchmark一行
+static std::map<std::string, double> read_baseline(const std::string& filename) {
+    std::map<std::string, double> medians;
+    std::ifstream in(filename);
+    if (!in.is_open()) {
+        std::cerr << "Error: Cannot open baseline " << filename << std::endl;
+        return medians;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t name_pos = line.find("\"name\": \"");
+        size_t median_pos = line.find("\"median_ms\": ");
+        if (name_pos == std::string::npos || median_pos == std::string::npos) continue;
+        name_pos += 9;
+        std::string name = line.substr(name_pos, line.find('"', name_pos) - name_pos);
+        medians[name] = std::atof(line.c_str() + median_pos + 13);
+    }
+    return medians;
+}
+
+static int compare_with_baseline(const std::vector<BenchmarkResult>& results, const std::string& filename,
+                                 double threshold_percent) {
+    std::map<std::string, double> baseline = read_baseline(filename);
+    if (baseline.empty()) return 0;
+
+    std::cout << "\n=== BASELINE COMPARISON (" << filename << ") ===" << std::endl;
+    std::cout << std::left << std::setw(30) << "Benchmark" << std::right
+              << std::setw(14) << "Before(ms)" << std::setw(14) << "After(ms)"
+              << std::setw(10) << "Change" << std::setw(10) << "Speedup" << std::endl;
+    std::cout << std::string(78, '-') << std::endl;
+
+    int regressions = 0;
+    for (const auto& r : results) {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end() || it->second <= 0.0) {
+            std::cout << std::left << std::setw(30) << r.name << std::right << std::setw(14) << "-" << std::endl;
+            continue;
+        }
+        double change = (r.median_ms - it->second) / it->second * 100.0;
+        bool regressed = change > threshold_percent;
+        regressions += regressed ? 1 : 0;
+        std::cout << std::left << std::setw(30) << r.name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(14) << it->second << std::setw(14) << r.median_ms
+                  << std::setprecision(1) << std::setw(9) << change << "%"
+                  << std::setprecision(2) << std::setw(9) << it->second / std::max(r.median_ms, 1e-9) << "x"
+                  << (regressed ? "  REGRESSION" : "") << std::endl;
+    }
+    return regressions;
+}
+
+// =============================================================================
+// MAIN
+// =============================================================================
+
+static void print_microbench_usage(const char* program) {
+    std::cout << "Usage: " << program << " [options]" << std::endl;
+    std::cout << "  -size <n>          FFs / lines / cells per benchmark (default " << MICROBENCH_DEFAULT_SIZE << ")" << std::endl;
+    std::cout << "  -reps <n>          Measured repetitions (default " << MICROBENCH_DEFAULT_REPS << ")" << std::endl;
+    std::cout << "  -warmup <n>        Warmup repetitions (default " << MICROBENCH_DEFAULT_WARMUP << ")" << std::endl;
+    std::cout << "  -filter <text>     Only run benchmarks whose name contains text" << std::endl;
+    std::cout << "  -seed <n>          Input generator seed (default 1)" << std::endl;
+    std::cout << "  -json <file>       Write results as JSON" << std::endl;
+    std::cout << "  -baseline <file>   Compare medians with an earlier -json file" << std::endl;
+    std::cout << "  -threshold <pct>   Slowdown reported as regression (default " << MICROBENCH_REGRESSION_PERCENT << ")" << std::endl;
+    std::cout << "  -strict            Exit with status 1 when a regression is found" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    BenchmarkContext ctx;
+    ctx.size = MICROBENCH_DEFAULT_SIZE;
+    ctx.seed = 1;
+    int reps = MICROBENCH_DEFAULT_REPS;
+    int warmup = MICROBENCH_DEFAULT_WARMUP;
+    double threshold = MICROBENCH_REGRESSION_PERCENT;
+    bool strict = false;
+    std::string filter, json_file, baseline_file;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_microbench_usage(argv[0]);
+            return 0;
+        }
+        if (arg == "-strict") {
+            strict = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Error: Missing value for " << arg << std::endl;
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "-size") ctx.size = std::max(2L, std::atol(value.c_str()));
+        else if (arg == "-reps") reps = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "-warmup") warmup = std::max(0, std::atoi(value.c_str()));
+        else if (arg == "-filter") filter = value;
+        else if (arg == "-seed") ctx.seed = static_cast<unsigned>(std::atol(value.c_str()));
+        else if (arg == "-json") json_file = value;
+        else if (arg == "-baseline") baseline_file = value;
+        else if (arg == "-threshold") threshold = std::atof(value.c_str());
+        else {
+            std::cerr << "Error: Unknown option " << arg << std::endl;
+            print_microbench_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::cout << "=== MBFF microbenchmarks: size " << ctx.size << ", " << warmup << " warmup + "
+              << reps << " reps ===" << std::endl;
+
+    std::vector<Benchmark> benches = build_benchmarks(ctx);
+    std::vector<BenchmarkResult> results;
+    for (auto& bench : benches) {
+        if (!filter.empty() && bench.name.find(filter) == std::string::npos) continue;
+        std::cout << "  Running " << bench.name << "..." << std::endl;
+        results.push_back(run_benchmark(bench, warmup, reps));
+    }
+
+    print_results(results, ctx.size);
+    if (!json_file.empty() && write_json(results, ctx.size, json_file)) {
+        std::cout << "\n  Results written to " << json_file << std::endl;
+    }
+
+    int regressions = 0;
+    if (!baseline_file.empty()) {
+        regressions = compare_with_baseline(results, baseline_file, threshold);
+        std::cout << "\n  " << regressions << " regression(s) above " << threshold << "%" << std::endl;
+    }
+
+    std::remove(temp_path("input.v").c_str());
+    std::remove(temp_path("output.v").c_str());
+    return (strict && regressions > 0) ? 1 : 0;
+}
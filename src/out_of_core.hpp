@@ -0,0 +1,132 @@
+#ifndef OUT_OF_CORE_HPP
+#define OUT_OF_CORE_HPP
+
+#include "data_structures.hpp"
+#include "compressed_stream.hpp"
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+// =============================================================================
+// OUT-OF-CORE NETLIST (-out_of_core)
+// =============================================================================
+// 大design大部分記憶體是組合邏輯instance (名稱 + 每個pin的連線)，但banking只動FF：
+//   Step 3: Verilog逐行串流parse (不把整個檔案讀進記憶體)；FF照常放進db.instances，
+//           非FF instance寫進spill檔 <out>.ooc_cells，不建Instance / Net物件
+//           結束時建on-disk net index <out>.ooc_nets (hash bucket，mmap查詢)
+//   Step 4: DEF中非FF component只存成obstacle rectangle <out>.ooc_obstacles (32 bytes)
+//   Step 19: Legalizer直接用mmap的obstacle切sub-rows
+//   Writers: Verilog的module header和組合邏輯instance從原始檔 / spill檔串流輸出
+// 記憶體 ~ FF數 + module數，組合邏輯只在page cache；檔案在DesignDatabase釋放時刪除
+// Step 7 / 8的clock tracing和scan chain detection用 net_instances() 從index分頁讀入
+// 一個net上的組合邏輯cell (clock tree cell / scan path buffer)，不掃整個spill檔
+// 不支援checkpoint (spill檔不在DesignDatabase裡)
+// =============================================================================
+
+#define OUT_OF_CORE_PINS_PER_BUCKET 64      // Average index entries scanned per net lookup
+#define OUT_OF_CORE_MIN_BUCKETS 1024
+#define OUT_OF_CORE_WRITE_BUFFER (1 << 20)  // Spill / obstacle stream buffer (bytes)
+
+// Placement obstacle of one combinational instance (DBU)
+struct ObstacleRecord {
+    Dbu x;
+    Dbu y;
+    Dbu width;
+    Dbu height;
+};
+
+// A combinational instance read back from the spill file
+struct SpilledInstance {
+    std::string name;
+    std::string cell_type;
+    size_t module_index = 0;            // Index into DesignDatabase::modules
+    std::vector<Instance::Connection> connections;
+};
+
+class OutOfCoreNetlist {
+public:
+    // Files are <prefix>.ooc_cells / .ooc_nets / .ooc_obstacles
+    explicit OutOfCoreNetlist(const std::string& prefix);
+    ~OutOfCoreNetlist();
+
+    // --- Step 3 ---------------------------------------------------------------
+    // Header layout of db.modules[index] in `verilog_path` (byte offsets; npos = absent)
+    void add_module(const std::string& verilog_path, uint64_t start, uint64_t end);
+    void set_module_header(size_t module_index, uint64_t wire, uint64_t header_end);
+    void spill_instance(const Instance& instance, size_t module_index);
+    void finish_netlist();              // Map the spill file and build the net index
+
+    // --- Step 4 ---------------------------------------------------------------
+    void add_obstacle(Dbu x, Dbu y, Dbu width, Dbu height);
+    void finish_obstacles();            // Map the obstacle file
+
+    size_t instance_count() const { return instance_count_; }
+    size_t pin_count() const { return pin_count_; }
+    size_t obstacle_count() const { return obstacle_count_; }
+    const ObstacleRecord* obstacles() const;
+
+    // Spilled instances of one module with a pin on `net_name` (paged in from the index)
+    std::vector<SpilledInstance> net_instances(const std::string& net_name, size_t module_index) const;
+
+    // Spilled instances of one module, in file order
+    void for_each_instance(size_t module_index, const std::function<void(const SpilledInstance&)>& visit) const;
+
+    // Module header and wire declarations as generate_final_verilog_file prints them
+    void write_module_header(std::ostream& out, size_t module_index, const std::string& module_name) const;
+
+private:
+    struct Mapping {
+        char* data = nullptr;
+        size_t size = 0;
+    };
+    struct ModuleSpan {
+        std::string verilog_path;
+        uint64_t start = 0;
+        uint64_t end = 0;
+        uint64_t wire = UINT64_MAX;
+        uint64_t header_end = UINT64_MAX;
+        uint64_t first_record = UINT64_MAX;    // Spill file range of the module's instances
+        uint64_t end_record = 0;
+    };
+
+    OutOfCoreNetlist(const OutOfCoreNetlist&) = delete;
+    OutOfCoreNetlist& operator=(const OutOfCoreNetlist&) = delete;
+
+    uint64_t decode_instance(uint64_t offset, SpilledInstance& instance) const;
+    void build_net_index();
+
+    std::string cells_path_;
+    std::string nets_path_;
+    std::string obstacles_path_;
+    std::ofstream cells_out_;
+    std::ofstream obstacles_out_;
+    std::vector<char> cells_buffer_;
+    std::vector<char> obstacles_buffer_;
+    uint64_t cells_size_ = 0;
+
+    std::vector<ModuleSpan> modules_;
+    size_t instance_count_ = 0;
+    size_t pin_count_ = 0;              // Indexed pins (signal nets only)
+    size_t obstacle_count_ = 0;
+
+    Mapping cells_;
+    Mapping nets_;
+    Mapping obstacles_;
+    uint64_t bucket_count_ = 0;
+
+    // write_module_header依module順序往前讀，壓縮的Verilog只解壓一次
+    mutable std::unique_ptr<InputFile> header_input_;
+    mutable std::string header_input_path_;
+};
+
+// Streaming replacement for parse_verilog_file (db.out_of_core must be set)
+void parse_verilog_file_out_of_core(const std::string& filepath, DesignDatabase& db);
+
+// DEF component that is not in db.instances → obstacle; false if it is not a placed combinational cell
+bool record_component_obstacle(const std::string& line, DesignDatabase& db);
+
+#endif // OUT_OF_CORE_HPP
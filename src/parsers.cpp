@@ -1,4 +1,8 @@
 #include "parsers.hpp"
+#include "out_of_core.hpp"
+#include "thread_pool.hpp"
+#include "compressed_stream.hpp"
+#include "clock_tracing.hpp"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -23,7 +27,10 @@ bool ends_with(const std::string& str, const std::string& suffix) {
 }
 
 // 檢查是否應該解析此Liberty檔案
-bool should_parse_liberty_file(const std::string& filepath) {
+bool should_parse_liberty_file(const std::string& path) {
+    // .lib.gz / .lib.zst 視同 .lib
+    std::string filepath = strip_compression_extension(path);
+
     // 跳過.db檔案
     if (ends_with(filepath, ".db")) {
         return false;
@@ -45,8 +52,8 @@ bool should_parse_liberty_file(const std::string& filepath) {
 
 // 檢查是否應該解析此LEF檔案
 bool should_parse_lef_file(const std::string& filepath) {
-    // 只解析.lef檔案
-    return ends_with(filepath, ".lef");
+    // 只解析.lef檔案 (含 .lef.gz / .lef.zst)
+    return ends_with(strip_compression_extension(filepath), ".lef");
 }
 
 // 遞迴搜尋目錄中的檔案
@@ -87,7 +94,8 @@ std::vector<std::string> discover_liberty_files(const std::string& testcase_path
     
     // 過濾出需要的Liberty檔案
     for (const std::string& filepath : all_files) {
-        if (ends_with(filepath, ".lib") || ends_with(filepath, ".db")) {
+        std::string uncompressed = strip_compression_extension(filepath);
+        if (ends_with(uncompressed, ".lib") || ends_with(uncompressed, ".db")) {
             if (should_parse_liberty_file(filepath)) {
                 liberty_files.push_back(filepath);
             } else {
@@ -257,6 +265,105 @@ std::string extract_quoted_string(const std::string& text, const std::string& ke
     return text.substr(quote_start + 1, quote_end - quote_start - 1);
 }
 
+std::string trim_whitespace(const std::string& str);
+
+// Liberty attribute "name : value ;" (value去掉空白和引號)，找不到回傳""
+// name前面不能是identifier字元，避免related_pin之類的attribute被當成pin
+static std::string extract_liberty_attribute(const std::string& text, const std::string& name) {
+    size_t pos = 0;
+    while ((pos = text.find(name, pos)) != std::string::npos) {
+        size_t after = pos + name.size();
+        bool word_start = pos == 0 || !(std::isalnum(static_cast<unsigned char>(text[pos - 1])) || text[pos - 1] == '_');
+        pos = after;
+        if (!word_start) continue;
+        while (after < text.size() && (text[after] == ' ' || text[after] == '\t')) after++;
+        if (after >= text.size() || text[after] != ':') continue;
+        size_t end = text.find_first_of(";\n", after + 1);
+        std::string value = text.substr(after + 1, end == std::string::npos ? std::string::npos : end - after - 1);
+        value.erase(std::remove(value.begin(), value.end(), '"'), value.end());
+        return trim_whitespace(value);
+    }
+    return "";
+}
+
+// 解析buffer / inverter / ICG的clock tree角色 (clock tracing用)
+// 每個pin(...) { } block取direction、function和clock_gate_*_pin；只有單一輸入、單一輸出，
+// 且輸出function就是輸入 (或其反相) 的cell才算buffer / inverter
+static void parse_clock_tree_role(CellTemplate& cell, const std::string& cell_block) {
+    bool icg = cell_block.find("clock_gating_integrated_cell") != std::string::npos;
+    if (!icg && cell_block.find("function") == std::string::npos) return;
+    
+    std::vector<std::string> inputs, outputs;
+    std::string output_function;
+    std::string gate_clock, gate_enable, gate_out, gate_out_function;
+    size_t pos = 0;
+    while ((pos = cell_block.find("pin", pos)) != std::string::npos) {
+        size_t name_start = pos + 3;
+        bool word_start = pos == 0 || !(std::isalnum(static_cast<unsigned char>(cell_block[pos - 1])) || cell_block[pos - 1] == '_');
+        pos = name_start;
+        while (name_start < cell_block.size() && cell_block[name_start] == ' ') name_start++;
+        if (!word_start || name_start >= cell_block.size() || cell_block[name_start] != '(') continue;
+        size_t name_end = cell_block.find(')', name_start);
+        size_t body_start = cell_block.find('{', name_start);
+        if (name_end == std::string::npos || body_start == std::string::npos) break;
+        std::string pin_name = cell_block.substr(name_start + 1, name_end - name_start - 1);
+        pin_name.erase(std::remove(pin_name.begin(), pin_name.end(), '"'), pin_name.end());
+        pin_name = trim_whitespace(pin_name);
+        
+        int depth = 1;
+        size_t body_end = body_start + 1;
+        while (body_end < cell_block.size() && depth > 0) {
+            if (cell_block[body_end] == '{') depth++;
+            else if (cell_block[body_end] == '}') depth--;
+            body_end++;
+        }
+        std::string body = cell_block.substr(body_start, body_end - body_start);
+        pos = body_end;
+        
+        std::string direction = extract_liberty_attribute(body, "direction");
+        std::string function = extract_liberty_attribute(body, "function");
+        if (direction == "input") inputs.push_back(pin_name);
+        if (direction == "output") {
+            outputs.push_back(pin_name);
+            output_function = function;
+        }
+        if (extract_liberty_attribute(body, "clock_gate_clock_pin") == "true") gate_clock = pin_name;
+        if (extract_liberty_attribute(body, "clock_gate_enable_pin") == "true") gate_enable = pin_name;
+        if (extract_liberty_attribute(body, "clock_gate_out_pin") == "true") {
+            gate_out = pin_name;
+            gate_out_function = function;
+        }
+    }
+    
+    if (icg) {
+        if (gate_clock.empty() || gate_enable.empty() || gate_out.empty()) return;
+        cell.clock_role = CellTemplate::CLOCK_GATE;
+        cell.clock_in_pin = gate_clock;
+        cell.clock_out_pin = gate_out;
+        cell.clock_enable_pin = gate_enable;
+        cell.clock_out_inverted = gate_out_function.find("!" + gate_clock) != std::string::npos ||
+                                  gate_out_function.find(gate_clock + "'") != std::string::npos;
+        return;
+    }
+    
+    if (inputs.size() != 1 || outputs.size() != 1 || output_function.empty()) return;
+    std::string function;
+    for (char c : output_function) {
+        if (c != ' ' && c != '(' && c != ')') function += c;
+    }
+    const std::string& input = inputs[0];
+    if (function == input) {
+        cell.clock_role = CellTemplate::CLOCK_BUFFER;
+    } else if (function == "!" + input || function == "~" + input || function == input + "'") {
+        cell.clock_role = CellTemplate::CLOCK_INVERTER;
+        cell.clock_out_inverted = true;
+    } else {
+        return;
+    }
+    cell.clock_in_pin = input;
+    cell.clock_out_pin = outputs[0];
+}
+
 // 解析cell屬性
 void parse_cell_properties(CellTemplate& cell, const std::string& cell_block) {
     // 設定cell類型
@@ -302,7 +409,10 @@ void parse_cell_properties(CellTemplate& cell, const std::string& cell_block) {
         }
     }
     
-    // TODO: 解析pin資訊（較複雜，後續添加）
+    // Buffer / inverter / ICG (FF的pin資訊由LEF提供)
+    if (cell.type != CellTemplate::FLIP_FLOP) {
+        parse_clock_tree_role(cell, cell_block);
+    }
 }
 
 // =============================================================================
@@ -333,20 +443,21 @@ std::string extract_pin_name(const std::string& pin_line) {
 
 // 解析SIZE行
 void parse_size_line(const std::string& line, std::shared_ptr<CellTemplate> cell) {
-    // "SIZE 0.592 BY 0.6 ;" -> width=0.592, height=0.6
+    // "SIZE 0.592 BY 0.6 ;" -> width=592, height=600 (DBU)
     std::istringstream iss(line);
     std::string token;
+    double width = 0.0, height = 0.0;
     
     iss >> token; // "SIZE"
-    iss >> cell->width;
+    iss >> width;
     iss >> token; // "BY"
-    iss >> cell->height;
-    cell->width*=1000;
-    cell->height*=1000; 
+    iss >> height;
+    cell->width = microns_to_dbu(width);
+    cell->height = microns_to_dbu(height);
 }
 
 // 解析PIN section
-void parse_pin_section(std::ifstream& file, const std::string& pin_line, std::shared_ptr<CellTemplate> cell) {
+void parse_pin_section(std::istream& file, const std::string& pin_line, std::shared_ptr<CellTemplate> cell) {
     // 提取pin名稱
     std::string pin_name = extract_pin_name(pin_line);
     if (pin_name.empty()) return;
@@ -407,7 +518,7 @@ std::string extract_cell_name_from_macro(const std::string& macro_line) {
 }
 
 // 解析MACRO內容
-void parse_macro_content(std::ifstream& file, std::shared_ptr<CellTemplate> cell) {
+void parse_macro_content(std::istream& file, std::shared_ptr<CellTemplate> cell) {
     std::string line;
     
     while (std::getline(file, line)) {
@@ -431,7 +542,7 @@ void parse_macro_content(std::ifstream& file, std::shared_ptr<CellTemplate> cell
 }
 
 // 跳過未知MACRO的內容
-void skip_macro_content(std::ifstream& file) {
+void skip_macro_content(std::istream& file) {
     std::string line;
     while (std::getline(file, line)) {
         if (line.find("END ") == 0) {
@@ -948,7 +1059,7 @@ void build_net_connections(DesignDatabase& db) {
 // 解析DIEAREA行: "DIEAREA ( 0 0 ) ( 0 610000 ) ( 809940 610000 ) ( 809940 0 ) ;"
 void parse_diearea_line(const std::string& line, DesignDatabase& db) {
     // 簡化處理：只取第一個和第三個點來確定die area
-    std::vector<std::pair<double, double>> points;
+    std::vector<std::pair<Dbu, Dbu>> points;
     
     size_t pos = 0;
     while (pos < line.length()) {
@@ -960,9 +1071,9 @@ void parse_diearea_line(const std::string& line, DesignDatabase& db) {
         
         std::string coord_str = line.substr(open_paren + 1, close_paren - open_paren - 1);
         std::istringstream iss(coord_str);
-        double x, y;
+        Dbu x, y;
         if (iss >> x >> y) {
-            points.emplace_back(x , y ); // Convert from nanometers to microns
+            points.emplace_back(x , y ); // DBU
         }
         
         pos = close_paren + 1;
@@ -1012,9 +1123,9 @@ void parse_row_line(const std::string& line, DesignDatabase& db) {
     iss >> row.name; // row name
     iss >> row.site; // site type
     
-    double x, y;
-    iss >> x >> y; // origin coordinates
-    row.origin.x = x ; // Convert to microns
+    Dbu x = 0, y = 0;
+    iss >> x >> y; // origin coordinates (DBU)
+    row.origin.x = x ;
     row.origin.y = y ;
     
     std::string orientation;
@@ -1039,7 +1150,7 @@ void parse_row_line(const std::string& line, DesignDatabase& db) {
 }
 
 // 解析NETS section
-void parse_nets_section(std::ifstream& file, DesignDatabase& db) {
+void parse_nets_section(std::istream& file, DesignDatabase& db) {
     std::string line;
     int parsed_nets = 0;
     int existing_nets = 0;
@@ -1063,7 +1174,9 @@ void parse_nets_section(std::ifstream& file, DesignDatabase& db) {
             
             // 創建或更新net (確保所有DEF中的nets都存在)
             auto existing_net = db.nets.find(net_name);
-            if (existing_net == db.nets.end()) {
+            if (existing_net == db.nets.end() && db.out_of_core) {
+                existing_nets++;   // -out_of_core：沒有FF pin的net不建物件
+            } else if (existing_net == db.nets.end()) {
                 auto net = std::make_shared<Net>();
                 net->name = net_name;
                 
@@ -1114,7 +1227,7 @@ bool parse_rect_line(const std::string& line, Rectangle& rect) {
 }
 
 // 解析BLOCKAGES section
-void parse_blockages_section(std::ifstream& file, DesignDatabase& db) {
+void parse_blockages_section(std::istream& file, DesignDatabase& db) {
     std::string line;
     int parsed_placement_blockages = 0;
     int skipped_layer_blockages = 0;
@@ -1156,7 +1269,7 @@ void parse_blockages_section(std::ifstream& file, DesignDatabase& db) {
 }
 
 // 解析SPECIALNETS section  
-void parse_specialnets_section(std::ifstream& file, DesignDatabase& db) {
+void parse_specialnets_section(std::istream& file, DesignDatabase& db) {
     std::string line;
     int parsed_special_nets = 0;
     
@@ -1269,9 +1382,9 @@ bool parse_component_line(const std::string& line, DesignDatabase& db) {
     
     std::string coord_str = line.substr(coord_start, coord_end - coord_start);
     std::istringstream iss(coord_str);
-    double x, y;
+    Dbu x, y;
     if (iss >> x >> y) {
-        inst_it->second->position.x = x ; // Convert to microns
+        inst_it->second->position.x = x ; // DBU
         inst_it->second->position.y = y ;
     }
     
@@ -1300,30 +1413,35 @@ bool parse_component_line(const std::string& line, DesignDatabase& db) {
 // =============================================================================
 
 void parse_liberty_file(const std::string& filepath, DesignDatabase& db) {
+    // 加入資料庫 (依檔案中的順序)
+    for (auto& cell : parse_liberty_cells(filepath)) {
+        db.cell_library[cell->name] = cell;
+    }
+}
+
+// 整個輸入檔讀成一個字串；和逐行getline串接的結果相同 (最後一行也以'\n'結尾)
+std::string read_file_content(InputFile& file) {
+    std::string content = file.read_all();
+    if (!content.empty() && content.back() != '\n') content += '\n';
+    return content;
+}
+
+std::vector<std::shared_ptr<CellTemplate>> parse_liberty_cells(const std::string& filepath) {
+    std::vector<std::shared_ptr<CellTemplate>> cells;
     std::cout << "  Parsing: " << filepath << std::endl;
     
-    std::ifstream file(filepath);
+    InputFile file(filepath);
     if (!file.is_open()) {
         std::cout << "  SKIPPED: Cannot open " << filepath << std::endl;
-        return;
+        return cells;
     }
     
     // 提取library名稱（從檔案路徑）
     std::string library_name = extract_library_name(filepath);
     std::cout << "    Reading file..." << std::flush;
     
-    // 讀取整個檔案內容 (with progress indicator)
-    std::string file_content;
-    std::string line;
-    int line_count = 0;
-    while(std::getline(file, line)) {
-        file_content += line + "\n";
-        line_count++;
-        // 每10000行顯示一次進度
-        // if (line_count % 10000 == 0) {
-        //     std::cout << "." << std::flush;
-        // }
-    }
+    // 讀取整個檔案內容 (一次讀完，不逐行串接)
+    std::string file_content = read_file_content(file);
     file.close();
     
     std::cout << "\n    File size: " << file_content.length() << " chars, Library: " << library_name << std::endl;
@@ -1367,8 +1485,7 @@ void parse_liberty_file(const std::string& filepath, DesignDatabase& db) {
             // 解析cell屬性
             parse_cell_properties(*cell, cell_block);
             
-            // 加入資料庫
-            db.cell_library[cell->name] = cell;
+            cells.push_back(cell);
             cell_count++;
         }
         
@@ -1376,12 +1493,13 @@ void parse_liberty_file(const std::string& filepath, DesignDatabase& db) {
     }
     
     std::cout << "    Parsed " << cell_count << " cells" << std::endl;
+    return cells;
 }
 
 void parse_lef_file(const std::string& filepath, DesignDatabase& db) {
     std::cout << "  Parsing: " << filepath << std::endl;
     
-    std::ifstream file(filepath);
+    InputFile file(filepath);
     if (!file.is_open()) {
         std::cout << "  ERROR: Cannot open " << filepath << std::endl;
         return;
@@ -1420,17 +1538,13 @@ void parse_lef_file(const std::string& filepath, DesignDatabase& db) {
 void parse_verilog_file(const std::string& filepath, DesignDatabase& db) {
     std::cout << "  Parsing: " << filepath << std::endl;
     
-    std::ifstream file(filepath);
+    InputFile file(filepath);
     if (!file.is_open()) {
         std::cout << "  ERROR: Cannot open " << filepath << std::endl;
         return;
     }
     
-    std::string file_content;
-    std::string line;
-    while(std::getline(file, line)) {
-        file_content += line + "\n";
-    }
+    std::string file_content = read_file_content(file);
     file.close();
     
     std::cout << "    File size: " << file_content.length() << " chars" << std::endl;
@@ -1519,17 +1633,13 @@ void parse_targeted_ff_connections(const std::string& content,
 void parse_verilog_file_selective(const std::string& filepath, DesignDatabase& db) {
     std::cout << "  Parsing: " << filepath << " (selective FF-only)" << std::endl;
     
-    std::ifstream file(filepath);
+    InputFile file(filepath);
     if (!file.is_open()) {
         std::cout << "  ERROR: Cannot open " << filepath << std::endl;
         return;
     }
     
-    std::string file_content;
-    std::string line;
-    while(std::getline(file, line)) {
-        file_content += line + "\n";
-    }
+    std::string file_content = read_file_content(file);
     file.close();
     
     std::cout << "    File size: " << file_content.length() << " chars" << std::endl;
@@ -1569,16 +1679,20 @@ void parse_verilog_file_selective(const std::string& filepath, DesignDatabase& d
 void parse_def_file(const std::string& filepath, DesignDatabase& db) {
     std::cout << "  Parsing: " << filepath << std::endl;
     
-    std::ifstream file(filepath);
+    InputFile file(filepath);
     if (!file.is_open()) {
         std::cout << "  ERROR: Cannot open " << filepath << std::endl;
         return;
     }
+    if (db.input_def_path.empty()) {
+        db.input_def_path = filepath;
+    }
     
     std::string line;
     int placed_instances = 0;
     int rows_parsed = 0;
     int tracks_parsed = 0;
+    int obstacle_count = 0;
     bool in_components = false;
     
     while (std::getline(file, line)) {
@@ -1641,12 +1755,17 @@ void parse_def_file(const std::string& filepath, DesignDatabase& db) {
         else if (in_components && (line.find(" - ") == 0 || line.find("- ") == 0)) {
             if (parse_component_line(line, db)) {
                 placed_instances++;
+            } else if (db.out_of_core && record_component_obstacle(line, db)) {
+                obstacle_count++;   // -out_of_core：組合邏輯只留obstacle
             }
         }
     }
     
     file.close();
     std::cout << "    Placed " << placed_instances << " instances" << std::endl;
+    if (db.out_of_core) {
+        std::cout << "    Recorded " << obstacle_count << " combinational obstacles" << std::endl;
+    }
     std::cout << "    Parsed " << rows_parsed << " placement rows" << std::endl;
     std::cout << "    Parsed " << tracks_parsed << " routing tracks" << std::endl;
     std::cout << "    Die area: " << db.die_area.width() << " x " << db.die_area.height() << std::endl;
@@ -1655,7 +1774,7 @@ void parse_def_file(const std::string& filepath, DesignDatabase& db) {
 void parse_weight_file(const std::string& filepath, DesignDatabase& db) {
     std::cout << "  Parsing: " << filepath << std::endl;
     
-    std::ifstream file(filepath);
+    InputFile file(filepath);
     if (!file.is_open()) {
         std::cout << "  ERROR: Cannot open " << filepath << std::endl;
         return;
@@ -2201,7 +2320,7 @@ bool is_same_clock_domain(const std::vector<std::shared_ptr<Instance>>& ff_insta
             // 檢查是否是時鐘pin (CK, CLK等)
             if (conn.pin_name == "CK" || conn.pin_name == "CLK" || 
                 conn.pin_name == "C" || conn.pin_name == "CP") {
-                clock_net = conn.net_name;
+                clock_net = clock_domain_label(db, ff->module_name, conn.net_name);   // 經過clock tree的同一個domain
                 break;
             }
         }
@@ -2263,10 +2382,8 @@ bool check_scan_chain_compatibility(const std::vector<std::shared_ptr<Instance>>
     return true;
 }
 
-double calculate_manhattan_distance(const Instance& ff1, const Instance& ff2) {
-    double dx = std::abs(ff1.position.x - ff2.position.x);
-    double dy = std::abs(ff1.position.y - ff2.position.y);
-    return dx + dy;
+Dbu calculate_manhattan_distance(const Instance& ff1, const Instance& ff2) {
+    return ff1.position.manhattan_to(ff2.position);
 }
 
 // =============================================================================
@@ -2600,67 +2717,75 @@ std::string orientation_to_string(Instance::Orientation orientation) {
 void analyze_ff_pin_connections(DesignDatabase& db) {
     std::cout << "  Analyzing FF pin connection status..." << std::endl;
     
-    int analyzed_ff_count = 0;
-    std::map<std::string, int> pin_status_stats;
-    
+    // 只分析flip-flop instances；每個instance只寫自己的pin_status，可以平行
+    std::vector<Instance*> flip_flops;
     for (auto& inst_pair : db.instances) {
         auto& instance = inst_pair.second;
-        
-        // 只分析flip-flop instances
-        if (!instance->is_flip_flop() || !instance->cell_template) {
-            continue;
+        if (instance->is_flip_flop() && instance->cell_template) {
+            flip_flops.push_back(instance.get());
         }
-        
-        instance->pin_status.clear();
-        
-        // 檢查cell template中的每個pin
-        for (const auto& template_pin : instance->cell_template->pins) {
-            // 跳過電源pins，因為它們不影響兼容性
-            if (template_pin.ff_pin_type == Pin::FF_NOT_FF_PIN) {
-                continue;
-            }
-            
-            // 在instance連線中查找這個pin
-            auto conn = instance->find_connection(template_pin.name);
-            
-            Instance::PinConnectionStatus::Status status;
-            std::string connected_net = "";
-            
-            if (conn == nullptr) {
-                // Pin在verilog中沒有連線，視為missing
-                status = Instance::PinConnectionStatus::MISSING;
-            } else {
-                connected_net = conn->net_name;
+    }
+    
+    typedef std::map<std::string, int> StatusCounts;
+    StatusCounts pin_status_stats = parallel_reduce(0, flip_flops.size(), 0, StatusCounts(),
+        [&flip_flops](size_t begin, size_t end) {
+            StatusCounts counts;
+            for (size_t i = begin; i < end; i++) {
+                Instance* instance = flip_flops[i];
+                instance->pin_status.clear();
                 
-                if (is_unconnected_net(connected_net)) {
-                    status = Instance::PinConnectionStatus::UNCONNECTED;
-                } else if (is_ground_net(connected_net)) {
-                    status = Instance::PinConnectionStatus::TIED_TO_GROUND;
-                } else if (is_power_net(connected_net)) {
-                    status = Instance::PinConnectionStatus::TIED_TO_POWER;
-                } else {
-                    status = Instance::PinConnectionStatus::CONNECTED;
+                // 檢查cell template中的每個pin
+                for (const auto& template_pin : instance->cell_template->pins) {
+                    // 跳過電源pins，因為它們不影響兼容性
+                    if (template_pin.ff_pin_type == Pin::FF_NOT_FF_PIN) {
+                        continue;
+                    }
+                    
+                    // 在instance連線中查找這個pin
+                    auto conn = instance->find_connection(template_pin.name);
+                    
+                    Instance::PinConnectionStatus::Status status;
+                    std::string connected_net = "";
+                    
+                    if (conn == nullptr) {
+                        // Pin在verilog中沒有連線，視為missing
+                        status = Instance::PinConnectionStatus::MISSING;
+                    } else {
+                        connected_net = conn->net_name;
+                        
+                        if (is_unconnected_net(connected_net)) {
+                            status = Instance::PinConnectionStatus::UNCONNECTED;
+                        } else if (is_ground_net(connected_net)) {
+                            status = Instance::PinConnectionStatus::TIED_TO_GROUND;
+                        } else if (is_power_net(connected_net)) {
+                            status = Instance::PinConnectionStatus::TIED_TO_POWER;
+                        } else {
+                            status = Instance::PinConnectionStatus::CONNECTED;
+                        }
+                    }
+                    
+                    instance->pin_status.emplace_back(template_pin.name, status, connected_net);
+                    
+                    // 統計狀態
+                    std::string status_name;
+                    switch (status) {
+                        case Instance::PinConnectionStatus::CONNECTED: status_name = "CONNECTED"; break;
+                        case Instance::PinConnectionStatus::UNCONNECTED: status_name = "UNCONNECTED"; break;
+                        case Instance::PinConnectionStatus::TIED_TO_GROUND: status_name = "TIED_TO_GROUND"; break;
+                        case Instance::PinConnectionStatus::TIED_TO_POWER: status_name = "TIED_TO_POWER"; break;
+                        case Instance::PinConnectionStatus::MISSING: status_name = "MISSING"; break;
+                    }
+                    counts[status_name]++;
                 }
             }
-            
-            instance->pin_status.emplace_back(template_pin.name, status, connected_net);
-            
-            // 統計狀態
-            std::string status_name;
-            switch (status) {
-                case Instance::PinConnectionStatus::CONNECTED: status_name = "CONNECTED"; break;
-                case Instance::PinConnectionStatus::UNCONNECTED: status_name = "UNCONNECTED"; break;
-                case Instance::PinConnectionStatus::TIED_TO_GROUND: status_name = "TIED_TO_GROUND"; break;
-                case Instance::PinConnectionStatus::TIED_TO_POWER: status_name = "TIED_TO_POWER"; break;
-                case Instance::PinConnectionStatus::MISSING: status_name = "MISSING"; break;
-            }
-            pin_status_stats[status_name]++;
-        }
-        
-        analyzed_ff_count++;
-    }
-    
-    std::cout << "    Analyzed pin connections for " << analyzed_ff_count << " flip-flops" << std::endl;
+            return counts;
+        },
+        [](StatusCounts total, StatusCounts partial) {
+            for (const auto& pair : partial) total[pair.first] += pair.second;
+            return total;
+        });
+    
+    std::cout << "    Analyzed pin connections for " << flip_flops.size() << " flip-flops" << std::endl;
     std::cout << "    Pin status distribution:" << std::endl;
     for (const auto& pair : pin_status_stats) {
         std::cout << "      " << pair.first << ": " << pair.second << " pins" << std::endl;
@@ -2671,9 +2796,104 @@ void analyze_ff_pin_connections(DesignDatabase& db) {
 // SCANDEF PARSER IMPLEMENTATION
 // =============================================================================
 
-void parse_scandef_section(std::ifstream& file, DesignDatabase& db) {
+namespace {
+
+bool is_scandef_keyword(const std::string& token) {
+    return token == "+" || token == ";" || token == "START" || token == "STOP" || token == "FLOATING" ||
+           token == "ORDERED" || token == "PARTITION" || token == "COMMONSCANPINS" || token == "(";
+}
+
+// "- NAME ..." statement (tokens up to ';') -> ScanChain
+// 支援DEF 5.8語法：
+//   - chain + COMMONSCANPINS ( IN SI ) ( OUT Q ) + START PIN si | + START inst pin
+//     + FLOATING inst ( IN SI ) ( OUT Q ) ... + ORDERED inst ... + PARTITION p MAXBITS n + STOP PIN so ;
+// 以及舊的簡化格式：- CHAIN START PIN STOP PIN / ( INST ( SI PIN ) ( SO PIN ) ) / ;
+ScanChain parse_scandef_chain(const std::vector<std::string>& tokens, int& next_segment) {
+    ScanChain chain;
+    chain.from_def = true;
+    if (tokens.size() > 1) chain.name = tokens[1];
+    std::string common_in = "SI", common_out;
+    int segment = -1;   // 目前的ORDERED list (-1 = FLOATING)
+
+    // "( KEY pin )" groups after an instance (or after COMMONSCANPINS)
+    auto read_pin_groups = [&](size_t& i, std::string& in_pin, std::string& out_pin) {
+        while (i + 3 < tokens.size() && tokens[i] == "(" && tokens[i + 3] == ")") {
+            const std::string& key = tokens[i + 1];
+            if (key == "IN" || key == "SI") in_pin = tokens[i + 2];
+            else if (key == "OUT" || key == "SO") out_pin = tokens[i + 2];
+            i += 4;
+        }
+    };
+    // START / STOP: "PIN name", "inst pin" 或舊格式的單一pin名稱
+    auto read_endpoint = [&](size_t& i, std::string& instance, std::string& pin) {
+        if (i >= tokens.size()) return;
+        if (tokens[i] == "PIN" && i + 1 < tokens.size()) {
+            pin = tokens[i + 1];
+            i += 2;
+        } else if (i + 1 < tokens.size() && !is_scandef_keyword(tokens[i + 1])) {
+            instance = tokens[i];
+            pin = tokens[i + 1];
+            i += 2;
+        } else {
+            pin = tokens[i];
+            i += 1;
+        }
+    };
+
+    size_t i = 2;
+    while (i < tokens.size()) {
+        const std::string& token = tokens[i];
+        if (token == "+" || token == ";") {
+            i++;
+        } else if (token == "START") {
+            i++;
+            read_endpoint(i, chain.start_instance, chain.scan_in_pin);
+        } else if (token == "STOP") {
+            i++;
+            read_endpoint(i, chain.stop_instance, chain.scan_out_pin);
+        } else if (token == "FLOATING") {
+            segment = -1;
+            i++;
+        } else if (token == "ORDERED") {
+            segment = next_segment++;
+            i++;
+        } else if (token == "PARTITION") {
+            if (i + 1 < tokens.size()) chain.partition = tokens[i + 1];
+            i += 2;
+            if (i + 1 < tokens.size() && tokens[i] == "MAXBITS") {
+                chain.max_bits = std::atoi(tokens[i + 1].c_str());
+                i += 2;
+            }
+        } else if (token == "COMMONSCANPINS") {
+            i++;
+            read_pin_groups(i, common_in, common_out);
+        } else if (token == "(") {
+            // 舊格式：( INST ( SI PIN ) ( SO PIN ) )
+            if (i + 1 >= tokens.size()) break;
+            std::string instance = tokens[i + 1];
+            std::string in_pin = common_in, out_pin = common_out;
+            i += 2;
+            read_pin_groups(i, in_pin, out_pin);
+            if (i < tokens.size() && tokens[i] == ")") i++;
+            chain.chain_sequence.emplace_back(instance, in_pin, out_pin, segment);
+        } else {
+            // FLOATING / ORDERED element：inst ( IN pin ) ( OUT pin ) ( BITS n )
+            std::string in_pin = common_in, out_pin = common_out;
+            i++;
+            read_pin_groups(i, in_pin, out_pin);
+            chain.chain_sequence.emplace_back(token, in_pin, out_pin, segment);
+        }
+    }
+    return chain;
+}
+
+} // namespace
+
+void parse_scandef_section(std::istream& file, DesignDatabase& db) {
     std::string line;
     int parsed_chains = 0;
+    int next_segment = 0;
+    std::vector<std::string> tokens;
     
     while (std::getline(file, line)) {
         line = trim_whitespace(line);
@@ -2684,63 +2904,29 @@ void parse_scandef_section(std::ifstream& file, DesignDatabase& db) {
             break;
         }
         
-        // 解析單個scan chain定義
-        // 格式：- CHAIN_NAME START PIN_NAME STOP PIN_NAME
-        //      ( INST_NAME ( SI PIN_NAME ) ( SO PIN_NAME ) )
-        //      ( INST_NAME ( SI PIN_NAME ) ( SO PIN_NAME ) ) ...
-        //      ;
-        if (line.find("- ") == 0) {
-            ScanChain chain;
-            
-            // 解析chain header: "- CHAIN_NAME START PIN_NAME STOP PIN_NAME"
-            std::istringstream iss(line);
-            std::string token;
-            iss >> token; // "-"
-            iss >> chain.name; // chain name
-            iss >> token; // "START"
-            iss >> chain.scan_in_pin; // input pin
-            iss >> token; // "STOP"
-            iss >> chain.scan_out_pin; // output pin
-            
-            // 讀取chain中的instance序列
-            bool in_chain_definition = true;
-            while (in_chain_definition && std::getline(file, line)) {
-                line = trim_whitespace(line);
-                
-                if (line == ";") {
-                    in_chain_definition = false;
-                    break;
-                }
-                
-                // 解析instance line: "( INST_NAME ( SI PIN_NAME ) ( SO PIN_NAME ) )"
-                if (line.find("( ") == 0) {
-                    std::istringstream inst_iss(line);
-                    std::string paren, inst_name, si_pin, so_pin;
-                    
-                    inst_iss >> paren; // "("
-                    inst_iss >> inst_name; // instance name
-                    inst_iss >> paren; // "("
-                    inst_iss >> token; // "SI"
-                    inst_iss >> si_pin; // SI pin name
-                    inst_iss >> paren; // ")"
-                    inst_iss >> paren; // "("
-                    inst_iss >> token; // "SO"
-                    inst_iss >> so_pin; // SO pin name
-                    inst_iss >> paren; // ")"
-                    inst_iss >> paren; // ")"
-                    
-                    // 加入到scan chain
-                    chain.chain_sequence.emplace_back(inst_name, si_pin, so_pin);
-                }
+        // 一個chain的statement從"- NAME"開始，到';'結束 (可跨多行)
+        std::istringstream iss(line);
+        std::string token;
+        bool statement_done = false;
+        while (iss >> token) {
+            if (tokens.empty() && token != "-") continue;
+            bool ends = token.size() > 1 && token.back() == ';';
+            if (ends) token.pop_back();
+            tokens.push_back(token);
+            if (token == ";" || ends) {
+                statement_done = true;
+                break;
             }
-            
-            // 加入到資料庫
-            db.scan_chains.push_back(chain);
-            parsed_chains++;
-            
-            std::cout << "      Parsed scan chain: " << chain.name 
-                      << " (length: " << chain.length() << ")" << std::endl;
         }
+        if (!statement_done) continue;
+        
+        ScanChain chain = parse_scandef_chain(tokens, next_segment);
+        tokens.clear();
+        
+        std::cout << "      Parsed scan chain: " << chain.name 
+                  << " (length: " << chain.length() << ")" << std::endl;
+        db.scan_chains.push_back(std::move(chain));
+        parsed_chains++;
     }
     
     std::cout << "    Parsed " << parsed_chains << " scan chains total" << std::endl;
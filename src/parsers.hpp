@@ -12,6 +12,9 @@
 // Liberty parser: 解析.lib檔案，直接添加CellTemplate到db.cell_library
 void parse_liberty_file(const std::string& filepath, DesignDatabase& db);
 
+// 只parse不寫入DB：回傳檔案中依序出現的cells (可平行parse多個檔案再依序合併)
+std::vector<std::shared_ptr<CellTemplate>> parse_liberty_cells(const std::string& filepath);
+
 // LEF parser: 解析.lef檔案，為現有CellTemplate添加物理資訊
 void parse_lef_file(const std::string& filepath, DesignDatabase& db);
 
@@ -64,6 +67,9 @@ bool is_active_logical_connection(const Instance::Connection& conn, Pin::FlipFlo
 std::string orientation_to_string(Instance::Orientation orientation);
 
 // Scan chain detection函數
+// 一次掃過所有instance建 scan out net -> SI pin 的連線，再沿著next pointer串chain
+// (中間可以經過單輸入的non-FF cell，例如buffer / inverter / delay cell)
+#define SCAN_TRACE_MAX_BUFFERS 32     // Longest buffer / inverter path followed between two scan FFs
 void detect_scan_chains(DesignDatabase& db);
 void build_scan_chain_groups(DesignDatabase& db);
 
@@ -80,6 +86,7 @@ void export_strategic_debanking_report(const DesignDatabase& db);
 
 
 // FF grouping結果輸出函數
+// Also builds db.hierarchical_ff_groups; an empty output_file skips the report file
 void export_ff_grouping_report(DesignDatabase& db, const std::string& output_file = "ff_grouping_report.txt");
 
 // FF instance grouping functions
@@ -125,7 +132,7 @@ bool is_same_clock_domain(const std::vector<std::shared_ptr<Instance>>& ff_insta
                          const DesignDatabase& db);
 bool check_scan_chain_compatibility(const std::vector<std::shared_ptr<Instance>>& ff_instances, 
                                    const DesignDatabase& db);
-double calculate_manhattan_distance(const Instance& ff1, const Instance& ff2);
+Dbu calculate_manhattan_distance(const Instance& ff1, const Instance& ff2);
 
 // FF兼容性檢查函數
 bool check_ff_compatibility(const std::shared_ptr<Instance>& ff1, 
@@ -155,20 +162,16 @@ void record_keep_transformation(DesignDatabase& db, std::shared_ptr<Instance> or
 void record_substitute_transformation(DesignDatabase& db, const std::string& instance_name, const std::string& original_cell_type, const std::string& final_cell_type);
 void record_substitution_transformation_complete(DesignDatabase& db, const std::string& instance_name, const std::string& original_cell_type, const std::string& final_cell_type);
 void record_debank_transformation(DesignDatabase& db, std::shared_ptr<Instance> original_multibit_instance, const std::vector<std::shared_ptr<Instance>>& resulting_singlebit_instances, const std::string& parent_cell_type);
-void record_all_debank_pin_mappings_from_record(const TransformationRecord& debank_record);
-
-// Forward declaration for SimpleTransformationChain
-struct SimpleTransformationChain;
-
-// Simple Pin Mapping functions and data
-extern std::map<std::string, std::string> global_debank_pin_mappings;
-std::map<std::string, SimpleTransformationChain> build_simple_transformation_chains(const DesignDatabase& db);
-std::vector<std::string> generate_pin_mapping_for_chain(const SimpleTransformationChain& chain, const DesignDatabase& db);
-void record_bank_transformation(DesignDatabase& db, const std::vector<std::shared_ptr<Instance>>& original_singlebit_ffs, const std::string& resulting_multibit_name, const std::string& multibit_cell_type, const std::map<std::string, std::string>& pin_mapping);
+void record_bank_transformation(DesignDatabase& db, const std::vector<std::shared_ptr<Instance>>& original_singlebit_ffs, const std::string& resulting_multibit_name, const std::string& multibit_cell_type);
 void record_legalization_transformations(DesignDatabase& db);
 void remove_keep_transformation_record(DesignDatabase& db, const std::string& instance_name);
 
 // Banking functions
+std::vector<std::vector<std::shared_ptr<Instance>>>
+simple_distance_clustering(const std::vector<std::shared_ptr<Instance>>& instances,
+                           int target_cluster_size,
+                           double max_distance_threshold);
+size_t banking_group_limit(const DesignDatabase& db, size_t group_count);
 void execute_banking_preparation(DesignDatabase& db);
 void assign_banking_types(DesignDatabase& db);
 void export_banking_preparation_report(DesignDatabase& db, const std::string& output_file);
@@ -188,7 +191,8 @@ void generate_pin_mapping_list_file(const DesignDatabase& db, const std::string&
 void generate_final_def_file(const DesignDatabase& db, const std::string& output_file);
 void generate_final_verilog_file(const DesignDatabase& db, const std::string& output_file);
 
-// Simple pin mapping system (no DEBANK version)
+// Pin mapping system (driven by db.pin_provenance)
+int write_pin_mapping_entries(const DesignDatabase& db, std::ostream& out);
 void generate_simple_pin_mapping_file(const DesignDatabase& db, const std::string& output_file);
 void export_simple_transformation_chains_report(const DesignDatabase& db, const std::string& output_file);
 
@@ -213,6 +217,9 @@ void export_transformation_verification_report(const DesignDatabase& db, const s
 // HELPER FUNCTION DECLARATIONS
 // =============================================================================
 
+// Liberty parser helpers
+void parse_cell_properties(CellTemplate& cell, const std::string& cell_block);
+
 // Verilog parser helpers
 std::string extract_module_name(const std::string& content);
 void parse_module_hierarchy(const std::string& file_content, DesignDatabase& db);
@@ -225,14 +232,16 @@ std::string clean_net_name(const std::string& raw_name);
 std::pair<std::string, std::string> parse_pin_connection(const std::string& conn_str);
 std::shared_ptr<Instance> parse_verilog_instance(const std::string& content, size_t start_pos, std::set<std::string>& net_names);
 void build_net_connections(DesignDatabase& db);
+bool is_power_net(const std::string& net_name);
+bool is_ground_net(const std::string& net_name);
 
 // DEF parser helpers
 void parse_diearea_line(const std::string& line, DesignDatabase& db);
 void parse_track_line(const std::string& line, DesignDatabase& db);
 void parse_row_line(const std::string& line, DesignDatabase& db);
 bool parse_component_line(const std::string& line, DesignDatabase& db);
-void parse_scandef_section(std::ifstream& file, DesignDatabase& db);
-void parse_nets_section(std::ifstream& file, DesignDatabase& db);
-void parse_blockages_section(std::ifstream& file, DesignDatabase& db);
-void parse_specialnets_section(std::ifstream& file, DesignDatabase& db);
+void parse_scandef_section(std::istream& file, DesignDatabase& db);
+void parse_nets_section(std::istream& file, DesignDatabase& db);
+void parse_blockages_section(std::istream& file, DesignDatabase& db);
+void parse_specialnets_section(std::istream& file, DesignDatabase& db);
 bool parse_rect_line(const std::string& line, Rectangle& rect);
\ No newline at end of file
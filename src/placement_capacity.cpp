@@ -0,0 +1,134 @@
+#include "placement_capacity.hpp"
+#include "out_of_core.hpp"
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+// =============================================================================
+// BUILD: row gaps -> bins
+// =============================================================================
+
+RowGapCapacity::RowGapCapacity(const DesignDatabase& db) {
+    const auto& rows = db.placement_rows;
+    if (rows.empty()) return;
+
+    // Row依y排序，obstacle用binary search找重疊的row
+    std::vector<size_t> order(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(),
+              [&rows](size_t a, size_t b) { return rows[a].origin.y < rows[b].origin.y; });
+    std::vector<Dbu> row_y(rows.size());
+    Dbu max_height = 1;
+    Dbu x_max = std::numeric_limits<Dbu>::min(), y_max = std::numeric_limits<Dbu>::min();
+    x0_ = std::numeric_limits<Dbu>::max();
+    y0_ = std::numeric_limits<Dbu>::max();
+    for (size_t k = 0; k < order.size(); ++k) {
+        const PlacementRow& row = rows[order[k]];
+        Dbu height = row.height > 0 ? row.height : std::max<Dbu>(1, row.step_y);
+        row_y[k] = row.origin.y;
+        max_height = std::max(max_height, height);
+        x0_ = std::min(x0_, row.origin.x);
+        y0_ = std::min(y0_, row.origin.y);
+        x_max = std::max(x_max, row.origin.x + row.step_x * row.num_x);
+        y_max = std::max(y_max, row.origin.y + height);
+    }
+    const PlacementRow& first = rows[order[0]];
+    site_ = first.site_width > 0 ? first.site_width : std::max<Dbu>(1, first.step_x);
+
+    std::vector<std::vector<std::pair<Dbu, Dbu>>> cuts(rows.size());   // per sorted row: [x1, x2)
+    auto add_obstacle = [&](Dbu x1, Dbu y1, Dbu x2, Dbu y2) {
+        size_t k = std::lower_bound(row_y.begin(), row_y.end(), y1 - max_height + 1) - row_y.begin();
+        for (; k < row_y.size() && row_y[k] < y2; ++k) {
+            const PlacementRow& row = rows[order[k]];
+            Dbu height = row.height > 0 ? row.height : std::max<Dbu>(1, row.step_y);
+            if (row.origin.y + height > y1) cuts[k].emplace_back(x1, x2);
+        }
+    };
+    for (const auto& pair : db.instances) {
+        const auto& instance = pair.second;
+        if (instance->is_flip_flop() || !instance->cell_template) continue;
+        add_obstacle(instance->position.x, instance->position.y,
+                     instance->position.x + instance->cell_template->width,
+                     instance->position.y + instance->cell_template->height);
+    }
+    if (db.out_of_core) {
+        const ObstacleRecord* obstacles = db.out_of_core->obstacles();
+        for (size_t i = 0; i < db.out_of_core->obstacle_count(); ++i) {
+            add_obstacle(obstacles[i].x, obstacles[i].y,
+                         obstacles[i].x + obstacles[i].width, obstacles[i].y + obstacles[i].height);
+        }
+    }
+    for (const auto& rect : db.placement_blockages) add_obstacle(rect.x1, rect.y1, rect.x2, rect.y2);
+
+    nx_ = static_cast<int>(ceil_div(std::max<Dbu>(1, x_max - x0_), BANKING_CAPACITY_BIN_SIZE));
+    ny_ = static_cast<int>(ceil_div(std::max<Dbu>(1, y_max - y0_), BANKING_CAPACITY_BIN_SIZE));
+    bins_.assign(static_cast<size_t>(nx_) * ny_, std::vector<Dbu>());
+
+    // 每條row：obstacle之間的空隙 (和Legalizer::cutRow一樣對齊site)，依中點放進bin
+    for (size_t k = 0; k < order.size(); ++k) {
+        const PlacementRow& row = rows[order[k]];
+        Dbu site = row.site_width > 0 ? row.site_width : std::max<Dbu>(1, row.step_x);
+        Dbu row_end = row.origin.x + row.step_x * row.num_x;
+        auto& row_cuts = cuts[k];
+        std::sort(row_cuts.begin(), row_cuts.end());
+        Dbu cursor = row.origin.x;
+        auto close_gap = [&](Dbu end) {
+            if (end - cursor >= site) bins_[bin_of(cursor + (end - cursor) / 2, row.origin.y)].push_back(end - cursor);
+        };
+        for (const auto& cut : row_cuts) {
+            Dbu front = row.origin.x + floor_div(cut.first - row.origin.x, site) * site;
+            Dbu back = row.origin.x + ceil_div(cut.second - row.origin.x, site) * site;
+            if (front > cursor) close_gap(std::min(front, row_end));
+            cursor = std::max(cursor, back);
+            if (cursor >= row_end) break;
+        }
+        if (row_end > cursor) close_gap(row_end);
+    }
+
+    // 已經存在的wide FF (沒被debank的MBFF、前一個phase做出的cell) 先預留
+    for (const auto& pair : db.instances) {
+        const auto& instance = pair.second;
+        if (!instance->is_flip_flop() || !instance->cell_template) continue;
+        reserve(instance->position, instance->cell_template->width, instance->get_bit_width());
+    }
+    refused_ = 0;
+}
+
+// =============================================================================
+// RESERVE
+// =============================================================================
+
+int RowGapCapacity::bin_of(Dbu x, Dbu y) const {
+    int bx = static_cast<int>(std::min<Dbu>(nx_ - 1, std::max<Dbu>(0, floor_div(x - x0_, BANKING_CAPACITY_BIN_SIZE))));
+    int by = static_cast<int>(std::min<Dbu>(ny_ - 1, std::max<Dbu>(0, floor_div(y - y0_, BANKING_CAPACITY_BIN_SIZE))));
+    return by * nx_ + bx;
+}
+
+// Best fit：夠寬的空隙裡最短的一段，扣掉width
+bool RowGapCapacity::take(int bin, Dbu width) {
+    auto& gaps = bins_[bin];
+    size_t best = gaps.size();
+    for (size_t i = 0; i < gaps.size(); ++i) {
+        if (gaps[i] >= width && (best == gaps.size() || gaps[i] < gaps[best])) best = i;
+    }
+    if (best == gaps.size()) return false;
+    gaps[best] -= width;
+    return true;
+}
+
+bool RowGapCapacity::reserve(const Point& center, Dbu width, int bits) {
+    if (!limited() || bits < BANKING_CAPACITY_MIN_BITS) return true;
+    Dbu needed = ceil_div(width, site_) * site_;
+    int home = bin_of(center.x, center.y);
+    if (take(home, needed)) return true;
+    int hx = home % nx_, hy = home / nx_;
+    for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            int bx = hx + dx, by = hy + dy;
+            if ((dx == 0 && dy == 0) || bx < 0 || by < 0 || bx >= nx_ || by >= ny_) continue;
+            if (take(by * nx_ + bx, needed)) return true;
+        }
+    }
+    refused_++;
+    return false;
+}
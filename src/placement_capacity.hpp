@@ -0,0 +1,49 @@
+#ifndef PLACEMENT_CAPACITY_HPP
+#define PLACEMENT_CAPACITY_HPP
+
+#include "data_structures.hpp"
+#include <vector>
+
+// =============================================================================
+// ROW GAP CAPACITY FOR WIDE MBFFs (Step 18)
+// =============================================================================
+// Legalization只移動FF：組合邏輯cell、placement blockage (和-out_of_core的obstacle)
+// 把每條row切成一段段空隙，4-bit MBFF需要一段夠寬的連續空隙。banking不看空隙時，
+// 密的design會做出比空隙還多的4-bit cell，Abacus放不下只能留在原位 (off-row / overlap)
+//   1. 每條row扣掉obstacle後的空隙 (site對齊)，依空隙中點分到 BANKING_CAPACITY_BIN_SIZE 的bin
+//   2. db裡已經有的wide FF (>= BANKING_CAPACITY_MIN_BITS bits) 先在它的位置預留
+//   3. banking每做一個wide cell之前，在中心所在的bin (沒有就周圍8個bin) 找最小的
+//      夠寬空隙 (best fit) 扣掉cell寬度；找不到就不做這個cell (member保持原本的bit數)
+// 每個banking phase開始時重建 (已經做出的wide cell由第2步扣掉)
+// 沒有placement row時 (banking tile worker) 不限制
+// =============================================================================
+
+#define BANKING_CAPACITY_BIN_SIZE 20000     // Gap bin edge (DBU); a wide cell may use its own bin or the 8 around it
+#define BANKING_CAPACITY_MIN_BITS 4         // FFs with at least this many bits need a reserved gap
+
+class RowGapCapacity {
+public:
+    explicit RowGapCapacity(const DesignDatabase& db);
+
+    // Reserve a gap for a `bits`-bit cell of `width` near `center`; false when no nearby bin has room
+    // (cells narrower than BANKING_CAPACITY_MIN_BITS bits always succeed)
+    bool reserve(const Point& center, Dbu width, int bits);
+
+    // Wide cells refused so far
+    int refused() const { return refused_; }
+
+    // false when the design has no placement rows (no limit)
+    bool limited() const { return !bins_.empty(); }
+
+private:
+    Dbu x0_ = 0, y0_ = 0;
+    int nx_ = 0, ny_ = 0;
+    Dbu site_ = 1;
+    std::vector<std::vector<Dbu>> bins_;   // free gap lengths per bin (row-major)
+    int refused_ = 0;
+
+    int bin_of(Dbu x, Dbu y) const;
+    bool take(int bin, Dbu width);
+};
+
+#endif // PLACEMENT_CAPACITY_HPP
@@ -0,0 +1,222 @@
+#include "profiler.hpp"
+#include "trace_recorder.hpp"
+#include <fstream>
+#include <iomanip>
+#include <sys/resource.h>
+
+// =============================================================================
+// STAGE PROFILER IMPLEMENTATION
+// =============================================================================
+
+namespace {
+thread_local std::vector<int> tls_scope_stack;   // Open scopes of the calling thread
+}
+
+StageProfiler& StageProfiler::instance() {
+    static StageProfiler profiler;
+    return profiler;
+}
+
+double StageProfiler::process_cpu_ms() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+}
+
+long StageProfiler::peak_rss_kb() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return usage.ru_maxrss;  // Linux: kilobytes
+}
+
+int StageProfiler::enter(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<int>& stack = tls_scope_stack;
+    int parent = stack.empty() ? -1 : stack.back();
+    const std::vector<int>& siblings = (parent == -1) ? roots_ : nodes_[parent].children;
+
+    // 同一個parent底下同名的scope合併
+    int node_id = -1;
+    for (int sibling : siblings) {
+        if (nodes_[sibling].name == name) {
+            node_id = sibling;
+            break;
+        }
+    }
+
+    if (node_id == -1) {
+        ProfileNode node;
+        node.name = name;
+        node.parent = parent;
+        node.depth = static_cast<int>(stack.size());
+        node_id = static_cast<int>(nodes_.size());
+        nodes_.push_back(node);
+        if (parent == -1) {
+            roots_.push_back(node_id);
+        } else {
+            nodes_[parent].children.push_back(node_id);
+        }
+    }
+
+    stack.push_back(node_id);
+    return node_id;
+}
+
+void StageProfiler::leave(int node_id, double wall_ms, double cpu_ms,
+                          long rss_before_kb, long rss_after_kb, long items) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<int>& stack = tls_scope_stack;
+    ProfileNode& node = nodes_[node_id];
+    node.calls++;
+    node.wall_ms += wall_ms;
+    node.cpu_ms += cpu_ms;
+    node.peak_rss_delta_kb += rss_after_kb - rss_before_kb;
+    node.peak_rss_kb = rss_after_kb;
+    node.items += items;
+
+    if (!stack.empty() && stack.back() == node_id) {
+        stack.pop_back();
+    }
+}
+
+void StageProfiler::print_node(std::ostream& out, int node_id) const {
+    const ProfileNode& node = nodes_[node_id];
+    std::string label = std::string(node.depth * 2, ' ') + node.name;
+    if (label.size() > 44) label = label.substr(0, 41) + "...";
+
+    out << std::left << std::setw(44) << label << std::right
+        << std::setw(7) << node.calls
+        << std::fixed << std::setprecision(1)
+        << std::setw(12) << node.wall_ms
+        << std::setw(12) << node.cpu_ms
+        << std::setw(11) << node.peak_rss_delta_kb / 1024.0
+        << std::setw(12) << node.items << std::endl;
+
+    for (int child : node.children) {
+        print_node(out, child);
+    }
+}
+
+void StageProfiler::print_summary(std::ostream& out) const {
+    double total_wall = 0.0;
+    double total_cpu = 0.0;
+    for (int root : roots_) {
+        total_wall += nodes_[root].wall_ms;
+        total_cpu += nodes_[root].cpu_ms;
+    }
+
+    out << "\n=== STAGE PROFILE ===" << std::endl;
+    out << std::left << std::setw(44) << "Stage" << std::right
+        << std::setw(7) << "Calls"
+        << std::setw(12) << "Wall(ms)"
+        << std::setw(12) << "CPU(ms)"
+        << std::setw(11) << "RSS+(MB)"
+        << std::setw(12) << "Items" << std::endl;
+    out << std::string(98, '-') << std::endl;
+
+    for (int root : roots_) {
+        print_node(out, root);
+    }
+
+    out << std::string(98, '-') << std::endl;
+    out << std::left << std::setw(44) << "Total (profiled steps)" << std::right
+        << std::setw(7) << ""
+        << std::fixed << std::setprecision(1)
+        << std::setw(12) << total_wall
+        << std::setw(12) << total_cpu
+        << std::setw(11) << peak_rss_kb() / 1024.0 << std::endl;
+    out << "(RSS+ = growth of peak RSS; last column of Total = overall peak RSS in MB)" << std::endl;
+}
+
+static std::string json_escape(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\t': escaped += "\\t"; break;
+            default: escaped += c; break;
+        }
+    }
+    return escaped;
+}
+
+void StageProfiler::write_json_node(std::ostream& out, int node_id, int indent) const {
+    const ProfileNode& node = nodes_[node_id];
+    std::string pad(indent, ' ');
+
+    out << pad << "{\"name\": \"" << json_escape(node.name) << "\""
+        << ", \"calls\": " << node.calls
+        << std::fixed << std::setprecision(3)
+        << ", \"wall_ms\": " << node.wall_ms
+        << ", \"cpu_ms\": " << node.cpu_ms
+        << ", \"peak_rss_delta_kb\": " << node.peak_rss_delta_kb
+        << ", \"peak_rss_kb\": " << node.peak_rss_kb
+        << ", \"items\": " << node.items
+        << ", \"children\": [";
+
+    if (node.children.empty()) {
+        out << "]}";
+        return;
+    }
+
+    out << "\n";
+    for (size_t i = 0; i < node.children.size(); i++) {
+        write_json_node(out, node.children[i], indent + 2);
+        out << (i + 1 < node.children.size() ? ",\n" : "\n");
+    }
+    out << pad << "]}";
+}
+
+bool StageProfiler::export_json(const std::string& filename) const {
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot open " << filename << " for writing" << std::endl;
+        return false;
+    }
+
+    out << "{\n  \"peak_rss_kb\": " << peak_rss_kb() << ",\n  \"stages\": [\n";
+    for (size_t i = 0; i < roots_.size(); i++) {
+        write_json_node(out, roots_[i], 4);
+        out << (i + 1 < roots_.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    return true;
+}
+
+// =============================================================================
+// SCOPED TIMER
+// =============================================================================
+
+ScopedTimer::ScopedTimer(const std::string& name)
+    : node_id_(StageProfiler::instance().enter(name)),
+      wall_start_(std::chrono::steady_clock::now()),
+      cpu_start_ms_(StageProfiler::process_cpu_ms()),
+      rss_start_kb_(StageProfiler::peak_rss_kb()),
+      items_(0),
+      trace_name_(nullptr) {
+    TraceRecorder& recorder = TraceRecorder::instance();
+    if (recorder.enabled()) {
+        trace_name_ = recorder.intern(name);
+        recorder.begin(trace_name_);
+    }
+}
+
+ScopedTimer::~ScopedTimer() {
+    double wall_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - wall_start_).count();
+    double cpu_ms = StageProfiler::process_cpu_ms() - cpu_start_ms_;
+    long rss_end_kb = StageProfiler::peak_rss_kb();
+    StageProfiler::instance().leave(node_id_, wall_ms, cpu_ms,
+                                    rss_start_kb_, rss_end_kb, items_);
+
+    if (trace_name_) {
+        TraceRecorder& recorder = TraceRecorder::instance();
+        recorder.end(trace_name_);
+        static const char* rss_counter = recorder.intern("peak_rss_mb");
+        recorder.counter(rss_counter, rss_end_kb / 1024.0);
+    }
+}
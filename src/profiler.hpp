@@ -0,0 +1,85 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+
+// =============================================================================
+// HIERARCHICAL STAGE PROFILER
+// =============================================================================
+// ScopedTimer在建構/解構時記錄 wall time、CPU time、peak RSS 增量和 item 數
+// 同一個parent底下同名的scope會合併 (calls累加)，例如每個liberty檔各算一次
+// 結束時輸出summary table，並可輸出JSON (-profile <file>) 供跨版本比較
+// 開啟 -trace 時同一組scope也會送到TraceRecorder (Chrome trace begin/end)
+// 每個thread有自己的scope stack (task graph的stage在worker上開的scope成為root)
+// =============================================================================
+
+struct ProfileNode {
+    std::string name;
+    int parent = -1;
+    int depth = 0;
+    long calls = 0;
+    double wall_ms = 0.0;
+    double cpu_ms = 0.0;                 // Process CPU time (all threads)
+    long peak_rss_delta_kb = 0;          // Growth of peak RSS while this scope was open
+    long peak_rss_kb = 0;                // Peak RSS when the scope last closed
+    long items = 0;                      // Caller-defined work count (instances, FFs, lines ...)
+    std::vector<int> children;
+};
+
+class StageProfiler {
+public:
+    static StageProfiler& instance();
+
+    // Scope bookkeeping (used by ScopedTimer)
+    int enter(const std::string& name);
+    void leave(int node_id, double wall_ms, double cpu_ms, long rss_before_kb, long rss_after_kb, long items);
+
+    void print_summary(std::ostream& out) const;
+    bool export_json(const std::string& filename) const;
+
+    const std::vector<ProfileNode>& nodes() const { return nodes_; }
+    const std::vector<int>& roots() const { return roots_; }
+
+    static double process_cpu_ms();
+    static long peak_rss_kb();
+
+private:
+    StageProfiler() = default;
+
+    void print_node(std::ostream& out, int node_id) const;
+    void write_json_node(std::ostream& out, int node_id, int indent) const;
+
+    mutable std::mutex mutex_;           // enter/leave may run on several threads
+    std::vector<ProfileNode> nodes_;
+    std::vector<int> roots_;
+};
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const std::string& name);
+    ~ScopedTimer();
+
+    void add_items(long count) { items_ += count; }
+    void set_items(long count) { items_ = count; }
+
+private:
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    int node_id_;
+    std::chrono::steady_clock::time_point wall_start_;
+    double cpu_start_ms_;
+    long rss_start_kb_;
+    long items_;
+    const char* trace_name_;             // Non-null while a trace begin event is open
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ScopedTimer PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+
+#endif // PROFILER_HPP
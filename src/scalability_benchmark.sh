@@ -0,0 +1,116 @@
+#!/bin/bash
+# =============================================================================
+# SCALABILITY BENCHMARK
+# =============================================================================
+# 對每個size產生synthetic design，跑完整flow (-profile)，收集每個step的
+# wall time / CPU time / peak RSS，輸出CSV並估計每個step的scaling exponent
+# (t ~ n^k，用最小和最大size估)，k > 1.5 標成SUPERLINEAR，用來抓O(n^2)路徑
+#
+# Usage:
+#   ./scalability_benchmark.sh [ff_bits ...]         (default: 10000 50000 100000 200000)
+# Environment:
+#   BENCH_DIR   output directory (default: ../benchmark)
+#   GEN_ARGS    extra synthetic_design_generator options (e.g. "-multibit 0.3 -clocks 4")
+#   TIMEOUT     per-run timeout in seconds (default: 3600)
+# =============================================================================
+
+set -u
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+BENCH_DIR="${BENCH_DIR:-$SCRIPT_DIR/../benchmark}"
+GEN_ARGS="${GEN_ARGS:-}"
+TIMEOUT="${TIMEOUT:-3600}"
+GENERATOR="$SCRIPT_DIR/synthetic_design_generator"
+FLOW="$SCRIPT_DIR/cadb_1060_final"
+
+if [ $# -gt 0 ]; then
+    SIZES="$*"
+else
+    SIZES="10000 50000 100000 200000"
+fi
+
+for tool in "$GENERATOR" "$FLOW"; do
+    if [ ! -x "$tool" ]; then
+        echo "Error: $tool not built (run: make all generator)"
+        exit 1
+    fi
+done
+
+mkdir -p "$BENCH_DIR"
+BENCH_DIR="$(cd "$BENCH_DIR" && pwd)"
+CSV="$BENCH_DIR/scaling.csv"
+echo "ff_bits,stage,wall_ms,cpu_ms,peak_rss_kb" > "$CSV"
+
+echo "=== Scalability benchmark: sizes [$SIZES] ==="
+for size in $SIZES; do
+    design_dir="$BENCH_DIR/ff$size"
+    echo ""
+    echo "📦 ff_bits=$size"
+    "$GENERATOR" -ff "$size" -out "$design_dir" $GEN_ARGS > "$design_dir.gen.log" 2>&1 || {
+        echo "  ❌ generator failed (see $design_dir.gen.log)"
+        continue
+    }
+
+    start=$(date +%s.%N)
+    (cd "$design_dir" && timeout "$TIMEOUT" "$FLOW" $(cat run_args) -out "ff$size" \
+        -profile profile.json -quiet > flow.log 2>&1)
+    status=$?
+    end=$(date +%s.%N)
+    elapsed=$(awk -v s="$start" -v e="$end" 'BEGIN { printf "%.1f", e - s }')
+
+    if [ $status -ne 0 ] || [ ! -f "$design_dir/profile.json" ]; then
+        echo "  ❌ flow failed or timed out after ${elapsed}s (exit $status, see $design_dir/flow.log)"
+        continue
+    fi
+    echo "  ✓ ${elapsed}s"
+
+    # 只取top-level step (JSON中縮排4格的節點)
+    sed -n 's/^    {"name": "\([^"]*\)", "calls": [0-9]*, "wall_ms": \([0-9.]*\), "cpu_ms": \([0-9.]*\), "peak_rss_delta_kb": -\{0,1\}[0-9]*, "peak_rss_kb": \([0-9]*\).*/\1|\2|\3|\4/p' \
+        "$design_dir/profile.json" |
+        awk -F'|' -v n="$size" '{ gsub(/,/, ";", $1); printf "%s,%s,%s,%s,%s\n", n, $1, $2, $3, $4 }' >> "$CSV"
+done
+
+echo ""
+echo "=== Scaling summary (wall ms; k = log(t_max/t_min) / log(n_max/n_min)) ==="
+awk -F',' '
+    NR == 1 { next }
+    {
+        if (!($1 in seen_size)) { seen_size[$1] = 1; sizes[++size_count] = $1 }
+        if (!($2 in seen_stage)) { seen_stage[$2] = 1; stages[++stage_count] = $2 }
+        wall[$1, $2] = $3
+        if ($5 > peak[$1]) peak[$1] = $5
+    }
+    END {
+        if (size_count == 0) { print "No successful runs."; exit }
+        printf "%-44s", "Stage"
+        for (s = 1; s <= size_count; s++) printf "%12s", sizes[s]
+        printf "%8s\n", "k"
+        for (t = 1; t <= stage_count; t++) {
+            stage = stages[t]
+            label = length(stage) > 43 ? substr(stage, 1, 40) "..." : stage
+            printf "%-44s", label
+            first = ""; last = ""; first_n = 0; last_n = 0
+            for (s = 1; s <= size_count; s++) {
+                key = sizes[s] SUBSEP stage
+                if (key in wall) {
+                    printf "%12.1f", wall[key]
+                    if (first == "") { first = wall[key]; first_n = sizes[s] }
+                    last = wall[key]; last_n = sizes[s]
+                } else {
+                    printf "%12s", "-"
+                }
+            }
+            if (first != "" && first_n != last_n && first >= 5.0 && last > 0) {
+                k = log(last / first) / log(last_n / first_n)
+                printf "%8.2f%s\n", k, (k > 1.5 ? "  SUPERLINEAR" : "")
+            } else {
+                printf "%8s\n", "-"
+            }
+        }
+        printf "%-44s", "Peak RSS (MB)"
+        for (s = 1; s <= size_count; s++) printf "%12.1f", peak[sizes[s]] / 1024.0
+        printf "\n"
+    }' "$CSV"
+
+echo ""
+echo "CSV written to $CSV"
@@ -7,8 +7,12 @@
 
 #include "parsers.hpp"
 #include "timing_repr_hardcoded.hpp"
+#include "logger.hpp"
+#include "out_of_core.hpp"
+#include <deque>
 #include <set>
 #include <queue>
+#include <unordered_set>
 #include <algorithm>
 #include <fstream>
 #include <iomanip>
@@ -17,230 +21,393 @@
 // =============================================================================
 // SCAN CHAIN DETECTION
 // =============================================================================
+// 一次線性掃描：
+//   1. 每個instance的pin依cell template查一次角色 (SI/SE/SO/Q、一般input/output)
+//   2. 每個module建 net -> SI sink / net -> 單輸入non-FF cell 的linked list
+//   3. 每個scan FF從scan out (SO，沒有時Q由最後一個bit往前) 找下一個SI；
+//      經過buffer/inverter的路徑遞迴追，完整追完的結果記在cell上 (不再重追)；
+//      撞到深度上限或cycle而沒找到的cell不記，從較淺的路徑遇到時再追
+//   4. 沒有predecessor的FF是chain head，沿next pointer串成chain
+// net名稱是module內的local名稱，所以lookup都在同一個module內
+// -out_of_core時組合邏輯cell不在db.instances：某個net第一次往下追時，
+// 才從net index讀入net上的單輸入cell (只碰scan path經過的net)
 
-void detect_scan_chains(DesignDatabase& db) {
-    std::cout << "  Detecting scan-capable FFs from netlist connections..." << std::endl;
-    
-    db.scan_chains.clear();
-    
-    // Get all flip-flop instances
-    auto flip_flops = db.get_flip_flops();
-    std::cout << "    Total flip-flops in design: " << flip_flops.size() << std::endl;
-    if (flip_flops.empty()) {
-        std::cout << "    No flip-flops found for scan chain detection" << std::endl;
-        return;
+namespace {
+
+bool is_active_scan_net(const std::string& net) {
+    return !net.empty() && net != "UNCONNECTED" && net.find("SYNOPSYS_UNCONNECTED") == std::string::npos;
+}
+
+enum ScanPinRole { ROLE_NONE, ROLE_SI, ROLE_SE, ROLE_SO, ROLE_Q, ROLE_INPUT, ROLE_OUTPUT };
+
+// 每個cell template的pin角色只算一次
+class PinRoleCache {
+public:
+    ScanPinRole role(const CellTemplate* cell, const std::string& pin_name) {
+        if (cell != last_cell_) {
+            auto it = tables_.find(cell);
+            if (it == tables_.end()) it = tables_.emplace(cell, build(cell)).first;
+            last_cell_ = cell;
+            last_table_ = &it->second;
+        }
+        for (const auto& entry : *last_table_) {
+            if (*entry.first == pin_name) return entry.second;
+        }
+        return ROLE_NONE;
     }
-    
-    // Find all FFs that have scan pins (SI and/or SE)
-    // Note: In this testcase, there are no SO pins, only SI and SE
-    std::vector<std::shared_ptr<Instance>> scan_capable_ffs;
-    int connected_scan_ffs = 0;
-    
-    for (const auto& ff : flip_flops) {
-        bool has_si = false, has_se = false;
-        bool si_connected = false, se_connected = false;
-        
-        // Check if this FF has scan pins and their connection status
-        for (const auto& conn : ff->connections) {
-            Pin::FlipFlopPinType pin_type = classify_ff_pin_type(conn.pin_name);
-            if (pin_type == Pin::FlipFlopPinType::FF_SCAN_INPUT) {
-                has_si = true;
-                if (conn.net_name != "UNCONNECTED" && 
-                    conn.net_name.find("SYNOPSYS_UNCONNECTED") == std::string::npos) {
-                    si_connected = true;
-                }
-            }
-            if (pin_type == Pin::FlipFlopPinType::FF_SCAN_ENABLE) {
-                has_se = true;
-                if (conn.net_name != "UNCONNECTED" && 
-                    conn.net_name.find("SYNOPSYS_UNCONNECTED") == std::string::npos) {
-                    se_connected = true;
+
+private:
+    typedef std::vector<std::pair<const std::string*, ScanPinRole>> Table;
+
+    static Table build(const CellTemplate* cell) {
+        Table table;
+        for (const auto& pin : cell->pins) {
+            ScanPinRole role = ROLE_NONE;
+            if (cell->is_flip_flop()) {
+                switch (classify_ff_pin_type(pin.name)) {
+                    case Pin::FF_SCAN_INPUT: role = ROLE_SI; break;
+                    case Pin::FF_SCAN_ENABLE: role = ROLE_SE; break;
+                    case Pin::FF_SCAN_OUTPUT: role = ROLE_SO; break;
+                    case Pin::FF_DATA_OUTPUT:
+                    case Pin::FF_DATA_OUTPUT_N: role = ROLE_Q; break;
+                    default: break;
                 }
+            } else if (pin.usage != Pin::POWER && pin.usage != Pin::GROUND && pin.usage != Pin::CLOCK) {
+                if (pin.direction == Pin::INPUT) role = ROLE_INPUT;
+                else if (pin.direction == Pin::OUTPUT) role = ROLE_OUTPUT;
             }
+            if (role != ROLE_NONE) table.emplace_back(&pin.name, role);
         }
-        
-        // FF is scan-capable if it has SI and/or SE pins
-        if (has_si || has_se) {
-            scan_capable_ffs.push_back(ff);
-            // Count as actively connected scan FF if either SI or SE is connected
-            if (si_connected || se_connected) {
-                connected_scan_ffs++;
-            }
+        return table;
+    }
+
+    std::unordered_map<const CellTemplate*, Table> tables_;
+    const CellTemplate* last_cell_ = nullptr;
+    const Table* last_table_ = nullptr;
+};
+
+// (module, net名稱指標) 當key，指向Instance::Connection裡的字串，不複製字串
+struct NetKey {
+    int module;
+    const std::string* net;
+};
+struct NetKeyHash {
+    size_t operator()(const NetKey& key) const {
+        return std::hash<std::string>()(*key.net) ^ (static_cast<size_t>(key.module) * 0x9e3779b97f4a7c15ULL);
+    }
+};
+struct NetKeyEqual {
+    bool operator()(const NetKey& a, const NetKey& b) const { return a.module == b.module && *a.net == *b.net; }
+};
+struct NetSinks {
+    int si_head = -1;           // first scan FF whose SI is on the net
+    int buffer_head = -1;       // first single-input cell whose input is on the net
+};
+typedef std::unordered_map<NetKey, NetSinks, NetKeyHash, NetKeyEqual> NetSinkMap;
+
+struct ScanNode {
+    Instance* instance = nullptr;
+    int module = 0;
+    const Instance::Connection* si = nullptr;
+    int next_on_net = -1;       // next scan FF on the same SI net
+    int out_begin = 0, out_end = 0;   // scan out candidates in outputs[]
+    int next = -1, prev = -1;
+    const std::string* scan_out_pin = nullptr;
+};
+
+struct BufferNode {
+    int module = 0;
+    int next_on_net = -1;       // next cell with its input on the same net
+    int out_begin = 0, out_end = 0;
+    int reaches = -2;           // -2 = not traced, -3 = on the current path, -1 = no scan FF, otherwise ScanNode index
+};
+
+struct ScanGraph {
+    NetSinkMap sinks;
+    std::vector<ScanNode> nodes;
+    std::deque<BufferNode> buffers;     // deque：trace中讀入新的buffer時，reference不失效
+    std::vector<const Instance::Connection*> outputs;
+
+    // -out_of_core
+    const DesignDatabase* db = nullptr;
+    PinRoleCache* roles = nullptr;
+    std::vector<size_t> module_index;               // graph module -> db.modules index
+    std::deque<Instance::Connection> spilled_pins;  // Paged-in pins (outputs[] / NetKey point here)
+    std::unordered_set<std::string> paged_nets;     // "module/net" already read from the index
+
+    const NetSinks* find_sinks(int module, const std::string& net_name) {
+        auto it = sinks.find(NetKey{module, &net_name});
+        if (db && (it == sinks.end() || it->second.si_head < 0) &&
+            paged_nets.insert(std::to_string(module) + "/" + net_name).second) {
+            page_in_buffers(module, net_name);
+            it = sinks.find(NetKey{module, &net_name});
         }
+        return it != sinks.end() ? &it->second : nullptr;
     }
-    
-    std::cout << "    Found " << scan_capable_ffs.size() << " scan-capable FFs (with SI/SE pins)" << std::endl;
-    std::cout << "    Found " << connected_scan_ffs << " FFs with active scan connections" << std::endl;
-    
-    // For this testcase, there are no actual scan chains (all scan pins are UNCONNECTED)
-    // So we return early and treat all FFs as non-scan FFs
-    if (connected_scan_ffs == 0) {
-        std::cout << "    No active scan chains detected (all scan pins are UNCONNECTED)" << std::endl;
-        std::cout << "    All FFs will be treated as functional (non-scan) FFs for banking purposes" << std::endl;
-        return;
+
+    // 和pass 1相同的條件：input是這個net的單輸入non-FF cell
+    void page_in_buffers(int module, const std::string& net_name) {
+        for (const SpilledInstance& instance : db->out_of_core->net_instances(net_name, module_index[module])) {
+            std::shared_ptr<CellTemplate> cell = db->get_cell(instance.cell_type);
+            if (!cell || cell->is_flip_flop()) continue;
+            std::vector<const Instance::Connection*> inputs, outs;
+            for (const auto& conn : instance.connections) {
+                if (!is_active_scan_net(conn.net_name)) continue;
+                ScanPinRole role = roles->role(cell.get(), conn.pin_name);
+                if (role == ROLE_INPUT) inputs.push_back(&conn);
+                else if (role == ROLE_OUTPUT) outs.push_back(&conn);
+            }
+            if (inputs.size() != 1 || inputs[0]->net_name != net_name || outs.empty()) continue;
+            BufferNode buffer;
+            buffer.module = module;
+            buffer.out_begin = static_cast<int>(outputs.size());
+            for (const auto* conn : outs) {
+                spilled_pins.push_back(*conn);
+                outputs.push_back(&spilled_pins.back());
+            }
+            buffer.out_end = static_cast<int>(outputs.size());
+            spilled_pins.push_back(*inputs[0]);
+            int index = static_cast<int>(buffers.size());
+            NetSinks& net = sinks[NetKey{module, &spilled_pins.back().net_name}];
+            buffer.next_on_net = net.buffer_head;
+            net.buffer_head = index;
+            buffers.push_back(buffer);
+        }
     }
-    
-    // Performance optimization: if we have too many scan-capable FFs but no actual chains
-    // (likely all connected to the same scan signals), return early after quick check
-    if (scan_capable_ffs.size() > 10000) {
-        std::cout << "    Large design detected (" << scan_capable_ffs.size() << " scan FFs)" << std::endl;
-        std::cout << "    Performing quick scan chain validation..." << std::endl;
-        
-        // Quick check: count unique SI and SE nets
-        std::set<std::string> unique_si_nets, unique_se_nets;
-        for (const auto& ff : scan_capable_ffs) {
-            for (const auto& conn : ff->connections) {
-                Pin::FlipFlopPinType pin_type = classify_ff_pin_type(conn.pin_name);
-                if (pin_type == Pin::FlipFlopPinType::FF_SCAN_INPUT && 
-                    conn.net_name != "UNCONNECTED" && 
-                    conn.net_name.find("SYNOPSYS_UNCONNECTED") == std::string::npos) {
-                    unique_si_nets.insert(conn.net_name);
-                }
-                else if (pin_type == Pin::FlipFlopPinType::FF_SCAN_ENABLE && 
-                         conn.net_name != "UNCONNECTED" && 
-                         conn.net_name.find("SYNOPSYS_UNCONNECTED") == std::string::npos) {
-                    unique_se_nets.insert(conn.net_name);
-                }
+
+    // truncated: 某條路徑撞到深度上限或cycle；這時的 -1 不是完整結果，不memoize
+    int trace_buffer(int b, int depth, bool& truncated) {
+        BufferNode& buffer = buffers[b];
+        if (buffer.reaches == -3 || (buffer.reaches == -2 && depth >= SCAN_TRACE_MAX_BUFFERS)) {
+            truncated = true;
+            return -1;
+        }
+        if (buffer.reaches != -2) return buffer.reaches;
+        buffer.reaches = -3;    // cycle guard
+        bool incomplete = false;
+        int result = -1;
+        for (int o = buffer.out_begin; o < buffer.out_end; o++) {
+            const NetSinks* net = find_sinks(buffer.module, outputs[o]->net_name);
+            if (!net) continue;
+            int reached = trace_sinks(*net, depth + 1, incomplete);
+            if (reached >= 0) {
+                result = reached;
+                break;
             }
         }
-        
-        std::cout << "    Unique SI nets: " << unique_si_nets.size() 
-                  << ", Unique SE nets: " << unique_se_nets.size() << std::endl;
-        
-        // If most FFs are connected to the same few scan signals, skip detailed chain building
-        if (unique_si_nets.size() < 10 && unique_se_nets.size() < 10) {
-            std::cout << "    Most FFs connected to same few scan signals - treating as functional FFs" << std::endl;
-            return;
+        if (result < 0 && incomplete) {
+            buffer.reaches = -2;    // 從較淺的位置再遇到時重追
+            truncated = true;
+        } else {
+            buffer.reaches = result;
+        }
+        return result;
+    }
+
+    // net上的SI；沒有SI時經過net上的buffer往下追
+    int trace_sinks(const NetSinks& net, int depth, bool& truncated) {
+        if (net.si_head >= 0) return net.si_head;
+        for (int b = net.buffer_head; b >= 0; b = buffers[b].next_on_net) {
+            int reached = trace_buffer(b, depth, truncated);
+            if (reached >= 0) return reached;
         }
+        return -1;
+    }
+};
+
+} // namespace
+
+void detect_scan_chains(DesignDatabase& db) {
+    // DEF SCANCHAINS (step 4) 已經給了chain順序：直接用，不從netlist推
+    size_t def_chains = std::count_if(db.scan_chains.begin(), db.scan_chains.end(),
+                                      [](const ScanChain& chain) { return chain.from_def; });
+    if (def_chains > 0) {
+        std::cout << "  Using " << def_chains << " scan chains from DEF SCANCHAINS" << std::endl;
+        return;
     }
     
-    // Simplified approach: just check for actual scan connectivity patterns
-    std::cout << "    Building SI->SE connectivity map..." << std::endl;
+    std::cout << "  Detecting scan chains from netlist connections..." << std::endl;
     
-    // Build maps: SI net -> FFs using it, SE net -> FFs using it
-    std::unordered_map<std::string, std::vector<std::shared_ptr<Instance>>> si_net_to_ffs;
-    std::unordered_map<std::string, std::vector<std::shared_ptr<Instance>>> se_net_to_ffs;
+    db.scan_chains.clear();
     
-    for (const auto& ff : scan_capable_ffs) {
-        for (const auto& conn : ff->connections) {
-            Pin::FlipFlopPinType pin_type = classify_ff_pin_type(conn.pin_name);
-            
-            if (pin_type == Pin::FlipFlopPinType::FF_SCAN_INPUT && 
-                conn.net_name != "UNCONNECTED" && 
-                conn.net_name.find("SYNOPSYS_UNCONNECTED") == std::string::npos) {
-                si_net_to_ffs[conn.net_name].push_back(ff);
+    // Pass 1: pin角色、SI sink和單輸入cell的per-net linked list
+    ScanGraph graph;
+    PinRoleCache roles;
+    graph.sinks.reserve(db.instances.size());
+    std::unordered_map<std::string, int> modules;
+    int module = 0;
+    const std::string* current_module = nullptr;
+    size_t flip_flops = 0, scan_capable = 0;
+    std::vector<const Instance::Connection*> inputs;
+    
+    for (const auto& inst_pair : db.instances) {
+        Instance* instance = inst_pair.second.get();
+        if (!instance->cell_template) continue;
+        if (!current_module || *current_module != instance->module_name) {
+            current_module = &instance->module_name;
+            module = modules.emplace(instance->module_name, static_cast<int>(modules.size())).first->second;
+        }
+        
+        if (instance->is_flip_flop()) {
+            flip_flops++;
+            ScanNode node;
+            node.instance = instance;
+            node.module = module;
+            node.out_begin = static_cast<int>(graph.outputs.size());
+            bool has_scan_pin = false;
+            const Instance::Connection* so = nullptr;
+            for (const auto& conn : instance->connections) {
+                ScanPinRole role = roles.role(instance->cell_template.get(), conn.pin_name);
+                if (role == ROLE_SI || role == ROLE_SE) has_scan_pin = true;
+                if (!is_active_scan_net(conn.net_name)) continue;
+                if (role == ROLE_SI) node.si = &conn;
+                else if (role == ROLE_SO) so = &conn;
+                else if (role == ROLE_Q) graph.outputs.push_back(&conn);
+            }
+            if (has_scan_pin) scan_capable++;
+            if (so) {
+                // 有SO時只看SO
+                graph.outputs.resize(node.out_begin);
+                graph.outputs.push_back(so);
+            } else {
+                // Q由最後一個bit往前 (MBFF內部scan順序是bit 0 -> 最後一個bit)
+                std::reverse(graph.outputs.begin() + node.out_begin, graph.outputs.end());
             }
-            else if (pin_type == Pin::FlipFlopPinType::FF_SCAN_ENABLE && 
-                     conn.net_name != "UNCONNECTED" && 
-                     conn.net_name.find("SYNOPSYS_UNCONNECTED") == std::string::npos) {
-                se_net_to_ffs[conn.net_name].push_back(ff);
+            node.out_end = static_cast<int>(graph.outputs.size());
+            if (!node.si) {
+                graph.outputs.resize(node.out_begin);
+                continue;
             }
+            int index = static_cast<int>(graph.nodes.size());
+            NetSinks& net = graph.sinks[NetKey{module, &node.si->net_name}];
+            node.next_on_net = net.si_head;
+            net.si_head = index;
+            graph.nodes.push_back(node);
+            continue;
         }
-    }
-    
-    std::cout << "    Found " << si_net_to_ffs.size() << " unique SI nets, " 
-              << se_net_to_ffs.size() << " unique SE nets" << std::endl;
-    
-    // Simple heuristic: if there are real scan chains, SI and SE nets should form chains
-    // If most FFs are connected to same few nets, treat as functional FFs
-    bool has_real_scan_chains = false;
-    
-    // Check if any SE net is connected to an SI net (forming a chain)
-    for (const auto& se_pair : se_net_to_ffs) {
-        const std::string& se_net = se_pair.first;
-        if (si_net_to_ffs.count(se_net)) {
-            // This SE net is also used as SI net - possible chain connection
-            has_real_scan_chains = true;
-            break;
+        
+        // 單一signal input的non-FF cell (buffer / inverter / delay cell) 可以在scan path上
+        inputs.clear();
+        BufferNode buffer;
+        buffer.module = module;
+        buffer.out_begin = static_cast<int>(graph.outputs.size());
+        for (const auto& conn : instance->connections) {
+            ScanPinRole role = roles.role(instance->cell_template.get(), conn.pin_name);
+            if (role == ROLE_INPUT && is_active_scan_net(conn.net_name)) inputs.push_back(&conn);
+            else if (role == ROLE_OUTPUT && is_active_scan_net(conn.net_name)) graph.outputs.push_back(&conn);
         }
+        buffer.out_end = static_cast<int>(graph.outputs.size());
+        if (inputs.size() != 1 || buffer.out_end == buffer.out_begin) {
+            graph.outputs.resize(buffer.out_begin);
+            continue;
+        }
+        int index = static_cast<int>(graph.buffers.size());
+        NetSinks& net = graph.sinks[NetKey{module, &inputs[0]->net_name}];
+        buffer.next_on_net = net.buffer_head;
+        net.buffer_head = index;
+        graph.buffers.push_back(buffer);
     }
     
-    if (!has_real_scan_chains) {
-        std::cout << "    No SE->SI connections found - all FFs treated as functional FFs" << std::endl;
+    std::cout << "    Total flip-flops in design: " << flip_flops << std::endl;
+    std::cout << "    Found " << scan_capable << " scan-capable FFs (with SI/SE pins), "
+              << graph.nodes.size() << " with connected SI" << std::endl;
+    if (graph.nodes.empty()) {
+        std::cout << "    No active scan chains detected (all scan pins are UNCONNECTED)" << std::endl;
+        std::cout << "    All FFs will be treated as functional (non-scan) FFs for banking purposes" << std::endl;
         return;
     }
     
-    std::cout << "    Building scan chains from SI->SE connections..." << std::endl;
-    
-    // Build complete scan chains by following SI->SE->SI connections
-    int chain_counter = 0;
-    std::set<std::string> visited_ffs;
-    
-    // Find all chain head FFs (FFs whose SI is NOT connected to any SE)
-    std::vector<std::shared_ptr<Instance>> chain_heads;
-    for (const auto& si_pair : si_net_to_ffs) {
-        const std::string& si_net = si_pair.first;
-        const auto& ffs_using_si = si_pair.second;
-        
-        // If this SI net is not produced by any SE, it's an external input (chain head)
-        if (!se_net_to_ffs.count(si_net)) {
-            for (const auto& ff : ffs_using_si) {
-                chain_heads.push_back(ff);
-            }
+    // -out_of_core：scan path上的buffer在pass 2從net index讀入
+    if (db.out_of_core) {
+        std::unordered_map<std::string, size_t> module_of_name;
+        for (size_t m = 0; m < db.modules.size(); m++) module_of_name.emplace(db.modules[m].name, m);
+        graph.module_index.resize(modules.size(), std::numeric_limits<size_t>::max());
+        for (const auto& entry : modules) {
+            auto it = module_of_name.find(entry.first);
+            if (it != module_of_name.end()) graph.module_index[entry.second] = it->second;
         }
+        graph.db = &db;
+        graph.roles = &roles;
     }
     
-    std::cout << "    Found " << chain_heads.size() << " chain head FFs" << std::endl;
-    
-    // Build chains starting from each head
-    for (const auto& head_ff : chain_heads) {
-        if (visited_ffs.count(head_ff->name)) continue;
-        
-        ScanChain chain;
-        chain.name = "chain_" + std::to_string(chain_counter++);
-        
-        // Follow the chain from head to tail
-        std::shared_ptr<Instance> current_ff = head_ff;
-        while (current_ff && !visited_ffs.count(current_ff->name)) {
-            visited_ffs.insert(current_ff->name);
-            
-            // Add this FF to chain
-            ScanChain::ScanConnection scan_conn;
-            scan_conn.instance_name = current_ff->name;
-            scan_conn.scan_in_pin = "SI";
-            scan_conn.scan_out_pin = "SE";
-            chain.chain_sequence.push_back(scan_conn);
-            
-            // Find next FF in chain by looking at SE output
-            std::shared_ptr<Instance> next_ff = nullptr;
-            for (const auto& se_pair : se_net_to_ffs) {
-                const std::string& se_net = se_pair.first;
-                const auto& ffs_producing_se = se_pair.second;
-                
-                // Check if current FF produces this SE net
-                bool current_ff_produces_se = false;
-                for (const auto& ff : ffs_producing_se) {
-                    if (ff->name == current_ff->name) {
-                        current_ff_produces_se = true;
+    // Pass 2: scan out -> 下一個SI (direct或經過buffer)
+    int conflicts = 0;
+    for (size_t n = 0; n < graph.nodes.size(); n++) {
+        ScanNode& node = graph.nodes[n];
+        for (int o = node.out_begin; o < node.out_end && node.next < 0; o++) {
+            const NetSinks* net = graph.find_sinks(node.module, graph.outputs[o]->net_name);
+            if (!net) continue;
+            int next = -1;
+            if (net->si_head >= 0) {
+                for (int s = net->si_head; s >= 0; s = graph.nodes[s].next_on_net) {
+                    if (s != static_cast<int>(n) && graph.nodes[s].prev < 0) {
+                        next = s;
                         break;
                     }
                 }
-                
-                if (current_ff_produces_se) {
-                    // This SE net is produced by current FF, find FF that consumes it as SI
-                    if (si_net_to_ffs.count(se_net)) {
-                        for (const auto& ff : si_net_to_ffs[se_net]) {
-                            if (!visited_ffs.count(ff->name)) {
-                                next_ff = ff;
-                                break;
-                            }
-                        }
-                    }
-                    break;
+            } else {
+                bool truncated = false;
+                next = graph.trace_sinks(*net, 0, truncated);
+                if (next == static_cast<int>(n)) next = -1;
+                if (next >= 0 && graph.nodes[next].prev >= 0) {
+                    conflicts++;    // 兩個scan out接到同一個SI
+                    next = -1;
                 }
             }
-            
-            current_ff = next_ff;
+            if (next < 0) continue;
+            node.next = next;
+            node.scan_out_pin = &graph.outputs[o]->pin_name;
+            graph.nodes[next].prev = static_cast<int>(n);
         }
-        
-        if (!chain.chain_sequence.empty()) {
-            db.scan_chains.push_back(chain);
+    }
+    
+    // Pass 3: chain head (沒有predecessor) 沿next串起來；單一FF不算chain
+    std::vector<int> heads;
+    for (size_t n = 0; n < graph.nodes.size(); n++) {
+        if (graph.nodes[n].prev < 0 && graph.nodes[n].next >= 0) heads.push_back(static_cast<int>(n));
+    }
+    std::sort(heads.begin(), heads.end(), [&graph](int a, int b) {
+        return graph.nodes[a].instance->name < graph.nodes[b].instance->name;
+    });
+    
+    size_t chained = 0, longest = 0;
+    for (int head : heads) {
+        ScanChain chain;
+        chain.name = "chain_" + std::to_string(db.scan_chains.size());
+        chain.scan_in_pin = graph.nodes[head].si->net_name;
+        int tail = head;
+        for (int n = head; n >= 0; n = graph.nodes[n].next) {
+            const ScanNode& node = graph.nodes[n];
+            chain.chain_sequence.emplace_back(node.instance->name, node.si->pin_name,
+                                              node.scan_out_pin ? *node.scan_out_pin : std::string());
+            tail = n;
+        }
+        // tail：SO或最後一個Q當作STOP
+        const ScanNode& last = graph.nodes[tail];
+        if (last.out_end > last.out_begin) {
+            chain.stop_instance = last.instance->name;
+            chain.scan_out_pin = graph.outputs[last.out_begin]->pin_name;
+            chain.chain_sequence.back().scan_out_pin = chain.scan_out_pin;
         }
+        chained += chain.chain_sequence.size();
+        longest = std::max(longest, chain.chain_sequence.size());
+        LOG_HOT << "      " << chain.name << ": " << chain.length() << " FFs";
+        db.scan_chains.push_back(std::move(chain));
     }
     
-    std::cout << "    Detected " << db.scan_chains.size() << " scan chains:" << std::endl;
-    for (const auto& chain : db.scan_chains) {
-        std::cout << "      " << chain.name << ": " << chain.length() << " FFs" << std::endl;
+    // 剩下有predecessor但沒被走到的是環 (scan out接回chain前面)，不當chain
+    size_t cyclic = 0;
+    for (const auto& node : graph.nodes) {
+        if (node.prev >= 0) cyclic++;
+    }
+    cyclic -= chained - heads.size();
+    
+    std::cout << "    Detected " << db.scan_chains.size() << " scan chains with " << chained
+              << " FFs (longest " << longest << ", " << graph.buffers.size()
+              << " single-input cells)" << std::endl;
+    if (conflicts > 0 || cyclic > 0) {
+        LOG_WARN << "Scan chain detection: " << conflicts << " SI pins driven by more than one scan out, "
+                 << cyclic << " FFs in scan loops (ignored)";
     }
 }
 
@@ -322,12 +489,15 @@ void build_scan_chain_groups(DesignDatabase& db) {
 // =============================================================================
 
 void export_ff_grouping_report(DesignDatabase& db, const std::string& output_file) {
-    std::cout << "  Exporting FF grouping report to: " << output_file << std::endl;
-    
-    std::ofstream out(output_file);
-    if (!out.is_open()) {
-        std::cerr << "Error: Cannot open " << output_file << " for writing" << std::endl;
-        return;
+    // 空檔名：只建立hierarchical_ff_groups，不寫報告檔 (libmbff)
+    std::ofstream out;
+    if (!output_file.empty()) {
+        std::cout << "  Exporting FF grouping report to: " << output_file << std::endl;
+        out.open(output_file);
+        if (!out.is_open()) {
+            std::cerr << "Error: Cannot open " << output_file << " for writing" << std::endl;
+            return;
+        }
     }
     
     // Report header
@@ -686,5 +856,7 @@ void export_ff_grouping_report(DesignDatabase& db, const std::string& output_fil
     out << "Report generation completed." << std::endl;
     
     out.close();
-    std::cout << "  FF grouping report exported successfully" << std::endl;
+    if (out.is_open()) {
+        std::cout << "  FF grouping report exported successfully" << std::endl;
+    }
 }
\ No newline at end of file
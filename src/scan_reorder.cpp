@@ -0,0 +1,515 @@
+#include "scan_reorder.hpp"
+#include "parsers.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <unordered_set>
+
+// =============================================================================
+// CHAIN ENDPOINTS / PARTITIONS
+// =============================================================================
+
+namespace {
+
+bool is_connected_net(const std::string& net) {
+    return !net.empty() && net != "UNCONNECTED" && net.find("SYNOPSYS_UNCONNECTED") == std::string::npos;
+}
+
+Instance::Connection* find_scan_input(Instance& instance) {
+    for (auto& conn : instance.connections) {
+        if (classify_ff_pin_type(conn.pin_name) == Pin::FF_SCAN_INPUT) return &conn;
+    }
+    return nullptr;
+}
+
+// Scan out of an instance: SO pin, else the highest-numbered Q (MBFF internal scan order is bit 0 -> last bit)
+const Instance::Connection* find_scan_output(const Instance& instance) {
+    const Instance::Connection* best = nullptr;
+    int best_bit = -1;
+    for (const auto& conn : instance.connections) {
+        Pin::FlipFlopPinType type = classify_ff_pin_type(conn.pin_name);
+        if (type == Pin::FF_SCAN_OUTPUT && is_connected_net(conn.net_name)) return &conn;
+        if (type != Pin::FF_DATA_OUTPUT || !is_connected_net(conn.net_name)) continue;
+        int bit = 0;
+        size_t digits = conn.pin_name.find_first_of("0123456789");
+        if (digits != std::string::npos) bit = std::atoi(conn.pin_name.c_str() + digits);
+        if (bit > best_bit) {
+            best_bit = bit;
+            best = &conn;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+void record_scan_chain_endpoints(DesignDatabase& db) {
+    for (auto& chain : db.scan_chains) {
+        if (chain.chain_sequence.empty() || !chain.scan_in_net.empty()) continue;
+        auto it = db.instances.find(chain.chain_sequence.front().instance_name);
+        if (it == db.instances.end()) continue;
+        const std::string& si_pin = chain.chain_sequence.front().scan_in_pin;
+        for (const auto& conn : it->second->connections) {
+            if (conn.pin_name == si_pin ||
+                (si_pin.empty() && classify_ff_pin_type(conn.pin_name) == Pin::FF_SCAN_INPUT)) {
+                chain.scan_in_net = conn.net_name;
+                break;
+            }
+        }
+    }
+}
+
+std::unordered_map<std::string, std::string> build_scan_partition_map(const DesignDatabase& db) {
+    std::unordered_map<std::string, std::string> partitions;
+    for (const auto& chain : db.scan_chains) {
+        if (chain.partition.empty()) continue;
+        for (const auto& conn : chain.chain_sequence) {
+            partitions.emplace(conn.instance_name, chain.partition);
+        }
+    }
+    return partitions;
+}
+
+// =============================================================================
+// SEGMENT GRID (nearest-neighbor queries over segment endpoints)
+// =============================================================================
+
+namespace {
+
+Dbu manhattan(const Point& a, const Point& b) {
+    return std::llabs(a.x - b.x) + std::llabs(a.y - b.y);
+}
+
+// Uniform grid, about two points per cell; points can be removed (swap-pop)
+class SegmentGrid {
+public:
+    SegmentGrid(const std::vector<Point>& points, const Point& low, const Point& high) : points_(points), low_(low) {
+        size_t n = std::max<size_t>(1, points.size());
+        double area = std::max(1.0, static_cast<double>(high.x - low.x + 1) * static_cast<double>(high.y - low.y + 1));
+        cell_ = std::max<Dbu>(1, static_cast<Dbu>(std::sqrt(area * 2.0 / static_cast<double>(n))));
+        cols_ = static_cast<long>((high.x - low.x) / cell_) + 1;
+        rows_ = static_cast<long>((high.y - low.y) / cell_) + 1;
+        buckets_.assign(static_cast<size_t>(cols_ * rows_), std::vector<int>());
+        slot_.assign(points.size(), 0);
+        for (size_t i = 0; i < points.size(); i++) {
+            std::vector<int>& bucket = buckets_[bucket_of(points[i])];
+            slot_[i] = bucket.size();
+            bucket.push_back(static_cast<int>(i));
+        }
+        remaining_ = points.size();
+    }
+
+    void remove(int index) {
+        std::vector<int>& bucket = buckets_[bucket_of(points_[index])];
+        size_t slot = slot_[index];
+        bucket[slot] = bucket.back();
+        slot_[bucket[slot]] = slot;
+        bucket.pop_back();
+        remaining_--;
+    }
+
+    // Closest remaining point to q (-1 if none)
+    int nearest(const Point& q) const {
+        if (remaining_ == 0) return -1;
+        int best = -1;
+        Dbu best_distance = std::numeric_limits<Dbu>::max();
+        search(q, [&](int index) {
+            Dbu distance = manhattan(q, points_[index]);
+            if (distance < best_distance || (distance == best_distance && index < best)) {
+                best_distance = distance;
+                best = index;
+            }
+        }, [&](Dbu ring_bound) { return best >= 0 && best_distance <= ring_bound; });
+        return best;
+    }
+
+    // Up to k closest points to q, excluding `self`
+    std::vector<int> k_nearest(const Point& q, size_t k, int self) const {
+        std::vector<std::pair<Dbu, int>> found;
+        search(q, [&](int index) {
+            if (index == self) return;
+            found.emplace_back(manhattan(q, points_[index]), index);
+        }, [&](Dbu ring_bound) {
+            if (found.size() < k) return false;
+            std::nth_element(found.begin(), found.begin() + (k - 1), found.end());
+            found.resize(k);
+            return found[k - 1].first <= ring_bound;
+        });
+        std::sort(found.begin(), found.end());
+        if (found.size() > k) found.resize(k);
+        std::vector<int> result;
+        for (const auto& entry : found) result.push_back(entry.second);
+        return result;
+    }
+
+private:
+    long clamp_cell(Dbu offset, long cells) const {
+        long cell = static_cast<long>(floor_div(offset, cell_));
+        return std::max(0L, std::min(cells - 1, cell));
+    }
+
+    size_t bucket_of(const Point& p) const {
+        return static_cast<size_t>(clamp_cell(p.y - low_.y, rows_) * cols_ + clamp_cell(p.x - low_.x, cols_));
+    }
+
+    // Visit buckets ring by ring (Chebyshev distance in cells); after ring r every
+    // unvisited point is at least r * cell_ away, so done(r * cell_) may stop the search
+    template <typename Visit, typename Done>
+    void search(const Point& q, Visit visit, Done done) const {
+        long cx = clamp_cell(q.x - low_.x, cols_);
+        long cy = clamp_cell(q.y - low_.y, rows_);
+        long max_ring = std::max(std::max(cx, cols_ - 1 - cx), std::max(cy, rows_ - 1 - cy));
+        auto visit_cell = [&](long x, long y) {
+            for (int index : buckets_[static_cast<size_t>(y * cols_ + x)]) visit(index);
+        };
+        for (long r = 0; r <= max_ring; r++) {
+            // Ring r clipped to the grid
+            long x_low = std::max(0L, cx - r), x_high = std::min(cols_ - 1, cx + r);
+            long y_low = std::max(0L, cy - r + 1), y_high = std::min(rows_ - 1, cy + r - 1);
+            if (cy - r >= 0) {
+                for (long x = x_low; x <= x_high; x++) visit_cell(x, cy - r);
+            }
+            if (r > 0 && cy + r < rows_) {
+                for (long x = x_low; x <= x_high; x++) visit_cell(x, cy + r);
+            }
+            if (r > 0 && cx - r >= 0) {
+                for (long y = y_low; y <= y_high; y++) visit_cell(cx - r, y);
+            }
+            if (r > 0 && cx + r < cols_) {
+                for (long y = y_low; y <= y_high; y++) visit_cell(cx + r, y);
+            }
+            if (done(static_cast<Dbu>(r) * cell_)) return;
+        }
+    }
+
+    const std::vector<Point>& points_;
+    Point low_;
+    Dbu cell_ = 1;
+    long cols_ = 1;
+    long rows_ = 1;
+    std::vector<std::vector<int>> buckets_;
+    std::vector<size_t> slot_;
+    size_t remaining_ = 0;
+};
+
+// =============================================================================
+// ORDERING (nearest neighbor + Or-opt)
+// =============================================================================
+
+// 一段固定順序的chain成員 (FLOATING成員自己一段；ORDERED list一整段)
+struct ChainSegment {
+    std::vector<std::shared_ptr<Instance>> members;
+    int ordered_segment = -1;
+    Point entry;   // First member (its SI is stitched)
+    Point exit;    // Last member (its scan out feeds the next segment)
+};
+
+Point placed_position(const Instance& instance) {
+    return Point(instance.x_new, instance.y_new);
+}
+
+Dbu link_cost(const std::vector<ChainSegment>& segments, int from, int to) {
+    return manhattan(segments[from].exit, segments[to].entry);
+}
+
+Dbu path_cost(const std::vector<ChainSegment>& segments, const std::vector<int>& order) {
+    Dbu total = 0;
+    for (size_t i = 1; i < order.size(); i++) total += link_cost(segments, order[i - 1], order[i]);
+    return total;
+}
+
+void bounding_box(const std::vector<ChainSegment>& segments, Point& low, Point& high) {
+    low = Point(std::numeric_limits<Dbu>::max(), std::numeric_limits<Dbu>::max());
+    high = Point(std::numeric_limits<Dbu>::min(), std::numeric_limits<Dbu>::min());
+    for (const auto& segment : segments) {
+        for (const Point& p : {segment.entry, segment.exit}) {
+            low.x = std::min(low.x, p.x);
+            low.y = std::min(low.y, p.y);
+            high.x = std::max(high.x, p.x);
+            high.y = std::max(high.y, p.y);
+        }
+    }
+}
+
+// tail >= 0：從tail往回找最近的前一段 (tail固定在最後)；否則從head往後
+std::vector<int> nearest_neighbor_order(const std::vector<ChainSegment>& segments, int head, int tail) {
+    Point low, high;
+    bounding_box(segments, low, high);
+    bool backward = tail >= 0;
+    std::vector<Point> keys;
+    keys.reserve(segments.size());
+    for (const auto& segment : segments) keys.push_back(backward ? segment.exit : segment.entry);
+
+    SegmentGrid grid(keys, low, high);
+    int current = backward ? tail : head;
+    grid.remove(current);
+    std::vector<int> order(1, current);
+    for (size_t step = 1; step < segments.size(); step++) {
+        current = grid.nearest(backward ? segments[current].entry : segments[current].exit);
+        grid.remove(current);
+        order.push_back(current);
+    }
+    if (backward) std::reverse(order.begin(), order.end());
+    return order;
+}
+
+// Or-opt：把1-3段連續的segment搬到某個最近鄰居的前面 / 後面，直到沒有改善
+void or_opt(const std::vector<ChainSegment>& segments, std::vector<int>& order, bool fixed_tail) {
+    int n = static_cast<int>(order.size());
+    if (n < 3) return;
+
+    Point low, high;
+    bounding_box(segments, low, high);
+    std::vector<Point> entries;
+    for (const auto& segment : segments) entries.push_back(segment.entry);
+    SegmentGrid grid(entries, low, high);
+    std::vector<std::vector<int>> neighbors(segments.size());
+    for (int s = 0; s < n; s++) {
+        neighbors[s] = grid.k_nearest(segments[s].entry, SCAN_REORDER_NEIGHBORS, s);
+        if (segments[s].exit.x != segments[s].entry.x || segments[s].exit.y != segments[s].entry.y) {
+            std::vector<int> more = grid.k_nearest(segments[s].exit, SCAN_REORDER_NEIGHBORS, s);
+            neighbors[s].insert(neighbors[s].end(), more.begin(), more.end());
+        }
+    }
+
+    std::vector<int> pos(segments.size());
+    auto reindex = [&]() {
+        for (int i = 0; i < n; i++) pos[order[i]] = i;
+    };
+    reindex();
+    auto cost = [&](int from, int to) -> Dbu {
+        return from < 0 || to < 0 ? 0 : link_cost(segments, from, to);
+    };
+
+    for (int pass = 0; pass < SCAN_REORDER_MAX_PASSES; pass++) {
+        bool improved = false;
+        for (int i = 0; i < n; i++) {
+            for (int length = 1; length <= SCAN_REORDER_OR_OPT_MAX_RUN && i + length <= n; length++) {
+                if (fixed_tail && i + length == n) break;
+                int first = order[i], last = order[i + length - 1];
+                int before = i > 0 ? order[i - 1] : -1;
+                int after = i + length < n ? order[i + length] : -1;
+                Dbu removal_gain = cost(before, first) + cost(last, after) - cost(before, after);
+                if (removal_gain <= 0) continue;
+
+                // 插在position p的segment之後 (p = -1：最前面)
+                Dbu best_delta = 0;
+                int best_position = -2;
+                auto try_after = [&](int p) {
+                    if (p >= i - 1 && p <= i + length - 1) return;
+                    if (p >= n || p < -1) return;
+                    if (fixed_tail && p == n - 1) return;
+                    int u = p >= 0 ? order[p] : -1;
+                    int w = p + 1 < n ? order[p + 1] : -1;
+                    Dbu delta = cost(u, first) + cost(last, w) - cost(u, w) - removal_gain;
+                    if (delta < best_delta) {
+                        best_delta = delta;
+                        best_position = p;
+                    }
+                };
+                try_after(-1);
+                if (!fixed_tail) try_after(n - 1);
+                for (int endpoint : {first, last}) {
+                    for (int v : neighbors[endpoint]) {
+                        try_after(pos[v]);
+                        try_after(pos[v] - 1);
+                    }
+                }
+                if (best_position == -2) continue;
+
+                std::vector<int> run(order.begin() + i, order.begin() + i + length);
+                order.erase(order.begin() + i, order.begin() + i + length);
+                int insert_at = best_position < i ? best_position + 1 : best_position + 1 - length;
+                order.insert(order.begin() + insert_at, run.begin(), run.end());
+                reindex();
+                improved = true;
+                break;
+            }
+        }
+        if (!improved) break;
+    }
+}
+
+} // namespace
+
+// =============================================================================
+// REORDER + RE-STITCH
+// =============================================================================
+
+void reorder_scan_chains(DesignDatabase& db) {
+    if (db.scan_chains.empty()) {
+        std::cout << "  No scan chains, skipping scan chain reordering" << std::endl;
+        return;
+    }
+
+    // 原始chain成員的D pin provenance nodes (到最後的instance)
+    std::unordered_set<std::string> member_names;
+    for (const auto& chain : db.scan_chains) {
+        for (const auto& conn : chain.chain_sequence) member_names.insert(conn.instance_name);
+    }
+    std::unordered_map<std::string, std::vector<int>> member_data_pins;
+    const PinProvenance& provenance = db.pin_provenance;
+    for (int node : provenance.original_pins) {
+        const std::string& instance = provenance.node_instance(node);
+        if (!member_names.count(instance)) continue;
+        if (classify_ff_pin_type(provenance.node_pin(node)) != Pin::FF_DATA_INPUT) continue;
+        member_data_pins[instance].push_back(node);
+    }
+    auto final_instances = [&](const std::string& original) {
+        std::vector<std::shared_ptr<Instance>> result;
+        auto pins = member_data_pins.find(original);
+        if (pins == member_data_pins.end()) {
+            auto it = db.instances.find(original);
+            if (it != db.instances.end()) result.push_back(it->second);
+            return result;
+        }
+        for (int node : pins->second) {
+            auto it = db.instances.find(provenance.node_instance(provenance.find(node)));
+            if (it == db.instances.end()) continue;
+            if (std::find(result.begin(), result.end(), it->second) == result.end()) result.push_back(it->second);
+        }
+        return result;
+    };
+
+    // 每個最後的instance只屬於一條chain：先讓有STOP的chain認領它的最後一個FF，其餘依chain順序
+    std::unordered_map<const Instance*, size_t> owner;
+    std::vector<const Instance*> tails(db.scan_chains.size(), nullptr);
+    for (size_t c = 0; c < db.scan_chains.size(); c++) {
+        const ScanChain& chain = db.scan_chains[c];
+        if (chain.chain_sequence.empty() || (chain.scan_out_pin.empty() && chain.stop_instance.empty())) continue;
+        std::vector<std::shared_ptr<Instance>> finals = final_instances(chain.chain_sequence.back().instance_name);
+        if (finals.empty() || owner.count(finals.back().get())) continue;
+        tails[c] = finals.back().get();
+        owner[tails[c]] = c;
+    }
+
+    int shared_instances = 0, cross_partition = 0, dropped = 0, skipped_chains = 0, reordered_chains = 0;
+    Dbu total_before = 0, total_after = 0;
+
+    for (size_t c = 0; c < db.scan_chains.size(); c++) {
+        ScanChain& chain = db.scan_chains[c];
+
+        // Segments in the original chain order
+        std::vector<ChainSegment> segments;
+        std::unordered_set<const Instance*> seen;
+        for (const auto& conn : chain.chain_sequence) {
+            for (const auto& instance : final_instances(conn.instance_name)) {
+                const Instance* key = instance.get();
+                if (seen.count(key)) continue;
+                auto claimed = owner.find(key);
+                if (claimed != owner.end() && claimed->second != c) {
+                    // 已屬於別的chain (tail或前面的chain)
+                    seen.insert(key);
+                    shared_instances++;
+                    if (db.scan_chains[claimed->second].partition != chain.partition) cross_partition++;
+                    continue;
+                }
+                seen.insert(key);
+                owner[key] = c;
+                if (!find_scan_input(*instance) || (key != tails[c] && !find_scan_output(*instance))) {
+                    dropped++;   // 換成沒有SI的cell，或scan out沒接
+                    continue;
+                }
+                bool extend = conn.ordered_segment >= 0 && !segments.empty() &&
+                              segments.back().ordered_segment == conn.ordered_segment;
+                if (!extend) {
+                    segments.push_back(ChainSegment());
+                    segments.back().ordered_segment = conn.ordered_segment;
+                }
+                segments.back().members.push_back(instance);
+            }
+        }
+        // tail那一段放到最後
+        int tail = -1;
+        for (size_t s = 0; s < segments.size(); s++) {
+            for (const auto& member : segments[s].members) {
+                if (member.get() == tails[c]) tail = static_cast<int>(s);
+            }
+        }
+        for (auto& segment : segments) {
+            segment.entry = placed_position(*segment.members.front());
+            segment.exit = placed_position(*segment.members.back());
+        }
+
+        bool same_module = true;
+        for (const auto& segment : segments) {
+            for (const auto& member : segment.members) {
+                if (member->module_name != segments.front().members.front()->module_name) same_module = false;
+            }
+        }
+
+        std::vector<int> order;
+        for (size_t s = 0; s < segments.size(); s++) order.push_back(static_cast<int>(s));
+        if (tail >= 0 && tail != static_cast<int>(segments.size()) - 1) {
+            order.erase(order.begin() + tail);
+            order.push_back(tail);
+        }
+        Dbu before = path_cost(segments, order);
+
+        if (segments.empty() || chain.scan_in_net.empty() || !same_module) {
+            skipped_chains++;
+            LOG_WARN_LIMITED("scan chain not reordered") << "Scan chain " << chain.name << " not reordered ("
+                << (segments.empty() ? "no scan FFs left" : chain.scan_in_net.empty() ? "unknown start net"
+                                                                                         : "spans several modules")
+                << ")";
+        } else {
+            // 沒有固定的tail：從目前接在起點net上的segment開始
+            int head = 0;
+            for (size_t s = 0; s < segments.size(); s++) {
+                Instance::Connection* si = find_scan_input(*segments[s].members.front());
+                if (si && si->net_name == chain.scan_in_net) {
+                    head = static_cast<int>(s);
+                    break;
+                }
+            }
+            std::vector<int> improved = nearest_neighbor_order(segments, head, tail);
+            or_opt(segments, improved, tail >= 0);
+            if (path_cost(segments, improved) < before) order.swap(improved);
+
+            // Re-stitch SI pins along the new order
+            std::string previous_net = chain.scan_in_net;
+            for (int s : order) {
+                for (const auto& member : segments[s].members) {
+                    find_scan_input(*member)->net_name = previous_net;
+                    const Instance::Connection* scan_out = find_scan_output(*member);
+                    previous_net = scan_out ? scan_out->net_name : "UNCONNECTED";
+                }
+            }
+            reordered_chains++;
+        }
+        Dbu after = path_cost(segments, order);
+        total_before += before;
+        total_after += after;
+
+        // chain_sequence改成最後的instance (DEF SCANCHAINS照這個順序輸出)
+        std::vector<ScanChain::ScanConnection> sequence;
+        int bits = 0;
+        for (int s : order) {
+            for (const auto& member : segments[s].members) {
+                Instance::Connection* si = find_scan_input(*member);
+                const Instance::Connection* scan_out = find_scan_output(*member);
+                sequence.emplace_back(member->name, si ? si->pin_name : "SI", scan_out ? scan_out->pin_name : "",
+                                      segments[s].ordered_segment);
+                bits += member->cell_template ? std::max(1, member->cell_template->bit_width) : 1;
+            }
+        }
+        chain.chain_sequence.swap(sequence);
+        if (chain.max_bits >= 0 && bits > chain.max_bits) {
+            LOG_WARN << "Scan chain " << chain.name << " has " << bits << " bits, partition " << chain.partition
+                     << " allows " << chain.max_bits;
+        }
+        LOG_HOT << "    " << chain.name << ": " << chain.length() << " FFs, scan wirelength "
+                << before << " -> " << after;
+    }
+
+    if (cross_partition > 0) {
+        LOG_WARN << cross_partition << " banked FFs hold scan FFs from chains of different partitions";
+    }
+    std::cout << "  Reordered " << reordered_chains << " scan chains (" << skipped_chains << " kept as is)" << std::endl;
+    std::cout << "    Banked FFs shared with another chain: " << shared_instances
+              << ", scan FFs no longer on a chain: " << dropped << std::endl;
+    std::cout << "    Scan wirelength: " << total_before << " -> " << total_after << " DBU" << std::endl;
+}
@@ -0,0 +1,40 @@
+#ifndef SCAN_REORDER_HPP
+#define SCAN_REORDER_HPP
+
+#include <string>
+#include <unordered_map>
+
+class DesignDatabase;
+
+// =============================================================================
+// SCAN CHAIN REORDERING (Step 19.5, after banking / legalization)
+// =============================================================================
+// Banking把不同chain、不相鄰的scan FF併成同一個MBFF (SI共用第一個bit的net)，原本的
+// SI->Q串接就斷了。這裡在最後的instance上重新串每條chain：
+//   1. 原始chain成員經由pin provenance (D pin) 對到最後的instance；一個MBFF只屬於
+//      第一個認領它的chain。ORDERED list視為不可拆的一段，FLOATING成員各自一段
+//   2. STOP點之前的成員 (原本最後一個FF所在的instance) 固定在最後；沒有STOP時從目前
+//      接在chain起點net上的instance開始
+//   3. Nearest neighbor (uniform grid) 建初始順序，再用Or-opt (搬移1-3段到最近鄰居旁)
+//      改善，距離是legalization後位置的Manhattan距離
+//   4. 依新順序改SI connection：第一個接chain起點net (step 8記錄)，之後接前一個的
+//      scan out (SO，沒有SO時用編號最大的Q；MBFF內部的scan順序是bit 0 -> 最後一個bit)
+// SCANDEF PARTITION：banking只在同一個partition內併FF (沒有PARTITION的chain視為同一個)，
+// 所以重新分配的MBFF不會跨partition；MAXBITS超過時只警告
+// 成員跨hierarchy module的chain (net不在同一個module) 保持原樣
+// =============================================================================
+
+#define SCAN_REORDER_OR_OPT_MAX_RUN 3       // Or-opt moves runs of up to this many chain segments
+#define SCAN_REORDER_NEIGHBORS 8            // Candidate insertion points per segment (nearest neighbors)
+#define SCAN_REORDER_MAX_PASSES 8           // Or-opt improvement passes per chain
+
+// Record each chain's start net (SI net of its first FF) before any transformation
+void record_scan_chain_endpoints(DesignDatabase& db);
+
+// Instance / cluster name -> SCANDEF partition ("" for chains without PARTITION)
+std::unordered_map<std::string, std::string> build_scan_partition_map(const DesignDatabase& db);
+
+// Re-stitch every chain over the final instances in wirelength-minimizing order
+void reorder_scan_chains(DesignDatabase& db);
+
+#endif // SCAN_REORDER_HPP
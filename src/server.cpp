@@ -0,0 +1,351 @@
+#include "server.hpp"
+#include "data_structures.hpp"
+#include "flow.hpp"
+#include "checkpoint.hpp"
+#include "task_graph.hpp"
+#include "thread_pool.hpp"
+#include "profiler.hpp"
+#include "logger.hpp"
+#include "compressed_stream.hpp"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// =============================================================================
+// SOCKET HELPERS
+// =============================================================================
+
+namespace {
+
+bool make_socket_address(const std::string& path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        LOG_ERROR << "Socket path must be 1-" << sizeof(address.sun_path) - 1 << " characters: " << path;
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+int connect_to(const std::string& path) {
+    sockaddr_un address;
+    if (!make_socket_address(path, address)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        LOG_ERROR << "Cannot connect to server " << path << ": " << std::strerror(errno);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// 讀到換行為止 (不含換行)；連線中斷或超過SERVER_MAX_REQUEST_BYTES時回傳false
+bool read_line(int fd, std::string& line) {
+    line.clear();
+    char c;
+    while (true) {
+        ssize_t n = recv(fd, &c, 1, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        if (c == '\n') return true;
+        if (line.size() >= SERVER_MAX_REQUEST_BYTES) return false;
+        line.push_back(c);
+    }
+}
+
+std::vector<std::string> split_tabs(const std::string& text) {
+    std::vector<std::string> fields;
+    std::string field;
+    std::istringstream stream(text);
+    while (std::getline(stream, field, '\t')) {
+        if (!field.empty()) fields.push_back(field);
+    }
+    return fields;
+}
+
+std::string absolute_path(const std::string& path) {
+    if (path.empty() || path[0] == '/') return path;
+    char cwd[4096];
+    if (!getcwd(cwd, sizeof(cwd))) return path;
+    return std::string(cwd) + "/" + path;
+}
+
+// =============================================================================
+// SERVER STATE
+// =============================================================================
+
+struct ServerState {
+    const ProgramArguments* server_args = nullptr;
+    const DesignDatabase* library = nullptr;
+    ThreadPool* pool = nullptr;
+    int listen_fd = -1;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    int connections = 0;      // 還在處理的連線 (SHUTDOWN時等它們結束)
+    int running_jobs = 0;     // 正在跑flow的job (上限 -jobs)
+    int next_job_id = 1;
+    bool stopping = false;
+};
+
+// -jobs 個名額；拿不到名額的job排隊等待
+class JobSlot {
+public:
+    explicit JobSlot(ServerState& state) : state_(state) {
+        std::unique_lock<std::mutex> lock(state_.mutex);
+        state_.changed.wait(lock, [&]() { return state_.running_jobs < state_.server_args->jobs; });
+        state_.running_jobs++;
+    }
+    ~JobSlot() {
+        std::lock_guard<std::mutex> lock(state_.mutex);
+        state_.running_jobs--;
+        state_.changed.notify_all();
+    }
+
+private:
+    ServerState& state_;
+};
+
+// 把request轉成這個job自己的ProgramArguments (library和thread設定沿用server)
+ProgramArguments parse_job_arguments(const ServerState& state, const std::vector<std::string>& tokens) {
+    ProgramArguments job = parse_argument_tokens(tokens);
+    job.lib_files = state.server_args->lib_files;
+    job.lef_files = state.server_args->lef_files;
+    job.threads = state.server_args->threads;
+
+    if (job.output_name.empty()) throw std::runtime_error("job has no -out");
+    if (job.output_name[0] != '/') throw std::runtime_error("-out must be an absolute path");
+    if (job.resume_from.empty() && (job.verilog_files.empty() || job.def_files.empty() || job.weight_file.empty())) {
+        throw std::runtime_error("job needs -v, -def and -weight (or --resume-from)");
+    }
+    if (!job.checkpoint_after.empty() && checkpoint_step_rank(job.checkpoint_after) < 0) {
+        throw std::runtime_error("unknown checkpoint step " + job.checkpoint_after);
+    }
+    if (job.out_of_core && (!job.checkpoint_after.empty() || !job.resume_from.empty())) {
+        throw std::runtime_error("-out_of_core cannot be combined with checkpoints");
+    }
+    if (!job.compress_output.empty() && compression_suffix(job.compress_output).empty()) {
+        throw std::runtime_error("-compress_output must be gz or zst");
+    }
+    // debug report放在輸出檔旁邊，同時執行的job不會互相覆蓋
+    job.report_dir = directory_of(job.output_name);
+    return job;
+}
+
+void run_job(ServerState& state, int job_id, const ProgramArguments& job) {
+    JobSlot slot(state);
+    ScopedTimer job_timer("Server job");
+
+    DesignDatabase db;
+    db.design_name = "ICCAD_2025_Design";
+    int completed_rank;
+    if (!job.resume_from.empty()) {
+        std::string resumed_step;
+        if (!load_checkpoint(job.resume_from, db, resumed_step)) {
+            throw std::runtime_error("cannot resume from " + job.resume_from);
+        }
+        completed_rank = checkpoint_step_rank(resumed_step);
+    } else {
+        share_cell_library(*state.library, db);
+        completed_rank = checkpoint_step_rank("2");
+    }
+
+    std::cout << "\n📥 Job " << job_id << ": " << job.output_name << std::endl;
+    run_banking_flow(job, db, *state.pool, completed_rank);
+    job_timer.set_items(db.instances.size());
+}
+
+void serve_connection(ServerState& state, int fd) {
+    std::string request;
+    std::string reply;
+    bool shutdown_requested = false;
+
+    if (!read_line(fd, request)) {
+        reply = "ERROR malformed request\n";
+    } else if (request == "SHUTDOWN") {
+        shutdown_requested = true;
+        reply = "OK 0\n";
+    } else if (request.compare(0, 4, "JOB\t") == 0) {
+        int job_id;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            job_id = state.next_job_id++;
+        }
+        auto start = std::chrono::steady_clock::now();
+        try {
+            std::vector<std::string> tokens = split_tabs(request.substr(4));
+            if (tokens.empty()) throw std::runtime_error("empty job");
+            ProgramArguments job = parse_job_arguments(state, tokens);
+            run_job(state, job_id, job);
+            long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            std::cout << "✅ Job " << job_id << " finished in " << ms << " ms" << std::endl;
+            reply = "OK " + std::to_string(ms) + "\n";
+        } catch (const std::exception& e) {
+            LOG_ERROR << "❌ Job " << job_id << ": " << e.what();
+            reply = std::string("ERROR ") + e.what() + "\n";
+        }
+    } else {
+        reply = "ERROR unknown request\n";
+    }
+
+    send_all(fd, reply);
+    close(fd);
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (shutdown_requested && !state.stopping) {
+        state.stopping = true;
+        shutdown(state.listen_fd, SHUT_RDWR);   // 讓accept()返回
+    }
+    state.connections--;
+    state.changed.notify_all();
+}
+
+} // namespace
+
+// =============================================================================
+// SERVER
+// =============================================================================
+
+int run_server(const ProgramArguments& args) {
+    ThreadPool& pool = ThreadPool::instance();
+    pool.resize(args.threads);
+
+    // 每個job的stage輸出整段寫出 (同時執行的job不會一行一行交錯)
+    StageOutputScope routing;
+
+    // Steps 1-2 只做一次：之後所有job共用這份cell library
+    DesignDatabase library;
+    library.design_name = "ICCAD_2025_Library";
+    try {
+        std::cout << "\n📚 Loading cell library for server..." << std::endl;
+        run_banking_flow(args, library, pool, -1, checkpoint_step_rank("2"));
+    } catch (const std::exception& e) {
+        LOG_ERROR << "❌ " << e.what();
+        return 1;
+    }
+
+    sockaddr_un address;
+    if (!make_socket_address(args.server_socket, address)) return 1;
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        LOG_ERROR << "Cannot create socket: " << std::strerror(errno);
+        return 1;
+    }
+    unlink(args.server_socket.c_str());   // 上次沒正常結束留下的socket檔
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listen_fd, SERVER_LISTEN_BACKLOG) != 0) {
+        LOG_ERROR << "Cannot listen on " << args.server_socket << ": " << std::strerror(errno);
+        close(listen_fd);
+        return 1;
+    }
+
+    ServerState state;
+    state.server_args = &args;
+    state.library = &library;
+    state.pool = &pool;
+    state.listen_fd = listen_fd;
+
+    std::cout << "\n🛰️  Server ready on " << args.server_socket << " (" << library.cell_library.size()
+              << " cells, " << args.jobs << " concurrent jobs)" << std::endl;
+
+    while (true) {
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (state.stopping) break;
+            LOG_ERROR << "accept failed: " << std::strerror(errno);
+            state.stopping = true;
+            break;
+        }
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.connections++;
+        }
+        std::thread(serve_connection, std::ref(state), fd).detach();
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(state.mutex);
+        state.changed.wait(lock, [&]() { return state.connections == 0; });
+    }
+    close(listen_fd);
+    unlink(args.server_socket.c_str());
+    std::cout << "\n🛑 Server stopped after " << state.next_job_id - 1 << " jobs" << std::endl;
+    return 0;
+}
+
+// =============================================================================
+// CLIENT
+// =============================================================================
+
+namespace {
+
+int send_request(const std::string& socket_path, const std::string& request) {
+    int fd = connect_to(socket_path);
+    if (fd < 0) return 1;
+    std::string reply;
+    bool ok = send_all(fd, request) && read_line(fd, reply);
+    close(fd);
+    if (!ok) {
+        LOG_ERROR << "Server " << socket_path << " closed the connection";
+        return 1;
+    }
+    std::cout << reply << std::endl;
+    return reply.compare(0, 3, "OK ") == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int submit_job(const ProgramArguments& args) {
+    // server的工作目錄不同，路徑一律轉成絕對路徑
+    std::string request = "JOB";
+    auto add = [&](const std::string& flag, const std::string& value) {
+        request += "\t" + flag + "\t" + value;
+    };
+    for (const auto& file : args.verilog_files) add("-v", absolute_path(file));
+    for (const auto& file : args.def_files) add("-def", absolute_path(file));
+    if (!args.weight_file.empty()) add("-weight", absolute_path(args.weight_file));
+    for (const auto& file : args.sdc_files) add("-sdc", absolute_path(file));
+    add("-out", absolute_path(args.output_name.empty() ? "output" : args.output_name));
+    if (!args.checkpoint_after.empty()) add("--checkpoint-after", args.checkpoint_after);
+    if (!args.resume_from.empty()) add("--resume-from", absolute_path(args.resume_from));
+    if (args.time_budget > 0.0) add("-time_budget", std::to_string(args.time_budget));
+    for (const auto& assignment : banking_parameter_assignments(args.banking_params)) add("-param", assignment);
+    if (!args.compress_output.empty()) add("-compress_output", args.compress_output);
+    if (args.out_of_core) request += "\t-out_of_core";
+    if (!args.scan_reorder) request += "\t-no_scan_reorder";
+    request += "\n";
+
+    std::cout << "\n📤 Submitting job to " << args.submit_socket << "..." << std::endl;
+    return send_request(args.submit_socket, request);
+}
+
+int stop_server(const std::string& socket_path) {
+    std::cout << "\n📤 Stopping server " << socket_path << "..." << std::endl;
+    return send_request(socket_path, "SHUTDOWN\n");
+}
@@ -0,0 +1,32 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include "argument_parser.hpp"
+#include <string>
+
+// =============================================================================
+// RESIDENT SERVER MODE
+// =============================================================================
+// -server <socket> 只parse一次Liberty / LEF (steps 1-2)，之後在Unix-domain socket
+// 上接收job；每個job有自己的DesignDatabase，cell library (CellTemplate) 共用且唯讀
+//
+// Protocol (一行一個request，一行一個reply)：
+//   JOB\t<arg>\t<arg>...\n   一般的命令列參數 (-v/-def/-weight/-out，可加 --resume-from 等)
+//   SHUTDOWN\n               不再接收新job，等執行中的job結束後離開
+//   reply: "OK <ms>\n" 或 "ERROR <message>\n"
+// 同時執行的job數由 -jobs 限制，所有job共用同一個thread pool
+// =============================================================================
+
+#define SERVER_MAX_REQUEST_BYTES (1 << 20)
+#define SERVER_LISTEN_BACKLOG 16
+
+// Serve jobs on args.server_socket until SHUTDOWN; returns the process exit status
+int run_server(const ProgramArguments& args);
+
+// Send this invocation's design as one job to args.submit_socket and wait for it
+int submit_job(const ProgramArguments& args);
+
+// Ask the server on `socket_path` to finish running jobs and exit
+int stop_server(const std::string& socket_path);
+
+#endif // SERVER_HPP
@@ -0,0 +1,89 @@
+#include "spatial_order.hpp"
+#include "data_structures.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <utility>
+
+// =============================================================================
+// HILBERT INDEX
+// =============================================================================
+
+uint64_t hilbert_index(uint32_t x, uint32_t y, int bits) {
+    uint32_t n = 1u << bits;
+    uint64_t d = 0;
+    for (uint32_t s = n / 2; s > 0; s /= 2) {
+        uint32_t rx = (x & s) ? 1 : 0;
+        uint32_t ry = (y & s) ? 1 : 0;
+        d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+        // 旋轉象限，讓子曲線的起點 / 終點接上
+        if (ry == 0) {
+            if (rx == 1) {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+// =============================================================================
+// REORDER db.instances
+// =============================================================================
+
+void reorder_instances_spatially(DesignDatabase& db) {
+    ScopedTimer timer("Step 4: Spatial reorder");
+    size_t count = db.instances.size();
+    if (count < 2) return;
+
+    // Placement的bounding box (兩軸用同一個比例，保持長寬比)
+    Dbu min_x = std::numeric_limits<Dbu>::max(), min_y = std::numeric_limits<Dbu>::max();
+    Dbu max_x = std::numeric_limits<Dbu>::min(), max_y = std::numeric_limits<Dbu>::min();
+    for (const auto& pair : db.instances) {
+        const Point& p = pair.second->position;
+        min_x = std::min(min_x, p.x);
+        min_y = std::min(min_y, p.y);
+        max_x = std::max(max_x, p.x);
+        max_y = std::max(max_y, p.y);
+    }
+    Dbu span = std::max<Dbu>(1, std::max(max_x - min_x, max_y - min_y));
+    Dbu cells = (Dbu(1) << SPATIAL_ORDER_GRID_BITS) - 1;
+
+    // 指向db.instances的value (unordered_map的node不搬移)：原地換掉shared_ptr，iteration順序不變
+    std::vector<std::pair<uint64_t, std::shared_ptr<Instance>*>> order;
+    order.reserve(count);
+    size_t combinational = 0;
+    for (auto& pair : db.instances) {
+        const Point& p = pair.second->position;
+        uint32_t gx = static_cast<uint32_t>((p.x - min_x) * cells / span);
+        uint32_t gy = static_cast<uint32_t>((p.y - min_y) * cells / span);
+        order.emplace_back(hilbert_index(gx, gy), &pair.second);
+        if (!pair.second->is_flip_flop()) combinational++;
+    }
+    std::sort(order.begin(), order.end(),
+              [](const std::pair<uint64_t, std::shared_ptr<Instance>*>& a,
+                 const std::pair<uint64_t, std::shared_ptr<Instance>*>& b) {
+                  return a.first != b.first ? a.first < b.first : (*a.second)->name < (*b.second)->name;
+              });
+
+    // 組合邏輯cell整個flow都不會被換掉，複製進連續的arena (reserve之後不會搬移)；
+    // FF會被debank / banking換掉，依Hilbert順序個別配置，換掉時各自釋放
+    auto arena = std::make_shared<std::vector<Instance>>();
+    arena->reserve(combinational);
+    for (const auto& entry : order) {
+        std::shared_ptr<Instance>& slot = *entry.second;
+        if (slot->is_flip_flop()) {
+            slot = std::make_shared<Instance>(*slot);
+        } else {
+            arena->push_back(*slot);
+            slot = std::shared_ptr<Instance>(arena, &arena->back());
+        }
+    }
+
+    std::cout << "  🗺️  Reordered " << count << " instances along a Hilbert curve ("
+              << (1 << SPATIAL_ORDER_GRID_BITS) << "x" << (1 << SPATIAL_ORDER_GRID_BITS) << " grid, "
+              << combinational << " in the shared arena)" << std::endl;
+    timer.set_items(count);
+}
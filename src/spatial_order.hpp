@@ -0,0 +1,30 @@
+#ifndef SPATIAL_ORDER_HPP
+#define SPATIAL_ORDER_HPP
+
+#include <cstdint>
+
+class DesignDatabase;
+
+// =============================================================================
+// LOCALITY-PRESERVING INSTANCE ORDER (after Step 4)
+// =============================================================================
+// db.instances原本是Verilog parse時一個一個make_shared，iteration順序是hash順序，
+// 空間上相鄰的FF在記憶體裡分散；banking / legalization的鄰近搜尋一直cache miss
+// DEF parse完之後做一次，只改記憶體位置，不改任何演算法看到的順序：
+//   1. 依placement位置的Hilbert curve index排序 (同index用名稱排，結果固定)
+//   2. 依這個順序重新配置：組合邏輯cell複製到一塊連續的arena (std::vector<Instance>)，
+//      shared_ptr用aliasing constructor指向arena；FF (之後會被debank / banking換掉)
+//      個別make_shared，被換掉時各自釋放，不會讓整塊arena留著舊的copy
+//   3. db.instances裡的shared_ptr原地替換，unordered_map的iteration順序不變，
+//      debank / grouping / banking / legalization的結果和沒有reorder時相同
+// =============================================================================
+
+#define SPATIAL_ORDER_GRID_BITS 16          // Hilbert grid is 2^bits x 2^bits over the placement bounding box
+
+// Hilbert curve index of (x, y) on a 2^bits x 2^bits grid
+uint64_t hilbert_index(uint32_t x, uint32_t y, int bits = SPATIAL_ORDER_GRID_BITS);
+
+// Relocate db.instances along the Hilbert curve of instance positions (iteration order unchanged)
+void reorder_instances_spatially(DesignDatabase& db);
+
+#endif // SPATIAL_ORDER_HPP
@@ -1,5 +1,7 @@
 #include "data_structures.hpp"
 #include "parsers.hpp"
+#include "logger.hpp"
+#include "time_budget.hpp"
 #include <iostream>
 #include <vector>
 #include <memory>
@@ -26,22 +28,25 @@ void perform_strategic_debanking(DesignDatabase& db) {
         if (instance->cell_template->is_flip_flop() && 
             instance->cell_template->single_bit_degenerate != "null") {
             
+            // -time_budget到期：剩下的multi-bit FF保持原樣
+            if (time_budget_expired(db)) break;
+            
             std::string parent_cell_name = instance->cell_template->single_bit_degenerate;
             
             // Find the parent single-bit cell template
             auto parent_iter = db.cell_library.find(parent_cell_name);
             if (parent_iter == db.cell_library.end()) {
-                std::cout << "  WARNING: Parent cell " << parent_cell_name 
-                         << " not found for " << instance->cell_template->name << std::endl;
+                LOG_WARN_LIMITED("debank parent cell not found") << "Parent cell " << parent_cell_name
+                                                                 << " not found for " << instance->cell_template->name;
                 continue;
             }
             
             auto parent_template = parent_iter->second;
             int bit_width = instance->cell_template->bit_width;
             
-            std::cout << "  Debanking " << instance->name 
-                     << " (" << instance->cell_template->name << ", " << bit_width << "-bit)"
-                     << " → " << bit_width << "× " << parent_cell_name << std::endl;
+            LOG_HOT << "  Debanking " << instance->name
+                    << " (" << instance->cell_template->name << ", " << bit_width << "-bit)"
+                    << " → " << bit_width << "× " << parent_cell_name;
             
             // Create individual single-bit instances
             std::vector<std::shared_ptr<Instance>> resulting_singlebit_instances;
@@ -73,15 +78,6 @@ void perform_strategic_debanking(DesignDatabase& db) {
             record_debank_transformation(db, instance, resulting_singlebit_instances, 
                                        parent_cell_name);
             
-            // Record debank pin mappings to global storage
-            // Find the newly created debank transformation records and record their pin mappings
-            size_t records_start = db.transformation_history.size() - resulting_singlebit_instances.size();
-            for (size_t i = records_start; i < db.transformation_history.size(); i++) {
-                if (db.transformation_history[i].operation == TransformationRecord::DEBANK) {
-                    record_all_debank_pin_mappings_from_record(db.transformation_history[i]);
-                }
-            }
-            
             // Remove the corresponding KEEP record for this multi-bit instance
             remove_keep_transformation_record(db, instance->name);
             
@@ -93,8 +89,13 @@ void perform_strategic_debanking(DesignDatabase& db) {
     
     // Remove original multi-bit instances
     for (auto& instance_to_remove : instances_to_remove) {
-        // Find and erase from unordered_map
-        for (auto it = db.instances.begin(); it != db.instances.end(); ++it) {
+        // Find and erase from unordered_map (key lookup first; full scan only if the key differs)
+        auto it = db.instances.find(instance_to_remove->name);
+        if (it != db.instances.end() && it->second == instance_to_remove) {
+            db.instances.erase(it);
+            continue;
+        }
+        for (it = db.instances.begin(); it != db.instances.end(); ++it) {
             if (it->second == instance_to_remove) {
                 db.instances.erase(it);
                 break;
@@ -113,20 +114,10 @@ void perform_strategic_debanking(DesignDatabase& db) {
     
     // Capture DEBANK stage - all instances after debanking operation
     std::cout << "  Capturing DEBANK stage..." << std::endl;
-    std::vector<std::shared_ptr<Instance>> all_instances_after_debank;
-    for (const auto& inst_pair : db.instances) {
-        all_instances_after_debank.push_back(inst_pair.second);
-    }
-    
     // Get indices of new DEBANK transformation records
-    std::vector<size_t> debank_indices;
-    for (size_t i = 0; i < db.transformation_history.size(); i++) {
-        if (db.transformation_history[i].operation == TransformationRecord::DEBANK) {
-            debank_indices.push_back(i);
-        }
-    }
+    std::vector<size_t> debank_indices = db.transformation_history.indices_of(TransformationRecord::DEBANK);
     
-    db.complete_pipeline.capture_stage("DEBANK", all_instances_after_debank, debank_indices, &db.transformation_history);
+    db.complete_pipeline.capture_stage("DEBANK", db.instances, debank_indices, &db.transformation_history);
 }
 
 // Helper function to map connections from multi-bit FF to single-bit FF
@@ -154,6 +145,8 @@ void map_multibit_to_singlebit_connections(std::shared_ptr<Instance> multibit_in
         // If found, add to single-bit instance
         if (!connected_net.empty()) {
             singlebit_instance->connections.emplace_back(singlebit_pin_name, connected_net);
+            db.pin_provenance.forward_pin(multibit_instance->name, multibit_pin_name,
+                                          singlebit_instance->name, singlebit_pin_name);
         } else {
             // If not found, check for shared pins (like clock, reset)
             std::string shared_pin = find_shared_pin_connection(multibit_instance, singlebit_pin_name);
@@ -161,6 +154,9 @@ void map_multibit_to_singlebit_connections(std::shared_ptr<Instance> multibit_in
                 for (const auto& conn : multibit_instance->connections) {
                     if (conn.pin_name == shared_pin) {
                         singlebit_instance->connections.emplace_back(singlebit_pin_name, conn.net_name);
+                        // Shared pin: 第一個bit接手原始pin，之後的bit不會再forward
+                        db.pin_provenance.forward_pin(multibit_instance->name, shared_pin,
+                                                      singlebit_instance->name, singlebit_pin_name);
                         break;
                     }
                 }
@@ -214,15 +210,7 @@ std::string find_shared_pin_connection(std::shared_ptr<Instance> multibit_instan
 
 // Helper function to remove KEEP transformation record for a specific instance
 void remove_keep_transformation_record(DesignDatabase& db, const std::string& instance_name) {
-    auto it = db.transformation_history.begin();
-    while (it != db.transformation_history.end()) {
-        if (it->operation == TransformationRecord::KEEP && 
-            it->original_instance_name == instance_name) {
-            it = db.transformation_history.erase(it);
-        } else {
-            ++it;
-        }
-    }
+    db.transformation_history.remove_keep_record(instance_name);
 }
 
 // Export debanking results for analysis
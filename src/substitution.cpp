@@ -203,7 +203,7 @@ void execute_stage1_substitution(DesignDatabase& db) {
             }
             
             // Force write every 100 instances to prevent buffer issues
-            static int count = 0;
+            static thread_local int count = 0;
             count++;
             if (count % 100 == 0) {
 // stage1_report.flush();
@@ -393,7 +393,7 @@ void execute_stage2_substitution(DesignDatabase& db) {
             }
             
             // Force write every 100 instances
-            static int count = 0;
+            static thread_local int count = 0;
             count++;
             if (count % 100 == 0) {
 // stage2_report.flush();
@@ -642,7 +642,7 @@ void execute_stage3_substitution(DesignDatabase& db) {
             }
             
             // Force write every 100 instances
-            static int count = 0;
+            static thread_local int count = 0;
             count++;
             if (count % 100 == 0) {
 // stage3_report.flush();
@@ -672,7 +672,8 @@ void execute_stage3_substitution(DesignDatabase& db) {
 // =============================================================================
 
 // Create a map to store original cell types before any substitution
-std::map<std::string, std::string> original_cell_types;
+// (thread_local: 記錄和比對都在Step 11同一個stage裡，server mode同時跑的job各用各的)
+static thread_local std::map<std::string, std::string> original_cell_types;
 
 void record_final_substitution_operations(DesignDatabase& db) {
     int substitution_count = 0;
@@ -735,22 +736,12 @@ void execute_three_stage_substitution(DesignDatabase& db) {
     
     // Capture final substitution result
     std::cout << "  Capturing SUBSTITUTION stage..." << std::endl;
-    std::vector<std::shared_ptr<Instance>> all_instances_after_substitution;
-    for (const auto& inst_pair : db.instances) {
-        all_instances_after_substitution.push_back(inst_pair.second);
-    }
-    
     // Get indices of SUBSTITUTION transformation records
-    std::vector<size_t> substitution_indices;
-    for (size_t i = 0; i < db.transformation_history.size(); ++i) {
-        if (db.transformation_history[i].operation == TransformationRecord::SUBSTITUTE) {
-            substitution_indices.push_back(i);
-        }
-    }
+    std::vector<size_t> substitution_indices = db.transformation_history.indices_of(TransformationRecord::SUBSTITUTE);
     
     std::cout << "    Found " << substitution_indices.size() << " SUBSTITUTE transformation records" << std::endl;
     
-    db.complete_pipeline.capture_stage("SUBSTITUTION", all_instances_after_substitution, substitution_indices, &db.transformation_history);
+    db.complete_pipeline.capture_stage("SUBSTITUTION", db.instances, substitution_indices, &db.transformation_history);
     
     std::cout << "\n✅ Three-Stage Substitution Completed!" << std::endl;
 }
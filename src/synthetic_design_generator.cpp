@@ -0,0 +1,1004 @@
+// =============================================================================
+// SYNTHETIC DESIGN GENERATOR
+// =============================================================================
+// 產生一組互相一致的 Verilog / DEF / weight / SDC 輸入，外加精簡的 liberty / LEF
+// (只含testcase1用到的cell名稱與banking需要的屬性)，讓整個flow可以在不同規模下跑
+//
+// 可調參數：FF bit數 (10k ~ 5M)、multi-bit FF比例、hierarchy深度、clock domain數、
+// row數、placement blockage密度、utilization、組合邏輯比例、scan chain長度、clock buffer fanout
+//
+// 結構：
+// - 每個FF bit b 的輸出net是 q_b；若有driver gate，D接 d_b，否則直接接輸入port
+// - 前面一部分FF的Q經過BUF_ECO接到輸出port
+// - hierarchy決定DEF中的component名稱 (blk0_3/blk1_1/ff_12)，Verilog仍是flat名稱
+// - placement依hierarchy順序一排一排放，保證合法且同一個block空間上相鄰
+// - 固定seed產生固定結果
+//
+// 使用方式：
+//   ./synthetic_design_generator -ff 100000 -out ../synthetic/ff100000
+// =============================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+// Physical constants shared with testcase1 (DEF units: 1000 DBU / micron)
+#define GEN_DBU_PER_MICRON 1000
+#define GEN_ROW_HEIGHT 600
+#define GEN_SITE_WIDTH 74
+#define GEN_DIE_MARGIN 5000
+
+// =============================================================================
+// CONFIGURATION
+// =============================================================================
+
+struct GeneratorConfig {
+    long ff_bits = 10000;              // Total flip-flop bits
+    double multibit_fraction = 0.1;    // Fraction of bits already in 2/4-bit cells
+    int hierarchy_depth = 2;           // Levels of blkN_ prefixes in DEF component names
+    int hierarchy_fanout = 4;          // Children per hierarchy level
+    int clock_domains = 1;             // clk, clock_1, clock_2, ...
+    int rows = 0;                      // 0 = square die from total cell area
+    double blockage_density = 0.05;    // Fraction of the core covered by placement blockages
+    double utilization = 0.6;          // Cell area / free row area
+    double logic_ratio = 1.0;          // Combinational gates per FF bit
+    int scan_chain_length = 0;         // FF instances per scan chain (0 = SI/SE unconnected)
+    int clock_fanout = 0;              // FF instances per clock buffer (0 = CK on the clock port)
+    unsigned seed = 1;
+    std::string design_name = "top";
+    std::string output_dir;
+};
+
+// =============================================================================
+// CELL LIBRARY (names taken from testcase1)
+// =============================================================================
+
+struct GenCell {
+    std::string name;
+    int width_sites;
+    bool is_ff;
+    int bit_width;
+    bool has_qn;
+    std::string single_bit_degenerate;   // "" = none
+    std::vector<std::pair<std::string, std::string>> pins;  // (name, INPUT/OUTPUT)
+    std::string function;                // Liberty function of the (single) output pin, "" = none
+};
+
+static const char* LIBRARY_PREFIXES[] = {"SNPSHOPT25_", "SNPSLOPT25_", "SNPSROPT25_", "SNPSSLOPT25_"};
+static const char* LIBRARY_FILES[] = {"snps25hopt", "snps25lopt", "snps25ropt", "snps25slopt"};
+static const int LIBRARY_COUNT = 4;
+
+static std::vector<std::pair<std::string, std::string>> ff_pins(int bits, bool has_qn) {
+    std::vector<std::pair<std::string, std::string>> pins;
+    for (int b = 0; b < bits; b++) {
+        pins.push_back(std::make_pair(bits == 1 ? std::string("D") : "D" + std::to_string(b), std::string("INPUT")));
+    }
+    pins.push_back(std::make_pair(std::string("SI"), std::string("INPUT")));
+    pins.push_back(std::make_pair(std::string("SE"), std::string("INPUT")));
+    pins.push_back(std::make_pair(std::string("CK"), std::string("INPUT")));
+    for (int b = 0; b < bits; b++) {
+        pins.push_back(std::make_pair(bits == 1 ? std::string("Q") : "Q" + std::to_string(b), std::string("OUTPUT")));
+    }
+    if (has_qn) {
+        for (int b = 0; b < bits; b++) {
+            pins.push_back(std::make_pair(bits == 1 ? std::string("QN") : "QN" + std::to_string(b), std::string("OUTPUT")));
+        }
+    }
+    return pins;
+}
+
+static std::vector<GenCell> build_cell_list(const std::string& prefix) {
+    std::vector<GenCell> cells;
+    const char* ff_drives[] = {"1", "2", "4"};
+    for (const char* drive : ff_drives) {
+        cells.push_back({prefix + "FSDN_V2_" + drive, 13, true, 1, true, "", ff_pins(1, true), ""});
+        cells.push_back({prefix + "FSDNQ_V3_" + drive, 12, true, 1, false, "", ff_pins(1, false), ""});
+    }
+    const char* mb_drives[] = {"0P5", "1", "2"};
+    for (int i = 0; i < 2; i++) {
+        cells.push_back({prefix + "FSDN2_V2_" + mb_drives[i], 22, true, 2, true, prefix + "FSDN_V2_1", ff_pins(2, true), ""});
+    }
+    for (int i = 0; i < 3; i++) {
+        cells.push_back({prefix + "FSDN4_V2_" + mb_drives[i], 40, true, 4, true, prefix + "FSDN_V2_1", ff_pins(4, true), ""});
+    }
+
+    typedef std::vector<std::pair<std::string, std::string>> PinList;
+    cells.push_back({prefix + "AN2_MM_3", 5, false, 1, false, "",
+                     PinList{{"A1", "INPUT"}, {"A2", "INPUT"}, {"X", "OUTPUT"}}, "(A1&A2)"});
+    cells.push_back({prefix + "OR2_MM_2", 5, false, 1, false, "",
+                     PinList{{"A1", "INPUT"}, {"A2", "INPUT"}, {"X", "OUTPUT"}}, "(A1|A2)"});
+    cells.push_back({prefix + "INV_4", 3, false, 1, false, "",
+                     PinList{{"A", "INPUT"}, {"X", "OUTPUT"}}, "(!A)"});
+    cells.push_back({prefix + "BUF_ECO_2", 4, false, 1, false, "",
+                     PinList{{"A", "INPUT"}, {"X", "OUTPUT"}}, "A"});
+    return cells;
+}
+
+// =============================================================================
+// NETLIST MODEL
+// =============================================================================
+// Net id 編碼 (避免存幾百萬個字串)：
+//   [0, B)        q_<b>
+//   [B, 2B)       d_<b>
+//   [2B, ...)     port nets (clk, in[i], out[i], scan_en, scan_in[i])，之後是clock buffer的輸出net
+
+struct GenInstance {
+    uint32_t cell;          // Index into the merged cell list
+    uint32_t first_bit;     // FF: first bit index; gate: driven bit index
+    uint8_t kind;           // 0 = FF, 1 = logic gate, 2 = output buffer, 3 = clock buffer
+    uint8_t domain;
+    uint32_t leaf;          // Hierarchy leaf block
+    int32_t x = -1;
+    int32_t y = -1;
+    uint8_t row_orient = 0; // 0 = N, 1 = FS
+};
+
+struct GenConnection {
+    uint32_t net;
+    uint32_t instance;      // UINT32_MAX = top-level port
+    uint16_t pin;           // Index into pin name table (ignored for ports)
+
+    bool operator<(const GenConnection& other) const {
+        if (net != other.net) return net < other.net;
+        return instance < other.instance;
+    }
+};
+
+class SyntheticDesign {
+public:
+    explicit SyntheticDesign(const GeneratorConfig& config)
+        : config_(config), rng_(config.seed) {}
+
+    bool generate();
+
+private:
+    // --- Construction ---
+    void build_library();
+    void build_ports();
+    void build_flip_flops();
+    void build_logic();
+    void build_clock_tree();
+    void place_instances();
+
+    // --- Output ---
+    bool write_liberty() const;
+    bool write_lef() const;
+    bool write_verilog() const;
+    bool write_def();
+    bool write_sdc() const;
+    bool write_weight() const;
+    bool write_run_args() const;
+
+    // --- Helpers ---
+    uint32_t pin_id(const std::string& name);
+    std::string net_name(uint32_t net) const;
+    std::string instance_name(uint32_t index) const;
+    std::string hierarchical_name(uint32_t index) const;
+    uint32_t port_net(size_t port_index) const { return static_cast<uint32_t>(2 * config_.ff_bits + port_index); }
+    uint32_t q_net(long bit) const { return static_cast<uint32_t>(bit); }
+    uint32_t d_net(long bit) const { return static_cast<uint32_t>(config_.ff_bits + bit); }
+    uint32_t clock_leaf_net(size_t leaf) const { return static_cast<uint32_t>(2 * config_.ff_bits + port_names_.size() + leaf); }
+    void connect(uint32_t net, uint32_t instance, const std::string& pin);
+    std::string path(const std::string& file) const { return config_.output_dir + "/" + file; }
+
+    const GeneratorConfig& config_;
+    std::mt19937 rng_;
+
+    std::vector<GenCell> cells_;
+    std::vector<uint32_t> single_bit_ff_cells_;
+    std::vector<uint32_t> two_bit_ff_cells_;
+    std::vector<uint32_t> four_bit_ff_cells_;
+    uint32_t and_cell_ = 0, or_cell_ = 0, inv_cell_ = 0, buf_cell_ = 0;
+
+    std::vector<std::string> pin_names_;
+    std::vector<std::string> port_names_;
+    std::vector<bool> port_is_input_;
+    std::vector<size_t> clock_ports_;
+    std::vector<size_t> input_ports_;
+    std::vector<size_t> output_ports_;
+    std::vector<size_t> scan_in_ports_;
+    size_t scan_enable_port_ = 0;
+
+    std::vector<GenInstance> instances_;
+    std::vector<GenConnection> connections_;
+    std::vector<uint32_t> clock_leaf_first_ff_; // First FF instance driven by each clock buffer
+    std::vector<uint32_t> bit_owner_;          // FF instance for each bit
+    std::vector<bool> d_driven_;               // d_<b> exists (bit has a driver gate)
+    uint32_t ff_instance_count_ = 0;
+    uint32_t leaf_count_ = 1;
+
+    long row_count_ = 0;
+    long sites_per_row_ = 0;
+    std::vector<std::vector<std::pair<long, long>>> blocked_sites_;   // Per row, [begin, end) in sites
+    std::vector<std::pair<long, long>> blockage_rects_;                // (row, begin site) per blockage
+    std::vector<std::pair<long, long>> blockage_sizes_;                // (rows, sites)
+};
+
+uint32_t SyntheticDesign::pin_id(const std::string& name) {
+    for (size_t i = 0; i < pin_names_.size(); i++) {
+        if (pin_names_[i] == name) return static_cast<uint32_t>(i);
+    }
+    pin_names_.push_back(name);
+    return static_cast<uint32_t>(pin_names_.size() - 1);
+}
+
+std::string SyntheticDesign::net_name(uint32_t net) const {
+    long bits = config_.ff_bits;
+    if (net < bits) return "q_" + std::to_string(net);
+    if (net < 2 * bits) return "d_" + std::to_string(net - bits);
+    if (static_cast<size_t>(net - 2 * bits) < port_names_.size()) return port_names_[net - 2 * bits];
+    return "clk_leaf_" + std::to_string(net - 2 * bits - port_names_.size());
+}
+
+std::string SyntheticDesign::instance_name(uint32_t index) const {
+    if (index < ff_instance_count_) return "ff_" + std::to_string(index);
+    return "g_" + std::to_string(index - ff_instance_count_);
+}
+
+std::string SyntheticDesign::hierarchical_name(uint32_t index) const {
+    std::string name;
+    uint32_t leaf = instances_[index].leaf;
+    uint32_t divisor = leaf_count_;
+    for (int level = 0; level < config_.hierarchy_depth; level++) {
+        divisor /= config_.hierarchy_fanout;
+        name += "blk" + std::to_string(level) + "_" + std::to_string((leaf / divisor) % config_.hierarchy_fanout) + "/";
+    }
+    return name + instance_name(index);
+}
+
+void SyntheticDesign::connect(uint32_t net, uint32_t instance, const std::string& pin) {
+    GenConnection conn;
+    conn.net = net;
+    conn.instance = instance;
+    conn.pin = static_cast<uint16_t>(pin_id(pin));
+    connections_.push_back(conn);
+}
+
+// =============================================================================
+// CONSTRUCTION
+// =============================================================================
+
+void SyntheticDesign::build_library() {
+    for (int lib = 0; lib < LIBRARY_COUNT; lib++) {
+        std::vector<GenCell> lib_cells = build_cell_list(LIBRARY_PREFIXES[lib]);
+        for (const auto& cell : lib_cells) {
+            uint32_t index = static_cast<uint32_t>(cells_.size());
+            cells_.push_back(cell);
+            if (cell.is_ff && cell.bit_width == 1) single_bit_ff_cells_.push_back(index);
+            if (cell.is_ff && cell.bit_width == 2) two_bit_ff_cells_.push_back(index);
+            if (cell.is_ff && cell.bit_width == 4) four_bit_ff_cells_.push_back(index);
+
+            // testcase1的組合邏輯來自這幾個library
+            if (cell.name == "SNPSLOPT25_AN2_MM_3") and_cell_ = index;
+            if (cell.name == "SNPSSLOPT25_OR2_MM_2") or_cell_ = index;
+            if (cell.name == "SNPSSLOPT25_INV_4") inv_cell_ = index;
+            if (cell.name == "SNPSLOPT25_BUF_ECO_2") buf_cell_ = index;
+        }
+    }
+}
+
+void SyntheticDesign::build_ports() {
+    for (int d = 0; d < config_.clock_domains; d++) {
+        clock_ports_.push_back(port_names_.size());
+        port_names_.push_back(d == 0 ? "clk" : "clock_" + std::to_string(d));
+        port_is_input_.push_back(true);
+    }
+
+    long input_width = std::max(16L, config_.ff_bits / 100);
+    for (long i = 0; i < input_width; i++) {
+        input_ports_.push_back(port_names_.size());
+        port_names_.push_back("in[" + std::to_string(i) + "]");
+        port_is_input_.push_back(true);
+    }
+
+    long output_width = std::max(16L, std::min(config_.ff_bits, config_.ff_bits / 50));
+    for (long i = 0; i < output_width; i++) {
+        output_ports_.push_back(port_names_.size());
+        port_names_.push_back("out[" + std::to_string(i) + "]");
+        port_is_input_.push_back(false);
+    }
+
+    scan_enable_port_ = port_names_.size();
+    port_names_.push_back("scan_en");
+    port_is_input_.push_back(true);
+}
+
+void SyntheticDesign::build_flip_flops() {
+    // multi-bit instance的機率p：期望bit比例 = 3p / (3p + (1-p)) = f (2/4-bit各半，平均3 bits)
+    double f = std::min(0.99, std::max(0.0, config_.multibit_fraction));
+    double p = f / (3.0 - 2.0 * f);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    bit_owner_.assign(config_.ff_bits, 0);
+    long bit = 0;
+    while (bit < config_.ff_bits) {
+        GenInstance inst;
+        inst.kind = 0;
+        inst.first_bit = static_cast<uint32_t>(bit);
+
+        long remaining = config_.ff_bits - bit;
+        double roll = uniform(rng_);
+        const std::vector<uint32_t>* pool = &single_bit_ff_cells_;
+        if (roll < p / 2 && remaining >= 4) pool = &four_bit_ff_cells_;
+        else if (roll < p && remaining >= 2) pool = &two_bit_ff_cells_;
+        inst.cell = (*pool)[rng_() % pool->size()];
+
+        uint32_t index = static_cast<uint32_t>(instances_.size());
+        for (int b = 0; b < cells_[inst.cell].bit_width; b++) {
+            bit_owner_[bit + b] = index;
+        }
+        bit += cells_[inst.cell].bit_width;
+        instances_.push_back(inst);
+    }
+    ff_instance_count_ = static_cast<uint32_t>(instances_.size());
+
+    leaf_count_ = 1;
+    for (int level = 0; level < config_.hierarchy_depth; level++) leaf_count_ *= config_.hierarchy_fanout;
+
+    // hierarchy leaf連續分配；clock domain跟著leaf走 (一個block一個domain)
+    for (uint32_t i = 0; i < ff_instance_count_; i++) {
+        GenInstance& inst = instances_[i];
+        inst.leaf = static_cast<uint32_t>((static_cast<uint64_t>(i) * leaf_count_) / ff_instance_count_);
+        inst.domain = static_cast<uint8_t>(inst.leaf % config_.clock_domains);
+    }
+
+    // Scan chains (instance level: SI接前一個instance的最後一個Q)
+    int chain_count = 0;
+    if (config_.scan_chain_length > 0) {
+        chain_count = static_cast<int>((ff_instance_count_ + config_.scan_chain_length - 1) / config_.scan_chain_length);
+        for (int c = 0; c < chain_count; c++) {
+            scan_in_ports_.push_back(port_names_.size());
+            port_names_.push_back("scan_in[" + std::to_string(c) + "]");
+            port_is_input_.push_back(true);
+        }
+    }
+
+    // Clock buffer leaves：連續clock_fanout個FF (同一個leaf block) 共用一個clock buffer
+    for (uint32_t i = 0; i < ff_instance_count_; i++) {
+        const GenInstance& inst = instances_[i];
+        const GenCell& cell = cells_[inst.cell];
+        if (config_.clock_fanout > 0) {
+            bool new_leaf = clock_leaf_first_ff_.empty() || inst.leaf != instances_[clock_leaf_first_ff_.back()].leaf ||
+                            i - clock_leaf_first_ff_.back() >= static_cast<uint32_t>(config_.clock_fanout);
+            if (new_leaf) clock_leaf_first_ff_.push_back(i);
+            connect(clock_leaf_net(clock_leaf_first_ff_.size() - 1), i, "CK");
+        } else {
+            connect(port_net(clock_ports_[inst.domain]), i, "CK");
+        }
+        for (int b = 0; b < cell.bit_width; b++) {
+            connect(q_net(inst.first_bit + b), i, cell.bit_width == 1 ? "Q" : "Q" + std::to_string(b));
+        }
+        if (config_.scan_chain_length > 0) {
+            connect(port_net(scan_enable_port_), i, "SE");
+            if (i % config_.scan_chain_length == 0) {
+                connect(port_net(scan_in_ports_[i / config_.scan_chain_length]), i, "SI");
+            } else {
+                const GenInstance& prev = instances_[i - 1];
+                connect(q_net(prev.first_bit + cells_[prev.cell].bit_width - 1), i, "SI");
+            }
+        }
+    }
+}
+
+void SyntheticDesign::build_logic() {
+    long bits = config_.ff_bits;
+    long gate_count = std::min(bits, static_cast<long>(std::llround(config_.logic_ratio * bits)));
+    d_driven_.assign(bits, false);
+
+    // 選擇gate輸入：附近FF的Q或輸入port，讓net有locality
+    auto pick_source = [&](long bit) -> uint32_t {
+        if (rng_() % 4 == 0) {
+            return port_net(input_ports_[rng_() % input_ports_.size()]);
+        }
+        long window = 512;
+        long lo = std::max(0L, bit - window);
+        long hi = std::min(bits - 1, bit + window);
+        return q_net(lo + static_cast<long>(rng_() % static_cast<unsigned long>(hi - lo + 1)));
+    };
+
+    // D pin：有gate的bit接 d_b，其餘直接接輸入port
+    for (long bit = 0; bit < bits; bit++) {
+        uint32_t owner = bit_owner_[bit];
+        const GenCell& cell = cells_[instances_[owner].cell];
+        long local = bit - instances_[owner].first_bit;
+        std::string d_pin = cell.bit_width == 1 ? "D" : "D" + std::to_string(local);
+
+        if (bit < gate_count) {
+            d_driven_[bit] = true;
+            GenInstance gate;
+            gate.kind = 1;
+            gate.first_bit = static_cast<uint32_t>(bit);
+            gate.leaf = instances_[owner].leaf;
+            gate.domain = instances_[owner].domain;
+            int choice = static_cast<int>(bit % 3);
+            gate.cell = choice == 0 ? and_cell_ : (choice == 1 ? or_cell_ : inv_cell_);
+
+            uint32_t gate_index = static_cast<uint32_t>(instances_.size());
+            instances_.push_back(gate);
+            connect(d_net(bit), gate_index, "X");
+            if (gate.cell == inv_cell_) {
+                connect(pick_source(bit), gate_index, "A");
+            } else {
+                connect(pick_source(bit), gate_index, "A1");
+                connect(pick_source(bit), gate_index, "A2");
+            }
+            connect(d_net(bit), owner, d_pin);
+        } else {
+            connect(port_net(input_ports_[bit % input_ports_.size()]), owner, d_pin);
+        }
+    }
+
+    // 輸出port：BUF_ECO(A = q_b) -> out[i]
+    for (size_t i = 0; i < output_ports_.size(); i++) {
+        long bit = static_cast<long>((i * 7919) % static_cast<size_t>(bits));
+        GenInstance buffer;
+        buffer.kind = 2;
+        buffer.cell = buf_cell_;
+        buffer.first_bit = static_cast<uint32_t>(bit);
+        buffer.leaf = instances_[bit_owner_[bit]].leaf;
+        buffer.domain = instances_[bit_owner_[bit]].domain;
+        uint32_t index = static_cast<uint32_t>(instances_.size());
+        instances_.push_back(buffer);
+        connect(q_net(bit), index, "A");
+        connect(port_net(output_ports_[i]), index, "X");
+    }
+
+    // Port side of every port net
+    for (size_t p = 0; p < port_names_.size(); p++) {
+        GenConnection conn;
+        conn.net = port_net(p);
+        conn.instance = UINT32_MAX;
+        conn.pin = 0;
+        connections_.push_back(conn);
+    }
+}
+
+// Clock buffer：BUF_ECO(A = clock port) -> clk_leaf_<k> -> FF CK
+void SyntheticDesign::build_clock_tree() {
+    for (size_t leaf = 0; leaf < clock_leaf_first_ff_.size(); leaf++) {
+        const GenInstance& ff = instances_[clock_leaf_first_ff_[leaf]];
+        GenInstance buffer;
+        buffer.kind = 3;
+        buffer.cell = buf_cell_;
+        buffer.first_bit = ff.first_bit;
+        buffer.leaf = ff.leaf;
+        buffer.domain = ff.domain;
+        uint32_t index = static_cast<uint32_t>(instances_.size());
+        instances_.push_back(buffer);
+        connect(port_net(clock_ports_[buffer.domain]), index, "A");
+        connect(clock_leaf_net(leaf), index, "X");
+    }
+}
+
+void SyntheticDesign::place_instances() {
+    // --- Die sizing ---
+    long total_sites = 0;
+    for (const auto& inst : instances_) total_sites += cells_[inst.cell].width_sites;
+
+    double free_fraction = std::max(0.05, 1.0 - config_.blockage_density);
+    double needed_sites = total_sites / (config_.utilization * free_fraction) * 1.1;  // 10% slack
+    if (config_.rows > 0) {
+        row_count_ = config_.rows;
+        sites_per_row_ = static_cast<long>(std::ceil(needed_sites / row_count_));
+    } else {
+        double side_dbu = std::sqrt(needed_sites * GEN_SITE_WIDTH * GEN_ROW_HEIGHT);
+        row_count_ = std::max(1L, static_cast<long>(std::ceil(side_dbu / GEN_ROW_HEIGHT)));
+        sites_per_row_ = static_cast<long>(std::ceil(needed_sites / row_count_));
+    }
+    sites_per_row_ = std::max(sites_per_row_, 64L);
+
+    // --- Placement blockages (不重疊的矩形，對齊row/site) ---
+    blocked_sites_.assign(row_count_, std::vector<std::pair<long, long>>());
+    double target_blocked = config_.blockage_density * row_count_ * sites_per_row_;
+    double blocked = 0.0;
+    int attempts = 0;
+    while (blocked < target_blocked && attempts < 100000) {
+        attempts++;
+        long rows_tall = std::min(row_count_, 2L + static_cast<long>(rng_() % 7));
+        long sites_wide = std::min(sites_per_row_ / 2, 20L + static_cast<long>(rng_() % 61));
+        if (sites_wide <= 0) break;
+        long row0 = static_cast<long>(rng_() % static_cast<unsigned long>(row_count_ - rows_tall + 1));
+        long site0 = static_cast<long>(rng_() % static_cast<unsigned long>(sites_per_row_ - sites_wide + 1));
+
+        bool overlaps = false;
+        for (long r = row0; r < row0 + rows_tall && !overlaps; r++) {
+            for (const auto& interval : blocked_sites_[r]) {
+                if (site0 < interval.second && interval.first < site0 + sites_wide) {
+                    overlaps = true;
+                    break;
+                }
+            }
+        }
+        if (overlaps) continue;
+
+        for (long r = row0; r < row0 + rows_tall; r++) {
+            blocked_sites_[r].push_back(std::make_pair(site0, site0 + sites_wide));
+        }
+        blockage_rects_.push_back(std::make_pair(row0, site0));
+        blockage_sizes_.push_back(std::make_pair(rows_tall, sites_wide));
+        blocked += static_cast<double>(rows_tall * sites_wide);
+    }
+    for (auto& intervals : blocked_sites_) std::sort(intervals.begin(), intervals.end());
+
+    // --- Placement order：依leaf排，FF後面接它自己的gate，空間上和邏輯上相近 ---
+    std::vector<std::vector<uint32_t>> gates_of_ff(ff_instance_count_);
+    for (uint32_t i = ff_instance_count_; i < instances_.size(); i++) {
+        gates_of_ff[bit_owner_[instances_[i].first_bit]].push_back(i);
+    }
+    std::vector<uint32_t> order;
+    order.reserve(instances_.size());
+    for (uint32_t i = 0; i < ff_instance_count_; i++) {
+        order.push_back(i);
+        order.insert(order.end(), gates_of_ff[i].begin(), gates_of_ff[i].end());
+    }
+
+    // --- Row packing with random gaps to hit the utilization target ---
+    double mean_gap_factor = (1.0 / config_.utilization) - 1.0;
+    long row = 0;
+    long site = 0;
+    size_t next_interval = 0;
+    for (uint32_t index : order) {
+        GenInstance& inst = instances_[index];
+        long width = cells_[inst.cell].width_sites;
+        long max_gap = static_cast<long>(std::ceil(2.0 * mean_gap_factor * width));
+        long gap = max_gap > 0 ? static_cast<long>(rng_() % static_cast<unsigned long>(max_gap + 1)) : 0;
+        site += gap;
+
+        bool placed = false;
+        while (!placed && row < row_count_) {
+            const auto& intervals = blocked_sites_[row];
+            while (next_interval < intervals.size() && intervals[next_interval].second <= site) next_interval++;
+            if (next_interval < intervals.size() && intervals[next_interval].first < site + width) {
+                site = intervals[next_interval].second;
+                continue;
+            }
+            if (site + width > sites_per_row_) {
+                row++;
+                site = 0;
+                next_interval = 0;
+                continue;
+            }
+            placed = true;
+        }
+        if (!placed) {
+            // 理論上有10% slack不會發生；保險起見放在最後一排的開頭
+            row = row_count_ - 1;
+            site = 0;
+        }
+
+        inst.x = static_cast<int32_t>(GEN_DIE_MARGIN + site * GEN_SITE_WIDTH);
+        inst.y = static_cast<int32_t>(GEN_DIE_MARGIN + row * GEN_ROW_HEIGHT);
+        inst.row_orient = static_cast<uint8_t>(row % 2 == 0 ? 1 : 0);   // testcase1: 第一排FS
+        site += width;
+    }
+}
+
+// =============================================================================
+// OUTPUT WRITERS
+// =============================================================================
+
+bool SyntheticDesign::write_liberty() const {
+    for (int lib = 0; lib < LIBRARY_COUNT; lib++) {
+        std::string filename = path(std::string("lib/") + LIBRARY_FILES[lib] + "_base_tt0p8v25c.lib");
+        std::ofstream out(filename);
+        if (!out.is_open()) {
+            std::cerr << "Error: Cannot open " << filename << " for writing" << std::endl;
+            return false;
+        }
+        out << "library(" << LIBRARY_FILES[lib] << "_base_tt0p8v25c) {\n";
+        out << "  /* synthetic subset generated by synthetic_design_generator */\n";
+        out << "  time_unit : \"1ns\" ;\n  leakage_power_unit : \"1nW\" ;\n";
+        for (const auto& cell : cells_) {
+            if (cell.name.compare(0, std::string(LIBRARY_PREFIXES[lib]).size(), LIBRARY_PREFIXES[lib]) != 0) continue;
+            double area = cell.width_sites * (GEN_SITE_WIDTH / 1000.0) * (GEN_ROW_HEIGHT / 1000.0);
+            out << "  cell(" << cell.name << ") {\n";
+            out << "    area : " << area << " ;\n";
+            out << "    cell_leakage_power : " << (cell.is_ff ? 2.5 * cell.bit_width : 0.8) << " ;\n";
+            if (!cell.single_bit_degenerate.empty()) {
+                out << "    single_bit_degenerate : \"" << cell.single_bit_degenerate << "\" ;\n";
+            }
+            if (cell.is_ff) {
+                out << "    ff(IQ,IQN) {\n      clocked_on : \"CK\" ;\n      next_state : \"(D&!SE)|(SI&SE)\" ;\n    }\n";
+            }
+            for (const auto& pin : cell.pins) {
+                out << "    pin(" << pin.first << ") { direction : "
+                    << (pin.second == "INPUT" ? "input" : "output") << " ;";
+                if (pin.second == "OUTPUT" && !cell.function.empty()) out << " function : \"" << cell.function << "\" ;";
+                out << " }\n";
+            }
+            out << "  }\n";
+        }
+        out << "}\n";
+    }
+    return true;
+}
+
+bool SyntheticDesign::write_lef() const {
+    for (int lib = 0; lib < LIBRARY_COUNT; lib++) {
+        std::string filename = path(std::string("lef/") + LIBRARY_FILES[lib] + ".lef");
+        std::ofstream out(filename);
+        if (!out.is_open()) {
+            std::cerr << "Error: Cannot open " << filename << " for writing" << std::endl;
+            return false;
+        }
+        out << "VERSION 5.8 ;\nBUSBITCHARS \"[]\" ;\nDIVIDERCHAR \"/\" ;\n";
+        out << "UNITS\n  DATABASE MICRONS " << GEN_DBU_PER_MICRON << " ;\nEND UNITS\n\n";
+        out << "SITE unit\n  CLASS CORE ;\n  SIZE " << GEN_SITE_WIDTH / 1000.0 << " BY "
+            << GEN_ROW_HEIGHT / 1000.0 << " ;\nEND unit\n\n";
+        for (const auto& cell : cells_) {
+            if (cell.name.compare(0, std::string(LIBRARY_PREFIXES[lib]).size(), LIBRARY_PREFIXES[lib]) != 0) continue;
+            out << "MACRO " << cell.name << "\n";
+            out << "  CLASS CORE ;\n  ORIGIN 0 0 ;\n";
+            out << "  SIZE " << cell.width_sites * GEN_SITE_WIDTH / 1000.0 << " BY " << GEN_ROW_HEIGHT / 1000.0 << " ;\n";
+            out << "  SITE unit ;\n";
+            for (const auto& pin : cell.pins) {
+                out << "  PIN " << pin.first << "\n";
+                out << "    DIRECTION " << pin.second << " ;\n";
+                out << "    USE " << (pin.first == "CK" ? "CLOCK" : "SIGNAL") << " ;\n";
+                out << "  END " << pin.first << "\n";
+            }
+            out << "END " << cell.name << "\n\n";
+        }
+        out << "END LIBRARY\n";
+    }
+    return true;
+}
+
+bool SyntheticDesign::write_verilog() const {
+    std::string filename = path(config_.design_name + ".v");
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot open " << filename << " for writing" << std::endl;
+        return false;
+    }
+
+    // Header: scalar clocks / scan_en, bus in / out / scan_in
+    out << "module " << config_.design_name << " ( ";
+    for (size_t port : clock_ports_) out << port_names_[port] << " , ";
+    out << "in , out , scan_en";
+    if (!scan_in_ports_.empty()) out << " , scan_in";
+    out << " ) ;\n";
+    for (size_t port : clock_ports_) out << "input  " << port_names_[port] << " ;\n";
+    out << "input  [" << input_ports_.size() - 1 << ":0] in ;\n";
+    out << "output [" << output_ports_.size() - 1 << ":0] out ;\n";
+    out << "input  scan_en ;\n";
+    if (!scan_in_ports_.empty()) out << "input  [" << scan_in_ports_.size() - 1 << ":0] scan_in ;\n";
+    out << "\n";
+
+    for (long bit = 0; bit < config_.ff_bits; bit++) {
+        out << "wire " << net_name(q_net(bit)) << " ;\n";
+        if (d_driven_[bit]) out << "wire " << net_name(d_net(bit)) << " ;\n";
+    }
+    for (size_t leaf = 0; leaf < clock_leaf_first_ff_.size(); leaf++) {
+        out << "wire " << net_name(clock_leaf_net(leaf)) << " ;\n";
+    }
+    out << "\n";
+
+    // 依instance整理connections (connections_是依建構順序，先建index)
+    std::vector<uint32_t> begin(instances_.size() + 1, 0);
+    for (const auto& conn : connections_) {
+        if (conn.instance != UINT32_MAX) begin[conn.instance + 1]++;
+    }
+    for (size_t i = 0; i < instances_.size(); i++) begin[i + 1] += begin[i];
+    std::vector<uint32_t> by_instance(begin.back());
+    std::vector<uint32_t> fill(begin.begin(), begin.end() - 1);
+    for (uint32_t c = 0; c < connections_.size(); c++) {
+        if (connections_[c].instance != UINT32_MAX) by_instance[fill[connections_[c].instance]++] = c;
+    }
+
+    long unconnected = 0;
+    for (uint32_t i = 0; i < instances_.size(); i++) {
+        const GenCell& cell = cells_[instances_[i].cell];
+        out << cell.name << " " << instance_name(i) << " ( ";
+        bool first = true;
+        for (const auto& pin : cell.pins) {
+            std::string net;
+            for (uint32_t k = begin[i]; k < begin[i + 1]; k++) {
+                const GenConnection& conn = connections_[by_instance[k]];
+                if (pin_names_[conn.pin] == pin.first) {
+                    net = net_name(conn.net);
+                    break;
+                }
+            }
+            if (net.empty()) {
+                // 沒接的pin：輸出pin和scan pin標成SYNOPSYS_UNCONNECTED (同testcase1)
+                net = "SYNOPSYS_UNCONNECTED_" + std::to_string(++unconnected);
+            }
+            out << (first ? "" : " , ") << "." << pin.first << " ( " << net << " )";
+            first = false;
+        }
+        out << " ) ;\n";
+    }
+    out << "endmodule\n";
+    return true;
+}
+
+bool SyntheticDesign::write_def() {
+    std::string filename = path(config_.design_name + ".def");
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot open " << filename << " for writing" << std::endl;
+        return false;
+    }
+
+    long die_x = 2 * GEN_DIE_MARGIN + sites_per_row_ * GEN_SITE_WIDTH;
+    long die_y = 2 * GEN_DIE_MARGIN + row_count_ * GEN_ROW_HEIGHT;
+
+    out << "VERSION 5.8 ;\nDIVIDERCHAR \"/\" ;\nBUSBITCHARS \"[]\" ;\n";
+    out << "DESIGN " << config_.design_name << " ;\n";
+    out << "UNITS DISTANCE MICRONS " << GEN_DBU_PER_MICRON << " ;\n";
+    out << "DIEAREA ( 0 0 ) ( 0 " << die_y << " ) ( " << die_x << " " << die_y << " ) ( " << die_x << " 0 ) ;\n";
+    for (long r = 0; r < row_count_; r++) {
+        out << "ROW unit_row_" << r + 1 << " unit " << GEN_DIE_MARGIN << " " << GEN_DIE_MARGIN + r * GEN_ROW_HEIGHT
+            << " " << (r % 2 == 0 ? "FS" : "N") << " DO " << sites_per_row_ << " BY 1 STEP " << GEN_SITE_WIDTH << " 0 ;\n";
+    }
+
+    out << "COMPONENTS " << instances_.size() << " ;\n";
+    for (uint32_t i = 0; i < instances_.size(); i++) {
+        const GenInstance& inst = instances_[i];
+        out << " - " << hierarchical_name(i) << " " << cells_[inst.cell].name << " + PLACED ( "
+            << inst.x << " " << inst.y << " ) " << (inst.row_orient ? "FS" : "N") << " ;\n";
+    }
+    out << "END COMPONENTS\n";
+
+    // Pins：輸入在下邊，輸出在左邊
+    out << "PINS " << port_names_.size() << " ;\n";
+    long input_index = 0;
+    long output_index = 0;
+    for (size_t p = 0; p < port_names_.size(); p++) {
+        long x = 0, y = 0;
+        if (port_is_input_[p]) {
+            x = std::min(die_x - 200, 1000 + input_index++ * 200);
+        } else {
+            y = std::min(die_y - 200, 1000 + output_index++ * 200);
+        }
+        out << " - " << port_names_[p] << " + NET " << port_names_[p] << " + DIRECTION "
+            << (port_is_input_[p] ? "INPUT" : "OUTPUT") << " + USE SIGNAL\n";
+        out << "   + LAYER M3 ( 0 0 ) ( 34 148 )\n";
+        out << "   + PLACED ( " << x << " " << y << " ) N ;\n";
+    }
+    out << "END PINS\n";
+
+    if (!blockage_rects_.empty()) {
+        out << "BLOCKAGES " << blockage_rects_.size() << " ;\n";
+        for (size_t b = 0; b < blockage_rects_.size(); b++) {
+            long x1 = GEN_DIE_MARGIN + blockage_rects_[b].second * GEN_SITE_WIDTH;
+            long y1 = GEN_DIE_MARGIN + blockage_rects_[b].first * GEN_ROW_HEIGHT;
+            long x2 = x1 + blockage_sizes_[b].second * GEN_SITE_WIDTH;
+            long y2 = y1 + blockage_sizes_[b].first * GEN_ROW_HEIGHT;
+            out << " - PLACEMENT\n   RECT ( " << x1 << " " << y1 << " ) ( " << x2 << " " << y2 << " ) ;\n";
+        }
+        out << "END BLOCKAGES\n";
+    }
+
+    // NETS：connection依net排序後一次輸出
+    std::sort(connections_.begin(), connections_.end());
+    long net_count = 0;
+    for (size_t c = 0; c < connections_.size(); c++) {
+        if (c == 0 || connections_[c].net != connections_[c - 1].net) net_count++;
+    }
+    out << "NETS " << net_count << " ;\n";
+    for (size_t c = 0; c < connections_.size(); c++) {
+        const GenConnection& conn = connections_[c];
+        if (c == 0 || conn.net != connections_[c - 1].net) {
+            out << " - " << net_name(conn.net) << "\n";
+        }
+        if (conn.instance == UINT32_MAX) {
+            out << "   ( PIN " << net_name(conn.net) << " )\n";
+        } else {
+            out << "   ( " << hierarchical_name(conn.instance) << " " << pin_names_[conn.pin] << " )\n";
+        }
+        if (c + 1 == connections_.size() || connections_[c + 1].net != conn.net) {
+            out << "   + USE " << (conn.net >= 2 * config_.ff_bits && static_cast<size_t>(conn.net - 2 * config_.ff_bits) < clock_ports_.size()
+                                   ? "CLOCK" : "SIGNAL") << " ;\n";
+        }
+    }
+    out << "END NETS\n";
+
+    // SCANCHAINS：每條chain一個FLOATING list，STOP在最後一個instance的最後一個Q
+    if (!scan_in_ports_.empty()) {
+        auto last_q = [&](uint32_t i) {
+            const GenCell& cell = cells_[instances_[i].cell];
+            return cell.bit_width == 1 ? std::string("Q") : "Q" + std::to_string(cell.bit_width - 1);
+        };
+        uint32_t length = static_cast<uint32_t>(config_.scan_chain_length);
+        out << "SCANCHAINS " << scan_in_ports_.size() << " ;\n";
+        for (size_t c = 0; c < scan_in_ports_.size(); c++) {
+            uint32_t first = static_cast<uint32_t>(c) * length;
+            uint32_t last = std::min(first + length, ff_instance_count_) - 1;
+            out << " - chain_" << c << "\n";
+            out << "   + START PIN " << port_names_[scan_in_ports_[c]] << "\n";
+            out << "   + FLOATING\n";
+            for (uint32_t i = first; i <= last; i++) {
+                out << "     " << hierarchical_name(i) << " ( IN SI ) ( OUT " << last_q(i) << " )\n";
+            }
+            out << "   + STOP " << hierarchical_name(last) << " " << last_q(last) << " ;\n";
+        }
+        out << "END SCANCHAINS\n";
+    }
+    out << "END DESIGN\n";
+    return true;
+}
+
+bool SyntheticDesign::write_sdc() const {
+    std::string filename = path(config_.design_name + ".sdc");
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot open " << filename << " for writing" << std::endl;
+        return false;
+    }
+    const double period = 0.689445;
+    out << "set sdc_version 2.2\n";
+    out << "set_units -time ns -resistance kOhm -capacitance pF -voltage V -current uA\n";
+    for (size_t port : clock_ports_) {
+        const std::string& clock = port_names_[port];
+        out << "create_clock -name " << clock << " -period " << period << " -waveform {0 " << period / 2
+            << "} [get_ports {" << clock << "}]\n";
+    }
+    out << "\n";
+    for (size_t port : clock_ports_) {
+        const std::string& clock = port_names_[port];
+        out << "set_clock_latency " << period * 0.1 << " [get_clocks {" << clock << "}]\n";
+        out << "set_clock_uncertainty " << period * 0.15 << " [get_clocks {" << clock << "}]\n";
+        out << "set_clock_transition 0.0551556 [get_clocks {" << clock << "}]\n";
+    }
+    out << "set_max_transition 0.1 [current_design]\n";
+    out << "set_max_capacitance 0.1 [current_design]\n";
+    const std::string& main_clock = port_names_[clock_ports_[0]];
+    for (size_t p = 0; p < port_names_.size(); p++) {
+        if (p < clock_ports_.size()) continue;
+        if (port_is_input_[p]) {
+            out << "set_input_delay -clock [get_clocks {" << main_clock << "}] " << period / 2
+                << " [get_ports {" << port_names_[p] << "}]\n";
+        } else {
+            out << "set_output_delay -clock [get_clocks {" << main_clock << "}] " << period / 2
+                << " [get_ports {" << port_names_[p] << "}]\n";
+            out << "set_load -pin_load 0.0551556 [get_ports {" << port_names_[p] << "}]\n";
+        }
+    }
+    return true;
+}
+
+bool SyntheticDesign::write_weight() const {
+    std::string filename = path(config_.design_name + "_weight");
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot open " << filename << " for writing" << std::endl;
+        return false;
+    }
+    // 和testcase1相同的權重
+    out << "Alpha 1\nBeta 100\nGamma 0.05\nTNS 1058.87\nTPO 9.3\nArea 18300.35\n";
+    return true;
+}
+
+// cadb_1060_final的參數 (相對於output目錄)，給benchmark script用
+bool SyntheticDesign::write_run_args() const {
+    std::string filename = path("run_args");
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot open " << filename << " for writing" << std::endl;
+        return false;
+    }
+    const std::string& dir = config_.output_dir;
+    out << "-weight " << dir << "/" << config_.design_name << "_weight -lib";
+    for (int lib = 0; lib < LIBRARY_COUNT; lib++) out << " " << dir << "/lib/" << LIBRARY_FILES[lib] << "_base_tt0p8v25c.lib";
+    out << " -lef";
+    for (int lib = 0; lib < LIBRARY_COUNT; lib++) out << " " << dir << "/lef/" << LIBRARY_FILES[lib] << ".lef";
+    out << " -v " << dir << "/" << config_.design_name << ".v";
+    out << " -def " << dir << "/" << config_.design_name << ".def";
+    out << " -sdc " << dir << "/" << config_.design_name << ".sdc\n";
+    return true;
+}
+
+bool SyntheticDesign::generate() {
+    mkdir(config_.output_dir.c_str(), 0755);
+    mkdir(path("lib").c_str(), 0755);
+    mkdir(path("lef").c_str(), 0755);
+
+    std::cout << "  Building netlist..." << std::endl;
+    build_library();
+    build_ports();
+    build_flip_flops();
+    build_logic();
+    build_clock_tree();
+
+    std::cout << "  Placing " << instances_.size() << " instances..." << std::endl;
+    place_instances();
+
+    std::cout << "  Writing files to " << config_.output_dir << "..." << std::endl;
+    if (!write_liberty() || !write_lef() || !write_verilog() || !write_def() ||
+        !write_sdc() || !write_weight() || !write_run_args()) {
+        return false;
+    }
+
+    long multibit_instances = 0;
+    for (uint32_t i = 0; i < ff_instance_count_; i++) {
+        if (cells_[instances_[i].cell].bit_width > 1) multibit_instances++;
+    }
+    std::cout << "\n=== Synthetic design summary ===" << std::endl;
+    std::cout << "  FF bits:              " << config_.ff_bits << std::endl;
+    std::cout << "  FF instances:         " << ff_instance_count_ << " (" << multibit_instances << " multi-bit)" << std::endl;
+    std::cout << "  Logic/buffer cells:   " << instances_.size() - ff_instance_count_ << std::endl;
+    std::cout << "  Clock buffers:        " << clock_leaf_first_ff_.size() << std::endl;
+    std::cout << "  Clock domains:        " << config_.clock_domains << std::endl;
+    std::cout << "  Hierarchy leaves:     " << leaf_count_ << std::endl;
+    std::cout << "  Rows:                 " << row_count_ << " x " << sites_per_row_ << " sites" << std::endl;
+    std::cout << "  Placement blockages:  " << blockage_rects_.size() << std::endl;
+    std::cout << "  Scan chains:          " << scan_in_ports_.size() << std::endl;
+    std::cout << "  Run with: ./cadb_1060_final $(cat " << path("run_args") << ") -out <name>" << std::endl;
+    return true;
+}
+
+// =============================================================================
+// COMMAND LINE
+// =============================================================================
+
+static void print_generator_usage(const char* program) {
+    std::cout << "Usage: " << program << " -out <dir> [options]" << std::endl;
+    std::cout << "  -ff <n>               FF bits (default 10000)" << std::endl;
+    std::cout << "  -multibit <f>         Fraction of bits in 2/4-bit FFs (default 0.1)" << std::endl;
+    std::cout << "  -hier <depth>         Hierarchy depth (default 2)" << std::endl;
+    std::cout << "  -fanout <n>           Blocks per hierarchy level (default 4)" << std::endl;
+    std::cout << "  -clocks <n>           Clock domains (default 1)" << std::endl;
+    std::cout << "  -rows <n>             Placement rows (default: square die)" << std::endl;
+    std::cout << "  -blockage <f>         Placement blockage density (default 0.05)" << std::endl;
+    std::cout << "  -util <f>             Row utilization (default 0.6)" << std::endl;
+    std::cout << "  -logic <f>            Logic gates per FF bit (default 1.0)" << std::endl;
+    std::cout << "  -scan <n>             FF instances per scan chain (default 0 = none)" << std::endl;
+    std::cout << "  -clock_fanout <n>     FF instances per clock buffer (default 0 = CK on the clock port)" << std::endl;
+    std::cout << "  -seed <n>             Random seed (default 1)" << std::endl;
+    std::cout << "  -name <design>        Design / file base name (default top)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    GeneratorConfig config;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_generator_usage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Error: Missing value for " << arg << std::endl;
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "-ff") config.ff_bits = std::atol(value.c_str());
+        else if (arg == "-multibit") config.multibit_fraction = std::atof(value.c_str());
+        else if (arg == "-hier") config.hierarchy_depth = std::atoi(value.c_str());
+        else if (arg == "-fanout") config.hierarchy_fanout = std::atoi(value.c_str());
+        else if (arg == "-clocks") config.clock_domains = std::atoi(value.c_str());
+        else if (arg == "-rows") config.rows = std::atoi(value.c_str());
+        else if (arg == "-blockage") config.blockage_density = std::atof(value.c_str());
+        else if (arg == "-util") config.utilization = std::atof(value.c_str());
+        else if (arg == "-logic") config.logic_ratio = std::atof(value.c_str());
+        else if (arg == "-scan") config.scan_chain_length = std::atoi(value.c_str());
+        else if (arg == "-clock_fanout") config.clock_fanout = std::atoi(value.c_str());
+        else if (arg == "-seed") config.seed = static_cast<unsigned>(std::atol(value.c_str()));
+        else if (arg == "-name") config.design_name = value;
+        else if (arg == "-out") config.output_dir = value;
+        else {
+            std::cerr << "Error: Unknown option " << arg << std::endl;
+            print_generator_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (config.output_dir.empty() || config.ff_bits < 1 || config.clock_domains < 1 || config.clock_domains > 255 ||
+        config.hierarchy_depth < 0 || config.hierarchy_fanout < 1 || config.utilization <= 0.0 || config.utilization > 1.0) {
+        print_generator_usage(argv[0]);
+        return 1;
+    }
+
+    std::cout << "=== Synthetic MBFF design generator ===" << std::endl;
+    SyntheticDesign design(config);
+    return design.generate() ? 0 : 1;
+}
@@ -0,0 +1,224 @@
+#include "task_graph.hpp"
+#include "thread_pool.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+
+// =============================================================================
+// PIPELINE TASK GRAPH IMPLEMENTATION
+// =============================================================================
+
+namespace {
+
+thread_local std::string* tls_stage_output = nullptr;   // Capture buffer of the running stage
+
+// std::cout在graph執行期間換成這個：stage thread寫進自己的capture buffer，
+// 其他thread照常寫到原本的target (經過Logger的lock)
+class StageOutputRouter : public std::streambuf {
+public:
+    explicit StageOutputRouter(std::streambuf* target) : target_(target) {}
+
+    std::streambuf* target() const { return target_; }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+        char c = traits_type::to_char_type(ch);
+        if (tls_stage_output) tls_stage_output->push_back(c);
+        else Logger::write_raw(target_, std::string(1, c));
+        return ch;
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        if (tls_stage_output) tls_stage_output->append(s, static_cast<size_t>(n));
+        else Logger::write_raw(target_, std::string(s, static_cast<size_t>(n)));
+        return n;
+    }
+
+    int sync() override {
+        if (!tls_stage_output) Logger::write_raw(target_, std::string());   // flush也要拿Logger的lock
+        return 0;
+    }
+
+private:
+    std::streambuf* target_;
+};
+
+std::mutex routing_mutex;
+int routing_refs = 0;
+StageOutputRouter* routing_router = nullptr;
+
+std::streambuf* console_target() {
+    std::lock_guard<std::mutex> lock(routing_mutex);
+    return routing_router ? routing_router->target() : std::cout.rdbuf();
+}
+
+}  // namespace
+
+// 第一個scope安裝router，最後一個scope還原 (多個graph同時run時共用同一個router)
+StageOutputScope::StageOutputScope() {
+    std::lock_guard<std::mutex> lock(routing_mutex);
+    if (routing_refs++ == 0) {
+        routing_router = new StageOutputRouter(std::cout.rdbuf());
+        std::cout.rdbuf(routing_router);
+    }
+}
+
+StageOutputScope::~StageOutputScope() {
+    std::lock_guard<std::mutex> lock(routing_mutex);
+    if (--routing_refs == 0) {
+        std::cout.rdbuf(routing_router->target());
+        delete routing_router;
+        routing_router = nullptr;
+    }
+}
+
+int TaskGraph::add_stage(const std::string& name, unsigned reads, unsigned writes, std::function<void()> body) {
+    int id = static_cast<int>(stages_.size());
+    Stage stage;
+    stage.name = name;
+    stage.reads = reads;
+    stage.writes = writes;
+    stage.body = std::move(body);
+
+    for (int bit = 0; bit < 32; bit++) {
+        unsigned mask = 1u << bit;
+        if ((reads | writes) & mask) {
+            if (last_writer_[bit] >= 0) stage.dependencies.push_back(last_writer_[bit]);   // RAW / WAW
+        }
+        if (writes & mask) {
+            for (int reader : readers_since_write_[bit]) stage.dependencies.push_back(reader);   // WAR
+            readers_since_write_[bit].clear();
+            last_writer_[bit] = id;
+        } else if (reads & mask) {
+            readers_since_write_[bit].push_back(id);
+        }
+    }
+
+    std::sort(stage.dependencies.begin(), stage.dependencies.end());
+    stage.dependencies.erase(std::unique(stage.dependencies.begin(), stage.dependencies.end()),
+                             stage.dependencies.end());
+    stage.dependencies.erase(std::remove(stage.dependencies.begin(), stage.dependencies.end(), id),
+                             stage.dependencies.end());
+    for (int dependency : stage.dependencies) {
+        stages_[dependency].dependents.push_back(id);
+    }
+
+    stages_.push_back(std::move(stage));
+    return id;
+}
+
+void TaskGraph::depends_on(int stage, int prerequisite) {
+    std::vector<int>& dependencies = stages_[stage].dependencies;
+    if (prerequisite >= stage || std::find(dependencies.begin(), dependencies.end(), prerequisite) != dependencies.end()) {
+        return;   // 只能依賴較早加入的stage，保持topological order
+    }
+    dependencies.insert(std::upper_bound(dependencies.begin(), dependencies.end(), prerequisite), prerequisite);
+    stages_[prerequisite].dependents.push_back(stage);
+}
+
+void TaskGraph::run(ThreadPool& pool, std::streambuf* output) {
+    struct RunState {
+        std::mutex mutex;
+        std::condition_variable done_cv;
+        std::vector<int> remaining;
+        size_t finished = 0;
+        bool failed = false;
+        std::exception_ptr error;
+    } state;
+
+    const size_t total = stages_.size();
+    if (total == 0) return;
+    for (const auto& stage : stages_) {
+        state.remaining.push_back(static_cast<int>(stage.dependencies.size()));
+    }
+
+    StageOutputScope routing;
+    std::streambuf* console = output ? output : console_target();
+
+    std::function<void(int)> execute = [&](int id) {
+        Stage& stage = stages_[id];
+
+        bool skip;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            skip = state.failed;   // 有stage失敗後，剩下的stage只結算不執行
+        }
+        if (!skip) {
+            std::string output;
+            std::string* saved = tls_stage_output;
+            tls_stage_output = &output;
+            try {
+                stage.body();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                if (!state.failed) {
+                    state.failed = true;
+                    state.error = std::current_exception();
+                }
+            }
+            tls_stage_output = saved;
+            if (!output.empty()) Logger::write_raw(console, output);
+        }
+
+        std::vector<int> ready;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            for (int dependent : stage.dependents) {
+                if (--state.remaining[dependent] == 0) ready.push_back(dependent);
+            }
+            state.finished++;
+            state.done_cv.notify_all();   // 最後一個stage結束後不能再碰state (run()可能已經return)
+        }
+        for (int next : ready) {
+            pool.submit([&execute, next]() { execute(next); });
+        }
+    };
+
+    for (size_t id = 0; id < total; id++) {
+        if (stages_[id].dependencies.empty()) {
+            int root = static_cast<int>(id);
+            pool.submit([&execute, root]() { execute(root); });
+        }
+    }
+
+    // 呼叫端也一起做事；沒事做時短暫等待 (新的ready stage或全部完成)
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (state.finished == total) break;
+        }
+        if (!pool.run_pending_task()) {
+            std::unique_lock<std::mutex> lock(state.mutex);
+            state.done_cv.wait_for(lock, std::chrono::milliseconds(1),
+                                   [&]() { return state.finished == total; });
+        }
+    }
+
+    if (state.error) std::rethrow_exception(state.error);
+}
+
+void TaskGraph::print_plan(std::ostream& out) const {
+    // 最長dependency chain (stage數)：加入順序已經是topological order
+    std::vector<int> depth(stages_.size(), 1);
+    int longest = 0;
+    for (size_t id = 0; id < stages_.size(); id++) {
+        for (int dependency : stages_[id].dependencies) {
+            depth[id] = std::max(depth[id], depth[dependency] + 1);
+        }
+        longest = std::max(longest, depth[id]);
+    }
+
+    out << "  Task graph: " << stages_.size() << " stages, longest chain " << longest << " stages" << std::endl;
+    for (size_t id = 0; id < stages_.size(); id++) {
+        out << "    [" << id << "] " << stages_[id].name;
+        if (!stages_[id].dependencies.empty()) {
+            out << "  <-";
+            for (int dependency : stages_[id].dependencies) out << " " << dependency;
+        }
+        out << std::endl;
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef TASK_GRAPH_HPP
+#define TASK_GRAPH_HPP
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// =============================================================================
+// PIPELINE TASK GRAPH
+// =============================================================================
+// 每個stage宣告它讀/寫DesignDatabase的哪些部分 (DbResource bitmask)，
+// 依照加入順序自動建立dependency：
+//   - 讀某resource → 依賴最後一個寫它的stage (RAW)
+//   - 寫某resource → 依賴最後一個寫它的stage和之後所有讀它的stage (WAW / WAR)
+// 所以結果和依序執行完全一樣，只是沒有資料依賴的stage可以同時跑
+// (例如 Liberty ∥ Verilog ∥ Weights，最後四個writer同時輸出)
+//
+// 執行時每個stage的std::cout輸出先存在自己的buffer，stage結束才整段印出，
+// 平行的stage log不會交錯
+// =============================================================================
+
+enum DbResource : unsigned {
+    DB_NONE           = 0,
+    DB_CELL_LIBRARY   = 1u << 0,   // cell_library map + liberty attributes
+    DB_CELL_PHYSICAL  = 1u << 1,   // LEF size / pins on CellTemplate
+    DB_CELL_BANKING   = 1u << 2,   // CellTemplate::banking_targets
+    DB_CELL_GROUPS    = 1u << 3,   // ff_compatibility_groups, hierarchical_ff_groups
+    DB_NETLIST        = 1u << 4,   // instances, nets, modules, connections, design name
+    DB_PLACEMENT      = 1u << 5,   // die area, rows, tracks, blockages
+    DB_WEIGHTS        = 1u << 6,   // objective_weights
+    DB_SCAN           = 1u << 7,   // scan_chains
+    DB_INSTANCE_GROUPS = 1u << 8,  // ff_instance_groups, optimal FF / banking candidate lists
+    DB_HISTORY        = 1u << 9,   // transformation_history, complete_pipeline
+    DB_PIN_PROVENANCE = 1u << 10,  // pin_provenance (find() compresses paths)
+    DB_DUMMY_NAMES    = 1u << 11,  // dummy_to_real / real_to_dummy mapping
+    DB_CLOCKS         = 1u << 12,  // sdc_clocks, clock_domain_labels
+    DB_ALL            = (1u << 13) - 1
+};
+
+// std::cout在scope期間經過stage capture router (reference counted：同時執行的
+// graph和server這種長時間的owner共用同一個router，不會互相還原rdbuf)
+class StageOutputScope {
+public:
+    StageOutputScope();
+    ~StageOutputScope();
+
+private:
+    StageOutputScope(const StageOutputScope&) = delete;
+    StageOutputScope& operator=(const StageOutputScope&) = delete;
+};
+
+class TaskGraph {
+public:
+    // Returns the stage id; dependencies on earlier stages are derived from reads/writes
+    int add_stage(const std::string& name, unsigned reads, unsigned writes, std::function<void()> body);
+
+    // Extra ordering for data that lives outside DesignDatabase (scratch buffers)
+    void depends_on(int stage, int prerequisite);
+
+    // Execute all stages on `pool`; the first exception thrown by a stage is rethrown here.
+    // Each stage's output goes to `output` (default: the console)
+    void run(ThreadPool& pool, std::streambuf* output = nullptr);
+
+    // Stage list with dependencies and the longest dependency chain
+    void print_plan(std::ostream& out) const;
+
+    size_t size() const { return stages_.size(); }
+
+private:
+    struct Stage {
+        std::string name;
+        unsigned reads = DB_NONE;
+        unsigned writes = DB_NONE;
+        std::function<void()> body;
+        std::vector<int> dependencies;
+        std::vector<int> dependents;
+    };
+
+    std::vector<Stage> stages_;
+    int last_writer_[32] = {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
+    std::vector<int> readers_since_write_[32];
+};
+
+#endif // TASK_GRAPH_HPP
@@ -0,0 +1,194 @@
+#include "thread_pool.hpp"
+#include "trace_recorder.hpp"
+#include <chrono>
+
+// =============================================================================
+// WORK-STEALING THREAD POOL IMPLEMENTATION
+// =============================================================================
+
+namespace {
+thread_local ThreadPool* tls_pool = nullptr;   // Pool owning the current worker thread
+thread_local int tls_worker_index = -1;
+}  // namespace
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool;
+    return pool;
+}
+
+ThreadPool::ThreadPool() : queued_(0), stopping_(false) {
+    start(static_cast<int>(std::thread::hardware_concurrency()) - 1);
+}
+
+ThreadPool::~ThreadPool() {
+    stop();
+}
+
+void ThreadPool::resize(int threads) {
+    if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (threads < 1) threads = 1;
+    if (threads == size()) return;
+    stop();
+    start(threads - 1);
+}
+
+void ThreadPool::start(int worker_count) {
+    if (worker_count < 0) worker_count = 0;
+    stopping_.store(false);
+    queues_.clear();
+    for (int i = 0; i <= worker_count; i++) {
+        queues_.emplace_back(new TaskQueue());
+    }
+    for (int i = 0; i < worker_count; i++) {
+        workers_.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+void ThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_.store(true);
+    }
+    sleep_cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+
+    // 還沒執行的task在呼叫端做完，不能丟
+    std::function<void()> task;
+    while (pop_task(-1, task)) {
+        task();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    int index = (tls_pool == this && tls_worker_index >= 0) ? tls_worker_index
+                                                             : static_cast<int>(queues_.size()) - 1;
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+    queued_.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    sleep_cv_.notify_one();
+}
+
+bool ThreadPool::pop_task(int self, std::function<void()>& task) {
+    if (queued_.load() == 0) return false;
+    int injection = static_cast<int>(queues_.size()) - 1;
+
+    // 1. 自己的deque尾端
+    if (self >= 0) {
+        TaskQueue& own = *queues_[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued_.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // 2. injection queue，再來依序從其他worker前端偷
+    for (int offset = 0; offset <= injection; offset++) {
+        int victim = (injection + offset) % (injection + 1);
+        if (victim == self) continue;
+        TaskQueue& queue = *queues_[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            queued_.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::run_pending_task() {
+    std::function<void()> task;
+    int self = (tls_pool == this) ? tls_worker_index : -1;
+    if (!pop_task(self, task)) return false;
+    task();
+    return true;
+}
+
+void ThreadPool::wait_for_work(int timeout_ms) {
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    sleep_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                       [this]() { return stopping_.load() || queued_.load() > 0; });
+}
+
+void ThreadPool::worker_loop(int index) {
+    tls_pool = this;
+    tls_worker_index = index;
+    TraceRecorder::instance().set_thread_name("worker " + std::to_string(index + 1));
+
+    std::function<void()> task;
+    while (true) {
+        if (pop_task(index, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        if (stopping_.load()) break;
+        sleep_cv_.wait(lock, [this]() { return stopping_.load() || queued_.load() > 0; });
+        if (stopping_.load() && queued_.load() == 0) break;
+    }
+}
+
+// =============================================================================
+// TASK GROUP
+// =============================================================================
+
+TaskGroup::TaskGroup(ThreadPool& pool) : pool_(pool), pending_(0) {}
+
+TaskGroup::~TaskGroup() {
+    try {
+        wait();
+    } catch (...) {
+    }
+}
+
+void TaskGroup::run(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_++;
+    }
+    pool_.submit([this, task]() {
+        std::exception_ptr error;
+        try {
+            task();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (error && !error_) error_ = error;
+        pending_--;
+        done_cv_.notify_all();   // wait()可能馬上return，之後不能再碰this
+    });
+}
+
+void TaskGroup::wait() {
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_ == 0) break;
+        }
+        if (!pool_.run_pending_task()) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_cv_.wait_for(lock, std::chrono::milliseconds(1), [this]() { return pending_ == 0; });
+        }
+    }
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::swap(error, error_);
+    }
+    if (error) std::rethrow_exception(error);
+}
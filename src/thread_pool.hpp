@@ -0,0 +1,143 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// =============================================================================
+// WORK-STEALING THREAD POOL
+// =============================================================================
+// - 每個worker有自己的deque：自己submit的task從尾端拿 (LIFO，cache比較熱)，
+//   沒事做時從別人的deque前端偷 (FIFO，偷走最舊、通常最大的工作)
+// - 非worker thread (main) submit的task進共用的injection queue
+// - 等待中的thread可以呼叫 run_pending_task() 幫忙做事，所以 size()==1 時
+//   完全沒有worker，所有task都在呼叫端依submit順序執行 (等同sequential)
+// - 全程式共用 ThreadPool::instance()，thread數由 -threads 決定，不會oversubscribe
+//
+// 上層工具：
+// - TaskGroup：run() 丟task，wait() 等全部完成 (等待時幫忙做事，可巢狀使用)
+// - parallel_for(begin, end, grain, body)：body(chunk_begin, chunk_end)
+// - parallel_reduce：每個chunk各自算partial，再依chunk順序合併
+//   chunk切法只由range和grain決定 (和thread數無關)，所以結果是deterministic
+// =============================================================================
+
+#define PARALLEL_DEFAULT_GRAIN 1024   // Items per chunk when the caller passes grain 0
+
+class ThreadPool {
+public:
+    static ThreadPool& instance();
+
+    // Total threads including the caller that waits (>= 1); 0 = hardware concurrency
+    void resize(int threads);
+    int size() const { return static_cast<int>(workers_.size()) + 1; }
+
+    void submit(std::function<void()> task);
+
+    // Run one queued task on the calling thread; false if nothing was queued
+    bool run_pending_task();
+
+    // Sleep until a task is queued or `timeout_ms` passes (used by waiting threads)
+    void wait_for_work(int timeout_ms);
+
+    ~ThreadPool();
+
+private:
+    ThreadPool();
+
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void start(int worker_count);
+    void stop();
+    void worker_loop(int index);
+    bool pop_task(int self, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<TaskQueue>> queues_;   // One per worker + injection queue (last)
+    std::vector<std::thread> workers_;
+    std::atomic<long> queued_;
+    std::atomic<bool> stopping_;
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+};
+
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool = ThreadPool::instance());
+    ~TaskGroup();   // Waits; exceptions not collected by wait() are dropped
+
+    void run(std::function<void()> task);
+
+    // Block until every task has finished (helping meanwhile); rethrows the first exception
+    void wait();
+
+private:
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    ThreadPool& pool_;
+    std::mutex mutex_;
+    std::condition_variable done_cv_;
+    long pending_;
+    std::exception_ptr error_;
+};
+
+// Number of chunks [begin, end) is split into; depends only on the range and grain
+inline size_t parallel_chunk_count(size_t begin, size_t end, size_t grain) {
+    if (end <= begin) return 0;
+    if (grain == 0) grain = PARALLEL_DEFAULT_GRAIN;
+    return (end - begin + grain - 1) / grain;
+}
+
+// body(chunk_begin, chunk_end) is called once per chunk, possibly concurrently
+template <typename Body>
+void parallel_for(size_t begin, size_t end, size_t grain, const Body& body) {
+    if (grain == 0) grain = PARALLEL_DEFAULT_GRAIN;
+    size_t chunks = parallel_chunk_count(begin, end, grain);
+    if (chunks <= 1 || ThreadPool::instance().size() == 1) {
+        for (size_t chunk_begin = begin; chunk_begin < end; chunk_begin += grain) {
+            body(chunk_begin, std::min(end, chunk_begin + grain));
+        }
+        return;
+    }
+
+    TaskGroup group;
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+        size_t chunk_begin = begin + chunk * grain;
+        size_t chunk_end = std::min(end, chunk_begin + grain);
+        group.run([&body, chunk_begin, chunk_end]() { body(chunk_begin, chunk_end); });
+    }
+    group.wait();
+}
+
+// map(chunk_begin, chunk_end) -> T per chunk; partials are folded left to right
+// with combine(accumulated, partial), so the result does not depend on scheduling
+template <typename T, typename Map, typename Combine>
+T parallel_reduce(size_t begin, size_t end, size_t grain, T identity, const Map& map, const Combine& combine) {
+    if (grain == 0) grain = PARALLEL_DEFAULT_GRAIN;
+    size_t chunks = parallel_chunk_count(begin, end, grain);
+    std::vector<T> partials(chunks, identity);
+    parallel_for(0, chunks, 1, [&](size_t first_chunk, size_t last_chunk) {
+        for (size_t chunk = first_chunk; chunk < last_chunk; chunk++) {
+            size_t chunk_begin = begin + chunk * grain;
+            partials[chunk] = map(chunk_begin, std::min(end, chunk_begin + grain));
+        }
+    });
+
+    T result = identity;
+    for (auto& partial : partials) {
+        result = combine(std::move(result), std::move(partial));
+    }
+    return result;
+}
+
+#endif // THREAD_POOL_HPP
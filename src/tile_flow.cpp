@@ -0,0 +1,763 @@
+#include "tile_flow.hpp"
+#include "data_structures.hpp"
+#include "parsers.hpp"
+#include "checkpoint.hpp"
+#include "out_of_core.hpp"
+#include "thread_pool.hpp"
+#include "profiler.hpp"
+#include "logger.hpp"
+/*Legalization*/
+#include "Legalization.hpp"
+/*Legalization*/
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+const Dbu TILE_OPEN_LOW = std::numeric_limits<Dbu>::min();   // 外圈tile沒有邊界
+const Dbu TILE_OPEN_HIGH = std::numeric_limits<Dbu>::max();
+
+// =============================================================================
+// TILE GRID
+// =============================================================================
+// 先依x切成cols欄，每欄再各自依y切成rows格 (tile i = column * rows + row)
+// 每個tile是 [x1, x2) x [y1, y2)，外圈邊界是TILE_OPEN_LOW / TILE_OPEN_HIGH
+
+struct TileGrid {
+    int cols = 1, rows = 1;
+    std::vector<Dbu> x_cuts;                  // cols - 1
+    std::vector<std::vector<Dbu>> y_cuts;     // per column: rows - 1
+    std::vector<Rectangle> tiles;
+
+    int tile_of(const Point& p) const {
+        int column = static_cast<int>(std::upper_bound(x_cuts.begin(), x_cuts.end(), p.x) - x_cuts.begin());
+        const std::vector<Dbu>& cuts = y_cuts[column];
+        int row = static_cast<int>(std::upper_bound(cuts.begin(), cuts.end(), p.y) - cuts.begin());
+        return column * rows + row;
+    }
+
+    // 到最近的內部邊界 (相鄰tile) 的距離；單一tile = 不在任何邊界附近
+    Dbu distance_to_internal_edge(const Point& p) const {
+        const Rectangle& area = tiles[tile_of(p)];
+        Dbu distance = TILE_OPEN_HIGH;
+        if (area.x1 != TILE_OPEN_LOW) distance = std::min(distance, p.x - area.x1);
+        if (area.x2 != TILE_OPEN_HIGH) distance = std::min(distance, area.x2 - p.x);
+        if (area.y1 != TILE_OPEN_LOW) distance = std::min(distance, p.y - area.y1);
+        if (area.y2 != TILE_OPEN_HIGH) distance = std::min(distance, area.y2 - p.y);
+        return distance;
+    }
+};
+
+// parts等分的分位數切線 (values已排序)
+std::vector<Dbu> quantile_cuts(const std::vector<Dbu>& values, int parts) {
+    std::vector<Dbu> cuts;
+    for (int k = 1; k < parts; k++) {
+        cuts.push_back(values.empty() ? TILE_OPEN_HIGH : values[values.size() * k / parts]);
+    }
+    return cuts;
+}
+
+// 最近的row origin (row_ys已排序)；y切線對齊row，legalization的tile才是整條row
+Dbu snap_to_row(Dbu y, const std::vector<Dbu>& row_ys) {
+    if (row_ys.empty() || y == TILE_OPEN_HIGH) return y;
+    auto it = std::lower_bound(row_ys.begin(), row_ys.end(), y);
+    if (it == row_ys.end()) return row_ys.back();
+    if (it != row_ys.begin() && y - *std::prev(it) < *it - y) --it;
+    return *it;
+}
+
+TileGrid build_tile_grid(const std::vector<Point>& points, int tile_count, const DesignDatabase& db) {
+    TileGrid grid;
+    grid.cols = std::max(1, static_cast<int>(std::floor(std::sqrt(static_cast<double>(tile_count)))));
+    while (tile_count % grid.cols != 0) grid.cols--;
+    grid.rows = tile_count / grid.cols;
+
+    std::vector<Dbu> row_ys;
+    row_ys.reserve(db.placement_rows.size());
+    for (const auto& row : db.placement_rows) row_ys.push_back(row.origin.y);
+    std::sort(row_ys.begin(), row_ys.end());
+    row_ys.erase(std::unique(row_ys.begin(), row_ys.end()), row_ys.end());
+
+    std::vector<Dbu> xs;
+    xs.reserve(points.size());
+    for (const auto& p : points) xs.push_back(p.x);
+    std::sort(xs.begin(), xs.end());
+    grid.x_cuts = quantile_cuts(xs, grid.cols);
+
+    std::vector<std::vector<Dbu>> column_ys(grid.cols);
+    for (const auto& p : points) {
+        int column = static_cast<int>(std::upper_bound(grid.x_cuts.begin(), grid.x_cuts.end(), p.x) - grid.x_cuts.begin());
+        column_ys[column].push_back(p.y);
+    }
+    grid.y_cuts.resize(grid.cols);
+    for (int c = 0; c < grid.cols; c++) {
+        std::sort(column_ys[c].begin(), column_ys[c].end());
+        std::vector<Dbu> cuts = quantile_cuts(column_ys[c], grid.rows);
+        for (auto& cut : cuts) cut = snap_to_row(cut, row_ys);
+        std::sort(cuts.begin(), cuts.end());
+        grid.y_cuts[c] = cuts;
+    }
+
+    for (int c = 0; c < grid.cols; c++) {
+        for (int r = 0; r < grid.rows; r++) {
+            Rectangle area;
+            area.x1 = c == 0 ? TILE_OPEN_LOW : grid.x_cuts[c - 1];
+            area.x2 = c == grid.cols - 1 ? TILE_OPEN_HIGH : grid.x_cuts[c];
+            area.y1 = r == 0 ? TILE_OPEN_LOW : grid.y_cuts[c][r - 1];
+            area.y2 = r == grid.rows - 1 ? TILE_OPEN_HIGH : grid.y_cuts[c][r];
+            grid.tiles.push_back(area);
+        }
+    }
+    return grid;
+}
+
+std::string format_area(const Rectangle& area) {
+    auto edge = [](Dbu value) -> std::string {
+        if (value == TILE_OPEN_LOW) return "-inf";
+        if (value == TILE_OPEN_HIGH) return "+inf";
+        return std::to_string(value);
+    };
+    return "[" + edge(area.x1) + ", " + edge(area.x2) + ") x [" + edge(area.y1) + ", " + edge(area.y2) + ")";
+}
+
+// =============================================================================
+// WORKER PROCESSES
+// =============================================================================
+
+struct TileJob {
+    int tile = 0;
+    std::string input;        // tile checkpoint
+    std::string prefix;       // worker -out (結果 = prefix_step<step>.mbffckpt)
+    std::string log;
+    std::vector<std::string> argv;
+    pid_t pid = -1;
+    std::chrono::steady_clock::time_point start;
+    double seconds = 0.0;
+    int status = 0;
+    bool ok = false;
+};
+
+std::string executable_path() {
+    char buffer[TILE_EXE_PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
+    if (length <= 0) throw std::runtime_error("Cannot locate the running executable (/proc/self/exe)");
+    return std::string(buffer, static_cast<size_t>(length));
+}
+
+std::vector<std::string> worker_arguments(const ProgramArguments& args, const std::string& input,
+                                          const std::string& step, const std::string& prefix) {
+    std::vector<std::string> argv = {"--resume-from", input, "--checkpoint-after", step, "-tile_worker",
+                                     "-out", prefix, "-threads", "1", "-log_level", args.log_level};
+    for (const auto& assignment : banking_parameter_assignments(args.banking_params)) {
+        argv.push_back("-param");
+        argv.push_back(assignment);
+    }
+    return argv;
+}
+
+void spawn_worker(const std::string& exe, TileJob& job) {
+    // argv在fork之前準備好：child在exec之前只做async-signal-safe的呼叫
+    std::vector<char*> raw;
+    raw.push_back(const_cast<char*>(exe.c_str()));
+    for (auto& arg : job.argv) raw.push_back(const_cast<char*>(arg.c_str()));
+    raw.push_back(nullptr);
+
+    int log_fd = open(job.log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (log_fd < 0) throw std::runtime_error("Cannot create " + job.log);
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(log_fd, STDOUT_FILENO);
+        dup2(log_fd, STDERR_FILENO);
+        close(log_fd);
+        execv(raw[0], raw.data());
+        _exit(127);
+    }
+    close(log_fd);
+    if (pid < 0) throw std::runtime_error("Cannot start the worker for tile " + std::to_string(job.tile));
+    job.pid = pid;
+    job.start = std::chrono::steady_clock::now();
+}
+
+// 最多max_workers個同時執行；全部結束後有失敗的tile就throw (保留log)
+void run_workers(std::vector<TileJob>& jobs, int max_workers, const std::string& phase) {
+    ScopedTimer timer("Tiles: " + phase + " workers");
+    std::string exe = executable_path();
+    size_t next = 0, running = 0;
+    while (next < jobs.size() || running > 0) {
+        while (next < jobs.size() && running < static_cast<size_t>(max_workers)) {
+            spawn_worker(exe, jobs[next++]);
+            running++;
+        }
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) throw std::runtime_error("waitpid failed while waiting for tile workers");
+        for (auto& job : jobs) {
+            if (job.pid != pid) continue;
+            job.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - job.start).count();
+            job.status = status;
+            job.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            std::cout << "    " << (job.ok ? "✓" : "✗") << " Tile " << job.tile << " " << phase << " worker: "
+                      << std::fixed << std::setprecision(2) << job.seconds << " s" << std::defaultfloat << std::endl;
+            running--;
+            break;
+        }
+    }
+    timer.set_items(jobs.size());
+
+    std::string failed;
+    for (const auto& job : jobs) {
+        if (job.ok) continue;
+        failed += "\n  tile " + std::to_string(job.tile) + " (exit status " +
+                  std::to_string(WIFEXITED(job.status) ? WEXITSTATUS(job.status) : -1) + ", log " + job.log + ")";
+    }
+    if (!failed.empty()) throw std::runtime_error("Tile " + phase + " workers failed:" + failed);
+}
+
+void remove_tile_files(const std::vector<TileJob>& jobs, const std::string& step) {
+    for (const auto& job : jobs) {
+        std::remove(job.input.c_str());
+        std::remove((job.prefix + "_step" + step + CHECKPOINT_EXTENSION).c_str());
+        std::remove(job.log.c_str());
+    }
+}
+
+std::string tile_prefix(const ProgramArguments& args) {
+    return args.output_name.empty() ? "checkpoint" : args.output_name;
+}
+
+int worker_limit(const ProgramArguments& args, int tile_count) {
+    if (args.tile_workers > 0) return args.tile_workers;
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    return std::max(1, std::min(tile_count, cores > 0 ? cores : 1));
+}
+
+void relink_cell(const DesignDatabase& db, Instance& inst) {
+    if (!inst.cell_template) return;
+    auto it = db.cell_library.find(inst.cell_template->name);
+    if (it != db.cell_library.end()) inst.cell_template = it->second;
+}
+
+// Step 18之前所有FF依序 (db.instances順序) 和它們的tile
+struct Ownership {
+    std::vector<std::shared_ptr<Instance>> ffs;
+    std::vector<int> tile;
+    std::unordered_map<const Instance*, int> tile_of;
+};
+
+// =============================================================================
+// STEP 18: BANKING TILES
+// =============================================================================
+
+void add_tile_layout(const DesignDatabase& db, const Rectangle& area, const std::vector<Rectangle>& obstacles,
+                     Dbu row_height, DesignDatabase& sub);
+
+void export_banking_tile(const DesignDatabase& db, const std::vector<std::shared_ptr<Instance>>& owned,
+                         const std::unordered_map<const Instance*, int>& tile_of, int tile, int name_offset,
+                         const Rectangle& area, const std::vector<Rectangle>& obstacles, Dbu row_height,
+                         const std::string& filename) {
+    DesignDatabase sub;
+    sub.design_name = db.design_name;
+    sub.testcase_path = db.testcase_path;
+    sub.input_verilog_path = db.input_verilog_path;
+    sub.input_def_path = db.input_def_path;
+    sub.cell_library = db.cell_library;
+    sub.ff_compatibility_groups = db.ff_compatibility_groups;
+    sub.hierarchical_ff_groups = db.hierarchical_ff_groups;
+    sub.optimal_ff_for_groups = db.optimal_ff_for_groups;
+    sub.banking_eligible_groups = db.banking_eligible_groups;
+    sub.banking_candidate_instance_groups = db.banking_candidate_instance_groups;
+    sub.objective_weights = db.objective_weights;
+    sub.die_area = db.die_area;
+    sub.stats = db.stats;
+    sub.banking_params = db.banking_params;
+    sub.banking_name_counters.fsdn2 = db.banking_name_counters.fsdn2 + name_offset;
+    sub.banking_name_counters.fsdn4 = db.banking_name_counters.fsdn4 + name_offset;
+    sub.banking_name_counters.lsrdpq4 = db.banking_name_counters.lsrdpq4 + name_offset;
+
+    // 反向插入：iteration順序和parent相同
+    sub.instances.reserve(owned.size());
+    for (size_t i = owned.size(); i-- > 0;) sub.instances.emplace(owned[i]->name, owned[i]);
+
+    // 每個group都保留 (banking_group_fraction依key順序取前面的group)
+    for (const auto& group_pair : db.ff_instance_groups) {
+        auto& members = sub.ff_instance_groups[group_pair.first];
+        for (const auto& inst : group_pair.second) {
+            auto it = tile_of.find(inst.get());
+            if (it != tile_of.end() && it->second == tile) members.push_back(inst);
+        }
+    }
+
+    // 每個FF最新的record (banking record繼承它的cluster_id)
+    std::vector<size_t> latest;
+    for (const auto& inst : owned) {
+        TransformationRecordRef record = db.transformation_history.latest_for_instance(inst->name);
+        if (record.valid()) latest.push_back(record.index());
+    }
+    std::sort(latest.begin(), latest.end());
+    latest.erase(std::unique(latest.begin(), latest.end()), latest.end());
+    for (size_t index : latest) sub.transformation_history.push_back(db.transformation_history[index].to_record());
+
+    for (const auto& inst : owned) sub.pin_provenance.register_original_instance(*inst);
+
+    // 4-bit cell的row空隙上限 (placement_capacity.hpp) 用tile內的row和obstacle
+    add_tile_layout(db, area, obstacles, row_height, sub);
+
+    if (!save_checkpoint(sub, "16", filename)) throw std::runtime_error("Cannot write tile checkpoint " + filename);
+}
+
+void merge_banking_tile(DesignDatabase& db, DesignDatabase& result, const std::vector<std::shared_ptr<Instance>>& owned,
+                        size_t exported_records, std::map<std::string, std::vector<std::shared_ptr<Instance>>>& groups,
+                        int& removed_count, int& created_count) {
+    std::unordered_map<std::string, std::shared_ptr<Instance>> owned_by_name;
+    owned_by_name.reserve(owned.size());
+    for (const auto& inst : owned) owned_by_name.emplace(inst->name, inst);
+
+    // 被banking掉的FF
+    std::unordered_set<std::string> removed;
+    for (const auto& inst : owned) {
+        if (result.instances.count(inst->name)) continue;
+        db.instances.erase(inst->name);
+        removed.insert(inst->name);
+        removed_count++;
+    }
+
+    // 新的MBFF (CellTemplate換回parent library的物件)
+    std::unordered_map<std::string, std::shared_ptr<Instance>> created;
+    for (const auto& pair : result.instances) {
+        if (owned_by_name.count(pair.first)) continue;
+        relink_cell(db, *pair.second);
+        db.instances[pair.first] = pair.second;
+        created.emplace(pair.first, pair.second);
+        created_count++;
+    }
+
+    // Groups：原本的FF用parent的物件，其他 (新的 / worker留下的舊entry) 用worker的物件
+    for (const auto& group_pair : result.ff_instance_groups) {
+        auto& members = groups[group_pair.first];
+        for (const auto& inst : group_pair.second) {
+            auto owned_it = owned_by_name.find(inst->name);
+            if (owned_it != owned_by_name.end()) {
+                members.push_back(owned_it->second);
+                continue;
+            }
+            auto created_it = created.find(inst->name);
+            if (created_it != created.end()) {
+                members.push_back(created_it->second);
+                continue;
+            }
+            relink_cell(db, *inst);
+            members.push_back(inst);
+        }
+    }
+
+    // Worker新增的records (匯出的最新records之後)
+    for (size_t i = exported_records; i < result.transformation_history.slot_count(); i++) {
+        if (result.transformation_history.is_removed(i)) continue;
+        db.transformation_history.push_back(result.transformation_history[i].to_record());
+    }
+
+    // Pin provenance：tile內原始pin的最終位置接到parent的live pin
+    const PinProvenance& provenance = result.pin_provenance;
+    for (int node : provenance.original_pins) {
+        int live = provenance.find(node);
+        if (live == node) continue;
+        db.pin_provenance.forward_pin(provenance.node_instance(node), provenance.node_pin(node),
+                                      provenance.node_instance(live), provenance.node_pin(live));
+    }
+
+    db.banking_name_counters.fsdn2 = std::max(db.banking_name_counters.fsdn2, result.banking_name_counters.fsdn2);
+    db.banking_name_counters.fsdn4 = std::max(db.banking_name_counters.fsdn4, result.banking_name_counters.fsdn4);
+    db.banking_name_counters.lsrdpq4 = std::max(db.banking_name_counters.lsrdpq4, result.banking_name_counters.lsrdpq4);
+}
+
+// 邊界halo內的1-bit FF再banking一次 (跨tile的配對)，只看這些FF
+int run_boundary_fixup_banking(DesignDatabase& db, const TileGrid& grid, Dbu halo) {
+    ScopedTimer timer("Tiles: boundary fix-up banking");
+    std::unordered_set<const Instance*> band;
+    std::map<std::string, std::vector<std::shared_ptr<Instance>>> band_groups;
+    for (const auto& group_pair : db.ff_instance_groups) {
+        auto& members = band_groups[group_pair.first];
+        for (const auto& inst : group_pair.second) {
+            auto it = db.instances.find(inst->name);
+            if (it == db.instances.end() || it->second != inst) continue;
+            if (inst->get_bit_width() != 1 || grid.distance_to_internal_edge(inst->position) > halo) continue;
+            if (band.insert(inst.get()).second) members.push_back(inst);
+        }
+    }
+    std::cout << "  Boundary fix-up: " << band.size() << " single-bit FFs within " << halo << " DBU of a tile edge"
+              << std::endl;
+
+    size_t before = db.instances.size();
+    db.ff_instance_groups.swap(band_groups);
+    {
+        PROFILE_SCOPE("execute_fsdn_two_phase_banking");
+        execute_fsdn_two_phase_banking(db);
+    }
+    {
+        PROFILE_SCOPE("execute_lsrdpq_single_phase_banking");
+        execute_lsrdpq_single_phase_banking(db);
+    }
+    db.ff_instance_groups.swap(band_groups);
+
+    // band以外的member照舊，band的部分換成fix-up之後的list
+    for (auto& group_pair : db.ff_instance_groups) {
+        auto& members = group_pair.second;
+        members.erase(std::remove_if(members.begin(), members.end(),
+                                     [&band](const std::shared_ptr<Instance>& inst) { return band.count(inst.get()) > 0; }),
+                      members.end());
+        const auto& fixed = band_groups[group_pair.first];
+        members.insert(members.end(), fixed.begin(), fixed.end());
+    }
+    timer.set_items(band.size());
+    return static_cast<int>(before - db.instances.size());
+}
+
+// =============================================================================
+// STEP 19: LEGALIZATION TILES
+// =============================================================================
+
+// Row裁成tile範圍內的一條sub-row (site對齊)；沒有空間時回傳false
+bool clip_row(const PlacementRow& row, const Rectangle& area, PlacementRow& clipped) {
+    Dbu site = row.site_width > 0 ? row.site_width : row.step_x;
+    if (site <= 0) return false;
+    Dbu row_start = row.origin.x;
+    Dbu row_end = row.origin.x + row.step_x * row.num_x;
+    Dbu lo = std::max(row_start, area.x1);
+    Dbu hi = std::min(row_end, area.x2);
+    if (lo >= hi) return false;
+    Dbu x_min = row_start + ceil_div(lo - row_start, site) * site;
+    Dbu x_max = row_start + floor_div(hi - row_start, site) * site;
+    if (x_min >= x_max) return false;
+    clipped = row;
+    clipped.subrows.clear();
+    clipped.subrows.emplace_back(x_min, x_max);
+    return true;
+}
+
+bool overlaps(const Rectangle& rect, const Rectangle& area, Dbu row_height) {
+    // row origin在 [y1, y2) 的row往上延伸row_height
+    Dbu top = area.y2 == TILE_OPEN_HIGH ? TILE_OPEN_HIGH : area.y2 + row_height;
+    return rect.x1 < area.x2 && rect.x2 > area.x1 && rect.y1 < top && rect.y2 > area.y1;
+}
+
+// Tile範圍內的row (裁過) 和重疊的obstacle
+void add_tile_layout(const DesignDatabase& db, const Rectangle& area, const std::vector<Rectangle>& obstacles,
+                     Dbu row_height, DesignDatabase& sub) {
+    for (const auto& row : db.placement_rows) {
+        if (row.origin.y < area.y1 || row.origin.y >= area.y2) continue;
+        PlacementRow clipped;
+        if (clip_row(row, area, clipped)) sub.placement_rows.push_back(clipped);
+    }
+    for (const auto& rect : obstacles) {
+        if (overlaps(rect, area, row_height)) sub.placement_blockages.push_back(rect);
+    }
+}
+
+void export_legalization_tile(const DesignDatabase& db, const std::vector<std::shared_ptr<Instance>>& owned,
+                              const Rectangle& area, const std::vector<Rectangle>& obstacles, Dbu row_height,
+                              const std::string& filename) {
+    DesignDatabase sub;
+    sub.design_name = db.design_name;
+    sub.input_def_path = db.input_def_path;
+    sub.cell_library = db.cell_library;
+    sub.die_area = db.die_area;
+    sub.banking_params = db.banking_params;
+
+    sub.instances.reserve(owned.size());
+    for (size_t i = owned.size(); i-- > 0;) {
+        auto copy = std::make_shared<Instance>(*owned[i]);
+        copy->placement_status = Instance::UNPLACED;
+        sub.instances.emplace(copy->name, copy);
+    }
+    add_tile_layout(db, area, obstacles, row_height, sub);
+
+    if (!save_checkpoint(sub, "18.5", filename)) throw std::runtime_error("Cannot write tile checkpoint " + filename);
+}
+
+// 組合邏輯cell / out-of-core obstacle / placement blockage的rectangle
+std::vector<Rectangle> collect_obstacles(const DesignDatabase& db) {
+    std::vector<Rectangle> obstacles;
+    for (const auto& pair : db.instances) {
+        const auto& inst = pair.second;
+        if (inst->is_flip_flop() || !inst->cell_template) continue;
+        Rectangle rect;
+        rect.x1 = inst->position.x;
+        rect.y1 = inst->position.y;
+        rect.x2 = inst->position.x + inst->cell_template->width;
+        rect.y2 = inst->position.y + inst->cell_template->height;
+        obstacles.push_back(rect);
+    }
+    if (db.out_of_core) {
+        const ObstacleRecord* records = db.out_of_core->obstacles();
+        for (size_t i = 0; i < db.out_of_core->obstacle_count(); i++) {
+            Rectangle rect;
+            rect.x1 = records[i].x;
+            rect.y1 = records[i].y;
+            rect.x2 = records[i].x + records[i].width;
+            rect.y2 = records[i].y + records[i].height;
+            obstacles.push_back(rect);
+        }
+    }
+    obstacles.insert(obstacles.end(), db.placement_blockages.begin(), db.placement_blockages.end());
+    return obstacles;
+}
+
+} // namespace
+
+// =============================================================================
+// run_tiled_banking
+// =============================================================================
+
+void run_tiled_banking(const ProgramArguments& args, DesignDatabase& db) {
+    int tile_count = args.tiles;
+    int max_workers = worker_limit(args, tile_count);
+    std::string prefix = tile_prefix(args);
+
+    // 擁有權：FF的位置；debank cluster的FF用cluster中心 (同一cluster在同一個tile)
+    Ownership ownership;
+    std::unordered_map<std::string, std::pair<Point, long>> cluster_centers;
+    for (const auto& pair : db.instances) {
+        if (!pair.second->is_flip_flop()) continue;
+        ownership.ffs.push_back(pair.second);
+        if (pair.second->cluster_id.empty()) continue;
+        auto& center = cluster_centers[pair.second->cluster_id];
+        center.first.x += pair.second->position.x;
+        center.first.y += pair.second->position.y;
+        center.second++;
+    }
+    std::vector<Point> points;
+    points.reserve(ownership.ffs.size());
+    for (const auto& inst : ownership.ffs) {
+        Point p = inst->position;
+        if (!inst->cluster_id.empty()) {
+            const auto& center = cluster_centers[inst->cluster_id];
+            p.x = center.first.x / center.second;
+            p.y = center.first.y / center.second;
+        }
+        points.push_back(p);
+    }
+    TileGrid grid = build_tile_grid(points, tile_count, db);
+
+    std::vector<std::vector<std::shared_ptr<Instance>>> owned(tile_count);
+    ownership.tile_of.reserve(ownership.ffs.size());
+    for (size_t i = 0; i < ownership.ffs.size(); i++) {
+        int tile = grid.tile_of(points[i]);
+        owned[tile].push_back(ownership.ffs[i]);
+        ownership.tile_of[ownership.ffs[i].get()] = tile;
+    }
+    // groups裡不在db.instances的舊entry依位置分
+    for (const auto& group_pair : db.ff_instance_groups) {
+        for (const auto& inst : group_pair.second) {
+            if (!ownership.tile_of.count(inst.get())) ownership.tile_of[inst.get()] = grid.tile_of(inst->position);
+        }
+    }
+
+    Dbu row_height = 0;
+    for (const auto& row : db.placement_rows) row_height = std::max(row_height, row.height > 0 ? row.height : row.step_y);
+    std::vector<Rectangle> obstacles = collect_obstacles(db);
+
+    std::cout << "  🧩 Tiled banking: " << tile_count << " tiles (" << grid.cols << "x" << grid.rows << "), "
+              << max_workers << " worker processes" << std::endl;
+    for (int t = 0; t < tile_count; t++) {
+        std::cout << "    Tile " << t << " " << format_area(grid.tiles[t]) << ": " << owned[t].size() << " FFs"
+                  << std::endl;
+    }
+
+    std::vector<TileJob> jobs(tile_count);
+    std::vector<size_t> exported_records(tile_count, 0);
+    std::vector<int> name_offsets(tile_count, 0);
+    for (int t = 1; t < tile_count; t++) name_offsets[t] = name_offsets[t - 1] + static_cast<int>(owned[t - 1].size());
+    for (int t = 0; t < tile_count; t++) {
+        TileJob& job = jobs[t];
+        job.tile = t;
+        job.prefix = prefix + "_tile" + std::to_string(t) + "_bank";
+        job.input = job.prefix + CHECKPOINT_EXTENSION;
+        job.log = job.prefix + ".log";
+        job.argv = worker_arguments(args, job.input, "18", job.prefix);
+    }
+    {
+        ScopedTimer timer("Tiles: export banking tiles");
+        parallel_for(0, tile_count, 1, [&](size_t first, size_t last) {
+            for (size_t t = first; t < last; t++) {
+                export_banking_tile(db, owned[t], ownership.tile_of, static_cast<int>(t), name_offsets[t],
+                                    grid.tiles[t], obstacles, row_height, jobs[t].input);
+            }
+        });
+        // 匯出的record數 = 不重複的最新record數 (worker的新record接在後面)
+        for (int t = 0; t < tile_count; t++) {
+            std::unordered_set<size_t> latest;
+            for (const auto& inst : owned[t]) {
+                TransformationRecordRef record = db.transformation_history.latest_for_instance(inst->name);
+                if (record.valid()) latest.insert(record.index());
+            }
+            exported_records[t] = latest.size();
+        }
+        timer.set_items(ownership.ffs.size());
+    }
+
+    run_workers(jobs, max_workers, "banking");
+
+    int removed_count = 0, created_count = 0;
+    {
+        ScopedTimer timer("Tiles: merge banking tiles");
+        std::map<std::string, std::vector<std::shared_ptr<Instance>>> groups;
+        for (const auto& group_pair : db.ff_instance_groups) groups[group_pair.first];
+        for (int t = 0; t < tile_count; t++) {
+            DesignDatabase result;
+            std::string step;
+            std::string filename = jobs[t].prefix + "_step18" + CHECKPOINT_EXTENSION;
+            if (!load_checkpoint(filename, result, step)) {
+                throw std::runtime_error("Cannot load tile result " + filename);
+            }
+            merge_banking_tile(db, result, owned[t], exported_records[t], groups, removed_count, created_count);
+        }
+        db.ff_instance_groups.swap(groups);
+        timer.set_items(ownership.ffs.size());
+    }
+    remove_tile_files(jobs, "18");
+    std::cout << "  Merged " << tile_count << " tiles: " << removed_count << " FFs banked into " << created_count
+              << " MBFFs" << std::endl;
+
+    Dbu halo = args.tile_halo > 0
+        ? static_cast<Dbu>(args.tile_halo)
+        : static_cast<Dbu>(std::max(db.banking_params.fsdn2_distance,
+                                    std::max(db.banking_params.fsdn4_distance, db.banking_params.lsrdpq4_distance)));
+    int fixup_reduction = run_boundary_fixup_banking(db, grid, halo);
+    std::cout << "  Boundary fix-up reduced the instance count by " << fixup_reduction << std::endl;
+
+    {
+        PROFILE_SCOPE("record_all_banking_transformations");
+        record_all_banking_transformations(db);
+    }
+}
+
+// =============================================================================
+// run_tiled_legalization
+// =============================================================================
+
+void run_tiled_legalization(const ProgramArguments& args, DesignDatabase& db) {
+    int tile_count = args.tiles;
+    int max_workers = worker_limit(args, tile_count);
+    std::string prefix = tile_prefix(args);
+
+    std::vector<std::shared_ptr<Instance>> ffs;
+    std::vector<Point> points;
+    for (const auto& pair : db.instances) {
+        if (!pair.second->is_flip_flop()) continue;
+        ffs.push_back(pair.second);
+        points.push_back(pair.second->position);
+    }
+    TileGrid grid = build_tile_grid(points, tile_count, db);
+    std::vector<std::vector<std::shared_ptr<Instance>>> owned(tile_count);
+    for (size_t i = 0; i < ffs.size(); i++) owned[grid.tile_of(points[i])].push_back(ffs[i]);
+
+    Dbu row_height = 0;
+    for (const auto& row : db.placement_rows) row_height = std::max(row_height, row.height > 0 ? row.height : row.step_y);
+    std::vector<Rectangle> obstacles = collect_obstacles(db);
+
+    std::cout << "  🧩 Tiled legalization: " << tile_count << " tiles (" << grid.cols << "x" << grid.rows << "), "
+              << max_workers << " worker processes, " << obstacles.size() << " obstacles" << std::endl;
+    for (int t = 0; t < tile_count; t++) {
+        std::cout << "    Tile " << t << " " << format_area(grid.tiles[t]) << ": " << owned[t].size() << " FFs"
+                  << std::endl;
+    }
+
+    std::vector<TileJob> jobs(tile_count);
+    for (int t = 0; t < tile_count; t++) {
+        TileJob& job = jobs[t];
+        job.tile = t;
+        job.prefix = prefix + "_tile" + std::to_string(t) + "_legal";
+        job.input = job.prefix + CHECKPOINT_EXTENSION;
+        job.log = job.prefix + ".log";
+        job.argv = worker_arguments(args, job.input, "19", job.prefix);
+    }
+    {
+        ScopedTimer timer("Tiles: export legalization tiles");
+        parallel_for(0, tile_count, 1, [&](size_t first, size_t last) {
+            for (size_t t = first; t < last; t++) {
+                export_legalization_tile(db, owned[t], grid.tiles[t], obstacles, row_height, jobs[t].input);
+            }
+        });
+        timer.set_items(ffs.size());
+    }
+
+    run_workers(jobs, max_workers, "legalization");
+
+    std::vector<std::shared_ptr<Instance>> failed;
+    {
+        ScopedTimer timer("Tiles: merge legalization tiles");
+        for (int t = 0; t < tile_count; t++) {
+            DesignDatabase result;
+            std::string step;
+            std::string filename = jobs[t].prefix + "_step19" + CHECKPOINT_EXTENSION;
+            if (!load_checkpoint(filename, result, step)) {
+                throw std::runtime_error("Cannot load tile result " + filename);
+            }
+            for (const auto& inst : owned[t]) {
+                auto it = result.instances.find(inst->name);
+                if (it != result.instances.end() && it->second->placement_status == Instance::PLACED) {
+                    inst->x_new = it->second->x_new;
+                    inst->y_new = it->second->y_new;
+                    inst->placement_status = Instance::PLACED;
+                } else {
+                    inst->x_new = inst->position.x;
+                    inst->y_new = inst->position.y;
+                    failed.push_back(inst);
+                }
+            }
+        }
+        timer.set_items(ffs.size());
+    }
+    remove_tile_files(jobs, "19");
+
+    // Tile內放不下的FF：已放好的FF也當obstacle，在整個die上再legalize
+    if (!failed.empty()) {
+        ScopedTimer timer("Tiles: boundary fix-up legalization");
+        std::cout << "  Fix-up legalization: " << failed.size() << " FFs did not fit in their tile" << std::endl;
+        std::unordered_set<const Instance*> pending;
+        for (const auto& inst : failed) pending.insert(inst.get());
+
+        DesignDatabase fixup;
+        fixup.cell_library = db.cell_library;
+        fixup.banking_params = db.banking_params;
+        fixup.placement_rows = db.placement_rows;
+        for (auto& row : fixup.placement_rows) row.subrows.clear();
+        fixup.placement_blockages = obstacles;
+        for (const auto& inst : ffs) {
+            if (pending.count(inst.get()) || !inst->cell_template) continue;
+            Rectangle rect;
+            rect.x1 = inst->x_new;
+            rect.y1 = inst->y_new;
+            rect.x2 = inst->x_new + inst->cell_template->width;
+            rect.y2 = inst->y_new + inst->cell_template->height;
+            fixup.placement_blockages.push_back(rect);
+        }
+        for (const auto& inst : failed) fixup.instances.emplace(inst->name, inst);
+
+        double max_displacement = db.banking_params.legalization_max_displacement > 0.0
+            ? db.banking_params.legalization_max_displacement : std::numeric_limits<double>::max();
+        Legalizer legalizer(max_displacement, fixup);
+        legalizer.Abacus();
+        legalizer.place();
+        timer.set_items(failed.size());
+    }
+
+    int placed_count = 0;
+    for (const auto& inst : ffs) {
+        if (inst->x_new != 0 || inst->y_new != 0) placed_count++;
+    }
+    std::cout << "Total placed flip-flops: " << placed_count << std::endl;
+}
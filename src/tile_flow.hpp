@@ -0,0 +1,36 @@
+#ifndef TILE_FLOW_HPP
+#define TILE_FLOW_HPP
+
+#include "argument_parser.hpp"
+
+class DesignDatabase;
+
+// =============================================================================
+// TILE-BASED DIVIDE-AND-CONQUER (-tiles N)
+// =============================================================================
+// 百萬FF等級的design，Step 18 / 19 在單一process裡受限於一台機器的記憶體頻寬和heap
+// -tiles N 把die依FF分布切成N個tile (先依x分欄、每欄再依y分，每個tile FF數相近，
+// y切線對齊placement row)，每個tile交給獨立的worker process：
+//   Step 18: tile sub-database (tile內的FF + 相關的groups / 最新record / pin provenance)
+//            存成checkpoint → worker (同一個執行檔, -tile_worker) 做banking → 存回checkpoint
+//            → 依tile順序合併 (instances / groups / transformation records / pin forwarding)
+//            Boundary fix-up：tile邊界halo內還是1-bit的FF在主process再banking一次
+//            (跨tile的配對)，再記錄所有banking並capture BANK stage
+//   Step 19: tile sub-database (tile內的FF + 和tile重疊的obstacle rectangles，
+//            row裁成tile範圍內的sub-row) → worker做Abacus → 合併位置
+//            Boundary fix-up：tile內放不下的FF，以已放好的FF為obstacle在整個die上再legalize
+// 同一個debank cluster的FF (cluster_id) 一律分到cluster中心所在的tile
+// worker最多 -tile_workers 個同時執行；tile檔 (<out>_tile<k>_*) 成功後刪除，
+// worker失敗時保留log (<out>_tile<k>_*.log)
+// 結果和單一process不會逐byte相同 (tile邊界附近的配對不同)，QoR在容許範圍內
+// =============================================================================
+
+#define TILE_EXE_PATH_MAX 4096
+
+// Step 18 with per-tile banking worker processes and a boundary fix-up pass
+void run_tiled_banking(const ProgramArguments& args, DesignDatabase& db);
+
+// Step 19 with per-tile legalization worker processes and a whole-die fix-up pass
+void run_tiled_legalization(const ProgramArguments& args, DesignDatabase& db);
+
+#endif // TILE_FLOW_HPP
@@ -0,0 +1,91 @@
+#include "time_budget.hpp"
+#include "data_structures.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+// =============================================================================
+// TIME BUDGET
+// =============================================================================
+
+TimeBudget::TimeBudget(double seconds)
+    : budget_seconds_(seconds), start_(Clock::now()) {
+    deadline_ = start_ + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    phase_deadline_ = deadline_;
+}
+
+double TimeBudget::seconds_between(Clock::time_point from, Clock::time_point to) const {
+    return std::chrono::duration<double>(to - from).count();
+}
+
+double TimeBudget::elapsed_seconds() const {
+    return seconds_between(start_, Clock::now());
+}
+
+double TimeBudget::remaining_seconds() const {
+    return seconds_between(Clock::now(), deadline_);
+}
+
+void TimeBudget::plan_phase(const std::string& name, double weight) {
+    for (const auto& phase : phases_) {
+        if (phase.name == name) return;     // 同一個design分段執行時只登記一次
+    }
+    Phase phase;
+    phase.name = name;
+    phase.weight = weight;
+    phases_.push_back(phase);
+}
+
+void TimeBudget::begin_phase(const std::string& name) {
+    auto it = std::find_if(phases_.begin(), phases_.end(), [&name](const Phase& p) { return p.name == name; });
+    if (it == phases_.end()) return;
+
+    // 輸出保留時間：第一個phase開始時依已量到的setup時間決定，之後固定
+    if (output_reserve_seconds_ < 0.0) {
+        output_reserve_seconds_ = std::max(TIME_BUDGET_OUTPUT_RATIO * elapsed_seconds(),
+                                           TIME_BUDGET_MIN_OUTPUT_FRACTION * budget_seconds_);
+    }
+
+    double remaining_weight = 0.0;
+    for (auto p = it; p != phases_.end(); ++p) {
+        if (!p->started) remaining_weight += p->weight;
+    }
+    double window = std::max(0.0, remaining_seconds() - output_reserve_seconds_);
+    double share = remaining_weight > 0.0 ? it->weight / remaining_weight : 1.0;
+
+    it->started = true;
+    it->allocated_seconds = window * share;
+    current_ = static_cast<int>(it - phases_.begin());
+    phase_deadline_ = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                         std::chrono::duration<double>(it->allocated_seconds));
+
+    std::cout << "  ⏱️  Time budget: " << name << " gets " << std::fixed << std::setprecision(1)
+              << it->allocated_seconds << " s (" << remaining_seconds() << " s left, "
+              << output_reserve_seconds_ << " s reserved for output)" << std::defaultfloat << std::endl;
+}
+
+bool TimeBudget::phase_expired() {
+    if (current_ < 0) return false;
+    Phase& phase = phases_[current_];
+    if (phase.expired) return true;
+    if (Clock::now() < phase_deadline_) return false;
+
+    phase.expired = true;
+    phase.expired_at = elapsed_seconds();
+    std::cout << "  ⏱️  Time budget: " << phase.name << " stopped at " << std::fixed << std::setprecision(1)
+              << phase.expired_at << " s, keeping the best result so far" << std::defaultfloat << std::endl;
+    return true;
+}
+
+void TimeBudget::print_summary(std::ostream& out) const {
+    out << "\n⏱️  Time budget " << std::fixed << std::setprecision(1) << budget_seconds_ << " s: "
+        << elapsed_seconds() << " s used before output";
+    for (const auto& phase : phases_) {
+        if (phase.expired) out << ", " << phase.name << " cut at " << phase.expired_at << " s";
+    }
+    out << std::defaultfloat << std::endl;
+}
+
+bool time_budget_expired(DesignDatabase& db) {
+    return db.time_budget && db.time_budget->phase_expired();
+}
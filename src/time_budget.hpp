@@ -0,0 +1,77 @@
+#ifndef TIME_BUDGET_HPP
+#define TIME_BUDGET_HPP
+
+#include <chrono>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class DesignDatabase;
+
+// =============================================================================
+// WALL-CLOCK TIME BUDGET (-time_budget <seconds>)
+// =============================================================================
+// 沒有 -time_budget 時每個stage照常跑完；有的話：
+//   1. 先保留輸出時間 (legalization + writers)：以第一個anytime phase開始前
+//      實際量到的setup時間 (parse + steps 6-11) 乘上比例估計，至少整體的固定比例
+//   2. 剩下的時間在還沒開始的anytime phases之間依權重分配；每個phase開始時
+//      重新用「現在到deadline」計算，前面省下或超用的時間自動轉給後面的phase
+//   3. Anytime phase在group / cluster之間檢查 phase_expired()，到期就停下，
+//      已完成的banking / debanking保留 (best-so-far)，其餘FF維持原樣
+//   4. Legalization一定會跑完 (結果一定合法)；到期後每個FF只找到第一個可放的row為止
+// Parse和非anytime的steps不會被中斷，它們本身超時的話anytime phases直接跳過
+// =============================================================================
+
+#define TIME_BUDGET_OUTPUT_RATIO 3.5          // Output reserve = ratio x measured setup time
+#define TIME_BUDGET_MIN_OUTPUT_FRACTION 0.15  // ... but at least this share of the whole budget
+
+// Anytime phase weights (share of the optimization window, measured on synthetic designs)
+#define TIME_BUDGET_WEIGHT_DEBANKING 0.20
+#define TIME_BUDGET_WEIGHT_BANKING 0.70
+#define TIME_BUDGET_WEIGHT_LEGALIZATION 0.10
+
+class TimeBudget {
+public:
+    explicit TimeBudget(double seconds);
+
+    // Declare the anytime phases this run will execute, in order (repeated names are ignored)
+    void plan_phase(const std::string& name, double weight);
+
+    // Start a planned phase: its deadline is its weighted share of the time left
+    void begin_phase(const std::string& name);
+
+    // Polled between units of work; prints once when the phase runs out
+    bool phase_expired();
+
+    double elapsed_seconds() const;
+    double remaining_seconds() const;   // Until the overall deadline (may be negative)
+
+    void print_summary(std::ostream& out) const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Phase {
+        std::string name;
+        double weight = 0.0;
+        bool started = false;
+        double allocated_seconds = 0.0;
+        bool expired = false;
+        double expired_at = 0.0;        // Elapsed seconds when the phase was cut
+    };
+
+    double seconds_between(Clock::time_point from, Clock::time_point to) const;
+
+    double budget_seconds_;
+    Clock::time_point start_;
+    Clock::time_point deadline_;
+    Clock::time_point phase_deadline_;
+    double output_reserve_seconds_ = -1.0;   // Fixed at the first begin_phase
+    std::vector<Phase> phases_;
+    int current_ = -1;
+};
+
+// Loop check for anytime phases (false when the run has no -time_budget)
+bool time_budget_expired(DesignDatabase& db);
+
+#endif // TIME_BUDGET_HPP
@@ -0,0 +1,121 @@
+#include "trace_recorder.hpp"
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+
+// =============================================================================
+// TRACE RECORDER IMPLEMENTATION
+// =============================================================================
+
+TraceRecorder& TraceRecorder::instance() {
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+TraceRecorder::TraceRecorder() : epoch_(std::chrono::steady_clock::now()) {}
+
+void TraceRecorder::enable(const std::string& output_file) {
+    output_file_ = output_file;
+    epoch_ = std::chrono::steady_clock::now();
+    enabled_.store(true, std::memory_order_relaxed);
+    set_thread_name("main");
+}
+
+const char* TraceRecorder::intern(const std::string& name) {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    return names_.insert(name).first->c_str();  // unordered_set nodes are stable
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::local_buffer() {
+    static thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer) return buffer;
+
+    std::unique_ptr<ThreadBuffer> created(new ThreadBuffer());
+    created->events.resize(RING_CAPACITY);
+
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    created->thread_id = static_cast<int>(buffers_.size()) + 1;
+    created->thread_name = "thread " + std::to_string(created->thread_id);
+    buffer = created.get();
+    buffers_.push_back(std::move(created));
+    return buffer;
+}
+
+void TraceRecorder::set_thread_name(const std::string& name) {
+    if (!enabled()) return;
+    ThreadBuffer* buffer = local_buffer();
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    buffer->thread_name = name;
+}
+
+void TraceRecorder::record(const char* name, char phase, double value) {
+    if (!enabled()) return;
+    ThreadBuffer* buffer = local_buffer();
+
+    unsigned long long position = buffer->head.load(std::memory_order_relaxed);
+    TraceEvent& event = buffer->events[position % RING_CAPACITY];
+    event.name = name;
+    event.phase = phase;
+    event.value = value;
+    event.timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - epoch_).count();
+    buffer->head.store(position + 1, std::memory_order_release);
+}
+
+static void write_json_string(std::ostream& out, const char* value) {
+    out << '"';
+    for (const char* c = value; *c; ++c) {
+        if (*c == '"' || *c == '\\') out << '\\';
+        out << *c;
+    }
+    out << '"';
+}
+
+bool TraceRecorder::flush() {
+    if (!enabled()) return false;
+
+    std::ofstream out(output_file_);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot open " << output_file_ << " for writing" << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    out << "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \"cadb_1060_final\"}}";
+
+    size_t total_events = 0;
+    size_t dropped_events = 0;
+    for (const auto& buffer : buffers_) {
+        out << ",\n  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->thread_id
+            << ", \"args\": {\"name\": ";
+        write_json_string(out, buffer->thread_name.c_str());
+        out << "}}";
+
+        unsigned long long head = buffer->head.load(std::memory_order_acquire);
+        unsigned long long first = head > RING_CAPACITY ? head - RING_CAPACITY : 0;
+        dropped_events += static_cast<size_t>(first);
+
+        for (unsigned long long i = first; i < head; ++i) {
+            const TraceEvent& event = buffer->events[i % RING_CAPACITY];
+            out << ",\n  {\"name\": ";
+            write_json_string(out, event.name);
+            out << ", \"ph\": \"" << event.phase << "\", \"ts\": " << event.timestamp_us
+                << ", \"pid\": 1, \"tid\": " << buffer->thread_id;
+            if (event.phase == 'C') {
+                out << ", \"args\": {\"value\": " << std::setprecision(12) << event.value << "}";
+            }
+            out << "}";
+            total_events++;
+        }
+    }
+    out << "\n]}\n";
+
+    std::cout << "  Trace written to " << output_file_ << " (" << total_events << " events, "
+              << buffers_.size() << " threads";
+    if (dropped_events > 0) {
+        std::cout << ", " << dropped_events << " oldest events overwritten";
+    }
+    std::cout << ")" << std::endl;
+    return true;
+}
@@ -0,0 +1,99 @@
+#ifndef TRACE_RECORDER_HPP
+#define TRACE_RECORDER_HPP
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
+// =============================================================================
+// CHROME TRACE-EVENT RECORDER (-trace <file>)
+// =============================================================================
+// 每個thread第一次記錄時註冊自己的ring buffer，之後寫入完全不用lock
+// (single producer：只有owner thread寫，flush時用acquire讀head)
+// buffer滿了就覆蓋最舊的事件；flush輸出Chrome trace-event JSON，可直接用Perfetto開
+// 沒有 -trace 時 enabled() 為false，TRACE_SCOPE只剩一個branch
+// =============================================================================
+
+struct TraceEvent {
+    const char* name = nullptr;          // Interned, stable for the whole run
+    char phase = 'B';                    // 'B' begin, 'E' end, 'C' counter
+    long long timestamp_us = 0;
+    double value = 0.0;                  // Counter value
+};
+
+class TraceRecorder {
+public:
+    static const size_t RING_CAPACITY = 1 << 16;  // Events per thread
+
+    static TraceRecorder& instance();
+
+    void enable(const std::string& output_file);
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // Intern an event name (thread-safe; call once per distinct name)
+    const char* intern(const std::string& name);
+
+    void begin(const char* name) { record(name, 'B', 0.0); }
+    void end(const char* name) { record(name, 'E', 0.0); }
+    void counter(const char* name, double value) { record(name, 'C', value); }
+
+    // Label the calling thread in the trace (e.g. "main", "worker 3")
+    void set_thread_name(const std::string& name);
+
+    // Write all buffered events; call after worker threads have finished
+    bool flush();
+
+private:
+    struct ThreadBuffer {
+        int thread_id = 0;
+        std::string thread_name;
+        std::vector<TraceEvent> events;
+        std::atomic<unsigned long long> head{0};   // Total events written by the owner
+    };
+
+    TraceRecorder();
+
+    void record(const char* name, char phase, double value);
+    ThreadBuffer* local_buffer();
+
+    std::atomic<bool> enabled_{false};
+    std::string output_file_;
+    std::chrono::steady_clock::time_point epoch_;
+
+    std::mutex registry_mutex_;                    // Only for buffer registration / interning / flush
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+    std::unordered_set<std::string> names_;
+};
+
+// RAII begin/end pair; usable from any thread
+class TraceScope {
+public:
+    explicit TraceScope(const char* interned_name) : name_(nullptr) {
+        TraceRecorder& recorder = TraceRecorder::instance();
+        if (recorder.enabled()) {
+            name_ = interned_name;
+            recorder.begin(name_);
+        }
+    }
+    ~TraceScope() {
+        if (name_) TraceRecorder::instance().end(name_);
+    }
+
+private:
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+    const char* name_;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+// name must be a string literal; it is interned once per call site
+#define TRACE_SCOPE(name) \
+    static const char* TRACE_CONCAT(trace_name_, __LINE__) = TraceRecorder::instance().intern(name); \
+    TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(TRACE_CONCAT(trace_name_, __LINE__))
+
+#endif // TRACE_RECORDER_HPP
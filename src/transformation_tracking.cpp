@@ -7,6 +7,8 @@
 // =============================================================================
 
 #include "parsers.hpp"
+#include "out_of_core.hpp"
+#include "compressed_stream.hpp"
 #include <iostream>
 #include <fstream>
 #include <iomanip>
@@ -173,15 +175,11 @@ void record_substitute_transformation(DesignDatabase& db,
     record.result_y = instance->position.y;
     record.result_orientation = orientation_to_string(instance->orientation);
     
-    // Enhanced cluster tracking: Inherit cluster_id from previous record
+    // Enhanced cluster tracking: Inherit cluster_id from the latest record of this instance
     std::string inherited_cluster_id = "";
-    for (const auto& existing_record : db.transformation_history) {
-        bool is_matching_record = (existing_record.original_instance_name == instance_name) ||
-                                 (existing_record.result_instance_name == instance_name);
-        if (is_matching_record && !existing_record.cluster_id.empty()) {
-            inherited_cluster_id = existing_record.cluster_id;
-            break;
-        }
+    TransformationRecordRef existing_record = db.transformation_history.latest_for_instance(instance_name);
+    if (existing_record.valid()) {
+        inherited_cluster_id = existing_record.cluster_id();
     }
     
     // Set cluster_id and stage info
@@ -203,8 +201,7 @@ void record_substitution_transformation_complete(DesignDatabase& db,
 void record_bank_transformation(DesignDatabase& db,
                               const std::vector<std::shared_ptr<Instance>>& original_singlebit_ffs,
                               const std::string& resulting_multibit_name,
-                              const std::string& multibit_cell_type,
-                              const std::map<std::string, std::string>& pin_mapping) {
+                              const std::string& multibit_cell_type) {
     // Create one record for the banking operation
     // We'll use the first original FF as the "primary" one
     if (original_singlebit_ffs.empty()) return;
@@ -222,8 +219,13 @@ void record_bank_transformation(DesignDatabase& db,
         record.related_instances.push_back(original_singlebit_ffs[i]->name);
     }
     
-    // Record pin mapping
-    record.pin_mapping = pin_mapping;
+    // Record the pins of every source bit; the log derives "src/pin" -> "mbff/pin[i]" from them
+    for (const auto& source : original_singlebit_ffs) {
+        std::vector<std::string> pins;
+        pins.reserve(source->connections.size());
+        for (const auto& conn : source->connections) pins.push_back(conn.pin_name);
+        record.bank_source_pins.push_back(std::move(pins));
+    }
     
     // Position information (use first FF's position)
     record.result_x = original_singlebit_ffs[0]->position.x;
@@ -232,13 +234,9 @@ void record_bank_transformation(DesignDatabase& db,
     
     // Enhanced cluster tracking: Try to inherit cluster_id from primary instance
     std::string inherited_cluster_id = "";
-    for (const auto& existing_record : db.transformation_history) {
-        bool is_matching_record = (existing_record.original_instance_name == original_singlebit_ffs[0]->name) ||
-                                 (existing_record.result_instance_name == original_singlebit_ffs[0]->name);
-        if (is_matching_record && !existing_record.cluster_id.empty()) {
-            inherited_cluster_id = existing_record.cluster_id;
-            break;
-        }
+    TransformationRecordRef existing_record = db.transformation_history.latest_for_instance(original_singlebit_ffs[0]->name);
+    if (existing_record.valid()) {
+        inherited_cluster_id = existing_record.cluster_id();
     }
     
     // Set cluster information
@@ -256,25 +254,25 @@ std::vector<std::string> generate_split_multibit_operations(DesignDatabase& db)
     std::vector<std::string> operations;
     
     // Group DEBANK records by original_instance_name
-    std::map<std::string, std::vector<const TransformationRecord*>> debank_groups;
+    std::map<std::string, std::vector<TransformationRecordRef>> debank_groups;
     
     for (const auto& record : db.transformation_history) {
-        if (record.operation == TransformationRecord::DEBANK) {
-            debank_groups[record.original_instance_name].push_back(&record);
+        if (record.operation() == TransformationRecord::DEBANK) {
+            debank_groups[record.original_instance_name()].push_back(record);
         }
     }
     
     // Generate split_multibit operation for each debank group
     for (const auto& group : debank_groups) {
         const std::string& original_multibit_name = group.first;
-        const std::vector<const TransformationRecord*>& debank_records = group.second;
+        const std::vector<TransformationRecordRef>& debank_records = group.second;
         
         if (debank_records.empty()) continue;
         
         // Extract bit width and library info
         int bit_width = debank_records.size();
-        const std::string& original_lib = debank_records[0]->original_cell_type;
-        const std::string& result_lib = debank_records[0]->result_cell_type;
+        const std::string& original_lib = debank_records[0].original_cell_type();
+        const std::string& result_lib = debank_records[0].result_cell_type();
         
         // Generate operation string
         std::stringstream op;
@@ -286,7 +284,7 @@ std::vector<std::string> generate_split_multibit_operations(DesignDatabase& db)
         // Output single-bit FFs (with dummy names and mapping)
         for (size_t i = 0; i < debank_records.size(); i++) {
             std::string dummy_name = "dummy_" + std::to_string(db.global_dummy_counter++);
-            std::string real_name = debank_records[i]->result_instance_name;
+            std::string real_name = debank_records[i].result_instance_name();
             
             // Build dummy mapping
             db.dummy_to_real_mapping[dummy_name] = real_name;
@@ -307,12 +305,12 @@ std::vector<std::string> generate_size_cell_operations(const DesignDatabase& db)
     
     // Find all SUBSTITUTE records
     for (const auto& record : db.transformation_history) {
-        if (record.operation == TransformationRecord::SUBSTITUTE) {
+        if (record.operation() == TransformationRecord::SUBSTITUTE) {
             // Determine instance name to use (dummy if exists, otherwise real name)
-            std::string instance_name = record.original_instance_name;
+            std::string instance_name = record.original_instance_name();
             
             // Check if this instance has a dummy mapping
-            auto dummy_it = db.real_to_dummy_mapping.find(record.original_instance_name);
+            auto dummy_it = db.real_to_dummy_mapping.find(record.original_instance_name());
             if (dummy_it != db.real_to_dummy_mapping.end()) {
                 instance_name = dummy_it->second;  // Use dummy name
             }
@@ -320,7 +318,7 @@ std::vector<std::string> generate_size_cell_operations(const DesignDatabase& db)
             // Generate size_cell operation
             std::stringstream op;
             op << "size_cell {" << instance_name << " " 
-               << record.original_cell_type << " " << record.result_cell_type << "}";
+               << record.original_cell_type() << " " << record.result_cell_type() << "}";
             operations.push_back(op.str());
         }
     }
@@ -333,12 +331,12 @@ std::vector<std::string> generate_post_substitute_operations(const DesignDatabas
     
     // Find all POST_SUBSTITUTE records
     for (const auto& record : db.transformation_history) {
-        if (record.operation == TransformationRecord::POST_SUBSTITUTE) {
+        if (record.operation() == TransformationRecord::POST_SUBSTITUTE) {
             // Generate size_cell operation for post-substitution
             std::stringstream op;
-            op << "size_cell {" << record.original_instance_name 
-               << " " << record.original_cell_type 
-               << " " << record.result_cell_type << "}";
+            op << "size_cell {" << record.original_instance_name() 
+               << " " << record.original_cell_type() 
+               << " " << record.result_cell_type() << "}";
             operations.push_back(op.str());
         }
     }
@@ -351,35 +349,35 @@ std::vector<std::string> generate_create_multibit_operations(const DesignDatabas
     
     // Find all BANK records
     for (const auto& record : db.transformation_history) {
-        if (record.operation == TransformationRecord::BANK) {
+        if (record.operation() == TransformationRecord::BANK) {
             // Extract bit width from related instances + primary instance
-            int bit_width = 1 + record.related_instances.size();
+            int bit_width = 1 + record.related_instances().size();
             
             // Generate create_multibit operation
             std::stringstream op;
             op << "create_multibit { ";
             
             // Primary input FF (use dummy name if available)
-            std::string primary_name = record.original_instance_name;
-            auto dummy_it = db.real_to_dummy_mapping.find(record.original_instance_name);
+            std::string primary_name = record.original_instance_name();
+            auto dummy_it = db.real_to_dummy_mapping.find(record.original_instance_name());
             if (dummy_it != db.real_to_dummy_mapping.end()) {
                 primary_name = dummy_it->second;
             }
             
-            op << "{" << primary_name << " " << record.original_cell_type << " 1} ";
+            op << "{" << primary_name << " " << record.original_cell_type() << " 1} ";
             
             // Related input FFs
-            for (const auto& related_name : record.related_instances) {
+            for (const auto& related_name : record.related_instances()) {
                 std::string input_name = related_name;
                 auto related_dummy_it = db.real_to_dummy_mapping.find(related_name);
                 if (related_dummy_it != db.real_to_dummy_mapping.end()) {
                     input_name = related_dummy_it->second;
                 }
-                op << "{" << input_name << " " << record.original_cell_type << " 1} ";
+                op << "{" << input_name << " " << record.original_cell_type() << " 1} ";
             }
             
             // Output multibit FF
-            op << "{" << record.result_instance_name << " " << record.result_cell_type << " " << bit_width << "} ";
+            op << "{" << record.result_instance_name() << " " << record.result_cell_type() << " " << bit_width << "} ";
             
             op << "}";
             operations.push_back(op.str());
@@ -392,7 +390,7 @@ std::vector<std::string> generate_create_multibit_operations(const DesignDatabas
 void generate_operation_log_file(DesignDatabase& db, const std::string& output_file) {
     std::cout << "  Generating .list file with operation log: " << output_file << std::endl;
     
-    std::ofstream out(output_file);
+    OutputFile out(output_file);
     if (!out.is_open()) {
         std::cerr << "Error: Cannot open " << output_file << " for writing" << std::endl;
         return;
@@ -409,25 +407,8 @@ void generate_operation_log_file(DesignDatabase& db, const std::string& output_f
     // CellInst section with pin mappings
     out << "CellInst " << ff_count << std::endl;
     
-    // Read and include pin mappings from temporary file
-    std::ifstream temp_file("temp_pin_mapping.list");
-    if (temp_file.is_open()) {
-        std::string line;
-        bool skip_first_line = true;  // Skip "CellInst XXXX" line from temp file
-        while (std::getline(temp_file, line)) {
-            if (skip_first_line) {
-                skip_first_line = false;
-                continue;
-            }
-            out << line << std::endl;
-        }
-        temp_file.close();
-        
-        // Clean up temporary file
-        std::remove("temp_pin_mapping.list");
-    } else {
-        out << "# Pin mapping generation failed" << std::endl;
-    }
+    // Pin mappings straight from the provenance table (one pass over original pins)
+    write_pin_mapping_entries(db, out);
     
     out << std::endl;
     
@@ -487,7 +468,7 @@ void generate_pin_mapping_list_file(const DesignDatabase& db, const std::string&
     // Generate pin mappings from transformation history
     for (const auto& record : db.transformation_history) {
         // Get the result cell template to check which pins exist
-        auto result_cell_it = db.cell_library.find(record.result_cell_type);
+        auto result_cell_it = db.cell_library.find(record.result_cell_type());
         std::set<std::string> result_cell_pins;
         if (result_cell_it != db.cell_library.end()) {
             for (const auto& pin : result_cell_it->second->pins) {
@@ -495,17 +476,17 @@ void generate_pin_mapping_list_file(const DesignDatabase& db, const std::string&
             }
         }
         
-        for (const auto& pin_pair : record.pin_mapping) {
+        for (const auto& pin_pair : record.pin_mapping()) {
             // Check if result cell actually has this pin
             if (!result_cell_pins.empty() && result_cell_pins.find(pin_pair.second) == result_cell_pins.end()) {
                 // Skip pins that don't exist in the result cell
                 std::cout << "    Skipping pin mapping " << pin_pair.first << " -> " << pin_pair.second 
-                          << " (pin not found in " << record.result_cell_type << ")" << std::endl;
+                          << " (pin not found in " << record.result_cell_type() << ")" << std::endl;
                 continue;
             }
             
-            out << record.original_instance_name << "." << pin_pair.first 
-                << " -> " << record.result_instance_name << "." << pin_pair.second << std::endl;
+            out << record.original_instance_name() << "." << pin_pair.first 
+                << " -> " << record.result_instance_name() << "." << pin_pair.second << std::endl;
         }
     }
     
@@ -540,18 +521,18 @@ void generate_final_def_file(const DesignDatabase& db, const std::string& output
     // Components section - based on transformation history
     std::set<std::string> result_instances;
     for (const auto& record : db.transformation_history) {
-        result_instances.insert(record.result_instance_name);
+        result_instances.insert(record.result_instance_name());
     }
     
     out << "COMPONENTS " << result_instances.size() << " ;" << std::endl;
     for (const auto& record : db.transformation_history) {
         // Only output each result instance once
-        if (result_instances.count(record.result_instance_name)) {
-            result_instances.erase(record.result_instance_name); // Remove to avoid duplicates
+        if (result_instances.count(record.result_instance_name())) {
+            result_instances.erase(record.result_instance_name()); // Remove to avoid duplicates
             
-            out << "- " << record.result_instance_name << " " << record.result_cell_type 
-                << " + PLACED ( " << (int)record.result_x << " " << (int)record.result_y 
-                << " ) " << record.result_orientation << " ;" << std::endl;
+            out << "- " << record.result_instance_name() << " " << record.result_cell_type() 
+                << " + PLACED ( " << record.result_x() << " " << record.result_y() 
+                << " ) " << record.result_orientation() << " ;" << std::endl;
         }
     }
     out << "END COMPONENTS" << std::endl;
@@ -624,7 +605,7 @@ void extract_original_module_structure(const std::string& input_verilog_path,
                                       const std::string& module_name,
                                       std::string& module_header,
                                       std::string& wire_declarations) {
-    std::ifstream file(input_verilog_path);
+    InputFile file(input_verilog_path);
     if (!file.is_open()) {
         std::cout << "    WARNING: Cannot read original verilog file: " << input_verilog_path << std::endl;
         module_header = "module " + module_name + " ();\n";
@@ -673,10 +654,57 @@ void extract_original_module_structure(const std::string& input_verilog_path,
     }
 }
 
+// One instance block of the final netlist: every pin of the cell, missing ones tied to UNCONNECTED
+void write_verilog_instance(std::ostream& out, const DesignDatabase& db, const std::string& cell_type,
+                            const std::string& local_name, const std::vector<Instance::Connection>& connections) {
+    out << cell_type << " " << local_name << " (" << std::endl;
+    
+    // Get cell template to ensure all pins are output
+    auto cell_it = db.cell_library.find(cell_type);
+    std::set<std::string> cell_pins;
+    if (cell_it != db.cell_library.end()) {
+        for (const auto& pin : cell_it->second->pins) {
+            cell_pins.insert(pin.name);
+        }
+    }
+    
+    // Create connection map for quick lookup
+    std::map<std::string, std::string> conn_map;
+    for (const auto& conn : connections) {
+        conn_map[conn.pin_name] = conn.net_name;
+    }
+    
+    // Output ALL pins (including unconnected ones)
+    bool first_conn = true;
+    for (const std::string& pin_name : cell_pins) {
+        if (!first_conn) out << "," << std::endl;
+        
+        std::string net_name;
+        auto conn_it = conn_map.find(pin_name);
+        if (conn_it != conn_map.end()) {
+            net_name = conn_it->second;
+            // Normalize unconnected net names to single "UNCONNECTED"
+            if (net_name == "SYNOPSYS_UNCONNECTED" || 
+                net_name.find("UNCONNECTED") != std::string::npos) {
+                net_name = "UNCONNECTED";
+            }
+        } else {
+            // Pin not found in connections - must be unconnected
+            net_name = "UNCONNECTED";
+        }
+        
+        // Use local net name
+        std::string local_net = get_module_local_net_name(net_name);
+        out << "    ." << pin_name <<" "<< "("<<" " << local_net <<" "<< ")"<<" ";
+        first_conn = false;
+    }
+    out << std::endl <<" "<< ")" <<" "<<";"<< std::endl << std::endl;
+}
+
 void generate_final_verilog_file(const DesignDatabase& db, const std::string& output_file) {
     std::cout << "  Generating final Verilog file: " << output_file << std::endl;
     
-    std::ofstream out(output_file);
+    OutputFile out(output_file);
     if (!out.is_open()) {
         std::cerr << "ERROR: Cannot open " << output_file << " for writing" << std::endl;
         return;
@@ -696,6 +724,9 @@ void generate_final_verilog_file(const DesignDatabase& db, const std::string& ou
         }
     }
     
+    if (db.out_of_core) {
+        comb_count += static_cast<int>(db.out_of_core->instance_count());   // -out_of_core：串流自spill檔
+    }
     std::cout << "    FF instances: " << ff_count << ", Combinational: " << comb_count << std::endl;
     if (empty_conn_count > 0) {
         std::cout << "    WARNING: " << empty_conn_count << " instances have no connections" << std::endl;
@@ -712,27 +743,32 @@ void generate_final_verilog_file(const DesignDatabase& db, const std::string& ou
     std::cout << "    Generating " << module_instances.size() << " modules" << std::endl;
     
     // Generate each module
-    for (const auto& module : db.modules) {
-        const std::string& module_name = module.name;
+    for (size_t module_index = 0; module_index < db.modules.size(); module_index++) {
+        const std::string& module_name = db.modules[module_index].name;
         
         std::cout << "    Generating module: " << module_name << std::endl;
         
-        // Extract original module structure
-        std::string module_header, wire_declarations;
-        extract_original_module_structure(db.input_verilog_path, module_name, module_header, wire_declarations);
-        
-        // Output module header
-        out << module_header;
-        if (!module_header.empty() && module_header.back() != '\n') {
-            out << std::endl;
-        }
-        
-        // Output wire declarations
-        if (!wire_declarations.empty()) {
-            out << wire_declarations;
-            if (wire_declarations.back() != '\n') {
+        if (db.out_of_core) {
+            // Header直接從原始檔的offset複製 (不把整個Verilog讀進記憶體)
+            db.out_of_core->write_module_header(out, module_index, module_name);
+        } else {
+            // Extract original module structure
+            std::string module_header, wire_declarations;
+            extract_original_module_structure(db.input_verilog_path, module_name, module_header, wire_declarations);
+            
+            // Output module header
+            out << module_header;
+            if (!module_header.empty() && module_header.back() != '\n') {
                 out << std::endl;
             }
+            
+            // Output wire declarations
+            if (!wire_declarations.empty()) {
+                out << wire_declarations;
+                if (wire_declarations.back() != '\n') {
+                    out << std::endl;
+                }
+            }
         }
         
         // Add UNCONNECTED wire declaration for this module
@@ -753,51 +789,18 @@ void generate_final_verilog_file(const DesignDatabase& db, const std::string& ou
                 std::string current_cell_type = instance->cell_template ? 
                     instance->cell_template->name : instance->cell_type;
                 
-                out << current_cell_type << " " << local_name << " (" << std::endl;
-                
-                // Get cell template to ensure all pins are output
-                auto cell_it = db.cell_library.find(current_cell_type);
-                std::set<std::string> cell_pins;
-                if (cell_it != db.cell_library.end()) {
-                    for (const auto& pin : cell_it->second->pins) {
-                        cell_pins.insert(pin.name);
-                    }
-                }
-                
-                // Create connection map for quick lookup
-                std::map<std::string, std::string> conn_map;
-                for (const auto& conn : instance->connections) {
-                    conn_map[conn.pin_name] = conn.net_name;
-                }
-                
-                // Output ALL pins (including unconnected ones)
-                bool first_conn = true;
-                for (const std::string& pin_name : cell_pins) {
-                    if (!first_conn) out << "," << std::endl;
-                    
-                    std::string net_name;
-                    auto conn_it = conn_map.find(pin_name);
-                    if (conn_it != conn_map.end()) {
-                        net_name = conn_it->second;
-                        // Normalize unconnected net names to single "UNCONNECTED"
-                        if (net_name == "SYNOPSYS_UNCONNECTED" || 
-                            net_name.find("UNCONNECTED") != std::string::npos) {
-                            net_name = "UNCONNECTED";
-                        }
-                    } else {
-                        // Pin not found in connections - must be unconnected
-                        net_name = "UNCONNECTED";
-                    }
-                    
-                    // Use local net name
-                    std::string local_net = get_module_local_net_name(net_name);
-                    out << "    ." << pin_name <<" "<< "("<<" " << local_net <<" "<< ")"<<" ";
-                    first_conn = false;
-                }
-                out << std::endl <<" "<< ")" <<" "<<";"<< std::endl << std::endl;
+                write_verilog_instance(out, db, current_cell_type, local_name, instance->connections);
             }
         }
         
+        // -out_of_core：組合邏輯instance依原始順序從spill檔讀回
+        if (db.out_of_core) {
+            db.out_of_core->for_each_instance(module_index, [&](const SpilledInstance& instance) {
+                write_verilog_instance(out, db, instance.cell_type, get_module_local_instance_name(instance.name),
+                                       instance.connections);
+            });
+        }
+        
         out << "endmodule" << std::endl << std::endl;
     }
     
@@ -813,6 +816,7 @@ void initialize_transformation_tracking(DesignDatabase& db) {
     std::cout << "  Initializing transformation tracking system..." << std::endl;
     
     db.transformation_history.clear();
+    db.pin_provenance.clear();
     
     // Initialize with KEEP records for all current FF instances
     for (const auto& inst_pair : db.instances) {
@@ -820,19 +824,18 @@ void initialize_transformation_tracking(DesignDatabase& db) {
             // Set cluster_id for original instances (use instance name as cluster ID)
             inst_pair.second->cluster_id = inst_pair.second->name;
             record_keep_transformation(db, inst_pair.second);
+            db.pin_provenance.register_original_instance(*inst_pair.second);
         }
     }
     
     std::cout << "    Initialized with " << db.transformation_history.size() 
               << " KEEP transformation records" << std::endl;
+    std::cout << "    Registered " << db.pin_provenance.original_pins.size()
+              << " original FF pins for provenance tracking" << std::endl;
     
     // Capture ORIGINAL stage - all instances before any transformation
     std::cout << "  Capturing ORIGINAL stage..." << std::endl;
-    std::vector<std::shared_ptr<Instance>> all_instances;
-    for (const auto& inst_pair : db.instances) {
-        all_instances.push_back(inst_pair.second);
-    }
-    db.complete_pipeline.capture_stage("ORIGINAL", all_instances, {}, &db.transformation_history);
+    db.complete_pipeline.capture_stage("ORIGINAL", db.instances, {}, &db.transformation_history);
 }
 
 void export_transformation_report(const DesignDatabase& db, const std::string& output_file) {
@@ -850,17 +853,21 @@ void export_transformation_report(const DesignDatabase& db, const std::string& o
     
     // Removed transformation summary as not needed
     
-    // Stage-by-stage instance listings
+    // Stage-by-stage instance listings (full views rebuilt from stage deltas)
     for (const auto& stage : db.complete_pipeline.stages) {
+        std::vector<const InstanceSnapshot*> stage_view = db.complete_pipeline.reconstruct_stage(stage.stage_name);
+        
         out << "=== STAGE: " << stage.stage_name << " ===" << std::endl;
         out << "Total FF instances: " << stage.ff_instances << std::endl;
-        out << "Total instances captured: " << stage.instances.size() << std::endl;
+        out << "Total instances captured: " << stage_view.size() << std::endl;
+        out << "Changed since previous stage: " << stage.changed.size() 
+            << ", removed: " << stage.removed.size() << std::endl;
         
-        if (!stage.instances.empty()) {
+        if (!stage_view.empty()) {
             out << std::endl;
             // List all instances in this stage with numbering starting from 1
-            for (size_t i = 0; i < stage.instances.size(); i++) {
-                const auto& instance = stage.instances[i];
+            for (size_t i = 0; i < stage_view.size(); i++) {
+                const auto& instance = *stage_view[i];
                 out << std::setw(4) << (i + 1) << ". " << instance.instance_name 
                     << " (" << instance.cell_type << ")" << std::endl;
                 
@@ -883,120 +890,12 @@ void export_transformation_report(const DesignDatabase& db, const std::string& o
                     out << "      Pin connections: None captured" << std::endl;
                 }
                 
-                // Find the most appropriate transformation record for this instance in this stage
-                const TransformationRecord* appropriate_record = nullptr;
-                
-                // Stage-aware record selection
-                if (stage.stage_name == "ORIGINAL") {
-                    // In ORIGINAL stage, only show KEEP records
-                    for (const auto& record : db.transformation_history) {
-                        if (record.result_instance_name == instance.instance_name && 
-                            record.operation == TransformationRecord::KEEP) {
-                            appropriate_record = &record;
-                            break;
-                        }
-                    }
-                } else if (stage.stage_name == "DEBANK") {
-                    // In DEBANK stage, show DEBANK operations for this instance, otherwise KEEP
-                    // BUT exclude future operations
-                    for (const auto& record : db.transformation_history) {
-                        if (record.result_instance_name == instance.instance_name) {
-                            // Skip future operations that shouldn't be shown in DEBANK stage
-                            if (record.operation == TransformationRecord::SUBSTITUTE) continue;
-                            if (record.operation == TransformationRecord::BANK) continue;
-                            if (record.operation == TransformationRecord::KEEP && 
-                                !record.stage.empty() && record.stage == "LEGALIZATION") continue;
-                                
-                            if (record.operation == TransformationRecord::DEBANK) {
-                                appropriate_record = &record;
-                                break; // Found DEBANK, use this
-                            } else if (record.operation == TransformationRecord::KEEP && !appropriate_record) {
-                                appropriate_record = &record; // Use KEEP as fallback
-                            }
-                        }
-                    }
-                } else if (stage.stage_name == "SUBSTITUTE") {
-                    // In SUBSTITUTE stage, prioritize SUBSTITUTE operations, then DEBANK, then KEEP
-                    // BUT exclude future operations (BANK, LEGALIZATION)
-                    const TransformationRecord* substitute_record = nullptr;
-                    const TransformationRecord* debank_record = nullptr;
-                    const TransformationRecord* keep_record = nullptr;
-                    
-                    for (const auto& record : db.transformation_history) {
-                        if (record.result_instance_name == instance.instance_name) {
-                            // Skip future operations that shouldn't be shown in SUBSTITUTE stage
-                            if (record.operation == TransformationRecord::BANK) continue;
-                            // Skip KEEP operations with LEGALIZATION stage info
-                            if (record.operation == TransformationRecord::KEEP && 
-                                !record.stage.empty() && record.stage == "LEGALIZATION") continue;
-                            
-                            if (record.operation == TransformationRecord::SUBSTITUTE) {
-                                substitute_record = &record;
-                            } else if (record.operation == TransformationRecord::DEBANK) {
-                                debank_record = &record;
-                            } else if (record.operation == TransformationRecord::KEEP) {
-                                keep_record = &record;
-                            }
-                        }
-                    }
-                    
-                    // Select based on priority
-                    if (substitute_record) {
-                        appropriate_record = substitute_record;
-                    } else if (debank_record) {
-                        appropriate_record = debank_record;
-                    } else if (keep_record) {
-                        appropriate_record = keep_record;
-                    }
-                } else if (stage.stage_name == "BANK") {
-                    // In BANK stage, prioritize BANK operations, then SUBSTITUTE, then DEBANK, then KEEP
-                    // BUT exclude future operations (LEGALIZATION)
-                    const TransformationRecord* bank_record = nullptr;
-                    const TransformationRecord* substitute_record = nullptr;
-                    const TransformationRecord* debank_record = nullptr;
-                    const TransformationRecord* keep_record = nullptr;
-                    
-                    for (const auto& record : db.transformation_history) {
-                        if (record.result_instance_name == instance.instance_name) {
-                            // Skip KEEP operations with LEGALIZATION stage info
-                            if (record.operation == TransformationRecord::KEEP && 
-                                !record.stage.empty() && record.stage == "LEGALIZATION") continue;
-                                
-                            if (record.operation == TransformationRecord::BANK) {
-                                bank_record = &record;
-                            } else if (record.operation == TransformationRecord::SUBSTITUTE) {
-                                substitute_record = &record;
-                            } else if (record.operation == TransformationRecord::DEBANK) {
-                                debank_record = &record;
-                            } else if (record.operation == TransformationRecord::KEEP) {
-                                keep_record = &record;
-                            }
-                        }
-                    }
-                    
-                    // Select based on priority
-                    if (bank_record) {
-                        appropriate_record = bank_record;
-                    } else if (substitute_record) {
-                        appropriate_record = substitute_record;
-                    } else if (debank_record) {
-                        appropriate_record = debank_record;
-                    } else if (keep_record) {
-                        appropriate_record = keep_record;
-                    }
-                } else {
-                    // For other stages (LEGALIZE), find the chronologically latest record for this instance
-                    for (const auto& record : db.transformation_history) {
-                        if (record.result_instance_name == instance.instance_name) {
-                            appropriate_record = &record;  // Keep updating to get the latest
-                        }
-                    }
-                }
-                
-                if (appropriate_record) {
-                    out << "      Last operation: " << appropriate_record->operation_string();
-                    if (!appropriate_record->stage.empty()) {
-                        out << " (" << appropriate_record->stage << ")";
+                // Latest record as of this stage (captured with the snapshot, so no future operations)
+                if (instance.record_index >= 0) {
+                    TransformationRecordRef record = db.transformation_history[static_cast<size_t>(instance.record_index)];
+                    out << "      Last operation: " << record.operation_string();
+                    if (!record.stage().empty()) {
+                        out << " (" << record.stage() << ")";
                     }
                     out << std::endl;
                 } else {
@@ -1026,11 +925,8 @@ void record_legalization_transformations(DesignDatabase& db) {
         auto instance = inst_pair.second;
         if (!instance->is_flip_flop()) continue;
         
-        // Check if position changed during legalization
-        double displacement = std::sqrt((instance->x_new - instance->position.x) * (instance->x_new - instance->position.x) + 
-                                       (instance->y_new - instance->position.y) * (instance->y_new - instance->position.y));
-        
-        if (displacement > 1e-6) { // Position changed
+        // Check if position changed during legalization (exact in DBU)
+        if (instance->x_new != instance->position.x || instance->y_new != instance->position.y) {
             TransformationRecord record(instance->name, instance->name, TransformationRecord::KEEP, 
                                       instance->cell_template->name, instance->cell_template->name);
             
@@ -1045,8 +941,7 @@ void record_legalization_transformations(DesignDatabase& db) {
             // Pin mapping stays the same for legalization (only position changes)
             // No need to set pin_mapping since it's just position adjustment
             
-            db.transformation_history.push_back(record);
-            legalization_indices.push_back(db.transformation_history.size() - 1);
+            legalization_indices.push_back(db.transformation_history.push_back(record));
             legalization_count++;
             
             // Update instance position to the legalized position
@@ -1058,12 +953,7 @@ void record_legalization_transformations(DesignDatabase& db) {
     std::cout << "    Recorded " << legalization_count << " legalization transformations" << std::endl;
     
     // Capture LEGALIZE stage
-    std::vector<std::shared_ptr<Instance>> all_instances_after_legalization;
-    for (const auto& inst_pair : db.instances) {
-        all_instances_after_legalization.push_back(inst_pair.second);
-    }
-    
-    db.complete_pipeline.capture_stage("LEGALIZE", all_instances_after_legalization, legalization_indices, &db.transformation_history);
+    db.complete_pipeline.capture_stage("LEGALIZE", db.instances, legalization_indices, &db.transformation_history);
     std::cout << "    LEGALIZE stage captured successfully" << std::endl;
 }
 
@@ -30,8 +30,8 @@ bool verify_transformation_completeness(const DesignDatabase& db) {
     std::set<std::string> original_ff_names; // Track what original FFs were processed
     
     for (const auto& record : db.transformation_history) {
-        result_ff_names.insert(record.result_instance_name);
-        original_ff_names.insert(record.original_instance_name);
+        result_ff_names.insert(record.result_instance_name());
+        original_ff_names.insert(record.original_instance_name());
     }
     
     // Check completeness: all current FFs should have transformation records
@@ -91,11 +91,11 @@ bool verify_pin_mapping_consistency(const DesignDatabase& db) {
         checked_records++;
         
         // For DEBANK operations, the original instance no longer exists - this is expected
-        if (record.operation == TransformationRecord::DEBANK) {
+        if (record.operation() == TransformationRecord::DEBANK) {
             // Check that the result instance exists
-            auto result_inst_it = db.instances.find(record.result_instance_name);
+            auto result_inst_it = db.instances.find(record.result_instance_name());
             if (result_inst_it == db.instances.end()) {
-                std::cout << "  ❌ Result instance not found after DEBANK: " << record.result_instance_name << std::endl;
+                std::cout << "  ❌ Result instance not found after DEBANK: " << record.result_instance_name() << std::endl;
                 consistent = false;
                 inconsistent_records++;
             }
@@ -103,9 +103,9 @@ bool verify_pin_mapping_consistency(const DesignDatabase& db) {
         }
         
         // Find original instance (for KEEP, SUBSTITUTE, BANK operations)
-        auto orig_inst_it = db.instances.find(record.original_instance_name);
+        auto orig_inst_it = db.instances.find(record.original_instance_name());
         if (orig_inst_it == db.instances.end()) {
-            std::cout << "  ❌ Original instance not found: " << record.original_instance_name << std::endl;
+            std::cout << "  ❌ Original instance not found: " << record.original_instance_name() << std::endl;
             consistent = false;
             inconsistent_records++;
             continue;
@@ -114,7 +114,7 @@ bool verify_pin_mapping_consistency(const DesignDatabase& db) {
         auto original_instance = orig_inst_it->second;
         
         // For KEEP operations, check that all pins are mapped 1:1
-        if (record.operation == TransformationRecord::KEEP) {
+        if (record.operation() == TransformationRecord::KEEP) {
             std::set<std::string> original_pins;
             for (const auto& conn : original_instance->connections) {
                 original_pins.insert(conn.pin_name);
@@ -122,7 +122,7 @@ bool verify_pin_mapping_consistency(const DesignDatabase& db) {
             
             std::set<std::string> mapped_original_pins;
             std::set<std::string> mapped_result_pins;
-            for (const auto& mapping : record.pin_mapping) {
+            for (const auto& mapping : record.pin_mapping()) {
                 mapped_original_pins.insert(mapping.first);
                 mapped_result_pins.insert(mapping.second);
             }
@@ -131,7 +131,7 @@ bool verify_pin_mapping_consistency(const DesignDatabase& db) {
             bool all_pins_mapped = true;
             for (const auto& pin : original_pins) {
                 if (mapped_original_pins.find(pin) == mapped_original_pins.end()) {
-                    std::cout << "  ❌ Missing pin mapping for " << record.original_instance_name 
+                    std::cout << "  ❌ Missing pin mapping for " << record.original_instance_name() 
                               << "." << pin << std::endl;
                     consistent = false;
                     all_pins_mapped = false;
@@ -141,7 +141,7 @@ bool verify_pin_mapping_consistency(const DesignDatabase& db) {
             // For KEEP operations, result pins should be identical to original pins
             if (mapped_original_pins != mapped_result_pins) {
                 std::cout << "  ❌ KEEP operation with non-identical pin mapping: " 
-                          << record.original_instance_name << std::endl;
+                          << record.original_instance_name() << std::endl;
                 consistent = false;
                 all_pins_mapped = false;
             }
@@ -173,32 +173,32 @@ bool verify_position_information(const DesignDatabase& db) {
         checked_records++;
         
         // For KEEP operations, check position consistency with original instance
-        if (record.operation == TransformationRecord::KEEP) {
-            auto orig_inst_it = db.instances.find(record.original_instance_name);
+        if (record.operation() == TransformationRecord::KEEP) {
+            auto orig_inst_it = db.instances.find(record.original_instance_name());
             if (orig_inst_it == db.instances.end()) {
                 continue; // Skip if original instance not found
             }
             
             auto original_instance = orig_inst_it->second;
-            if (std::abs(record.result_x - original_instance->position.x) > 0.01 ||
-                std::abs(record.result_y - original_instance->position.y) > 0.01) {
-                std::cout << "  ❌ Position mismatch for " << record.original_instance_name 
+            if (std::abs(record.result_x() - original_instance->position.x) > 0.01 ||
+                std::abs(record.result_y() - original_instance->position.y) > 0.01) {
+                std::cout << "  ❌ Position mismatch for " << record.original_instance_name() 
                           << ": original(" << original_instance->position.x << "," << original_instance->position.y 
-                          << ") vs result(" << record.result_x << "," << record.result_y << ")" << std::endl;
+                          << ") vs result(" << record.result_x() << "," << record.result_y() << ")" << std::endl;
                 positions_valid = false;
                 invalid_positions++;
             }
         }
         // For DEBANK operations, check that result instance has valid position
-        else if (record.operation == TransformationRecord::DEBANK) {
-            auto result_inst_it = db.instances.find(record.result_instance_name);
+        else if (record.operation() == TransformationRecord::DEBANK) {
+            auto result_inst_it = db.instances.find(record.result_instance_name());
             if (result_inst_it != db.instances.end()) {
                 auto result_instance = result_inst_it->second;
                 // Check if recorded position matches actual instance position
-                if (std::abs(record.result_x - result_instance->position.x) > 0.01 ||
-                    std::abs(record.result_y - result_instance->position.y) > 0.01) {
-                    std::cout << "  ❌ Position mismatch for debanked " << record.result_instance_name 
-                              << ": recorded(" << record.result_x << "," << record.result_y 
+                if (std::abs(record.result_x() - result_instance->position.x) > 0.01 ||
+                    std::abs(record.result_y() - result_instance->position.y) > 0.01) {
+                    std::cout << "  ❌ Position mismatch for debanked " << record.result_instance_name() 
+                              << ": recorded(" << record.result_x() << "," << record.result_y() 
                               << ") vs actual(" << result_instance->position.x << "," << result_instance->position.y << ")" << std::endl;
                     positions_valid = false;
                     invalid_positions++;
@@ -280,7 +280,7 @@ bool verify_transformation_logic(const DesignDatabase& db) {
     // Count operation types
     std::map<TransformationRecord::Operation, int> operation_counts;
     for (const auto& record : db.transformation_history) {
-        operation_counts[record.operation]++;
+        operation_counts[record.operation()]++;
     }
     
     std::cout << "  Operation distribution:" << std::endl;
@@ -296,46 +296,46 @@ bool verify_transformation_logic(const DesignDatabase& db) {
     
     // Check for logical consistency of operations
     for (const auto& record : db.transformation_history) {
-        switch (record.operation) {
+        switch (record.operation()) {
             case TransformationRecord::KEEP:
                 // For KEEP, original and result should be identical
-                if (record.original_instance_name != record.result_instance_name ||
-                    record.original_cell_type != record.result_cell_type) {
-                    std::cout << "  ❌ KEEP operation with changes: " << record.original_instance_name << std::endl;
+                if (record.original_instance_name() != record.result_instance_name() ||
+                    record.original_cell_type() != record.result_cell_type()) {
+                    std::cout << "  ❌ KEEP operation with changes: " << record.original_instance_name() << std::endl;
                     logic_valid = false;
                 }
                 break;
                 
             case TransformationRecord::SUBSTITUTE:
                 // For SUBSTITUTE, instance name same but cell type different
-                if (record.original_instance_name != record.result_instance_name ||
-                    record.original_cell_type == record.result_cell_type) {
-                    std::cout << "  ❌ SUBSTITUTE operation logic error: " << record.original_instance_name << std::endl;
+                if (record.original_instance_name() != record.result_instance_name() ||
+                    record.original_cell_type() == record.result_cell_type()) {
+                    std::cout << "  ❌ SUBSTITUTE operation logic error: " << record.original_instance_name() << std::endl;
                     logic_valid = false;
                 }
                 break;
                 
             case TransformationRecord::POST_SUBSTITUTE:
                 // For POST_SUBSTITUTE, same logic as SUBSTITUTE
-                if (record.original_instance_name != record.result_instance_name ||
-                    record.original_cell_type == record.result_cell_type) {
-                    std::cout << "  ❌ POST_SUBSTITUTE operation logic error: " << record.original_instance_name << std::endl;
+                if (record.original_instance_name() != record.result_instance_name() ||
+                    record.original_cell_type() == record.result_cell_type()) {
+                    std::cout << "  ❌ POST_SUBSTITUTE operation logic error: " << record.original_instance_name() << std::endl;
                     logic_valid = false;
                 }
                 break;
                 
             case TransformationRecord::DEBANK:
                 // For DEBANK, should have related instances
-                if (record.related_instances.empty()) {
-                    std::cout << "  ❌ DEBANK operation without related instances: " << record.original_instance_name << std::endl;
+                if (record.related_instances().empty()) {
+                    std::cout << "  ❌ DEBANK operation without related instances: " << record.original_instance_name() << std::endl;
                     logic_valid = false;
                 }
                 break;
                 
             case TransformationRecord::BANK:
                 // For BANK, should have related instances  
-                if (record.related_instances.empty()) {
-                    std::cout << "  ❌ BANK operation without related instances: " << record.original_instance_name << std::endl;
+                if (record.related_instances().empty()) {
+                    std::cout << "  ❌ BANK operation without related instances: " << record.original_instance_name() << std::endl;
                     logic_valid = false;
                 }
                 break;
@@ -397,7 +397,7 @@ void export_transformation_verification_report(const DesignDatabase& db, const s
     // Summary statistics
     std::map<TransformationRecord::Operation, int> op_counts;
     for (const auto& record : db.transformation_history) {
-        op_counts[record.operation]++;
+        op_counts[record.operation()]++;
     }
     
     out << "=== TRANSFORMATION STATISTICS ===" << std::endl;
@@ -414,14 +414,15 @@ void export_transformation_verification_report(const DesignDatabase& db, const s
     // Pin mapping analysis
     int total_pin_mappings = 0;
     for (const auto& record : db.transformation_history) {
-        total_pin_mappings += record.pin_mapping.size();
+        total_pin_mappings += record.pin_mapping().size();
     }
     out << "Total pin mappings: " << total_pin_mappings << std::endl;
+    out << "Distinct shared pin maps: " << db.transformation_history.distinct_pin_maps() << std::endl;
     
     // Position analysis
     int valid_positions = 0;
     for (const auto& record : db.transformation_history) {
-        if (record.result_x != 0.0 || record.result_y != 0.0) {
+        if (record.result_x() != 0.0 || record.result_y() != 0.0) {
             valid_positions++;
         }
     }